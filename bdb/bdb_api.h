@@ -550,6 +550,8 @@ int bdb_handle_reset_tran(bdb_state_type *, tran_type *, tran_type *);
 int bdb_handle_dbp_add_hash(bdb_state_type *bdb_state, int szkb);
 int bdb_handle_dbp_drop_hash(bdb_state_type *bdb_state);
 int bdb_handle_dbp_hash_stat(bdb_state_type *bdb_state);
+int bdb_handle_dbp_set_fillpct(bdb_state_type *bdb_state, int ixnum, int pct);
+int bdb_set_fillpct(bdb_state_type *bdb_state, int ixnum, int pct);
 int bdb_handle_dbp_hash_stat_reset(bdb_state_type *bdb_state);
 int bdb_close_temp_state(bdb_state_type *bdb_state, int *bdberr);
 
@@ -1102,6 +1104,32 @@ int bdb_load_cache(bdb_state_type *bdb_state, const char *file);
 /* Load default cache */
 int bdb_load_cache_default(bdb_state_type *bdb_state);
 
+/* Progress of the latest cache load */
+void bdb_get_cache_warmup(bdb_state_type *bdb_state, int *running,
+                          int *stopped, int *start, int *end, uint64_t *pages,
+                          uint64_t *pages_done, uint64_t *pages_read);
+
+/* Logical-commit cache usage and hit rates */
+void bdb_get_lc_cache(bdb_state_type *bdb_state, int *txns, int *spilled_txns,
+                      int *memused, int *largest_txn, uint64_t *hits,
+                      uint64_t *spilled_hits, uint64_t *misses,
+                      uint64_t *spills, uint64_t *evictions, uint64_t *drops);
+
+/* Background page compaction of one btree */
+struct bdb_pgcompact_stat {
+    char table[MAXTABLELEN];
+    int dtanum; /* -1 for an index */
+    int ixnum;  /* -1 for a data or blob file */
+    int stripe;
+    int64_t leaf_pages;
+    double fill_pct;
+    int64_t ranges_compacted;
+    int64_t pages_merged;
+    int64_t bytes_reclaimed;
+    int64_t logbytes;
+};
+int bdb_get_pgcompact_stats(struct bdb_pgcompact_stat **stats, int *nstats);
+
 /* Flush default cache */
 int bdb_dump_cache_default(bdb_state_type *bdb_state);
 
@@ -1246,6 +1274,7 @@ int bdb_temp_table_prev_norewind(bdb_state_type *bdb_state,
 
 void *bdb_temp_table_get_usermem(struct temp_table *table);
 void bdb_temp_table_set_user_data(struct temp_cursor *cur, void *usermem);
+void bdb_temp_table_set_zerocopy(struct temp_cursor *cur, int zerocopy);
 
 int bdb_temp_table_keysize(struct temp_cursor *cursor);
 int bdb_temp_table_datasize(struct temp_cursor *cursor);
@@ -1736,6 +1765,11 @@ int bdb_set_sc_start_lsn(tran_type *tran, const char *table, void *plsn,
                          int *bdberr);
 int bdb_delete_sc_start_lsn(tran_type *tran, const char *table, int *bdberr);
 
+int bdb_get_sc_spooled_keys(tran_type *tran, const char *table, int *bdberr);
+int bdb_set_sc_spooled_keys(tran_type *tran, const char *table, int *bdberr);
+int bdb_delete_sc_spooled_keys(tran_type *tran, const char *table,
+                               int *bdberr);
+
 enum {
     ACCESS_INVALID = 0,
     ACCESS_READ = 1,
@@ -1944,6 +1978,9 @@ int bdb_get_lock_counters(bdb_state_type *bdb_state, int64_t *deadlocks,
 int bdb_get_bpool_counters(bdb_state_type *bdb_state, int64_t *bpool_hits,
                            int64_t *bpool_misses, int64_t *rw_evicts);
 
+int bdb_get_log_flush_hist(bdb_state_type *bdb_state, uint32_t *commits,
+                           uint32_t *fsyncs, int nbuckets);
+
 int bdb_master_should_reject(bdb_state_type *bdb_state);
 
 void bdb_berkdb_iomap_set(bdb_state_type *bdb_state, int onoff);
@@ -4601,6 +4601,7 @@ int bdb_llog_cursor_open(bdb_llog_cursor *pCur)
                __func__, __LINE__, rc);
         return -1;
     }
+    pCur->logc->setflags(pCur->logc, DB_LOG_STREAM);
     pCur->openCursor = 1;
     pCur->data.flags = DB_DBT_REALLOC;
 
@@ -1508,6 +1508,46 @@ int bdb_load_cache_default(bdb_state_type *bdb_state)
     return bdb_state->dbenv->memp_load_default(bdb_state->dbenv);
 }
 
+extern void __memp_warmup_stat(DB_ENV *, DB_MPOOL_WARMUP_STAT *);
+
+void bdb_get_cache_warmup(bdb_state_type *bdb_state, int *running,
+                          int *stopped, int *start, int *end, uint64_t *pages,
+                          uint64_t *pages_done, uint64_t *pages_read)
+{
+    DB_MPOOL_WARMUP_STAT st;
+
+    __memp_warmup_stat(bdb_state->dbenv, &st);
+    *running = st.st_running;
+    *stopped = st.st_stopped;
+    *start = st.st_start;
+    *end = st.st_end;
+    *pages = st.st_pages;
+    *pages_done = st.st_pages_done;
+    *pages_read = st.st_pages_read;
+}
+
+extern void __lc_cache_get_stat(DB_ENV *, DB_LC_CACHE_STAT *);
+
+void bdb_get_lc_cache(bdb_state_type *bdb_state, int *txns, int *spilled_txns,
+                      int *memused, int *largest_txn, uint64_t *hits,
+                      uint64_t *spilled_hits, uint64_t *misses,
+                      uint64_t *spills, uint64_t *evictions, uint64_t *drops)
+{
+    DB_LC_CACHE_STAT st;
+
+    __lc_cache_get_stat(bdb_state->dbenv, &st);
+    *txns = st.st_txns;
+    *spilled_txns = st.st_spilled_txns;
+    *memused = st.st_memused;
+    *largest_txn = st.st_largest_txn;
+    *hits = st.st_hits;
+    *spilled_hits = st.st_spilled_hits;
+    *misses = st.st_misses;
+    *spills = st.st_spills;
+    *evictions = st.st_evictions;
+    *drops = st.st_drops;
+}
+
 int bdb_dump_cache_default(bdb_state_type *bdb_state)
 {
     return bdb_state->dbenv->memp_dump_default(bdb_state->dbenv, 1);
@@ -1869,6 +1909,82 @@ int bdb_handle_dbp_hash_stat_reset(bdb_state_type *bdb_state)
     return 0;
 }
 
+/* Set the fill factor of one of a table's indexes, or of its data files if
+ * ixnum is -1.  0 restores the default. */
+int bdb_handle_dbp_set_fillpct(bdb_state_type *bdb_state, int ixnum, int pct)
+{
+    DB *dbp;
+    int strnum, rc;
+
+    if (ixnum < -1 || ixnum >= bdb_state->numix ||
+        (pct != 0 && (pct < 50 || pct > 100)))
+        return EINVAL;
+
+    if (ixnum >= 0) {
+        dbp = bdb_state->dbp_ix[ixnum];
+        return dbp ? dbp->set_bt_fillpct(dbp, pct) : 0;
+    }
+    for (strnum = bdb_get_datafile_num_files(bdb_state, 0) - 1; strnum >= 0;
+         strnum--) {
+        dbp = bdb_state->dbp_data[0][strnum];
+        if (dbp && (rc = dbp->set_bt_fillpct(dbp, pct)) != 0)
+            return rc;
+    }
+    return 0;
+}
+
+static void fillpct_param(int ixnum, char *param, size_t len)
+{
+    if (ixnum < 0)
+        snprintf(param, len, "fillfactor_dta");
+    else
+        snprintf(param, len, "fillfactor_ix%d", ixnum);
+}
+
+/* Set a fill factor and save it in llmeta, for the table's handles to pick
+ * up whenever they are opened.  It's saved first, so the handles never run
+ * with a fill factor that the next open won't find. */
+int bdb_set_fillpct(bdb_state_type *bdb_state, int ixnum, int pct)
+{
+    char param[32], value[16];
+    int rc;
+
+    if (ixnum < -1 || ixnum >= bdb_state->numix ||
+        (pct != 0 && (pct < 50 || pct > 100)))
+        return EINVAL;
+
+    fillpct_param(ixnum, param, sizeof(param));
+    if (pct == 0)
+        rc = bdb_clear_table_parameter(NULL, bdb_state->name, param);
+    else {
+        snprintf(value, sizeof(value), "%d", pct);
+        rc = bdb_set_table_parameter(NULL, bdb_state->name, param, value);
+    }
+    if (rc != 0)
+        return rc;
+
+    return bdb_handle_dbp_set_fillpct(bdb_state, ixnum, pct);
+}
+
+static void set_fillpcts_from_llmeta(bdb_state_type *bdb_state,
+                                     tran_type *tran)
+{
+    char param[32];
+    char *value;
+
+    for (int ixnum = -1; ixnum < bdb_state->numix; ixnum++) {
+        fillpct_param(ixnum, param, sizeof(param));
+        value = NULL;
+        if (bdb_get_table_parameter_tran(bdb_state->name, param, &value,
+                                         tran) != 0)
+            continue;
+        if (bdb_handle_dbp_set_fillpct(bdb_state, ixnum, atoi(value)) != 0)
+            logmsg(LOGMSG_ERROR, "%s: bad %s %s for table %s\n", __func__,
+                   param, value, bdb_state->name);
+        free(value);
+    }
+}
+
 void bdb_stop_recover_threads(bdb_state_type *bdb_state)
 {
     if (bdb_state->dbenv->recovery_processors)
@@ -1899,6 +2015,7 @@ void *checkpoint_thread(void *arg);
 void *logdelete_thread(void *arg);
 void *memp_trickle_thread(void *arg);
 void *deadlockdetect_thread(void *arg);
+void *pgcompact_sched_thread(void *arg);
 
 void make_lsn(DB_LSN *logseqnum, unsigned int filenum, unsigned int offsetnum)
 {
@@ -2592,6 +2709,10 @@ static DB_ENV *dbenv_open(bdb_state_type *bdb_state)
     net_register_handler(bdb_state->repinfo->netinfo, USER_TYPE_BERKDB_REP,
                          "berkdb_replication", berkdb_receive_rtn);
 
+    net_register_handler(bdb_state->repinfo->netinfo,
+                         USER_TYPE_BERKDB_REP_BATCH, "berkdb_replication_batch",
+                         berkdb_receive_rtn);
+
     net_register_handler(bdb_state->repinfo->netinfo, USER_TYPE_BERKDB_NEWSEQ,
                          "berkdb_newseq", berkdb_receive_rtn);
 
@@ -4724,6 +4845,9 @@ deadlock_again:
         }
     } /* end of non-open-lite block */
 
+    if (bdbtype == BDBTYPE_TABLE && bdb_have_llmeta())
+        set_fillpcts_from_llmeta(bdb_state, &tran);
+
     if (tmp_tid) {
         rc = tid->commit(tid, 0);
         if (rc != 0) {
@@ -5983,6 +6107,15 @@ static bdb_state_type *bdb_open_int(
                 return NULL;
             }
 
+            /* create the background page compaction scheduler; it only
+               does anything on the master, and when enabled */
+            rc = pthread_create(&dummy_tid, &attr, pgcompact_sched_thread,
+                                bdb_state);
+            if (rc != 0)
+                logmsg(LOGMSG_ERROR,
+                       "unable to create pgcompact thread - rc=%d %s\n", rc,
+                       strerror(rc));
+
             /* create the deadlock detect thread if we arent doing auto
                deadlock detection */
             if (!bdb_state->attr->autodeadlockdetect) {
@@ -89,8 +89,10 @@ static void bdb_queue_extent_info(FILE *out, bdb_state_type *bdb_state,
 extern int gbl_namemangle_loglevel;
 extern int __db_dump_freepages(DB *dbp, FILE *out);
 extern int __memp_dump_region(DB_ENV *dbenv, const char *area, FILE *fp);
+extern void __memp_lru_fastforward(DB_ENV *dbenv);
 extern int bdb_temp_table_insert_test(bdb_state_type *bdb_state, int recsz,
                                       int maxins);
+extern int bdb_temp_table_spill_test(bdb_state_type *bdb_state);
 extern int __qam_extent_names(DB_ENV *dbenv, char *name, char ***namelistp);
 
 static void printf_wrapper(void *userptr, const char *fmt, ...)
@@ -143,6 +145,23 @@ static void txn_stats(FILE *out, bdb_state_type *bdb_state)
     free(stats);
 }
 
+static void prn_log_hist(FILE *out, const char *name, const u_int32_t *hist,
+                         unsigned base)
+{
+    int i;
+
+    for (i = 0; i < DB_LOG_HIST_BUCKETS; i++) {
+        if (hist[i] == 0)
+            continue;
+        if (i == DB_LOG_HIST_BUCKETS - 1)
+            logmsgf(LOGMSG_USER, out, "%s[>%u]: %u\n", name, base << (i - 1),
+                    hist[i]);
+        else
+            logmsgf(LOGMSG_USER, out, "%s[<=%u]: %u\n", name, base << i,
+                    hist[i]);
+    }
+}
+
 static void log_stats(FILE *out, bdb_state_type *bdb_state)
 {
     DB_LOG_STAT *stats;
@@ -172,6 +191,16 @@ static void log_stats(FILE *out, bdb_state_type *bdb_state)
     prn_stat(st_disk_offset);
     prn_stat(st_maxcommitperflush);
     prn_stat(st_mincommitperflush);
+    prn_stat(st_gc_waits);
+    prn_lstat(st_gc_wait_usecs);
+    prn_lstat(st_fsync_usecs);
+    prn_stat(st_lz4_records);
+    prn_lstat(st_lz4_bytes_in);
+    prn_lstat(st_lz4_bytes_out);
+    prn_stat(st_stream_reads);
+    prn_stat(st_stream_ahead);
+    prn_log_hist(out, "commits_per_flush", stats->st_commit_hist, 1);
+    prn_log_hist(out, "fsync_usecs", stats->st_fsync_hist, 16);
     prn_stat(st_regsize);
     prn_stat(st_region_wait);
     prn_stat(st_region_nowait);
@@ -234,6 +263,30 @@ int bdb_get_bpool_counters(bdb_state_type *bdb_state, int64_t *bpool_hits,
     return 0;
 }
 
+/* Copy out up to nbuckets of each log flush histogram; returns the number
+ * of buckets copied, or -1 on error.  Bucket i of commits counts flushes of
+ * up to 1 << i commits, bucket i of fsyncs syncs of up to 16 << i usecs, and
+ * the last bucket of each everything bigger. */
+int bdb_get_log_flush_hist(bdb_state_type *bdb_state, uint32_t *commits,
+                           uint32_t *fsyncs, int nbuckets)
+{
+    DB_LOG_STAT *stats;
+    int i;
+
+    if (bdb_state->dbenv->log_stat(bdb_state->dbenv, &stats, 0))
+        return -1;
+
+    if (nbuckets > DB_LOG_HIST_BUCKETS)
+        nbuckets = DB_LOG_HIST_BUCKETS;
+    for (i = 0; i < nbuckets; i++) {
+        commits[i] = stats->st_commit_hist[i];
+        fsyncs[i] = stats->st_fsync_hist[i];
+    }
+
+    free(stats);
+    return nbuckets;
+}
+
 const char *deadlock_policy_str(u_int32_t policy)
 {
     switch (policy) {
@@ -332,6 +385,13 @@ static void lock_stats(FILE *out, bdb_state_type *bdb_state)
     prn_lstat(st_nlocktimeouts);
     prn_stat(st_txntimeout);
     prn_lstat(st_ntxntimeouts);
+    prn_lstat(st_nlatch_optimistic);
+    prn_lstat(st_nlatch_optimistic_fail);
+    prn_lstat(st_ndetects);
+    prn_lstat(st_ndetects_skipped);
+    prn_lstat(st_ndeadlock_cycles);
+    prn_lstat(st_detect_usecs);
+    prn_lstat(st_detect_max_usecs);
     prn_lstat(st_region_wait);
     prn_lstat(st_region_nowait);
     logmsgf(LOGMSG_USER, out, "locks_check_waiters: %s\n",
@@ -351,7 +411,10 @@ static void rep_stats(FILE *out, bdb_state_type *bdb_state)
     char str[80];
     extern int64_t gbl_rep_trans_parallel, gbl_rep_trans_serial,
         gbl_rep_trans_deadlocked, gbl_rep_trans_inline,
-        gbl_rep_rowlocks_multifile;
+        gbl_rep_trans_page_dag, gbl_rep_rowlocks_multifile,
+        gbl_rep_batch_msgs, gbl_rep_batch_recs, gbl_rep_batch_raw_bytes,
+        gbl_rep_batch_sent_bytes, gbl_rep_prefetch_recs,
+        gbl_rep_prefetch_pages, gbl_rep_prefetch_dropped;
 
     bdb_state->dbenv->rep_stat(bdb_state->dbenv, &stats, 0);
 
@@ -405,10 +468,32 @@ static void rep_stats(FILE *out, bdb_state_type *bdb_state)
             gbl_rep_trans_serial);
     logmsgf(LOGMSG_USER, out, "txn inline: %" PRId64 "\n",
             gbl_rep_trans_inline);
+    logmsgf(LOGMSG_USER, out, "txn page scheduled: %" PRId64 "\n",
+            gbl_rep_trans_page_dag);
     logmsgf(LOGMSG_USER, out, "txn multifile rowlocks: %" PRId64 "\n",
             gbl_rep_rowlocks_multifile);
     logmsgf(LOGMSG_USER, out, "txn deadlocked: %" PRId64 "\n",
             gbl_rep_trans_deadlocked);
+    logmsgf(LOGMSG_USER, out, "batches sent: %" PRId64 "\n",
+            gbl_rep_batch_msgs);
+    logmsgf(LOGMSG_USER, out, "batch records: %" PRId64 "\n",
+            gbl_rep_batch_recs);
+    logmsgf(LOGMSG_USER, out, "batch bytes raw: %" PRId64 "\n",
+            gbl_rep_batch_raw_bytes);
+    logmsgf(LOGMSG_USER, out, "batch bytes sent: %" PRId64 "\n",
+            gbl_rep_batch_sent_bytes);
+    logmsgf(LOGMSG_USER, out, "prefetch records: %" PRId64 "\n",
+            gbl_rep_prefetch_recs);
+    logmsgf(LOGMSG_USER, out, "prefetch pages read: %" PRId64 "\n",
+            gbl_rep_prefetch_pages);
+    logmsgf(LOGMSG_USER, out, "prefetch dropped: %" PRId64 "\n",
+            gbl_rep_prefetch_dropped);
+    if (gbl_rep_batch_msgs && gbl_rep_batch_sent_bytes) {
+        logmsgf(LOGMSG_USER, out, "batch records per batch: %.1f\n",
+                (double)gbl_rep_batch_recs / gbl_rep_batch_msgs);
+        logmsgf(LOGMSG_USER, out, "batch compression ratio: %.2f\n",
+                (double)gbl_rep_batch_raw_bytes / gbl_rep_batch_sent_bytes);
+    }
     prn_lstat(lc_cache_hits);
     prn_lstat(lc_cache_misses);
     prn_stat(lc_cache_size);
@@ -577,6 +662,16 @@ static void cache_stats(FILE *out, bdb_state_type *bdb_state, int extra)
     prn_lstat(st_alloc_max_pages);
     prn_lstat(st_ckp_pages_sync);
     prn_lstat(st_ckp_pages_skip);
+    prn_lstat(st_cold_hit);
+    prn_lstat(st_hot_hit);
+    prn_lstat(st_promote);
+    prn_lstat(st_cold_evict);
+    prn_lstat(st_hot_evict);
+    prn_lstat(st_ccache_pages);
+    prn_lstat(st_ccache_bytes);
+    prn_lstat(st_ccache_hit);
+    prn_lstat(st_ccache_miss);
+    prn_lstat(st_ccache_evict);
 
     if (extra) {
         bdb_state->dbenv->memp_dump_region(bdb_state->dbenv, "A", out);
@@ -595,6 +690,23 @@ static void cache_stats(FILE *out, bdb_state_type *bdb_state, int extra)
             logmsgf(LOGMSG_USER, out, "  st_page_create: %"PRId64"\n", (*i)->st_page_create);
             logmsgf(LOGMSG_USER, out, "  st_page_in    : %"PRId64"\n", (*i)->st_page_in);
             logmsgf(LOGMSG_USER, out, "  st_page_out   : %"PRId64"\n", (*i)->st_page_out);
+            logmsgf(LOGMSG_USER, out, "  st_flush_writes: %"PRId64"\n", (*i)->st_flush_writes);
+            logmsgf(LOGMSG_USER, out, "  st_flush_usecs: %"PRId64"\n", (*i)->st_flush_usecs);
+            logmsgf(LOGMSG_USER, out, "  st_flush_max_usecs: %"PRId64"\n", (*i)->st_flush_max_usecs);
+            if ((*i)->st_flush_writes > 0 && (*i)->st_flush_usecs > 0) {
+                logmsgf(LOGMSG_USER, out, "  flush avg usecs: %"PRId64"\n",
+                        (*i)->st_flush_usecs / (*i)->st_flush_writes);
+                logmsgf(LOGMSG_USER, out, "  flush MB/sec  : %.2f\n",
+                        (double)(*i)->st_page_out * (*i)->st_pagesize /
+                            (*i)->st_flush_usecs);
+            }
+            logmsgf(LOGMSG_USER, out, "  st_ccache_hit : %"PRId64"\n", (*i)->st_ccache_hit);
+            logmsgf(LOGMSG_USER, out, "  st_ccache_miss: %"PRId64"\n", (*i)->st_ccache_miss);
+            logmsgf(LOGMSG_USER, out, "  st_ccache_put : %"PRId64"\n", (*i)->st_ccache_put);
+            if ((*i)->st_ccache_bytes_out > 0)
+                logmsgf(LOGMSG_USER, out, "  ccache ratio  : %.2f\n",
+                        (double)(*i)->st_ccache_bytes_in /
+                            (*i)->st_ccache_bytes_out);
         }
 
         free(fsp);
@@ -1441,6 +1553,11 @@ void bdb_process_user_command(bdb_state_type *bdb_state, char *line, int lline,
         cache_info(out, bdb_state);
     else if (tokcmp(tok, ltok, "cachestatall") == 0)
         cache_stats(out, bdb_state, 1);
+    else if (tokcmp(tok, ltok, "lrufastforward") == 0) {
+        //@send bdb lrufastforward
+        __memp_lru_fastforward(bdb_state->dbenv);
+        logmsg(LOGMSG_USER, "Moved cache LRU counters up to their reset\n");
+    }
     else if (tokcmp(tok, ltok, "repstat") == 0)
         rep_stats(out, bdb_state);
     else if (tokcmp(tok, ltok, "bdbstate") == 0)
@@ -1634,6 +1751,10 @@ void bdb_process_user_command(bdb_state_type *bdb_state, char *line, int lline,
 
         bdb_temp_table_insert_test(bdb_state, recsz, maxins);
     } 
+    else if (tokcmp(tok, ltok, "temptblspilltest") == 0) {
+        //@send bdb temptblspilltest
+        bdb_temp_table_spill_test(bdb_state);
+    }
     else if (tokcmp(tok, ltok, "reptrcy") == 0) {
         logmsg(LOGMSG_USER, "turning on replication trace\n");
         bdb_state->rep_trace = 1;
@@ -167,7 +167,9 @@ typedef enum {
     LLMETA_SCHEMACHANGE_STATUS = 50,
     LLMETA_VIEW = 51,                 /* User defined views */
     LLMETA_SCHEMACHANGE_HISTORY = 52, /* 52 + SEED[8] */
-    LLMETA_SEQUENCE_VALUE = 53
+    LLMETA_SEQUENCE_VALUE = 53,
+    LLMETA_SC_SPOOLED_KEYS = 54 /* 54 + TABLENAME[32]: a schema change spools
+                                   its index keys */
 } llmetakey_t;
 
 struct llmeta_file_type_key {
@@ -6695,6 +6697,22 @@ int bdb_llmeta_print_record(bdb_state_type *bdb_state, void *key, int keylen,
         logmsg(LOGMSG_USER, "LLMETA_SC_START_LSN: table=\"%s\" [%u:%u]\n",
                akey.dbname, adata.lsn.file, adata.lsn.offset);
     } break;
+    case LLMETA_SC_SPOOLED_KEYS: {
+        struct llmeta_schema_change_type akey;
+
+        if (keylen < sizeof(akey)) {
+            logmsg(LOGMSG_USER, "%s:%d: wrong LLMETA_SC_SPOOLED_KEYS entry\n",
+                   __FILE__, __LINE__);
+            *bdberr = BDBERR_MISC;
+            return -1;
+        }
+
+        p_buf_key =
+            llmeta_schema_change_type_get(&akey, p_buf_key, p_buf_end_key);
+
+        logmsg(LOGMSG_USER, "LLMETA_SC_SPOOLED_KEYS: table=\"%s\"\n",
+               akey.dbname);
+    } break;
     case LLMETA_TABLE_USER_READ:
     case LLMETA_TABLE_USER_WRITE: {
         struct llmeta_tbl_access akey;
@@ -10231,6 +10249,137 @@ done:
     return rc;
 }
 
+static int sc_spooled_keys_key(const char *table, char *key, int *bdberr)
+{
+    struct llmeta_schema_change_type schema_change;
+    uint8_t *p_buf = (uint8_t *)key, *p_buf_end = (p_buf + LLMETA_IXLEN);
+
+    schema_change.file_type = LLMETA_SC_SPOOLED_KEYS;
+    /*copy the table name and check its length so that we have a clean key*/
+    strncpy0(schema_change.dbname, table, sizeof(schema_change.dbname));
+    schema_change.dbname_len = strlen(schema_change.dbname) + 1;
+
+    if (!(llmeta_schema_change_type_put(&(schema_change), p_buf, p_buf_end))) {
+        logmsg(LOGMSG_ERROR, "%s: llmeta_schema_change_type_put returns NULL\n",
+               __func__);
+        logmsg(LOGMSG_ERROR, "%s: check the length of table: %s\n", __func__,
+               table);
+        *bdberr = BDBERR_BADARGS;
+        return -1;
+    }
+    return 0;
+}
+
+/* Returns 1 if the schema change on table has spooled index keys, 0 if not,
+   -1 on error. */
+int bdb_get_sc_spooled_keys(tran_type *tran, const char *table, int *bdberr)
+{
+    int rc, fndlen, spooled;
+    char key[LLMETA_IXLEN] = {0};
+
+    *bdberr = BDBERR_NOERROR;
+
+    if (sc_spooled_keys_key(table, key, bdberr))
+        return -1;
+
+    rc = bdb_lite_exact_fetch_tran(llmeta_bdb_state, tran, key, &spooled,
+                                   sizeof(spooled), &fndlen, bdberr);
+    if (rc == 0)
+        return 1;
+    if (*bdberr == BDBERR_FETCH_DTA) {
+        *bdberr = BDBERR_NOERROR;
+        return 0;
+    }
+    return -1;
+}
+
+/* Mark the schema change on table as spooling its index keys: it can't be
+   resumed, the keys it spooled being lost with the process. */
+int bdb_set_sc_spooled_keys(tran_type *tran, const char *table, int *bdberr)
+{
+    int rc;
+    int started_our_own_transaction = 0;
+    char key[LLMETA_IXLEN] = {0};
+    int spooled = htonl(1);
+
+    *bdberr = BDBERR_NOERROR;
+
+    if (sc_spooled_keys_key(table, key, bdberr))
+        return -1;
+
+    if (tran == NULL) {
+        started_our_own_transaction = 1;
+        tran = bdb_tran_begin(llmeta_bdb_state->parent, NULL, bdberr);
+        if (tran == NULL) {
+            logmsg(LOGMSG_ERROR, "%s: bdb_tran_begin returns NULL\n", __func__);
+            return -1;
+        }
+    }
+
+    rc = bdb_get_sc_spooled_keys(tran, table, bdberr);
+    if (rc == 0)
+        rc = bdb_lite_add(llmeta_bdb_state, tran, &spooled, sizeof(spooled),
+                          key, bdberr);
+    else if (rc == 1)
+        rc = 0;
+    if (rc || *bdberr) {
+        logmsg(LOGMSG_ERROR, "%s:%d failed with rc %d bdberr %d\n", __func__,
+               __LINE__, rc, *bdberr);
+        if (rc == 0)
+            rc = -1;
+    }
+
+    if (started_our_own_transaction) {
+        if (rc == 0)
+            rc = bdb_tran_commit(llmeta_bdb_state->parent, tran, bdberr);
+        else {
+            int arc;
+            arc = bdb_tran_abort(llmeta_bdb_state->parent, tran, bdberr);
+            if (arc)
+                rc = arc;
+        }
+    }
+    return rc;
+}
+
+int bdb_delete_sc_spooled_keys(tran_type *tran, const char *table,
+                               int *bdberr)
+{
+    int rc;
+    int started_our_own_transaction = 0;
+    char key[LLMETA_IXLEN] = {0};
+
+    *bdberr = BDBERR_NOERROR;
+
+    if (sc_spooled_keys_key(table, key, bdberr))
+        return -1;
+
+    if (tran == NULL) {
+        started_our_own_transaction = 1;
+        tran = bdb_tran_begin(llmeta_bdb_state->parent, NULL, bdberr);
+        if (tran == NULL)
+            return -1;
+    }
+
+    rc = bdb_lite_exact_del(llmeta_bdb_state, tran, key, bdberr);
+    if (*bdberr == BDBERR_DEL_DTA) {
+        rc = 0;
+        *bdberr = BDBERR_NOERROR;
+    }
+
+    if (started_our_own_transaction) {
+        if (rc == 0)
+            rc = bdb_tran_commit(llmeta_bdb_state->parent, tran, bdberr);
+        else {
+            int arc;
+            arc = bdb_tran_abort(llmeta_bdb_state->parent, tran, bdberr);
+            if (arc)
+                rc = arc;
+        }
+    }
+    return rc;
+}
+
 /* View key */
 struct llmeta_view_key {
     int file_type;
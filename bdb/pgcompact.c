@@ -0,0 +1,461 @@
+/*
+   Copyright 2026 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * Background page compaction.
+ *
+ * Otherwise pages are only compacted when a replicant happens to read a
+ * sparse leaf.  After a bulk delete, whole ranges of a btree are left
+ * sparse, and scans read several times the pages they need until the table
+ * is rebuilt.  On the master, this thread sweeps btrees a range of leaves at
+ * a time, starting with those that were least full when last swept, records
+ * how full they are, and compacts the ranges that are sparse.  It keeps to
+ * a budget of pages read and bytes logged per second.
+ */
+
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bdb_int.h"
+#include "locks.h"
+#include <locks_wrap.h>
+#include <epochlib.h>
+#include <plhash.h>
+#include "logmsg.h"
+#include "thrman.h"
+
+#include <build/db_int.h>
+#include "dbinc/log.h"
+
+/* If set, the master compacts sparse ranges of btrees in the background. */
+int gbl_pgcompact_sched = 0;
+/* Compact ranges of leaves that are on average less full than this. */
+int gbl_pgcompact_sched_range_pct = 50;
+/* Read at most this many pages a second. */
+int gbl_pgcompact_sched_pages_per_sec = 1000;
+/* Log at most this many bytes a second compacting pages. */
+int gbl_pgcompact_sched_logbytes_per_sec = 1048576;
+/* Sweep a btree again this long after its last sweep. */
+int gbl_pgcompact_sched_rescan_secs = 3600;
+
+extern double gbl_pg_compact_target_ff;
+extern int db_is_exiting(void);
+
+#define PGCOMPACT_RANGE_PAGES 64
+#define PGCOMPACT_RANGE_KEYS 16
+
+struct pgcompact_key {
+    char table[MAXTABLELEN];
+    int dtanum; /* -1 for an index */
+    int ixnum;  /* -1 for a data or blob file */
+    int stripe;
+};
+
+struct pgcompact_btree {
+    struct pgcompact_key key;
+    int seen;
+
+    DBT next; /* first key of the next range, allocated by berkdb; empty to
+                 start the sweep over */
+    time_t sweep_done; /* when the last sweep ended */
+    u_int32_t pgsize;
+
+    /* So far in this sweep. */
+    uint64_t sweep_pages;
+    uint64_t sweep_free;
+
+    /* In the last complete sweep. */
+    uint64_t leaf_pages;
+    uint64_t leaf_free;
+
+    uint64_t ranges_compacted;
+    uint64_t pages_merged;
+    uint64_t logbytes;
+};
+
+static pthread_mutex_t pgcompact_lk = PTHREAD_MUTEX_INITIALIZER;
+static hash_t *pgcompact_btrees;
+static int pgcompact_gen;
+
+static void pgcompact_free_dbt(bdb_state_type *bdb_state, DBT *dbt)
+{
+    if (dbt->data != NULL)
+        __os_free(bdb_state->dbenv, dbt->data);
+    memset(dbt, 0, sizeof(*dbt));
+}
+
+static double pgcompact_fill(const struct pgcompact_btree *b)
+{
+    uint64_t pages, nfree;
+
+    if (b->leaf_pages != 0) {
+        pages = b->leaf_pages;
+        nfree = b->leaf_free;
+    } else {
+        pages = b->sweep_pages;
+        nfree = b->sweep_free;
+    }
+    if (pages == 0)
+        return 0;
+    return 1 - (double)nfree / (pages * (b->pgsize - SIZEOF_PAGE));
+}
+
+static void pgcompact_see(const char *table, int dtanum, int ixnum,
+                          int stripe)
+{
+    struct pgcompact_key key = {{0}};
+    struct pgcompact_btree *b;
+
+    strncpy(key.table, table, sizeof(key.table) - 1);
+    key.dtanum = dtanum;
+    key.ixnum = ixnum;
+    key.stripe = stripe;
+
+    if ((b = hash_find(pgcompact_btrees, &key)) == NULL) {
+        if ((b = calloc(1, sizeof(struct pgcompact_btree))) == NULL)
+            return;
+        b->key = key;
+        hash_add(pgcompact_btrees, b);
+    }
+    b->seen = pgcompact_gen;
+}
+
+/* Bring the set of btrees up to date with the tables that are open. */
+static void pgcompact_refresh(bdb_state_type *bdb_state)
+{
+    struct pgcompact_btree *b, **stale;
+    bdb_state_type *child;
+    unsigned int bkt;
+    void *ent;
+    int i, j, k, n;
+
+    if (pgcompact_btrees == NULL)
+        pgcompact_btrees = hash_init_o(
+            offsetof(struct pgcompact_btree, key), sizeof(struct pgcompact_key));
+    ++pgcompact_gen;
+
+    for (i = 0; i < bdb_state->numchildren; i++) {
+        child = bdb_state->children[i];
+        if (child == NULL || child->bdbtype != BDBTYPE_TABLE)
+            continue;
+        for (j = 0; j < child->numdtafiles; j++)
+            for (k = 0; k < bdb_get_datafile_num_files(child, j); k++)
+                pgcompact_see(child->name, j, -1, k);
+        for (j = 0; j < child->numix; j++)
+            pgcompact_see(child->name, -1, j, 0);
+    }
+
+    n = 0;
+    stale = malloc(hash_get_num_entries(pgcompact_btrees) * sizeof(*stale));
+    if (stale == NULL)
+        return;
+    for (b = hash_first(pgcompact_btrees, &ent, &bkt); b;
+         b = hash_next(pgcompact_btrees, &ent, &bkt))
+        if (b->seen != pgcompact_gen)
+            stale[n++] = b;
+    for (i = 0; i < n; i++) {
+        hash_del(pgcompact_btrees, stale[i]);
+        pgcompact_free_dbt(bdb_state, &stale[i]->next);
+        free(stale[i]);
+    }
+    free(stale);
+}
+
+/* Return the least full btree that is due a sweep. */
+static struct pgcompact_btree *pgcompact_pick(bdb_state_type *bdb_state)
+{
+    struct pgcompact_btree *b, *best;
+    double fill, bestfill;
+    unsigned int bkt;
+    time_t now;
+    void *ent;
+
+    Pthread_mutex_lock(&pgcompact_lk);
+    pgcompact_refresh(bdb_state);
+
+    best = NULL;
+    bestfill = 0;
+    now = time(NULL);
+    for (b = hash_first(pgcompact_btrees, &ent, &bkt); b;
+         b = hash_next(pgcompact_btrees, &ent, &bkt)) {
+        if (b->sweep_done != 0 && b->sweep_pages == 0 &&
+            now - b->sweep_done < gbl_pgcompact_sched_rescan_secs)
+            continue;
+        fill = b->leaf_pages ? pgcompact_fill(b) : 0;
+        if (best == NULL || fill < bestfill) {
+            best = b;
+            bestfill = fill;
+        }
+    }
+    Pthread_mutex_unlock(&pgcompact_lk);
+    return best;
+}
+
+static DB *pgcompact_dbp(bdb_state_type *bdb_state,
+                         const struct pgcompact_key *key)
+{
+    bdb_state_type *child;
+    int i;
+
+    for (i = 0; i < bdb_state->numchildren; i++) {
+        child = bdb_state->children[i];
+        if (child == NULL || child->bdbtype != BDBTYPE_TABLE ||
+            strcmp(child->name, key->table) != 0)
+            continue;
+        if (key->ixnum >= 0)
+            return key->ixnum < child->numix ? child->dbp_ix[key->ixnum]
+                                             : NULL;
+        if (key->dtanum < child->numdtafiles &&
+            key->stripe < bdb_get_datafile_num_files(child, key->dtanum))
+            return child->dbp_data[key->dtanum][key->stripe];
+        return NULL;
+    }
+    return NULL;
+}
+
+static int32_t pgcompact_fileid(DB *dbp)
+{
+    if (dbp == NULL || dbp->log_filename == NULL)
+        return DB_LOGFILEID_INVALID;
+    return dbp->log_filename->id;
+}
+
+/* Sleep off what was just read and logged, at the configured rates. */
+static void pgcompact_throttle(uint64_t pages, uint64_t logbytes)
+{
+    static int64_t last_ms, owed_pages, owed_bytes;
+    int64_t now, elapsed, wait_ms;
+    int pps, lbps;
+
+    pps = gbl_pgcompact_sched_pages_per_sec;
+    lbps = gbl_pgcompact_sched_logbytes_per_sec;
+
+    now = comdb2_time_epochms();
+    elapsed = last_ms ? now - last_ms : 0;
+    last_ms = now;
+
+    wait_ms = 0;
+    if (pps > 0) {
+        owed_pages += (int64_t)pages - elapsed * pps / 1000;
+        if (owed_pages < 0)
+            owed_pages = 0;
+        wait_ms = owed_pages * 1000 / pps;
+    } else
+        owed_pages = 0;
+    if (lbps > 0) {
+        owed_bytes += (int64_t)logbytes - elapsed * lbps / 1000;
+        if (owed_bytes < 0)
+            owed_bytes = 0;
+        if (owed_bytes * 1000 / lbps > wait_ms)
+            wait_ms = owed_bytes * 1000 / lbps;
+    } else
+        owed_bytes = 0;
+
+    if (wait_ms == 0)
+        return;
+    while (wait_ms > 0 && !db_is_exiting()) {
+        poll(0, 0, wait_ms > 100 ? 100 : wait_ms);
+        wait_ms -= 100;
+    }
+    owed_pages = owed_bytes = 0;
+    last_ms = comdb2_time_epochms();
+}
+
+/*
+ * Sample the next range of a btree, and compact it if it is sparse.  Returns
+ * non-0 once the sweep of the btree is over.
+ */
+static int pgcompact_range(bdb_state_type *bdb_state,
+                           struct pgcompact_btree *b)
+{
+    DBT keys[PGCOMPACT_RANGE_KEYS], next;
+    u_int32_t nread, nkeys, npgs, i;
+    uint64_t nfree, logbytes, rangelog, rangepgs;
+    u_int32_t pgsize;
+    int32_t fileid;
+    double ff;
+    DB *dbp;
+    int rc;
+
+    ff = gbl_pg_compact_target_ff;
+    memset(keys, 0, sizeof(keys));
+    memset(&next, 0, sizeof(next));
+    nkeys = PGCOMPACT_RANGE_KEYS;
+    nread = 0;
+    nfree = 0;
+
+    BDB_READLOCK("pgcompact_range");
+    dbp = pgcompact_dbp(bdb_state, &b->key);
+    if ((fileid = pgcompact_fileid(dbp)) == DB_LOGFILEID_INVALID) {
+        BDB_RELLOCK();
+        return 1;
+    }
+    pgsize = dbp->pgsize;
+    rc = __dbenv_pgcompact_scan(bdb_state->dbenv, fileid, &b->next,
+                                PGCOMPACT_RANGE_PAGES, ff, &nread, &nfree,
+                                keys, &nkeys, &next);
+    BDB_RELLOCK();
+
+    if (rc == DB_LOCK_DEADLOCK) {
+        /* Try the range again. */
+        for (i = 0; i < PGCOMPACT_RANGE_KEYS; i++)
+            pgcompact_free_dbt(bdb_state, &keys[i]);
+        pgcompact_free_dbt(bdb_state, &next);
+        pgcompact_throttle(nread, 0);
+        return 0;
+    }
+
+    rangepgs = 0;
+    rangelog = 0;
+    if (rc == 0 && nread != 0 && nkeys != 0 &&
+        1 - (double)nfree / (nread * (pgsize - SIZEOF_PAGE)) <
+            gbl_pgcompact_sched_range_pct / 100.0) {
+        for (i = 0; i < nkeys && !db_is_exiting(); i++) {
+            npgs = 0;
+            logbytes = 0;
+            /* Make sure the file wasn't swapped out under us. */
+            BDB_READLOCK("pgcompact_range");
+            if (pgcompact_fileid(pgcompact_dbp(bdb_state, &b->key)) == fileid)
+                __dbenv_pgcompact(bdb_state->dbenv, fileid, &keys[i], ff, ff,
+                                  &npgs, &logbytes);
+            BDB_RELLOCK();
+            rangepgs += npgs;
+            rangelog += logbytes;
+            pgcompact_throttle(npgs, logbytes);
+        }
+    }
+
+    Pthread_mutex_lock(&pgcompact_lk);
+    pgcompact_free_dbt(bdb_state, &b->next);
+    b->next = next;
+    b->pgsize = pgsize;
+    b->sweep_pages += nread;
+    b->sweep_free += nfree;
+    if (rangepgs != 0)
+        ++b->ranges_compacted;
+    b->pages_merged += rangepgs;
+    b->logbytes += rangelog;
+    if (rc != 0 || next.size == 0) {
+        if (rc == 0) {
+            b->leaf_pages = b->sweep_pages;
+            b->leaf_free = b->sweep_free;
+        }
+        pgcompact_free_dbt(bdb_state, &b->next);
+        b->sweep_pages = b->sweep_free = 0;
+        b->sweep_done = time(NULL);
+    }
+    Pthread_mutex_unlock(&pgcompact_lk);
+
+    for (i = 0; i < PGCOMPACT_RANGE_KEYS; i++)
+        pgcompact_free_dbt(bdb_state, &keys[i]);
+
+    if (rc != 0)
+        logmsg(LOGMSG_DEBUG, "%s: scan of %s failed rc %d\n", __func__,
+               b->key.table, rc);
+
+    pgcompact_throttle(nread, 0);
+    return rc != 0 || next.size == 0;
+}
+
+void *pgcompact_sched_thread(void *arg)
+{
+    bdb_state_type *bdb_state = (bdb_state_type *)arg;
+    struct pgcompact_btree *b;
+
+    if (bdb_state->parent)
+        bdb_state = bdb_state->parent;
+
+    while (!bdb_state->after_llmeta_init_done)
+        sleep(1);
+
+    thrman_register(THRTYPE_GENERIC);
+    thread_started("bdb pgcompact");
+
+    bdb_thread_event(bdb_state, 1);
+
+    b = NULL;
+    while (!db_is_exiting()) {
+        if (!gbl_pgcompact_sched || !bdb_amimaster(bdb_state)) {
+            b = NULL;
+            sleep(1);
+            continue;
+        }
+
+        if (b == NULL) {
+            BDB_READLOCK("pgcompact_sched_thread");
+            b = pgcompact_pick(bdb_state);
+            BDB_RELLOCK();
+            if (b == NULL) {
+                sleep(1);
+                continue;
+            }
+        }
+
+        if (pgcompact_range(bdb_state, b))
+            b = NULL;
+    }
+
+    bdb_thread_event(bdb_state, 0);
+    logmsg(LOGMSG_DEBUG, "pgcompact_sched_thread: exiting\n");
+    return NULL;
+}
+
+int bdb_get_pgcompact_stats(struct bdb_pgcompact_stat **stats_out,
+                            int *nstats_out)
+{
+    struct bdb_pgcompact_stat *stats, *s;
+    struct pgcompact_btree *b;
+    unsigned int bkt;
+    void *ent;
+    int n;
+
+    *stats_out = NULL;
+    *nstats_out = 0;
+
+    Pthread_mutex_lock(&pgcompact_lk);
+    if (pgcompact_btrees == NULL ||
+        (n = hash_get_num_entries(pgcompact_btrees)) == 0) {
+        Pthread_mutex_unlock(&pgcompact_lk);
+        return 0;
+    }
+    if ((stats = calloc(n, sizeof(struct bdb_pgcompact_stat))) == NULL) {
+        Pthread_mutex_unlock(&pgcompact_lk);
+        return ENOMEM;
+    }
+    s = stats;
+    for (b = hash_first(pgcompact_btrees, &ent, &bkt); b;
+         b = hash_next(pgcompact_btrees, &ent, &bkt), s++) {
+        strcpy(s->table, b->key.table);
+        s->dtanum = b->key.dtanum;
+        s->ixnum = b->key.ixnum;
+        s->stripe = b->key.stripe;
+        s->leaf_pages = b->leaf_pages ? b->leaf_pages : b->sweep_pages;
+        s->fill_pct = 100 * pgcompact_fill(b);
+        s->ranges_compacted = b->ranges_compacted;
+        s->pages_merged = b->pages_merged;
+        s->bytes_reclaimed = b->pages_merged * b->pgsize;
+        s->logbytes = b->logbytes;
+    }
+    Pthread_mutex_unlock(&pgcompact_lk);
+
+    *stats_out = stats;
+    *nstats_out = n;
+    return 0;
+}
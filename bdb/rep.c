@@ -48,6 +48,12 @@
 #include "str0.h"
 #include <thrman.h>
 
+#include <lz4.h>
+
+#if LZ4_VERSION_NUMBER < 10701
+#define LZ4_compress_default LZ4_compress_limitedOutput
+#endif
+
 #define REP_PRI 100     /* we are all equal in the eyes of god */
 #define REPTIME 3000000 /* default 3 second timeout on election */
 
@@ -223,6 +229,66 @@ static const uint8_t *rep_type_berkdb_rep_seqnum_get(
     return p_buf;
 }
 
+/* A USER_TYPE_BERKDB_REP_BATCH message is this header followed by nrecs
+   records, each a length and then exactly what USER_TYPE_BERKDB_REP would
+   have carried.  If REP_BATCH_LZ4 is set the records are compressed and
+   rawlen is their uncompressed size. */
+struct rep_type_berkdb_rep_batch_hdr {
+    int nrecs;
+    int flags;
+    int rawlen;
+};
+
+enum { REP_TYPE_BERKDB_REP_BATCH_HDR_LEN = 4 + 4 + 4 };
+
+enum { REP_BATCH_LZ4 = 0x1 };
+
+BB_COMPILE_TIME_ASSERT(rep_type_berkdb_rep_batch_hdr,
+                       sizeof(struct rep_type_berkdb_rep_batch_hdr) ==
+                           REP_TYPE_BERKDB_REP_BATCH_HDR_LEN);
+
+static uint8_t *rep_type_berkdb_rep_batch_hdr_put(
+    const struct rep_type_berkdb_rep_batch_hdr *p_rep_type_berkdb_rep_batch_hdr,
+    uint8_t *p_buf, const uint8_t *p_buf_end)
+{
+    if (p_buf_end < p_buf ||
+        REP_TYPE_BERKDB_REP_BATCH_HDR_LEN > (p_buf_end - p_buf))
+        return NULL;
+
+    p_buf = buf_put(&(p_rep_type_berkdb_rep_batch_hdr->nrecs),
+                    sizeof(p_rep_type_berkdb_rep_batch_hdr->nrecs), p_buf,
+                    p_buf_end);
+    p_buf = buf_put(&(p_rep_type_berkdb_rep_batch_hdr->flags),
+                    sizeof(p_rep_type_berkdb_rep_batch_hdr->flags), p_buf,
+                    p_buf_end);
+    p_buf = buf_put(&(p_rep_type_berkdb_rep_batch_hdr->rawlen),
+                    sizeof(p_rep_type_berkdb_rep_batch_hdr->rawlen), p_buf,
+                    p_buf_end);
+
+    return p_buf;
+}
+
+static const uint8_t *rep_type_berkdb_rep_batch_hdr_get(
+    struct rep_type_berkdb_rep_batch_hdr *p_rep_type_berkdb_rep_batch_hdr,
+    const uint8_t *p_buf, const uint8_t *p_buf_end)
+{
+    if (p_buf_end < p_buf ||
+        REP_TYPE_BERKDB_REP_BATCH_HDR_LEN > (p_buf_end - p_buf))
+        return NULL;
+
+    p_buf = buf_get(&(p_rep_type_berkdb_rep_batch_hdr->nrecs),
+                    sizeof(p_rep_type_berkdb_rep_batch_hdr->nrecs), p_buf,
+                    p_buf_end);
+    p_buf = buf_get(&(p_rep_type_berkdb_rep_batch_hdr->flags),
+                    sizeof(p_rep_type_berkdb_rep_batch_hdr->flags), p_buf,
+                    p_buf_end);
+    p_buf = buf_get(&(p_rep_type_berkdb_rep_batch_hdr->rawlen),
+                    sizeof(p_rep_type_berkdb_rep_batch_hdr->rawlen), p_buf,
+                    p_buf_end);
+
+    return p_buf;
+}
+
 uint8_t *rep_berkdb_seqnum_type_put(const seqnum_type *p_seqnum_type,
                                     uint8_t *p_buf, const uint8_t *p_buf_end)
 {
@@ -699,6 +765,156 @@ void rep_reset_send_bytecount(void) { bytecount = 0; }
 
 extern int gbl_decoupled_logputs;
 
+/* Broadcast logputs are packed into batches of up to this many bytes.  A
+   batch goes out when it's full, with any record that can't wait, and
+   ahead of every other replication message.  0 sends each record on its
+   own. */
+int gbl_rep_batch_bytes = 0;
+
+/* Batches at least this big are compressed with LZ4.  0 never compresses. */
+int gbl_rep_batch_compress_bytes = 4096;
+
+int64_t gbl_rep_batch_msgs = 0;
+int64_t gbl_rep_batch_recs = 0;
+int64_t gbl_rep_batch_raw_bytes = 0;
+int64_t gbl_rep_batch_sent_bytes = 0;
+
+static struct {
+    pthread_mutex_t lk;
+    uint8_t *buf; /* room for the header, then the records */
+    int len;
+    int cap;
+    int nrecs;
+    int flags; /* net flags of every record in the batch */
+    uint8_t *zbuf;
+    int zcap;
+} rep_batch = {.lk = PTHREAD_MUTEX_INITIALIZER};
+
+/* Send the batch; rep_batch.lk must be held.  It stays held across the send
+   so that batches leave in the order they were filled. */
+static int rep_batch_send(bdb_state_type *bdb_state)
+{
+    struct rep_type_berkdb_rep_batch_hdr hdr = {0};
+    uint8_t *msg;
+    int msglen, need, type, zlen, rc;
+
+    if (rep_batch.nrecs == 0)
+        return 0;
+
+    hdr.nrecs = rep_batch.nrecs;
+    hdr.rawlen = rep_batch.len - REP_TYPE_BERKDB_REP_BATCH_HDR_LEN;
+    msg = rep_batch.buf;
+    msglen = rep_batch.len;
+
+    if (gbl_rep_batch_compress_bytes > 0 &&
+        hdr.rawlen >= gbl_rep_batch_compress_bytes) {
+        need = REP_TYPE_BERKDB_REP_BATCH_HDR_LEN + LZ4_compressBound(hdr.rawlen);
+        if (need > rep_batch.zcap) {
+            free(rep_batch.zbuf);
+            rep_batch.zbuf = malloc(need);
+            rep_batch.zcap = rep_batch.zbuf ? need : 0;
+        }
+        if (rep_batch.zbuf) {
+            zlen = LZ4_compress_default(
+                (char *)rep_batch.buf + REP_TYPE_BERKDB_REP_BATCH_HDR_LEN,
+                (char *)rep_batch.zbuf + REP_TYPE_BERKDB_REP_BATCH_HDR_LEN,
+                hdr.rawlen, need - REP_TYPE_BERKDB_REP_BATCH_HDR_LEN);
+            if (zlen > 0 && zlen < hdr.rawlen) {
+                hdr.flags |= REP_BATCH_LZ4;
+                msg = rep_batch.zbuf;
+                msglen = REP_TYPE_BERKDB_REP_BATCH_HDR_LEN + zlen;
+            }
+        }
+    }
+
+    rep_type_berkdb_rep_batch_hdr_put(&hdr, msg,
+                                      msg + REP_TYPE_BERKDB_REP_BATCH_HDR_LEN);
+
+    type = USER_TYPE_BERKDB_REP_BATCH;
+    rc = net_send_all(bdb_state->repinfo->netinfo, 1, (void **)&msg, &msglen,
+                      &type, &rep_batch.flags);
+
+    gbl_rep_batch_msgs++;
+    gbl_rep_batch_recs += hdr.nrecs;
+    gbl_rep_batch_raw_bytes += hdr.rawlen;
+    gbl_rep_batch_sent_bytes += msglen;
+
+    rep_batch.len = REP_TYPE_BERKDB_REP_BATCH_HDR_LEN;
+    rep_batch.nrecs = 0;
+    rep_batch.flags = 0;
+
+    /* Don't hang on to what one huge record needed. */
+    if (rep_batch.cap > 4 * (gbl_rep_batch_bytes + 65536)) {
+        free(rep_batch.buf);
+        free(rep_batch.zbuf);
+        rep_batch.buf = rep_batch.zbuf = NULL;
+        rep_batch.len = rep_batch.cap = rep_batch.zcap = 0;
+    }
+
+    return rc;
+}
+
+/* Add a packed USER_TYPE_BERKDB_REP message to the batch, sending the batch
+   if it's full or the message can't wait. */
+static int rep_batch_add(bdb_state_type *bdb_state, char *buf, int bufsz,
+                         int flags)
+{
+    uint8_t *p_buf, *newbuf;
+    int need, newcap, rc;
+
+    rc = 0;
+    Pthread_mutex_lock(&rep_batch.lk);
+
+    if (rep_batch.len == 0)
+        rep_batch.len = REP_TYPE_BERKDB_REP_BATCH_HDR_LEN;
+    need = rep_batch.len + sizeof(int) + bufsz;
+    if (need > rep_batch.cap) {
+        newcap = rep_batch.cap ? rep_batch.cap * 2
+                               : REP_TYPE_BERKDB_REP_BATCH_HDR_LEN +
+                                     gbl_rep_batch_bytes + 4096;
+        if (newcap < need)
+            newcap = need;
+        if ((newbuf = realloc(rep_batch.buf, newcap)) == NULL) {
+            /* Send what we have, and this record on its own. */
+            int type = USER_TYPE_BERKDB_REP;
+            rc = rep_batch_send(bdb_state);
+            if (net_send_all(bdb_state->repinfo->netinfo, 1, (void **)&buf,
+                             &bufsz, &type, &flags))
+                rc = 1;
+            Pthread_mutex_unlock(&rep_batch.lk);
+            return rc;
+        }
+        rep_batch.buf = newbuf;
+        rep_batch.cap = newcap;
+    }
+
+    p_buf = rep_batch.buf + rep_batch.len;
+    p_buf = buf_put(&bufsz, sizeof(bufsz), p_buf, rep_batch.buf + need);
+    memcpy(p_buf, buf, bufsz);
+    rep_batch.len = need;
+    rep_batch.nrecs++;
+    rep_batch.flags |= flags;
+
+    if ((flags & NET_SEND_NODELAY) ||
+        rep_batch.len - REP_TYPE_BERKDB_REP_BATCH_HDR_LEN >= gbl_rep_batch_bytes)
+        rc = rep_batch_send(bdb_state);
+
+    Pthread_mutex_unlock(&rep_batch.lk);
+    return rc;
+}
+
+/* Send any records waiting in the batch. */
+void bdb_rep_batch_flush(bdb_state_type *bdb_state)
+{
+    if (bdb_state->parent)
+        bdb_state = bdb_state->parent;
+
+    /* rep_batch_send returns early on an empty batch */
+    Pthread_mutex_lock(&rep_batch.lk);
+    rep_batch_send(bdb_state);
+    Pthread_mutex_unlock(&rep_batch.lk);
+}
+
 int berkdb_send_rtn(DB_ENV *dbenv, const DBT *control, const DBT *rec,
                     const DB_LSN *lsnp, char *host, uint32_t flags,
                     void *usr_ptr)
@@ -924,8 +1140,15 @@ int berkdb_send_rtn(DB_ENV *dbenv, const DBT *control, const DBT *rec,
             (bdb_state->attr->net_inorder_logputs ? NET_SEND_INORDER : 0) |
             (nodelay ? NET_SEND_NODELAY : 0) |
             (flags & DB_REP_TRACE ? NET_SEND_TRACE : 0);
-        ++num;
-        rc = net_send_all(bdb_state->repinfo->netinfo, num, data, sz, type, flag);
+        if (num == 0 && is_logput && gbl_rep_batch_bytes > 0 &&
+            !bdb_state->attr->net_inorder_logputs) {
+            rc = rep_batch_add(bdb_state, buf, bufsz, flag[num]);
+        } else {
+            ++num;
+            bdb_rep_batch_flush(bdb_state);
+            rc = net_send_all(bdb_state->repinfo->netinfo, num, data, sz, type,
+                              flag);
+        }
     } else {
         int tmpseq;
         uint8_t *p_seq_num = (uint8_t *)seqnum;
@@ -966,6 +1189,9 @@ int berkdb_send_rtn(DB_ENV *dbenv, const DBT *control, const DBT *rec,
             sendflags |= NET_SEND_TRACE;
         }
 
+        /* Anything batched was logged before this. */
+        bdb_rep_batch_flush(bdb_state);
+
         rc = net_send_flags(bdb_state->repinfo->netinfo, host,
                             USER_TYPE_BERKDB_REP, buf, bufsz, sendflags);
     }
@@ -4405,7 +4631,7 @@ static void pg_compact_do_work(struct thdpool *pool, void *work, void *thddata)
     dbt.size = arg->size;
 
     __dbenv_pgcompact(dbenv, fileid, &dbt, gbl_pg_compact_thresh,
-                      gbl_pg_compact_target_ff);
+                      gbl_pg_compact_target_ff, NULL, NULL);
 }
 
 /* thread pool work function */
@@ -5109,8 +5335,82 @@ static int berkdb_receive_rtn_int(void *ack_handle, void *usr_ptr,
     return outrc;
 }
 
+static void berkdb_receive_one(void *ack_handle, void *usr_ptr,
+                               char *from_host, int usertype, void *dta,
+                               int dtalen, uint8_t is_tcp);
+
+/* Unpack a USER_TYPE_BERKDB_REP_BATCH and apply its records in order, as if
+   each had arrived by itself. */
+static void berkdb_receive_batch(void *ack_handle, void *usr_ptr,
+                                 char *from_host, void *dta, int dtalen,
+                                 uint8_t is_tcp)
+{
+    struct rep_type_berkdb_rep_batch_hdr hdr = {0};
+    const uint8_t *p_buf, *p_buf_end;
+    uint8_t *raw = NULL;
+    int i, len;
+
+    p_buf = dta;
+    p_buf_end = (uint8_t *)dta + dtalen;
+
+    if ((p_buf = rep_type_berkdb_rep_batch_hdr_get(&hdr, p_buf, p_buf_end)) ==
+            NULL ||
+        hdr.nrecs < 0 || hdr.rawlen < 0) {
+        logmsg(LOGMSG_ERROR, "%s: bad batch header from %s\n", __func__,
+               from_host);
+        return;
+    }
+
+    if (hdr.flags & REP_BATCH_LZ4) {
+        if ((raw = malloc(hdr.rawlen)) == NULL) {
+            logmsg(LOGMSG_ERROR, "%s: can't allocate %d bytes\n", __func__,
+                   hdr.rawlen);
+            return;
+        }
+        if (LZ4_decompress_safe((const char *)p_buf, (char *)raw,
+                                p_buf_end - p_buf, hdr.rawlen) != hdr.rawlen) {
+            logmsg(LOGMSG_ERROR, "%s: corrupt batch from %s\n", __func__,
+                   from_host);
+            free(raw);
+            return;
+        }
+        p_buf = raw;
+        p_buf_end = raw + hdr.rawlen;
+    } else if (hdr.rawlen != p_buf_end - p_buf) {
+        logmsg(LOGMSG_ERROR, "%s: batch from %s is %d bytes, expected %d\n",
+               __func__, from_host, (int)(p_buf_end - p_buf), hdr.rawlen);
+        return;
+    }
+
+    for (i = 0; i < hdr.nrecs; i++) {
+        if ((p_buf = buf_get(&len, sizeof(len), p_buf, p_buf_end)) == NULL ||
+            len < 0 || len > p_buf_end - p_buf) {
+            logmsg(LOGMSG_ERROR, "%s: short batch from %s at record %d\n",
+                   __func__, from_host, i);
+            break;
+        }
+        berkdb_receive_one(ack_handle, usr_ptr, from_host, USER_TYPE_BERKDB_REP,
+                           (void *)p_buf, len, is_tcp);
+        p_buf += len;
+    }
+
+    free(raw);
+}
+
 void berkdb_receive_rtn(void *ack_handle, void *usr_ptr, char *from_host,
                         int usertype, void *dta, int dtalen, uint8_t is_tcp)
+{
+    if (usertype == USER_TYPE_BERKDB_REP_BATCH)
+        berkdb_receive_batch(ack_handle, usr_ptr, from_host, dta, dtalen,
+                             is_tcp);
+    else
+        berkdb_receive_one(ack_handle, usr_ptr, from_host, usertype, dta,
+                           dtalen, is_tcp);
+}
+
+static void berkdb_receive_one(void *ack_handle, void *usr_ptr,
+                               char *from_host, int usertype, void *dta,
+                               int dtalen, uint8_t is_tcp)
 {
     bdb_state_type *bdb_state;
     int rc;
@@ -146,12 +146,24 @@ struct temp_cursor {
     struct temp_list_node *list_cur;
     void *hash_cur;
     unsigned int hash_cur_buk;
+    int hash_part;
     LINKC_T(struct temp_cursor) lnk;
     int ind;
     int keymalloclen;
     int datamalloclen;
+    struct skl_node *skl_node;
+    int skl_gap; /* sitting between skl_node and its successor; once a
+                    btree, between two rows next to the one at cur
+                    (TMPCUR_GAP_AFTER or TMPCUR_GAP_BEFORE) */
+    int zerocopy; /* point key and data at the row instead of copying */
+    int borrowed; /* key and data belong to the table, not the cursor */
 };
 
+/* Where a cursor left between two rows by a skiplist spill sits, relative
+   to the row its berkdb cursor is on. */
+#define TMPCUR_GAP_AFTER 1
+#define TMPCUR_GAP_BEFORE 2
+
 typedef struct arr_elem {
     int keylen;
     int dtalen;
@@ -163,6 +175,14 @@ typedef struct arr_elem {
     do {                                                                       \
         arr_elem_t *elem = &(c)->tbl->elements[(c)->ind];                      \
         int keylen = elem->keylen, dtalen = elem->dtalen;                      \
+        if ((c)->zerocopy) {                                                   \
+            tmpcur_borrow_kv((c), elem->key, keylen, elem->dta, dtalen);       \
+            break;                                                             \
+        }                                                                      \
+        if ((c)->borrowed) {                                                   \
+            (c)->key = (c)->data = NULL;                                       \
+            (c)->borrowed = 0;                                                 \
+        }                                                                      \
         if ((c)->key == NULL || (c)->keymalloclen < keylen) {                  \
             (c)->key = malloc_resize((c)->key, keylen);                        \
             (c)->keymalloclen = keylen;                                        \
@@ -187,6 +207,51 @@ typedef struct arr_elem {
         (c)->valid = 1;                                                        \
     } while (0);
 
+/* A skiplist temptable keeps its rows in memory, in a skiplist whose nodes
+   are carved out of a chain of malloc'd chunks and are only given back when
+   the table is truncated. Once the chunks outgrow the cache size, the rows
+   are written out in key order to a berkdb temptable, which takes over from
+   there. Small and medium-sized tables never pay for a berkdb environment. */
+#define SKL_MAXHEIGHT 16
+#define TMPTBL_ARENA_CHUNK (64 * 1024)
+
+typedef struct skl_node {
+    struct skl_node *prev;
+    uint8_t *key;
+    uint8_t *dta;
+    int keylen;
+    int dtalen;
+    int height;
+    struct skl_node *next[/*height*/];
+} skl_node_t;
+
+struct tmptbl_arena {
+    struct tmptbl_arena *next;
+    size_t size;
+    size_t used;
+    uint8_t buf[/*size*/];
+};
+
+/* A hash temptable is split into partitions by key. When its rows outgrow
+   the cache size, whole partitions are written out, largest first, as
+   sequential runs to a file of their own, and a bloom filter of their keys
+   stays behind. Rows for a partition on disk are appended to its run. A
+   lookup that the bloom filter can't rule out, or a cursor stepping into
+   the partition, reads the run back in (first row for a key wins, as with
+   an insert) after pushing other partitions out. A table that keeps
+   reloading, or has a partition bigger than the cache, becomes a btree. */
+#define TMPTBL_HASH_NPARTS 16
+#define TMPTBL_HASH_MAX_RELOADS (4 * TMPTBL_HASH_NPARTS)
+
+struct temp_hash_part {
+    hash_t *h;
+    unsigned long long bytes; /* rows in memory */
+    FILE *run;
+    unsigned long long runbytes; /* rows on disk; bytes is 0 if any */
+    uint64_t *bloom;
+    uint32_t bloom_mask;
+};
+
 /* A temparray is a lightweight replacement of a temptable. It is simply
    a sorted array. If the number of elements is greater than a threshold,
    or the in-memory data size exceeds a pre-configured cache size,
@@ -197,7 +262,8 @@ enum {
     TEMP_TABLE_TYPE_BTREE,
     TEMP_TABLE_TYPE_HASH,
     TEMP_TABLE_TYPE_LIST,
-    TEMP_TABLE_TYPE_ARRAY
+    TEMP_TABLE_TYPE_ARRAY,
+    TEMP_TABLE_TYPE_SKIPLIST
 };
 
 struct temp_table {
@@ -206,7 +272,8 @@ struct temp_table {
     int temp_table_type;
     DB *tmpdb; /* in-memory table */
     LISTC_T(struct temp_list_node) temp_tbl_list;
-    hash_t *temp_hash_tbl;
+    struct temp_hash_part *hash_parts;
+    int hash_reloads;
 
     tmptbl_cmp cmpfunc;
     void *usermem;
@@ -223,6 +290,12 @@ struct temp_table {
     unsigned long long inmemsz;
     unsigned long long cachesz;
     arr_elem_t *elements;
+
+    struct tmptbl_arena *arena;
+    skl_node_t *skl_head[SKL_MAXHEIGHT];
+    skl_node_t *skl_tail;
+    int skl_height;
+    unsigned int skl_seed;
 };
 
 enum { TMPTBL_PRIORITY, TMPTBL_WAIT };
@@ -241,10 +314,73 @@ static int key_memcmp(void *usermem, int key1len, const void *key1, int key2len,
                       const void *key2);
 static int temp_table_compare(DB *db, const DBT *dbt1, const DBT *dbt2);
 
+/* A zerocopy cursor on a temparray or a skiplist hands out the row's own
+   key and data instead of copying them into its buffers. The table keeps
+   what it handed out valid and unchanged for as long as the cursor stays
+   on the row: before a row is freed or overwritten in place, the cursors
+   borrowing it are given copies of their own (tmptbl_unshare). */
+static void tmpcur_borrow_kv(struct temp_cursor *cur, void *key, int keylen,
+                             void *data, int datalen)
+{
+    if (!cur->borrowed) {
+        free(cur->key);
+        free(cur->data);
+        cur->keymalloclen = cur->datamalloclen = 0;
+        cur->borrowed = 1;
+    }
+    cur->key = key;
+    cur->keylen = keylen;
+    cur->data = data;
+    cur->datalen = datalen;
+    cur->valid = 1;
+}
+
+static int tmpcur_own_kv(struct temp_cursor *cur)
+{
+    void *key, *data;
+
+    if (!cur->borrowed)
+        return 0;
+    cur->borrowed = 0;
+    key = malloc(cur->keylen > 0 ? cur->keylen : 1);
+    data = malloc(cur->datalen > 0 ? cur->datalen : 1);
+    if (key == NULL || data == NULL) {
+        free(key);
+        free(data);
+        cur->key = cur->data = NULL;
+        cur->keylen = cur->datalen = 0;
+        cur->valid = 0;
+        return -1;
+    }
+    memcpy(key, cur->key, cur->keylen);
+    memcpy(data, cur->data, cur->datalen);
+    cur->key = key;
+    cur->keymalloclen = cur->keylen;
+    cur->data = data;
+    cur->datamalloclen = cur->datalen;
+    return 0;
+}
+
+/* Copy out the cursors borrowing the row whose key is at `key', or every
+   borrowing cursor if `key' is NULL. */
+static void tmptbl_unshare(struct temp_table *tbl, const void *key)
+{
+    struct temp_cursor *cur;
+
+    /* a cursor that can't get a copy is left without a row, and nothing
+       dangling */
+    LISTC_FOR_EACH(&tbl->cursors, cur, lnk)
+    {
+        if (cur->borrowed && (key == NULL || cur->key == key))
+            tmpcur_own_kv(cur);
+    }
+}
+
 /* refactored both insert and put code paths here */
 static int bdb_temp_table_insert_put(bdb_state_type *, struct temp_table *,
-                                     void *key, int keylen, void *data,
-                                     int dtalen, int *bdberr);
+                                     struct temp_cursor *, void *key,
+                                     int keylen, void *data, int dtalen,
+                                     void *unpacked, int *bdberr);
 
 void *bdb_temp_table_get_cur(struct temp_cursor *skippy) { return skippy->cur; }
 
@@ -366,6 +502,7 @@ static int bdb_array_copy_to_temp_db(bdb_state_type *bdb_state,
         }
     }
 
+    tmptbl_unshare(tbl, NULL);
     for (ii = 0; ii != nents; ++ii) {
         elem = &tbl->elements[ii];
         free(elem->key);
@@ -389,70 +526,409 @@ static int bdb_array_copy_to_temp_db(bdb_state_type *bdb_state,
             goto done;
         }
 
-        /* New cursor does not point to any data */
-        cur->key = cur->data = NULL;
-        cur->keylen = cur->datalen = 0;
+        /* New cursor does not point to any data. The copy of the row the
+           cursor was on is its own, and is freed when it next moves. */
     }
 
 done:
     return rc;
 }
 
+static uint64_t tmph_hash(const void *key, int keylen)
+{
+    const uint8_t *p = key;
+    uint64_t h = 14695981039346656037ULL;
+    int i;
+
+    for (i = 0; i < keylen; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+#define TMPH_PARTNO(h) ((int)((h) >> 60) & (TMPTBL_HASH_NPARTS - 1))
+
+static inline int tmph_entry_size(const char *data)
+{
+    int keylen, datalen;
+    memcpy(&keylen, data, sizeof(int));
+    memcpy(&datalen, data + keylen + sizeof(int), sizeof(int));
+    return keylen + datalen + 2 * sizeof(int);
+}
+
+static inline uint64_t tmph_entry_hash(const char *data)
+{
+    int keylen;
+    memcpy(&keylen, data, sizeof(int));
+    return tmph_hash(data + sizeof(int), keylen);
+}
+
+static void tmph_bloom_add(struct temp_hash_part *hp, uint64_t h)
+{
+    uint32_t h1 = (uint32_t)h, h2 = (uint32_t)(h >> 28) | 1, bit;
+    int i;
+
+    if (hp->bloom == NULL)
+        return;
+    for (i = 0; i < 3; ++i) {
+        bit = (h1 + i * h2) & hp->bloom_mask;
+        hp->bloom[bit >> 6] |= 1ULL << (bit & 63);
+    }
+}
+
+static int tmph_bloom_test(struct temp_hash_part *hp, uint64_t h)
+{
+    uint32_t h1 = (uint32_t)h, h2 = (uint32_t)(h >> 28) | 1, bit;
+    int i;
+
+    if (hp->bloom == NULL)
+        return 1;
+    for (i = 0; i < 3; ++i) {
+        bit = (h1 + i * h2) & hp->bloom_mask;
+        if (!(hp->bloom[bit >> 6] & (1ULL << (bit & 63))))
+            return 0;
+    }
+    return 1;
+}
+
+/* Free the rows of a partition; its run is emptied, or closed if close_run
+   is set. */
+static void tmph_clear_part(struct temp_table *tbl, struct temp_hash_part *hp,
+                            int close_run)
+{
+    void *hash_cur;
+    unsigned int hash_cur_buk;
+    char *data;
+
+    data = hash_first(hp->h, &hash_cur, &hash_cur_buk);
+    while (data) {
+        free(data);
+        data = hash_next(hp->h, &hash_cur, &hash_cur_buk);
+    }
+    hash_clear(hp->h);
+    tbl->inmemsz -= hp->bytes;
+    hp->bytes = 0;
+
+    if (hp->run) {
+        if (close_run) {
+            fclose(hp->run);
+            hp->run = NULL;
+        } else if (hp->runbytes) {
+            rewind(hp->run);
+            if (ftruncate(fileno(hp->run), 0))
+                logmsg(LOGMSG_ERROR, "%s: ftruncate %s\n", __func__,
+                       strerror(errno));
+        }
+    }
+    hp->runbytes = 0;
+    free(hp->bloom);
+    hp->bloom = NULL;
+}
+
+static void tmph_clear(struct temp_table *tbl, int close_runs)
+{
+    int i;
+
+    if (tbl->hash_parts == NULL)
+        return;
+    for (i = 0; i < TMPTBL_HASH_NPARTS; ++i) {
+        if (tbl->hash_parts[i].h != NULL)
+            tmph_clear_part(tbl, &tbl->hash_parts[i], close_runs);
+    }
+    tbl->num_mem_entries = 0;
+    tbl->hash_reloads = 0;
+}
+
+static int tmph_empty(struct temp_table *tbl)
+{
+    int i;
+
+    for (i = 0; i < TMPTBL_HASH_NPARTS; ++i) {
+        if (tbl->hash_parts[i].bytes || tbl->hash_parts[i].runbytes)
+            return 0;
+    }
+    return 1;
+}
+
+/* Write a partition's rows out as a run. */
+static int tmph_spill_part(struct temp_table *tbl, int partno)
+{
+    struct temp_hash_part *hp = &tbl->hash_parts[partno];
+    void *hash_cur;
+    unsigned int hash_cur_buk;
+    char *data;
+    uint32_t bits;
+    int nents = hash_get_num_entries(hp->h);
+
+    if (hp->run == NULL) {
+        char path[sizeof(tbl->filename) + 16];
+        snprintf(path, sizeof(path), "%s.part%d", tbl->filename, partno);
+        hp->run = fopen(path, "w+");
+        if (hp->run == NULL) {
+            logmsg(LOGMSG_ERROR, "%s: fopen %s: %s\n", __func__, path,
+                   strerror(errno));
+            return -1;
+        }
+        unlink(path);
+    }
+
+    /* ~16 bits a row leaves room for rows appended later */
+    for (bits = 1024; bits < (uint32_t)nents * 16 && bits < (1U << 28);
+         bits <<= 1)
+        ;
+    free(hp->bloom);
+    hp->bloom = calloc(bits / 64, sizeof(uint64_t));
+    hp->bloom_mask = bits - 1;
+
+    for (data = hash_first(hp->h, &hash_cur, &hash_cur_buk); data;
+         data = hash_next(hp->h, &hash_cur, &hash_cur_buk)) {
+        if (fwrite(data, tmph_entry_size(data), 1, hp->run) != 1) {
+            logmsg(LOGMSG_ERROR, "%s: fwrite %s\n", __func__,
+                   strerror(errno));
+            rewind(hp->run);
+            if (ftruncate(fileno(hp->run), 0))
+                logmsg(LOGMSG_ERROR, "%s: ftruncate %s\n", __func__,
+                       strerror(errno));
+            free(hp->bloom);
+            hp->bloom = NULL;
+            return -1;
+        }
+        tmph_bloom_add(hp, tmph_entry_hash(data));
+    }
+
+    data = hash_first(hp->h, &hash_cur, &hash_cur_buk);
+    while (data) {
+        free(data);
+        data = hash_next(hp->h, &hash_cur, &hash_cur_buk);
+    }
+    hash_clear(hp->h);
+
+    tbl->inmemsz -= hp->bytes;
+    tbl->num_mem_entries -= nents;
+    hp->runbytes = hp->bytes;
+    hp->bytes = 0;
+    return 0;
+}
+
+static int tmph_part_pinned(struct temp_table *tbl, int partno)
+{
+    struct temp_cursor *cur;
+
+    LISTC_FOR_EACH(&tbl->cursors, cur, lnk)
+    {
+        if (cur->valid && cur->hash_part == partno)
+            return 1;
+    }
+    return 0;
+}
+
+/* Spill partitions, largest first, until need more bytes fit in the cache.
+   Partitions that a cursor sits in stay, and so does keep. */
+static void tmph_make_room(struct temp_table *tbl, unsigned long long need,
+                           int keep)
+{
+    int i, victim, spilled = 0;
+
+    for (i = 0; i < TMPTBL_HASH_NPARTS; ++i)
+        spilled |= (tbl->hash_parts[i].runbytes != 0);
+
+    while (tbl->inmemsz + need > tbl->cachesz) {
+        victim = -1;
+        for (i = 0; i < TMPTBL_HASH_NPARTS; ++i) {
+            if (i == keep || tbl->hash_parts[i].bytes == 0 ||
+                tmph_part_pinned(tbl, i))
+                continue;
+            if (victim == -1 ||
+                tbl->hash_parts[i].bytes > tbl->hash_parts[victim].bytes)
+                victim = i;
+        }
+        if (victim == -1 || tmph_spill_part(tbl, victim) != 0)
+            break;
+        if (!spilled) {
+            gbl_temptable_spills++;
+            spilled = 1;
+        }
+    }
+}
+
+/* Read the next row of a run; 0 and NULL at the end. */
+static int tmph_read_entry(FILE *run, char **datap)
+{
+    int keylen, datalen;
+    char *data;
+
+    *datap = NULL;
+    if (fread(&keylen, sizeof(int), 1, run) != 1)
+        return feof(run) ? 0 : -1;
+    if ((data = malloc(keylen + 2 * sizeof(int))) == NULL)
+        return -1;
+    memcpy(data, &keylen, sizeof(int));
+    if (fread(data + sizeof(int), keylen + sizeof(int), 1, run) != 1)
+        goto err;
+    memcpy(&datalen, data + keylen + sizeof(int), sizeof(int));
+    char *grown = realloc(data, keylen + datalen + 2 * sizeof(int));
+    if (grown == NULL)
+        goto err;
+    data = grown;
+    if (datalen && fread(data + keylen + 2 * sizeof(int), datalen, 1, run) != 1)
+        goto err;
+    *datap = data;
+    return 0;
+
+err:
+    free(data);
+    return -1;
+}
+
+/* Bring a partition's run back into memory. Returns 1 if the table should
+   become a btree instead, which only happens if can_convert is set. */
+static int tmph_load_part(struct temp_table *tbl, int partno, int can_convert)
+{
+    struct temp_hash_part *hp = &tbl->hash_parts[partno];
+    char *data;
+    int rc;
+
+    if (hp->runbytes == 0)
+        return 0;
+    if (can_convert && (hp->runbytes > tbl->cachesz ||
+                        tbl->hash_reloads >= TMPTBL_HASH_MAX_RELOADS))
+        return 1;
+    ++tbl->hash_reloads;
+
+    tmph_make_room(tbl, hp->runbytes, partno);
+
+    fflush(hp->run);
+    rewind(hp->run);
+    while ((rc = tmph_read_entry(hp->run, &data)) == 0 && data) {
+        if (hash_find(hp->h, data)) {
+            free(data);
+            continue;
+        }
+        hash_add(hp->h, data);
+        hp->bytes += tmph_entry_size(data);
+        tbl->num_mem_entries++;
+    }
+    if (rc) {
+        logmsg(LOGMSG_ERROR, "%s: failed to read back partition %d\n",
+               __func__, partno);
+        return -1;
+    }
+    tbl->inmemsz += hp->bytes;
+
+    rewind(hp->run);
+    if (ftruncate(fileno(hp->run), 0))
+        logmsg(LOGMSG_ERROR, "%s: ftruncate %s\n", __func__, strerror(errno));
+    hp->runbytes = 0;
+    free(hp->bloom);
+    hp->bloom = NULL;
+    return 0;
+}
+
+/* Position cur on the first row of the first non-empty partition from
+   partno on, reading runs back in as needed. */
+static int tmph_first_from(struct temp_cursor *cur, int partno,
+                           int can_convert)
+{
+    struct temp_table *tbl = cur->tbl;
+    char *data;
+    int rc;
+
+    /* until it finds a row, the cursor pins no partition */
+    cur->valid = 0;
+    for (; partno < TMPTBL_HASH_NPARTS; ++partno) {
+        if ((rc = tmph_load_part(tbl, partno, can_convert)) != 0)
+            return rc;
+        data = hash_first(tbl->hash_parts[partno].h, &cur->hash_cur,
+                          &cur->hash_cur_buk);
+        if (data) {
+            cur->keylen = *(int *)data;
+            cur->key = data + sizeof(int);
+            cur->datalen = *(int *)(data + cur->keylen + sizeof(int));
+            cur->data = data + cur->keylen + 2 * sizeof(int);
+            cur->hash_part = partno;
+            cur->valid = 1;
+            return 0;
+        }
+    }
+    return IX_PASTEOF;
+}
+
 static int bdb_hash_table_copy_to_temp_db(bdb_state_type *bdb_state,
                                           struct temp_table *tbl, int *bdberr)
 {
     int rc = 0;
-    int num_recs = 0;
+    int ii;
+    unsigned long long nents = 0;
     DBT dbt_key, dbt_data;
     bzero(&dbt_key, sizeof(DBT));
     bzero(&dbt_data, sizeof(DBT));
     struct temp_cursor *cur;
+    struct temp_hash_part *hp;
     void *hash_cur;
     unsigned int hash_cur_buk;
     char *data;
 
     if (tbl->dbenv_temp == NULL &&
-        create_temp_db_env(bdb_state, tbl, bdberr) != 0) {
-        bdb_temp_table_destroy_pool_wrapper(tbl, bdb_state);
+        (rc = create_temp_db_env(bdb_state, tbl, bdberr)) != 0) {
+        logmsg(LOGMSG_ERROR, "%s: create_temp_db_env rc %d\n", __func__, rc);
+        return rc;
     }
 
-    /* copy the hash to a btree */
-    data = hash_first(tbl->temp_hash_tbl, &hash_cur, &hash_cur_buk);
-    while (data) {
-        int keylen = *(int *)data;
-        void *key = data + sizeof(int);
+    /* copy the hash to a btree; rows in runs may repeat a key, and the
+       first one wins */
+    for (ii = 0; ii < TMPTBL_HASH_NPARTS; ++ii) {
+        hp = &tbl->hash_parts[ii];
+        data = hash_first(hp->h, &hash_cur, &hash_cur_buk);
+        if (hp->runbytes) {
+            fflush(hp->run);
+            rewind(hp->run);
+            if (tmph_read_entry(hp->run, &data))
+                goto readerr;
+        }
+        while (data) {
+            int keylen = *(int *)data;
+            void *key = data + sizeof(int);
 #ifdef _SUN_SOURCE
-        int datalen;
-        memcpy(&datalen, data + keylen + sizeof(int), sizeof(int));
+            int datalen;
+            memcpy(&datalen, data + keylen + sizeof(int), sizeof(int));
 #else
-        int datalen = *(int *)(data + keylen + sizeof(int));
-        ;
+            int datalen = *(int *)(data + keylen + sizeof(int));
+            ;
 #endif
-        void *d_data = data + keylen + 2 * sizeof(int);
-
-        dbt_key.ulen = dbt_key.size = keylen;
-        dbt_data.ulen = dbt_data.size = datalen;
-        dbt_data.data = d_data;
-        dbt_key.data = key;
-
-        rc = tbl->tmpdb->put(tbl->tmpdb, NULL, &dbt_key, &dbt_data, 0);
-        num_recs++;
-        if (rc) {
-            logmsg(LOGMSG_ERROR, "%s:%d put rc %d\n", __FILE__, __LINE__, rc);
-            return rc;
+            void *d_data = data + keylen + 2 * sizeof(int);
+
+            dbt_key.ulen = dbt_key.size = keylen;
+            dbt_data.ulen = dbt_data.size = datalen;
+            dbt_data.data = d_data;
+            dbt_key.data = key;
+
+            rc = tbl->tmpdb->put(tbl->tmpdb, NULL, &dbt_key, &dbt_data,
+                                 hp->runbytes ? DB_NOOVERWRITE : 0);
+            if (rc == 0)
+                nents++;
+            if (hp->runbytes) {
+                free(data);
+                if (rc == DB_KEYEXIST)
+                    rc = 0;
+            }
+            if (rc) {
+                logmsg(LOGMSG_ERROR, "%s:%d put rc %d\n", __FILE__, __LINE__,
+                       rc);
+                return rc;
+            }
+            if (hp->runbytes) {
+                if (tmph_read_entry(hp->run, &data))
+                    goto readerr;
+            } else {
+                data = hash_next(hp->h, &hash_cur, &hash_cur_buk);
+            }
         }
-        data = hash_next(tbl->temp_hash_tbl, &hash_cur, &hash_cur_buk);
     }
 
     /* get rid of the hash */
-    data = hash_first(tbl->temp_hash_tbl, &hash_cur, &hash_cur_buk);
-    while (data) {
-        free(data);
-        data = hash_next(tbl->temp_hash_tbl, &hash_cur, &hash_cur_buk);
-    }
-    hash_clear(tbl->temp_hash_tbl);
-    hash_free(tbl->temp_hash_tbl);
-    tbl->temp_hash_tbl = hash_init_user(hashfunc, hashcmpfunc, 0, 0);
+    tmph_clear(tbl, 1);
+    tbl->num_mem_entries = nents;
 
     /* its now a btree! */
     tbl->temp_table_type = TEMP_TABLE_TYPE_BTREE;
@@ -474,8 +950,358 @@ static int bdb_hash_table_copy_to_temp_db(bdb_state_type *bdb_state,
         cur->keylen = cur->datalen = 0;
     }
 
-done:
-    return rc;
+done:
+    return rc;
+
+readerr:
+    logmsg(LOGMSG_ERROR, "%s: failed to read back partition %d\n", __func__,
+           ii);
+    *bdberr = BDBERR_MISC;
+    return -1;
+}
+
+static void *tmptbl_arena_alloc(struct temp_table *tbl, size_t n)
+{
+    struct tmptbl_arena *a = tbl->arena;
+    void *p;
+
+    n = (n + 7) & ~(size_t)7;
+    if (a == NULL || a->size - a->used < n) {
+        size_t sz = (n > TMPTBL_ARENA_CHUNK) ? n : TMPTBL_ARENA_CHUNK;
+        struct tmptbl_arena *nw = malloc(sizeof(struct tmptbl_arena) + sz);
+        if (nw == NULL)
+            return NULL;
+        nw->size = sz;
+        nw->used = 0;
+        tbl->inmemsz += sz;
+        if (a != NULL && n > TMPTBL_ARENA_CHUNK / 4) {
+            /* Big rows get a chunk of their own, behind the one we are
+               still filling. */
+            nw->next = a->next;
+            a->next = nw;
+        } else {
+            nw->next = a;
+            tbl->arena = nw;
+        }
+        a = nw;
+    }
+    p = a->buf + a->used;
+    a->used += n;
+    return p;
+}
+
+static void skl_reset(struct temp_table *tbl)
+{
+    struct tmptbl_arena *a, *next;
+    struct temp_cursor *cur;
+
+    tmptbl_unshare(tbl, NULL);
+    for (a = tbl->arena; a; a = next) {
+        next = a->next;
+        free(a);
+    }
+    tbl->arena = NULL;
+    tbl->inmemsz = 0;
+    memset(tbl->skl_head, 0, sizeof(tbl->skl_head));
+    tbl->skl_tail = NULL;
+    tbl->skl_height = 0;
+
+    /* Park the cursors in front of the first row. Those of a table that
+       has just become a btree are already on its rows. */
+    LISTC_FOR_EACH(&tbl->cursors, cur, lnk)
+    {
+        cur->skl_node = NULL;
+        if (tbl->temp_table_type == TEMP_TABLE_TYPE_SKIPLIST)
+            cur->skl_gap = 1;
+    }
+}
+
+static inline skl_node_t **skl_link(struct temp_table *tbl, skl_node_t *x,
+                                    int level)
+{
+    return x ? &x->next[level] : &tbl->skl_head[level];
+}
+
+static int skl_random_height(struct temp_table *tbl)
+{
+    unsigned int r = tbl->skl_seed;
+    int h = 1;
+
+    r ^= r << 13;
+    r ^= r >> 17;
+    r ^= r << 5;
+    tbl->skl_seed = r;
+
+    while (h < SKL_MAXHEIGHT && (r & 3) == 0) {
+        ++h;
+        r >>= 2;
+    }
+    return h;
+}
+
+/* Compare the search key with a node's key, with the same argument order
+   temp_table_compare() gets from berkdb. */
+static inline int skl_cmp(struct temp_table *tbl, const skl_node_t *n,
+                          const void *key, int keylen, void *unpacked)
+{
+    if (unpacked)
+        return -tbl->cmpfunc(NULL, n->keylen, n->key, -1, unpacked);
+    return tbl->cmpfunc(tbl->usermem, keylen, key, n->keylen, n->key);
+}
+
+/* Return the first node not smaller than key, or NULL. *cmpp is 0 if it is
+   equal to key. If prevs isn't NULL, it gets the node to link after (NULL
+   for the head) on every level. */
+static skl_node_t *skl_seek(struct temp_table *tbl, const void *key,
+                            int keylen, void *unpacked, skl_node_t **prevs,
+                            int *cmpp)
+{
+    skl_node_t *x = NULL, *nxt = NULL, *last = NULL;
+    int level, cmp = 1, lastcmp = 1;
+
+    for (level = tbl->skl_height - 1; level >= 0; --level) {
+        for (;;) {
+            nxt = *skl_link(tbl, x, level);
+            if (nxt == NULL)
+                break;
+            /* Don't compare again against the node that stopped us on the
+               level above. */
+            if (nxt == last) {
+                cmp = lastcmp;
+                break;
+            }
+            cmp = skl_cmp(tbl, nxt, key, keylen, unpacked);
+            if (cmp <= 0) {
+                last = nxt;
+                lastcmp = cmp;
+                break;
+            }
+            x = nxt;
+        }
+        if (prevs)
+            prevs[level] = x;
+    }
+    *cmpp = nxt ? cmp : 1;
+    return nxt;
+}
+
+/* Insert a row, or replace the data of the row with an equal key, like a
+   berkdb btree without duplicates does. */
+static skl_node_t *skl_insert(struct temp_table *tbl, void *key, int keylen,
+                              void *data, int dtalen, void *unpacked)
+{
+    skl_node_t *prevs[SKL_MAXHEIGHT];
+    skl_node_t *n, **link;
+    int cmp, h, level;
+
+    n = skl_seek(tbl, key, keylen, unpacked, prevs, &cmp);
+    if (n && cmp == 0) {
+        if (dtalen > n->dtalen) {
+            uint8_t *dta = tmptbl_arena_alloc(tbl, dtalen);
+            if (dta == NULL)
+                return NULL;
+            n->dta = dta;
+        } else {
+            tmptbl_unshare(tbl, n->key);
+        }
+        memmove(n->dta, data, dtalen); /* data may be a zerocopy view of it */
+        n->dtalen = dtalen;
+        return n;
+    }
+
+    h = skl_random_height(tbl);
+    n = tmptbl_arena_alloc(tbl, offsetof(skl_node_t, next) +
+                                    h * sizeof(skl_node_t *) + keylen +
+                                    dtalen);
+    if (n == NULL)
+        return NULL;
+    for (level = tbl->skl_height; level < h; ++level)
+        prevs[level] = NULL;
+    if (h > tbl->skl_height)
+        tbl->skl_height = h;
+
+    n->height = h;
+    n->keylen = keylen;
+    n->dtalen = dtalen;
+    n->key = (uint8_t *)&n->next[h];
+    n->dta = n->key + keylen;
+    memcpy(n->key, key, keylen);
+    memcpy(n->dta, data, dtalen);
+
+    for (level = 0; level < h; ++level) {
+        link = skl_link(tbl, prevs[level], level);
+        n->next[level] = *link;
+        *link = n;
+    }
+    n->prev = prevs[0];
+    if (n->next[0])
+        n->next[0]->prev = n;
+    else
+        tbl->skl_tail = n;
+
+    tbl->num_mem_entries++;
+    return n;
+}
+
+static int skl_delete(struct temp_table *tbl, skl_node_t *n)
+{
+    skl_node_t *prevs[SKL_MAXHEIGHT];
+    skl_node_t *x, *nxt;
+    struct temp_cursor *cur;
+    int cmp, level;
+
+    skl_seek(tbl, n->key, n->keylen, NULL, prevs, &cmp);
+
+    for (level = 0; level < n->height; ++level) {
+        /* walk past anything that compares equal but isn't n */
+        x = prevs[level];
+        while ((nxt = *skl_link(tbl, x, level)) != n) {
+            if (nxt == NULL) {
+                logmsg(LOGMSG_ERROR, "%s: row not found on level %d\n",
+                       __func__, level);
+                return -1;
+            }
+            x = nxt;
+        }
+        prevs[level] = x;
+    }
+
+    for (level = 0; level < n->height; ++level)
+        *skl_link(tbl, prevs[level], level) = n->next[level];
+    if (n->next[0])
+        n->next[0]->prev = n->prev;
+    else
+        tbl->skl_tail = n->prev;
+    while (tbl->skl_height > 0 && tbl->skl_head[tbl->skl_height - 1] == NULL)
+        --tbl->skl_height;
+    tbl->num_mem_entries--;
+
+    /* Like a berkdb cursor on a deleted row, next and prev still move
+       relative to where the row was. */
+    LISTC_FOR_EACH(&tbl->cursors, cur, lnk)
+    {
+        if (cur->skl_node == n) {
+            cur->skl_node = n->prev;
+            cur->skl_gap = 1;
+        }
+    }
+    return 0;
+}
+
+static int skl_copy_to_cur(struct temp_cursor *cur, skl_node_t *n)
+{
+    if (cur->zerocopy) {
+        tmpcur_borrow_kv(cur, n->key, n->keylen, n->dta, n->dtalen);
+        cur->skl_node = n;
+        cur->skl_gap = 0;
+        return 0;
+    }
+    if (cur->borrowed) {
+        cur->key = cur->data = NULL;
+        cur->borrowed = 0;
+    }
+    if (cur->key == NULL || cur->keymalloclen < n->keylen) {
+        cur->key = malloc_resize(cur->key, n->keylen);
+        cur->keymalloclen = n->keylen;
+    }
+    if (cur->data == NULL || cur->datamalloclen < n->dtalen) {
+        cur->data = malloc_resize(cur->data, n->dtalen);
+        cur->datamalloclen = n->dtalen;
+    }
+    if (cur->key == NULL || cur->data == NULL) {
+        cur->valid = 0;
+        return -1;
+    }
+    cur->keylen = n->keylen;
+    cur->datalen = n->dtalen;
+    memcpy(cur->key, n->key, n->keylen);
+    memcpy(cur->data, n->dta, n->dtalen);
+    cur->skl_node = n;
+    cur->skl_gap = 0;
+    cur->valid = 1;
+    return 0;
+}
+
+/* Write the skiplist out, in key order, to a berkdb temptable and turn the
+   table into a btree. Cursors sitting on a row stay on it; cursors sitting
+   between rows stay between the same two rows. */
+static int bdb_skiplist_copy_to_temp_db(bdb_state_type *bdb_state,
+                                        struct temp_table *tbl, int *bdberr)
+{
+    int rc = 0;
+    DBT dbt_key, dbt_data;
+    struct temp_cursor *cur;
+    skl_node_t *n;
+    int gap;
+    unsigned long long nents = tbl->num_mem_entries;
+    unsigned long long rowid = tbl->rowid;
+
+    bzero(&dbt_key, sizeof(DBT));
+    bzero(&dbt_data, sizeof(DBT));
+
+    if (tbl->dbenv_temp == NULL &&
+        (rc = create_temp_db_env(bdb_state, tbl, bdberr)) != 0) {
+        logmsg(LOGMSG_ERROR, "%s: create_temp_db_env rc %d\n", __func__, rc);
+        return rc;
+    }
+
+    for (n = tbl->skl_head[0]; n; n = n->next[0]) {
+        dbt_key.flags = dbt_data.flags = DB_DBT_USERMEM;
+        dbt_key.ulen = dbt_key.size = n->keylen;
+        dbt_data.ulen = dbt_data.size = n->dtalen;
+        dbt_data.data = n->dta;
+        dbt_key.data = n->key;
+
+        rc = tbl->tmpdb->put(tbl->tmpdb, NULL, &dbt_key, &dbt_data, 0);
+        if (rc) {
+            logmsg(LOGMSG_ERROR, "%s:%d put rc %d\n", __FILE__, __LINE__, rc);
+            *bdberr = rc;
+            return rc;
+        }
+    }
+
+    LISTC_FOR_EACH(&tbl->cursors, cur, lnk)
+    {
+        rc = tbl->tmpdb->cursor(tbl->tmpdb, NULL, &cur->cur, 0);
+        if (rc) {
+            cur->cur = NULL;
+            logmsg(LOGMSG_ERROR, "%s:%d cursor rc %d\n", __FILE__, __LINE__,
+                   rc);
+            *bdberr = rc;
+            return rc;
+        }
+        if (!cur->valid)
+            continue;
+
+        /* In a gap, stand on the row before it, or on the first row if
+           there isn't one: next and prev then treat that row specially. */
+        n = cur->skl_node;
+        gap = 0;
+        if (cur->skl_gap)
+            gap = n ? TMPCUR_GAP_AFTER : TMPCUR_GAP_BEFORE;
+        if (n == NULL)
+            n = tbl->skl_head[0];
+        if (n == NULL) {
+            cur->valid = 0;
+            continue;
+        }
+        dbt_key.flags = DB_DBT_USERMEM;
+        dbt_key.ulen = dbt_key.size = n->keylen;
+        dbt_key.data = n->key;
+        dbt_data.flags = DB_DBT_USERMEM | DB_DBT_PARTIAL;
+        dbt_data.ulen = dbt_data.size = dbt_data.dlen = dbt_data.doff = 0;
+        dbt_data.data = NULL;
+        if (cur->cur->c_get(cur->cur, &dbt_key, &dbt_data, DB_SET) != 0)
+            cur->valid = 0;
+        cur->skl_gap = gap;
+    }
+
+    /* its now a btree! */
+    tbl->temp_table_type = TEMP_TABLE_TYPE_BTREE;
+    skl_reset(tbl);
+    tbl->num_mem_entries = nents;
+    tbl->rowid = rowid;
+    return 0;
 }
 
 static void bdb_temp_table_reset(struct temp_table *tbl)
@@ -575,6 +1401,8 @@ static int bdb_temp_table_env_close(bdb_state_type *bdb_state,
 
 extern pthread_key_t current_sql_query_key;
 int gbl_debug_temptables = 0;
+int gbl_temptable_skiplist = 1;
+int gbl_temptable_grace_hash = 1;
 
 static struct temp_table *bdb_temp_table_create_main(bdb_state_type *bdb_state,
                                                      int *bdberr)
@@ -617,6 +1445,7 @@ static struct temp_table *bdb_temp_table_create_main(bdb_state_type *bdb_state,
     snprintf(tbl->filename, sizeof(tbl->filename), "%s/_temp_%d.db",
              parent->tmpdir, id);
     tbl->tblid = id;
+    tbl->skl_seed = (2463534242U ^ (unsigned int)id) | 1;
 
     listc_init(&tbl->cursors, offsetof(struct temp_cursor, lnk));
 
@@ -778,13 +1607,23 @@ static struct temp_table *bdb_temp_table_create_type(bdb_state_type *bdb_state,
             }
             break;
         case TEMP_TABLE_TYPE_HASH:
-            if (table->temp_hash_tbl == NULL) {
-                table->temp_hash_tbl = hash_init_user(hashfunc, hashcmpfunc, 0, 0);
-                if (table->temp_hash_tbl == NULL) {
+            if (table->hash_parts == NULL) {
+                table->hash_parts = calloc(TMPTBL_HASH_NPARTS,
+                                           sizeof(struct temp_hash_part));
+                if (table->hash_parts == NULL) {
                     bdb_temp_table_destroy_pool_wrapper(table, bdb_state);
                     return NULL;
                 }
+                for (int i = 0; i < TMPTBL_HASH_NPARTS; ++i) {
+                    table->hash_parts[i].h =
+                        hash_init_user(hashfunc, hashcmpfunc, 0, 0);
+                    if (table->hash_parts[i].h == NULL) {
+                        bdb_temp_table_destroy_pool_wrapper(table, bdb_state);
+                        return NULL;
+                    }
+                }
             }
+            table->hash_reloads = 0;
             break;
         case TEMP_TABLE_TYPE_LIST:
             listc_init(&table->temp_tbl_list, offsetof(struct temp_list_node, lnk));
@@ -798,6 +1637,9 @@ static struct temp_table *bdb_temp_table_create_type(bdb_state_type *bdb_state,
                 }
             }
             break;
+        case TEMP_TABLE_TYPE_SKIPLIST:
+            /* the arena is carved out as rows come in */
+            break;
         }
 
         table->num_mem_entries = 0;
@@ -813,14 +1655,19 @@ struct temp_table *bdb_temp_table_create_flags(bdb_state_type *bdb_state,
 {
     int temptype;
 
-    temptype = TEMP_TABLE_TYPE_BTREE;
+    temptype = gbl_temptable_skiplist ? TEMP_TABLE_TYPE_SKIPLIST
+                                      : TEMP_TABLE_TYPE_BTREE;
 
     return bdb_temp_table_create_type(bdb_state, temptype, bdberr);
 }
 
 struct temp_table *bdb_temp_table_create(bdb_state_type *bdb_state, int *bdberr)
 {
-    return bdb_temp_table_create_type(bdb_state, TEMP_TABLE_TYPE_BTREE, bdberr);
+    return bdb_temp_table_create_type(bdb_state,
+                                      gbl_temptable_skiplist
+                                          ? TEMP_TABLE_TYPE_SKIPLIST
+                                          : TEMP_TABLE_TYPE_BTREE,
+                                      bdberr);
 }
 
 struct temp_table *bdb_temp_list_create(bdb_state_type *bdb_state, int *bdberr)
@@ -862,6 +1709,7 @@ struct temp_cursor *bdb_temp_table_cursor(bdb_state_type *bdb_state,
     case TEMP_TABLE_TYPE_HASH:
         cur->hash_cur = NULL;
         cur->hash_cur_buk = 0;
+        cur->hash_part = 0;
         break;
 
     case TEMP_TABLE_TYPE_BTREE:
@@ -871,6 +1719,11 @@ struct temp_cursor *bdb_temp_table_cursor(bdb_state_type *bdb_state,
     case TEMP_TABLE_TYPE_ARRAY:
         cur->ind = 0;
         break;
+
+    case TEMP_TABLE_TYPE_SKIPLIST:
+        cur->skl_node = NULL;
+        cur->skl_gap = 0;
+        break;
     }
 
     if (rc) {
@@ -903,8 +1756,8 @@ int bdb_temp_table_insert(bdb_state_type *bdb_state, struct temp_cursor *cur,
     DBT dkey, ddata;
     struct temp_table *tbl = cur->tbl;
 
-    int rc = bdb_temp_table_insert_put(bdb_state, tbl, key, keylen, data,
-                                       dtalen, bdberr);
+    int rc = bdb_temp_table_insert_put(bdb_state, tbl, cur, key, keylen, data,
+                                       dtalen, NULL, bdberr);
     if (rc <= 0)
         goto done;
 
@@ -927,6 +1780,8 @@ int bdb_temp_table_insert(bdb_state_type *bdb_state, struct temp_cursor *cur,
         rc = -1;
         goto done;
     }
+    if (rc == 0)
+        cur->skl_gap = 0;
 
 done:
     dbghexdump(3, key, keylen);
@@ -944,22 +1799,39 @@ int bdb_temp_table_update(bdb_state_type *bdb_state, struct temp_cursor *cur,
     uint8_t *keycopy, *dtacopy;
 
     if (cur->tbl->temp_table_type != TEMP_TABLE_TYPE_BTREE &&
-        cur->tbl->temp_table_type != TEMP_TABLE_TYPE_ARRAY) {
+        cur->tbl->temp_table_type != TEMP_TABLE_TYPE_ARRAY &&
+        cur->tbl->temp_table_type != TEMP_TABLE_TYPE_SKIPLIST) {
         logmsg(LOGMSG_ERROR, "bdb_temp_table_update operation "
                              "only supported for btree or array.\n");
         return -1;
     }
 
+    if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_SKIPLIST) {
+        skl_node_t *n = cur->skl_node;
+
+        /* Like c_put(DB_CURRENT), this replaces the data only. */
+        if (!cur->valid || cur->skl_gap || n == NULL)
+            return -1;
+        if (dtalen > n->dtalen) {
+            uint8_t *dta = tmptbl_arena_alloc(cur->tbl, dtalen);
+            if (dta == NULL)
+                return -1;
+            n->dta = dta;
+        } else {
+            tmptbl_unshare(cur->tbl, n->key);
+        }
+        memmove(n->dta, data, dtalen);
+        n->dtalen = dtalen;
+        rc = 0;
+        goto skl_done;
+    }
+
     if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_ARRAY) {
         if (!cur->valid)
             return -1;
 
-        /* Free the existing elements and update the memory footprint. */
-        elem = &cur->tbl->elements[cur->ind];
-        free(elem->key);
-        cur->tbl->inmemsz -= (elem->keylen + elem->dtalen);
-
-        /* malloc and copy */
+        /* malloc and copy, before the old row goes: the new one may be
+           made from a zerocopy cursor's view of it */
         keycopy = malloc(keylen + dtalen);
         if (keycopy == NULL)
             return -1;
@@ -967,6 +1839,12 @@ int bdb_temp_table_update(bdb_state_type *bdb_state, struct temp_cursor *cur,
         memcpy(keycopy, key, keylen);
         memcpy(dtacopy, data, dtalen);
 
+        /* Free the existing elements and update the memory footprint. */
+        elem = &cur->tbl->elements[cur->ind];
+        tmptbl_unshare(cur->tbl, elem->key);
+        free(elem->key);
+        cur->tbl->inmemsz -= (elem->keylen + elem->dtalen);
+
         /* Update the element and the memory footprint. */
         elem->keylen = keylen;
         elem->key = keycopy;
@@ -975,6 +1853,10 @@ int bdb_temp_table_update(bdb_state_type *bdb_state, struct temp_cursor *cur,
         cur->tbl->inmemsz += (elem->keylen + elem->dtalen);
     }
 
+    /* not on a row since a spill */
+    if (cur->skl_gap)
+        return -1;
+
     REOPEN_CURSOR(cur);
 
     /*Pthread_setspecific(cur->tbl->curkey, cur);*/
@@ -997,6 +1879,7 @@ int bdb_temp_table_update(bdb_state_type *bdb_state, struct temp_cursor *cur,
         rc = -1;
     }
 
+skl_done:
     dbghexdump(3, key, keylen);
     dbgtrace(3, "temp_table_update(cursor %d) = %d\n", cur->curid, rc);
     return rc;
@@ -1005,8 +1888,6 @@ int bdb_temp_table_update(bdb_state_type *bdb_state, struct temp_cursor *cur,
 unsigned long long bdb_temp_table_new_rowid(struct temp_table *tbl)
 {
     DBC *cur;
-    void *ent;
-    unsigned int bkt;
 
     switch (tbl->temp_table_type) {
     case TEMP_TABLE_TYPE_BTREE:
@@ -1022,6 +1903,7 @@ unsigned long long bdb_temp_table_new_rowid(struct temp_table *tbl)
         }
         break;
     case TEMP_TABLE_TYPE_ARRAY:
+    case TEMP_TABLE_TYPE_SKIPLIST:
         if (tbl->num_mem_entries == 0)
             tbl->rowid = 0;
         break;
@@ -1030,7 +1912,7 @@ unsigned long long bdb_temp_table_new_rowid(struct temp_table *tbl)
             tbl->rowid = 0;
         break;
     case TEMP_TABLE_TYPE_HASH:
-        if (hash_first(tbl->temp_hash_tbl, &ent, &bkt) == NULL)
+        if (tmph_empty(tbl))
             tbl->rowid = 0;
     }
 
@@ -1043,8 +1925,8 @@ int bdb_temp_table_put(bdb_state_type *bdb_state, struct temp_table *tbl,
 {
     DBT dkey, ddata;
 
-    int rc = bdb_temp_table_insert_put(bdb_state, tbl, key, keylen, data,
-                                       dtalen, bdberr);
+    int rc = bdb_temp_table_insert_put(bdb_state, tbl, NULL, key, keylen, data,
+                                       dtalen, unpacked, bdberr);
     if (rc <= 0)
         goto done;
 
@@ -1095,26 +1977,22 @@ static int bdb_temp_table_first_last(bdb_state_type *bdb_state,
 
     if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_HASH) {
         cur->valid = 0;
-        char *data;
         if (how != DB_FIRST) {
             logmsg(LOGMSG_ERROR, "bdb_temp_table_first_last operation not supported "
                             "for temp list.\n");
             return -1;
         }
 
-        data = hash_first(cur->tbl->temp_hash_tbl, &cur->hash_cur,
-                          &cur->hash_cur_buk);
-        if (data) {
-            cur->keylen = *(int *)data;
-            cur->key = data + sizeof(int);
-            cur->datalen = *(int *)(data + cur->keylen + sizeof(int));
-            ;
-            cur->data = data + cur->keylen + 2 * sizeof(int);
-            cur->valid = 1;
-        } else {
-            return IX_EMPTY;
+        rc = tmph_first_from(cur, 0, 1);
+        if (rc == 1) {
+            rc = bdb_hash_table_copy_to_temp_db(bdb_state, cur->tbl, bdberr);
+            if (rc)
+                return -1;
+            return bdb_temp_table_first_last(bdb_state, cur, bdberr, how);
         }
-        return 0;
+        if (rc == IX_PASTEOF)
+            return IX_EMPTY;
+        return rc;
     }
 
     if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_ARRAY) {
@@ -1129,6 +2007,16 @@ static int bdb_temp_table_first_last(bdb_state_type *bdb_state,
         return 0;
     }
 
+    if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_SKIPLIST) {
+        skl_node_t *n = (how == DB_LAST) ? cur->tbl->skl_tail
+                                         : cur->tbl->skl_head[0];
+        if (n == NULL) {
+            cur->valid = 0;
+            return IX_EMPTY;
+        }
+        return skl_copy_to_cur(cur, n);
+    }
+
     REOPEN_CURSOR(cur);
 
     /*Pthread_setspecific(cur->tbl->curkey, cur);*/
@@ -1147,6 +2035,7 @@ static int bdb_temp_table_first_last(bdb_state_type *bdb_state,
         cur->data = NULL;
     }
     cur->valid = 0;
+    cur->skl_gap = 0;
     dkey.flags = ddata.flags = DB_DBT_MALLOC;
     rc = cur->cur->c_get(cur->cur, &dkey, &ddata, how);
     if (rc == DB_NOTFOUND)
@@ -1172,7 +2061,7 @@ static int bdb_temp_table_next_prev_norewind(bdb_state_type *bdb_state,
                                              int *bdberr, int how)
 {
     DBT ddata, dkey;
-    int rc;
+    int rc, gethow;
 
     if (!cur->valid)
         return IX_PASTEOF;
@@ -1200,8 +2089,8 @@ static int bdb_temp_table_next_prev_norewind(bdb_state_type *bdb_state,
                             "for temp list.\n");
             return -1;
         }
-        char *data = hash_next(cur->tbl->temp_hash_tbl, &cur->hash_cur,
-                               &cur->hash_cur_buk);
+        char *data = hash_next(cur->tbl->hash_parts[cur->hash_part].h,
+                               &cur->hash_cur, &cur->hash_cur_buk);
         if (data) {
             cur->keylen = *(int *)data;
             cur->key = data + sizeof(int);
@@ -1210,7 +2099,9 @@ static int bdb_temp_table_next_prev_norewind(bdb_state_type *bdb_state,
             cur->data = data + cur->keylen + 2 * sizeof(int);
             cur->valid = 1;
         } else {
-            return IX_PASTEOF;
+            /* runs of later partitions are read back whatever their size:
+               turning into a btree now would lose our place */
+            return tmph_first_from(cur, cur->hash_part + 1, 0);
         }
         return 0;
     }
@@ -1226,6 +2117,21 @@ static int bdb_temp_table_next_prev_norewind(bdb_state_type *bdb_state,
         return 0;
     }
 
+    if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_SKIPLIST) {
+        skl_node_t *n = cur->skl_node;
+
+        if (how == DB_NEXT)
+            n = cur->skl_gap ? *skl_link(cur->tbl, n, 0)
+                             : (n ? n->next[0] : NULL);
+        else if (!cur->skl_gap)
+            n = n ? n->prev : NULL;
+        if (n == NULL)
+            return IX_PASTEOF;
+        if (skl_copy_to_cur(cur, n))
+            return -1;
+        return IX_FND;
+    }
+
     REOPEN_CURSOR(cur);
 
     /*Pthread_setspecific(cur->tbl->curkey, cur);*/
@@ -1234,7 +2140,17 @@ static int bdb_temp_table_next_prev_norewind(bdb_state_type *bdb_state,
     memset(&ddata, 0, sizeof(DBT));
 
     ddata.flags = dkey.flags = DB_DBT_MALLOC;
-    rc = cur->cur->c_get(cur->cur, &dkey, &ddata, how);
+
+    /* Between rows since a spill: moving towards the row we're on returns
+       it, unless it has been deleted since. */
+    gethow = how;
+    if ((cur->skl_gap == TMPCUR_GAP_AFTER && how == DB_PREV) ||
+        (cur->skl_gap == TMPCUR_GAP_BEFORE && how == DB_NEXT))
+        gethow = DB_CURRENT;
+    cur->skl_gap = 0;
+    rc = cur->cur->c_get(cur->cur, &dkey, &ddata, gethow);
+    if (rc == DB_KEYEMPTY && gethow == DB_CURRENT)
+        rc = cur->cur->c_get(cur->cur, &dkey, &ddata, how);
     if (rc == DB_NOTFOUND)
         return IX_PASTEOF;
     else if (rc) {
@@ -1468,23 +2384,12 @@ int bdb_temp_table_truncate(bdb_state_type *bdb_state, struct temp_table *tbl,
     } break;
 
     case TEMP_TABLE_TYPE_HASH:
-        if (tbl->temp_hash_tbl) {
-            void *hash_cur;
-            unsigned int hash_cur_buk;
-            char *data;
-
-            data = hash_first(tbl->temp_hash_tbl, &hash_cur, &hash_cur_buk);
-            while (data) {
-                free(data);
-                data = hash_next(tbl->temp_hash_tbl, &hash_cur, &hash_cur_buk);
-            }
-            hash_clear(tbl->temp_hash_tbl);
-            hash_free(tbl->temp_hash_tbl);
-            tbl->temp_hash_tbl = hash_init_user(hashfunc, hashcmpfunc, 0, 0);
-        }
+        /* close the runs too: pooled tables shouldn't hold on to fds */
+        tmph_clear(tbl, 1);
         break;
 
     case TEMP_TABLE_TYPE_ARRAY:
+        tmptbl_unshare(tbl, NULL);
         for (; ii != tbl->num_mem_entries; ++ii) {
             elem = &tbl->elements[ii];
             free(elem->key);
@@ -1493,6 +2398,11 @@ int bdb_temp_table_truncate(bdb_state_type *bdb_state, struct temp_table *tbl,
         tbl->num_mem_entries = 0;
         break;
 
+    case TEMP_TABLE_TYPE_SKIPLIST:
+        skl_reset(tbl);
+        tbl->num_mem_entries = 0;
+        break;
+
     case TEMP_TABLE_TYPE_BTREE:
 
         if (tbl->num_mem_entries < 100)
@@ -1709,32 +2619,33 @@ int bdb_temp_table_destroy_lru(struct temp_table *tbl,
         }
     } break;
 
-    case TEMP_TABLE_TYPE_HASH: {
-        void *hash_cur;
-        unsigned int hash_cur_buk;
-        char *data;
-
-        data = hash_first(tbl->temp_hash_tbl, &hash_cur, &hash_cur_buk);
-        while (data) {
-            free(data);
-            data = hash_next(tbl->temp_hash_tbl, &hash_cur, &hash_cur_buk);
-        }
-        hash_clear(tbl->temp_hash_tbl);
-    } break;
+    case TEMP_TABLE_TYPE_HASH:
+        tmph_clear(tbl, 1);
+        break;
 
     case TEMP_TABLE_TYPE_ARRAY:
+        tmptbl_unshare(tbl, NULL);
         for (ii = 0; ii != tbl->num_mem_entries; ++ii) {
             elem = &tbl->elements[ii];
             free(elem->key);
         }
         break;
 
+    case TEMP_TABLE_TYPE_SKIPLIST:
+        skl_reset(tbl);
+        break;
+
     case TEMP_TABLE_TYPE_BTREE:
         break;
     }
 
-    if (tbl->temp_hash_tbl != NULL)
-        hash_free(tbl->temp_hash_tbl);
+    if (tbl->hash_parts != NULL) {
+        for (ii = 0; ii < TMPTBL_HASH_NPARTS; ++ii) {
+            if (tbl->hash_parts[ii].h != NULL)
+                hash_free(tbl->hash_parts[ii].h);
+        }
+        free(tbl->hash_parts);
+    }
     free(tbl->elements);
 
     /* close the environments*/
@@ -1788,12 +2699,20 @@ int bdb_temp_table_delete(bdb_state_type *bdb_state, struct temp_cursor *cur,
 
     if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_HASH) {
         // AZ: address of data returned by hash_find: cur->key - sizeof(int)
-        rc = hash_del(cur->tbl->temp_hash_tbl, cur->key - sizeof(int));
+        struct temp_hash_part *hp = &cur->tbl->hash_parts[cur->hash_part];
+        rc = hash_del(hp->h, cur->key - sizeof(int));
+        if (rc == 0) {
+            int sz = tmph_entry_size((char *)cur->key - sizeof(int));
+            hp->bytes -= sz;
+            cur->tbl->inmemsz -= sz;
+            cur->tbl->num_mem_entries--;
+        }
         goto done;
     }
 
     if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_ARRAY) {
         elem = &cur->tbl->elements[cur->ind];
+        tmptbl_unshare(cur->tbl, elem->key);
         free(elem->key);
         --cur->tbl->num_mem_entries;
         cur->tbl->inmemsz -= (elem->keylen + elem->dtalen);
@@ -1803,6 +2722,21 @@ int bdb_temp_table_delete(bdb_state_type *bdb_state, struct temp_cursor *cur,
         goto done;
     }
 
+    /* c_del() on a deleted row is DB_KEYEMPTY */
+    if (cur->skl_gap) {
+        *bdberr = DB_KEYEMPTY;
+        return -1;
+    }
+
+    if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_SKIPLIST) {
+        if (cur->skl_node == NULL) {
+            *bdberr = DB_KEYEMPTY;
+            return -1;
+        }
+        rc = skl_delete(cur->tbl, cur->skl_node);
+        goto done;
+    }
+
     REOPEN_CURSOR(cur);
 
     rc = cur->cur->c_del(cur->cur, 0);
@@ -1816,6 +2750,15 @@ done:
     return rc;
 }
 
+/* Have the cursor return the row's own key and data, without copying,
+   when the table is a temparray or a skiplist. The caller must treat them
+   as read-only and must not take them over with
+   bdb_temp_table_reset_datapointers(). */
+void bdb_temp_table_set_zerocopy(struct temp_cursor *cur, int zerocopy)
+{
+    cur->zerocopy = zerocopy;
+}
+
 void bdb_temp_table_set_cmp_func(struct temp_table *tbl, tmptbl_cmp cmpfunc)
 {
     tbl->cmpfunc = cmpfunc;
@@ -1847,45 +2790,83 @@ static int temp_table_compare(DB *db, const DBT *dbt1, const DBT *dbt2)
 }
 
 
-static int bdb_temp_table_find_hash(struct temp_cursor *cur, const void *key, int keylen)
+/* Look key up in a hash temptable, reading its partition back in if the
+   bloom filter can't rule it out. *rcp is 1 if the table should become a
+   btree first. */
+static char *tmph_lookup(struct temp_table *tbl, const void *key, int keylen,
+                         int *partp, int *rcp)
+{
+    struct hashobj *o;
+    struct temp_hash_part *hp;
+    uint64_t h = tmph_hash(key, keylen);
+    int should_free = 0;
+    char *data;
+
+    *partp = TMPH_PARTNO(h);
+    *rcp = 0;
+    hp = &tbl->hash_parts[*partp];
+    if (hp->runbytes) {
+        if (!tmph_bloom_test(hp, h))
+            return NULL;
+        if ((*rcp = tmph_load_part(tbl, *partp, 1)) != 0)
+            return NULL;
+    }
+
+    if (keylen + sizeof(int) < 64*1024)
+        o = alloca(keylen + sizeof(int));
+    else {
+        o = malloc(keylen + sizeof(int));
+        should_free = 1;
+    }
+    o->len = keylen;
+    memcpy(o->data, key, keylen);
+
+    data = hash_find(hp->h, o);
+    if (should_free)
+        free(o);
+    return data;
+}
+
+static int bdb_temp_table_find_hash(bdb_state_type *bdb_state,
+                                    struct temp_cursor *cur, const void *key,
+                                    int keylen, int *bdberr)
 {
         char *data = NULL;
+        int part = 0, rc, ii;
         cur->valid = 0;
-        if (!cur->tbl->temp_hash_tbl) {
+        if (!cur->tbl->hash_parts) {
             return IX_EMPTY;
         }
         if (keylen != 0 && key != NULL) {
-            struct hashobj *o;
-            int should_free = 0;
-
-            if (keylen + sizeof(int) < 64*1024)
-                o = alloca(keylen + sizeof(int));
-            else {
-                o = malloc(keylen + sizeof(int));
-                should_free = 1;
+            data = tmph_lookup(cur->tbl, key, keylen, &part, &rc);
+            if (rc == 1) {
+                rc = bdb_hash_table_copy_to_temp_db(bdb_state, cur->tbl,
+                                                    bdberr);
+                if (rc)
+                    return -1;
+                return bdb_temp_table_find(bdb_state, cur, key, keylen, NULL,
+                                           bdberr);
+            } else if (rc) {
+                return -1;
             }
-            o->len = keylen;
-            memcpy(o->data, key, keylen);
-
-            data = hash_find(cur->tbl->temp_hash_tbl, o);
-            if (should_free)
-                free(o);
         }
-        if (!data) { /* find anything at all if possible */
-            data = hash_first(cur->tbl->temp_hash_tbl, &cur->hash_cur,
+        /* find anything at all if possible, without reading runs back */
+        for (ii = 0; !data && ii < TMPTBL_HASH_NPARTS; ++ii) {
+            part = ii;
+            data = hash_first(cur->tbl->hash_parts[ii].h, &cur->hash_cur,
                               &cur->hash_cur_buk);
         }
-
-        if (data) {
-            cur->keylen = *(int *)data;
-            cur->key = data + sizeof(int);
-            cur->datalen = *(int *)(data + cur->keylen + sizeof(int));
-            ;
-            cur->data = data + cur->keylen + 2 * sizeof(int);
-            cur->valid = 1;
-        } else {
-            return IX_EMPTY;
+        if (!data) {
+            rc = tmph_first_from(cur, 0, 0);
+            return (rc == IX_PASTEOF) ? IX_EMPTY : rc;
         }
+
+        cur->keylen = *(int *)data;
+        cur->key = data + sizeof(int);
+        cur->datalen = *(int *)(data + cur->keylen + sizeof(int));
+        cur->data = data + cur->keylen + 2 * sizeof(int);
+        cur->hash_part = part;
+        cur->valid = 1;
         return 0;
     }
 
@@ -1905,7 +2886,7 @@ int bdb_temp_table_find(bdb_state_type *bdb_state, struct temp_cursor *cur,
         return -1;
     }
     else if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_HASH) {
-        return bdb_temp_table_find_hash(cur, key, keylen);
+        return bdb_temp_table_find_hash(bdb_state, cur, key, keylen, bdberr);
     }
 
     if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_ARRAY) {
@@ -1951,6 +2932,21 @@ int bdb_temp_table_find(bdb_state_type *bdb_state, struct temp_cursor *cur,
         return 0;
     }
 
+    if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_SKIPLIST) {
+        skl_node_t *n;
+
+        /* Like DB_SET_RANGE, but land on the last row rather than
+           nothing if key is past the end. */
+        n = skl_seek(cur->tbl, key, keylen, unpacked, NULL, &cmp);
+        if (n == NULL)
+            n = cur->tbl->skl_tail;
+        if (n == NULL) {
+            cur->valid = 0;
+            return IX_EMPTY;
+        }
+        return skl_copy_to_cur(cur, n);
+    }
+
     REOPEN_CURSOR(cur);
 
     /*Pthread_setspecific(cur->tbl->curkey, cur);*/
@@ -1962,6 +2958,7 @@ int bdb_temp_table_find(bdb_state_type *bdb_state, struct temp_cursor *cur,
     dkey.size = keylen;
     dkey.app_data = unpacked;
     cur->valid = 0;
+    cur->skl_gap = 0;
     rc = cur->cur->c_get(cur->cur, &dkey, &ddata, DB_SET_RANGE);
     if (rc == DB_NOTFOUND) {
         rc = bdb_temp_table_last(bdb_state, cur, bdberr);
@@ -2009,31 +3006,29 @@ done:
 }
 
 
-static int bdb_temp_table_find_exact_hash(struct temp_cursor *cur, 
-                                             void *key, int keylen)
+static int bdb_temp_table_find_exact_hash(bdb_state_type *bdb_state,
+                                          struct temp_cursor *cur, void *key,
+                                          int keylen, int *bdberr)
 {
-    struct hashobj *o;
-    int should_free = 0;
-
-    if (keylen < 64*1024)
-        o = alloca(keylen + sizeof(int));
-    else {
-        o = malloc(keylen + sizeof(int));
-        should_free = 1;
-    }
+    int part, rc;
 
     cur->valid = 0;
-    o->len = keylen;
-    memcpy(o->data, key, keylen);
-    char *data = hash_find(cur->tbl->temp_hash_tbl, o);
-    if (should_free)
-        free(o);
+    char *data = tmph_lookup(cur->tbl, key, keylen, &part, &rc);
+    if (rc == 1) {
+        rc = bdb_hash_table_copy_to_temp_db(bdb_state, cur->tbl, bdberr);
+        if (rc)
+            return -1;
+        return bdb_temp_table_find_exact(bdb_state, cur, key, keylen, bdberr);
+    } else if (rc) {
+        return -1;
+    }
 
     if (data) {
         cur->keylen = *(int *)data;
         cur->key = data + sizeof(int);
         cur->datalen = *(int *)(data + cur->keylen + sizeof(int));
         cur->data = data + cur->keylen + 2 * sizeof(int);
+        cur->hash_part = part;
         cur->valid = 1;
     } else {
         return IX_NOTFND;
@@ -2061,7 +3056,8 @@ int bdb_temp_table_find_exact(bdb_state_type *bdb_state,
     }
 
     if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_HASH) {
-        return bdb_temp_table_find_exact_hash(cur, key, keylen);
+        return bdb_temp_table_find_exact_hash(bdb_state, cur, key, keylen,
+                                              bdberr);
     }
 
     if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_ARRAY) {
@@ -2103,6 +3099,19 @@ int bdb_temp_table_find_exact(bdb_state_type *bdb_state,
         return 0;
     }
 
+    if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_SKIPLIST) {
+        skl_node_t *n;
+
+        n = skl_seek(cur->tbl, key, keylen, NULL, NULL, &cmp);
+        if (n == NULL || cmp != 0) {
+            cur->valid = 0;
+            return IX_NOTFND;
+        }
+        if (skl_copy_to_cur(cur, n))
+            return -1;
+        return IX_FND;
+    }
+
     REOPEN_CURSOR(cur);
 
     /* Make a copy of the user key */
@@ -2118,6 +3127,7 @@ int bdb_temp_table_find_exact(bdb_state_type *bdb_state,
     dkey.size = keylen;
 
     cur->valid = 0;
+    cur->skl_gap = 0;
     rc = cur->cur->c_get(cur->cur, &dkey, &ddata, DB_SET);
 
     if (rc == DB_NOTFOUND) {
@@ -2183,7 +3193,13 @@ static int bdb_temp_table_reset_cursor(bdb_state_type *bdb_state, struct temp_cu
     tbl = cur->tbl;
 
     if (tbl->temp_table_type == TEMP_TABLE_TYPE_BTREE ||
-        tbl->temp_table_type == TEMP_TABLE_TYPE_ARRAY) {
+        tbl->temp_table_type == TEMP_TABLE_TYPE_ARRAY ||
+        tbl->temp_table_type == TEMP_TABLE_TYPE_SKIPLIST) {
+        if (cur->borrowed) {
+            cur->key = cur->data = NULL;
+            cur->borrowed = 0;
+        }
+
         if (cur->key) {
             free(cur->key);
             cur->key = NULL;
@@ -2194,6 +3210,9 @@ static int bdb_temp_table_reset_cursor(bdb_state_type *bdb_state, struct temp_cu
             cur->data = NULL;
         }
 
+        cur->skl_node = NULL;
+        cur->skl_gap = 0;
+
         /* A cursor on a temparray will not have `cur'. */
         if (cur->cur) {
             rc = cur->cur->c_close(cur->cur);
@@ -2357,9 +3376,10 @@ int bdb_temp_table_maybe_reset_priority_thread(bdb_state_type *bdb_state,
 }
 
 static int bdb_temp_table_insert_put(bdb_state_type *bdb_state,
-                                     struct temp_table *tbl, void *key,
+                                     struct temp_table *tbl,
+                                     struct temp_cursor *cur, void *key,
                                      int keylen, void *data, int dtalen,
-                                     int *bdberr)
+                                     void *unpacked, int *bdberr)
 {
     int rc, cmp, lo, hi, mid;
     tmptbl_cmp cmpfn;
@@ -2379,24 +3399,51 @@ static int bdb_temp_table_insert_put(bdb_state_type *bdb_state,
     if (tbl->temp_table_type == TEMP_TABLE_TYPE_HASH) {
         void *hash_data;
         void *old;
+        uint64_t h = tmph_hash(key, keylen);
+        struct temp_hash_part *hp = &tbl->hash_parts[TMPH_PARTNO(h)];
+        int sz = keylen + dtalen + 2 * sizeof(int);
 
-        hash_data = malloc(keylen + dtalen + 2 * sizeof(int));
+        hash_data = malloc(sz);
+        if (hash_data == NULL)
+            return -1;
         memcpy(hash_data, &keylen, sizeof(int));
         memcpy((uint8_t *)hash_data + sizeof(int), key, keylen);
-        old = hash_find(tbl->temp_hash_tbl, hash_data);
+        memcpy((uint8_t *)hash_data + keylen + sizeof(int), &dtalen,
+               sizeof(int));
+        memcpy((uint8_t *)hash_data + keylen + 2 * sizeof(int), data, dtalen);
+
+        if (hp->runbytes) {
+            /* The partition is on disk. Reading it back drops this row if
+               its key was already there. */
+            rc = fwrite(hash_data, sz, 1, hp->run) != 1;
+            free(hash_data);
+            if (unlikely(rc)) {
+                logmsg(LOGMSG_ERROR, "%s: fwrite %s\n", __func__,
+                       strerror(errno));
+                return -1;
+            }
+            tmph_bloom_add(hp, h);
+            hp->runbytes += sz;
+            return 0;
+        }
+
+        old = hash_find(hp->h, hash_data);
 
         if (old == NULL) {
-            memcpy((uint8_t *)hash_data + keylen + sizeof(int), &dtalen,
-                   sizeof(int));
-            memcpy((uint8_t *)hash_data + keylen + 2 * sizeof(int), data,
-                   dtalen);
-            hash_add(tbl->temp_hash_tbl, hash_data);
+            hash_add(hp->h, hash_data);
+            hp->bytes += sz;
+            tbl->inmemsz += sz;
             tbl->num_mem_entries++;
         } else {
             free(hash_data);
         }
 
-        if (tbl->num_mem_entries > tbl->max_mem_entries) {
+        /* Partition runs are plain files: an encrypted database's temp
+           tables only spill to its encrypted berkdb environment. */
+        if (gbl_temptable_grace_hash && !gbl_crypto) {
+            if (tbl->inmemsz > tbl->cachesz)
+                tmph_make_room(tbl, 0, -1);
+        } else if (tbl->num_mem_entries > tbl->max_mem_entries) {
             gbl_temptable_spills++;
             rc = bdb_hash_table_copy_to_temp_db(bdb_state, tbl, bdberr);
             if (unlikely(rc)) {
@@ -2464,6 +3511,30 @@ static int bdb_temp_table_insert_put(bdb_state_type *bdb_state,
         return 0;
     }
 
+    if (tbl->temp_table_type == TEMP_TABLE_TYPE_SKIPLIST) {
+        skl_node_t *n;
+
+        n = skl_insert(tbl, key, keylen, data, dtalen, unpacked);
+        if (n == NULL)
+            return -1;
+
+        /* a berkdb cursor is left on the row it put */
+        if (cur) {
+            cur->skl_node = n;
+            cur->skl_gap = 0;
+        }
+
+        if (tbl->inmemsz > tbl->cachesz) {
+            gbl_temptable_spills++;
+            rc = bdb_skiplist_copy_to_temp_db(bdb_state, tbl, bdberr);
+            if (unlikely(rc)) {
+                return -1;
+            }
+        }
+
+        return 0;
+    }
+
     assert (tbl->temp_table_type == TEMP_TABLE_TYPE_BTREE);
     tbl->num_mem_entries++;
 
@@ -2480,7 +3551,8 @@ inline const char *bdb_temp_table_filename(struct temp_table *tbl)
 inline void bdb_temp_table_flush(struct temp_table *tbl)
 {
     DB *db = tbl->tmpdb;
-    db->sync(db, 0);
+    if (db)
+        db->sync(db, 0);
 }
 
 int bdb_temp_table_stat(bdb_state_type *bdb_state, DB_MPOOL_STAT **gspp)
@@ -2643,3 +3715,390 @@ int bdb_temp_table_insert_test(bdb_state_type *bdb_state, int recsz, int maxins)
     rc = bdb_temp_table_close(parent, db, &bdberr);
     return rc;
 }
+
+#define SPILLTEST_DTALEN 200
+
+static void spilltest_row(int k, uint8_t *key, uint8_t *dta)
+{
+    key[0] = k >> 24;
+    key[1] = k >> 16;
+    key[2] = k >> 8;
+    key[3] = k;
+    memset(dta, k & 0xff, SPILLTEST_DTALEN);
+}
+
+/* The key of the row a move left the cursor on, -1 if it found none, or -2
+   if the row it shows isn't one we wrote. */
+static int spilltest_key(struct temp_cursor *cur, int rc)
+{
+    uint8_t *key, *dta;
+    int k;
+
+    if (rc)
+        return -1;
+    key = bdb_temp_table_key(cur);
+    dta = bdb_temp_table_data(cur);
+    k = key[0] << 24 | key[1] << 16 | key[2] << 8 | key[3];
+    if (bdb_temp_table_keysize(cur) != 4 ||
+        bdb_temp_table_datasize(cur) != SPILLTEST_DTALEN ||
+        dta[0] != (k & 0xff) || dta[SPILLTEST_DTALEN - 1] != (k & 0xff))
+        return -2;
+    return k;
+}
+
+#define SPILLTEST_CHECK(what, got, want)                                       \
+    do {                                                                       \
+        int got_ = (got);                                                      \
+        if (got_ != (want)) {                                                  \
+            logmsg(LOGMSG_ERROR, "%s: %s: got %d, want %d\n", __func__,        \
+                   what, got_, (want));                                        \
+            goto out;                                                          \
+        }                                                                      \
+    } while (0)
+
+/* Fill a skiplist with even keys, leave cursors on rows and between rows,
+   then spill it with more rows: every cursor must carry on from where it
+   was, as it would have without the spill. Zerocopy cursors must see their
+   row as it was when they got to it through inserts, updates, deletes and
+   the spill. */
+static int tmptbl_skiplist_spill_test(bdb_state_type *bdb_state)
+{
+    struct temp_table *tbl;
+    struct temp_cursor *on, *mid_next, *mid_prev, *first_next, *first_prev;
+    struct temp_cursor *first_gone, *last_next, *last_prev, *scan;
+    struct temp_cursor *zc_keep, *zc_upd, *zc_del;
+    uint8_t key[4], dta[SPILLTEST_DTALEN];
+    void *zc_key;
+    int bdberr, i, k, last, nrows, nspill, prev, rc = -1;
+
+    tbl = bdb_temp_table_create_type(bdb_state, TEMP_TABLE_TYPE_SKIPLIST,
+                                     &bdberr);
+    if (tbl == NULL)
+        return -1;
+
+    for (nrows = 0; tbl->inmemsz < tbl->cachesz / 2; nrows++) {
+        spilltest_row(2 * nrows, key, dta);
+        SPILLTEST_CHECK("put", bdb_temp_table_put(bdb_state, tbl, key, 4, dta,
+                                                  sizeof(dta), NULL, &bdberr),
+                        0);
+    }
+    last = 2 * (nrows - 1);
+
+    on = bdb_temp_table_cursor(bdb_state, tbl, NULL, &bdberr);
+    mid_next = bdb_temp_table_cursor(bdb_state, tbl, NULL, &bdberr);
+    mid_prev = bdb_temp_table_cursor(bdb_state, tbl, NULL, &bdberr);
+    first_next = bdb_temp_table_cursor(bdb_state, tbl, NULL, &bdberr);
+    first_prev = bdb_temp_table_cursor(bdb_state, tbl, NULL, &bdberr);
+    first_gone = bdb_temp_table_cursor(bdb_state, tbl, NULL, &bdberr);
+    last_next = bdb_temp_table_cursor(bdb_state, tbl, NULL, &bdberr);
+    last_prev = bdb_temp_table_cursor(bdb_state, tbl, NULL, &bdberr);
+    scan = bdb_temp_table_cursor(bdb_state, tbl, NULL, &bdberr);
+    zc_keep = bdb_temp_table_cursor(bdb_state, tbl, NULL, &bdberr);
+    zc_upd = bdb_temp_table_cursor(bdb_state, tbl, NULL, &bdberr);
+    zc_del = bdb_temp_table_cursor(bdb_state, tbl, NULL, &bdberr);
+    if (!on || !mid_next || !mid_prev || !first_next || !first_prev ||
+        !first_gone || !last_next || !last_prev || !scan || !zc_keep ||
+        !zc_upd || !zc_del)
+        goto out;
+
+    /* on a row */
+    spilltest_row(10, key, dta);
+    SPILLTEST_CHECK("find 10",
+                    bdb_temp_table_find_exact(bdb_state, on, key, 4, &bdberr),
+                    IX_FND);
+
+    /* between 18 and 22 */
+    spilltest_row(20, key, dta);
+    bdb_temp_table_find_exact(bdb_state, mid_next, key, 4, &bdberr);
+    bdb_temp_table_find_exact(bdb_state, mid_prev, key, 4, &bdberr);
+    SPILLTEST_CHECK("delete 20",
+                    bdb_temp_table_delete(bdb_state, mid_next, &bdberr), 0);
+
+    /* in front of the first row */
+    spilltest_row(0, key, dta);
+    bdb_temp_table_find_exact(bdb_state, first_next, key, 4, &bdberr);
+    bdb_temp_table_find_exact(bdb_state, first_prev, key, 4, &bdberr);
+    bdb_temp_table_find_exact(bdb_state, first_gone, key, 4, &bdberr);
+    SPILLTEST_CHECK("delete 0",
+                    bdb_temp_table_delete(bdb_state, first_next, &bdberr), 0);
+
+    /* after the last row */
+    spilltest_row(last, key, dta);
+    bdb_temp_table_find_exact(bdb_state, last_next, key, 4, &bdberr);
+    bdb_temp_table_find_exact(bdb_state, last_prev, key, 4, &bdberr);
+    SPILLTEST_CHECK("delete last",
+                    bdb_temp_table_delete(bdb_state, last_next, &bdberr), 0);
+
+    /* zerocopy cursors on 30, 40 and 50 */
+    bdb_temp_table_set_zerocopy(zc_keep, 1);
+    bdb_temp_table_set_zerocopy(zc_upd, 1);
+    bdb_temp_table_set_zerocopy(zc_del, 1);
+    spilltest_row(40, key, dta);
+    SPILLTEST_CHECK("zerocopy find 40",
+                    spilltest_key(zc_keep, bdb_temp_table_find_exact(
+                                               bdb_state, zc_keep, key, 4,
+                                               &bdberr)),
+                    40);
+    zc_key = bdb_temp_table_key(zc_keep);
+    spilltest_row(30, key, dta);
+    bdb_temp_table_find_exact(bdb_state, zc_upd, key, 4, &bdberr);
+    spilltest_row(50, key, dta);
+    bdb_temp_table_find_exact(bdb_state, zc_del, key, 4, &bdberr);
+
+    /* rows around them come and go, and 30 gets new data under zc_upd */
+    for (k = 31; k <= 51; k += 10) {
+        spilltest_row(k, key, dta);
+        SPILLTEST_CHECK("put odd", bdb_temp_table_put(bdb_state, tbl, key, 4,
+                                                      dta, sizeof(dta), NULL,
+                                                      &bdberr),
+                        0);
+    }
+    spilltest_row(42, key, dta);
+    bdb_temp_table_find_exact(bdb_state, scan, key, 4, &bdberr);
+    SPILLTEST_CHECK("delete 42", bdb_temp_table_delete(bdb_state, scan, &bdberr),
+                    0);
+    spilltest_row(50, key, dta);
+    bdb_temp_table_find_exact(bdb_state, scan, key, 4, &bdberr);
+    SPILLTEST_CHECK("delete 50", bdb_temp_table_delete(bdb_state, scan, &bdberr),
+                    0);
+    spilltest_row(30, key, dta);
+    bdb_temp_table_find_exact(bdb_state, scan, key, 4, &bdberr);
+    dta[1] = ~30;
+    SPILLTEST_CHECK("update 30",
+                    bdb_temp_table_update(bdb_state, scan, key, 4, dta,
+                                          sizeof(dta), &bdberr),
+                    0);
+
+    /* zc_keep still points into the table, zc_upd has its old row */
+    SPILLTEST_CHECK("zerocopy kept", bdb_temp_table_key(zc_keep) == zc_key, 1);
+    SPILLTEST_CHECK("zerocopy 40", spilltest_key(zc_keep, 0), 40);
+    SPILLTEST_CHECK("zerocopy 30", spilltest_key(zc_upd, 0), 30);
+    SPILLTEST_CHECK("zerocopy 30 data",
+                    ((uint8_t *)bdb_temp_table_data(zc_upd))[1], 30);
+    SPILLTEST_CHECK("zerocopy 50", spilltest_key(zc_del, 0), 50);
+
+    /* odd keys after all of those, until the skiplist spills */
+    for (nspill = 0; tbl->temp_table_type == TEMP_TABLE_TYPE_SKIPLIST &&
+                     nspill < 10 * nrows;
+         nspill++) {
+        spilltest_row(2 * (nrows + nspill) + 1, key, dta);
+        SPILLTEST_CHECK("spill put",
+                        bdb_temp_table_put(bdb_state, tbl, key, 4, dta,
+                                           sizeof(dta), NULL, &bdberr),
+                        0);
+    }
+    SPILLTEST_CHECK("spilled", tbl->temp_table_type, TEMP_TABLE_TYPE_BTREE);
+
+    SPILLTEST_CHECK("on", spilltest_key(on, 0), 10);
+    SPILLTEST_CHECK("on next",
+                    spilltest_key(on, bdb_temp_table_next(bdb_state, on,
+                                                          &bdberr)),
+                    12);
+    SPILLTEST_CHECK("on prev",
+                    spilltest_key(on, bdb_temp_table_prev(bdb_state, on,
+                                                          &bdberr)),
+                    10);
+    SPILLTEST_CHECK("mid next",
+                    spilltest_key(mid_next, bdb_temp_table_next(
+                                                bdb_state, mid_next, &bdberr)),
+                    22);
+    SPILLTEST_CHECK("mid prev",
+                    spilltest_key(mid_prev, bdb_temp_table_prev(
+                                                bdb_state, mid_prev, &bdberr)),
+                    18);
+    SPILLTEST_CHECK("first prev",
+                    spilltest_key(first_prev,
+                                  bdb_temp_table_prev_norewind(
+                                      bdb_state, first_prev, &bdberr)),
+                    -1);
+    SPILLTEST_CHECK("first next",
+                    spilltest_key(first_next,
+                                  bdb_temp_table_next(bdb_state, first_next,
+                                                      &bdberr)),
+                    2);
+    SPILLTEST_CHECK("last next",
+                    spilltest_key(last_next, bdb_temp_table_next(
+                                                 bdb_state, last_next, &bdberr)),
+                    2 * nrows + 1);
+    SPILLTEST_CHECK("last prev",
+                    spilltest_key(last_prev, bdb_temp_table_prev(
+                                                 bdb_state, last_prev, &bdberr)),
+                    last - 2);
+
+    SPILLTEST_CHECK("zerocopy 40 spilled", spilltest_key(zc_keep, 0), 40);
+    SPILLTEST_CHECK("zerocopy 40 next",
+                    spilltest_key(zc_keep, bdb_temp_table_next(
+                                               bdb_state, zc_keep, &bdberr)),
+                    41);
+    SPILLTEST_CHECK("zerocopy 30 spilled", spilltest_key(zc_upd, 0), 30);
+    SPILLTEST_CHECK("zerocopy 30 data spilled",
+                    ((uint8_t *)bdb_temp_table_data(zc_upd))[1], 30);
+    SPILLTEST_CHECK("zerocopy 30 next",
+                    spilltest_key(zc_upd, bdb_temp_table_next(
+                                              bdb_state, zc_upd, &bdberr)),
+                    31);
+    SPILLTEST_CHECK("zerocopy 50 spilled", spilltest_key(zc_del, 0), 50);
+    SPILLTEST_CHECK("zerocopy 50 next",
+                    spilltest_key(zc_del, bdb_temp_table_next(
+                                              bdb_state, zc_del, &bdberr)),
+                    51);
+    spilltest_row(30, key, dta);
+    bdb_temp_table_find_exact(bdb_state, scan, key, 4, &bdberr);
+    SPILLTEST_CHECK("updated 30", ((uint8_t *)bdb_temp_table_data(scan))[1],
+                    (uint8_t)~30);
+
+    /* the row after a gap goes away before we move into it */
+    SPILLTEST_CHECK("delete 2",
+                    bdb_temp_table_delete(bdb_state, first_next, &bdberr), 0);
+    SPILLTEST_CHECK("first gone next",
+                    spilltest_key(first_gone,
+                                  bdb_temp_table_next(bdb_state, first_gone,
+                                                      &bdberr)),
+                    4);
+
+    /* every row once, in order */
+    prev = -1;
+    for (i = 0, rc = bdb_temp_table_first(bdb_state, scan, &bdberr); rc == 0;
+         i++, rc = bdb_temp_table_next(bdb_state, scan, &bdberr)) {
+        k = spilltest_key(scan, 0);
+        if (k <= prev) {
+            logmsg(LOGMSG_ERROR, "%s: scan: %d after %d\n", __func__, k, prev);
+            rc = -1;
+            goto out;
+        }
+        prev = k;
+    }
+    rc = -1;
+    SPILLTEST_CHECK("scan rows", i, nrows - 4 + nspill + 3 - 2);
+    rc = 0;
+
+out:
+    bdb_temp_table_close(bdb_state, tbl, &bdberr);
+    return rc;
+}
+
+/* Fill a hash temptable to twice its cache: lookups must find every row
+   whether its partition was spilled or not, keep the first of duplicate
+   keys, and the bloom filters of spilled partitions must never rule out a
+   row they hold. Nothing is written out in the clear under encryption. */
+static int tmptbl_hash_spill_test(bdb_state_type *bdb_state)
+{
+    struct temp_table *tbl;
+    struct temp_cursor *cur = NULL;
+    struct temp_hash_part *hp;
+    uint8_t key[4], dta[SPILLTEST_DTALEN], *seen = NULL;
+    uint64_t h;
+    int bdberr, i, k, nrows, nruns, nabsent, nfalse, rc = -1;
+
+    tbl = bdb_temp_table_create_type(bdb_state, TEMP_TABLE_TYPE_HASH, &bdberr);
+    if (tbl == NULL)
+        return -1;
+
+    nrows = 2 * tbl->cachesz / (sizeof(key) + sizeof(dta) + 2 * sizeof(int));
+    for (i = 0; i < nrows; i++) {
+        spilltest_row(i, key, dta);
+        SPILLTEST_CHECK("put", bdb_temp_table_put(bdb_state, tbl, key, 4, dta,
+                                                  sizeof(dta), NULL, &bdberr),
+                        0);
+    }
+
+    nruns = 0;
+    if (tbl->temp_table_type == TEMP_TABLE_TYPE_HASH) {
+        for (i = 0; i < TMPTBL_HASH_NPARTS; i++)
+            nruns += (tbl->hash_parts[i].runbytes != 0);
+    }
+    if (gbl_crypto || !gbl_temptable_grace_hash) {
+        SPILLTEST_CHECK("runs", nruns, 0);
+    } else {
+        if (nruns == 0) {
+            logmsg(LOGMSG_ERROR, "%s: no partition spilled\n", __func__);
+            goto out;
+        }
+
+        nabsent = nfalse = 0;
+        for (i = 0; i < 2 * nrows; i++) {
+            spilltest_row(i, key, dta);
+            h = tmph_hash(key, 4);
+            hp = &tbl->hash_parts[TMPH_PARTNO(h)];
+            if (hp->runbytes == 0)
+                continue;
+            if (i < nrows) {
+                SPILLTEST_CHECK("bloom", tmph_bloom_test(hp, h), 1);
+            } else {
+                nabsent++;
+                nfalse += tmph_bloom_test(hp, h);
+            }
+        }
+        if (nfalse * 10 > nabsent) {
+            logmsg(LOGMSG_ERROR, "%s: bloom passed %d of %d absent keys\n",
+                   __func__, nfalse, nabsent);
+            goto out;
+        }
+    }
+
+    /* a later row with the same key is dropped, spilled or not (a btree
+       put replaces the row instead) */
+    for (i = 0; tbl->temp_table_type == TEMP_TABLE_TYPE_HASH && i < nrows;
+         i += nrows / 16) {
+        spilltest_row(i, key, dta);
+        memset(dta, ~i & 0xff, sizeof(dta));
+        SPILLTEST_CHECK("put dup",
+                        bdb_temp_table_put(bdb_state, tbl, key, 4, dta,
+                                           sizeof(dta), NULL, &bdberr),
+                        0);
+    }
+
+    cur = bdb_temp_table_cursor(bdb_state, tbl, NULL, &bdberr);
+    if (cur == NULL)
+        goto out;
+    for (i = nrows; i < nrows + 1000; i++) {
+        spilltest_row(i, key, dta);
+        SPILLTEST_CHECK("find absent",
+                        bdb_temp_table_find_exact(bdb_state, cur, key, 4,
+                                                  &bdberr),
+                        IX_NOTFND);
+    }
+    for (i = 0; i < nrows; i++) {
+        spilltest_row(i, key, dta);
+        SPILLTEST_CHECK("find",
+                        spilltest_key(cur, bdb_temp_table_find_exact(
+                                               bdb_state, cur, key, 4, &bdberr)),
+                        i);
+    }
+
+    /* every row once */
+    if ((seen = calloc(nrows, 1)) == NULL)
+        goto out;
+    for (i = 0, rc = bdb_temp_table_first(bdb_state, cur, &bdberr); rc == 0;
+         i++, rc = bdb_temp_table_next(bdb_state, cur, &bdberr)) {
+        k = spilltest_key(cur, 0);
+        if (k < 0 || k >= nrows || seen[k]++) {
+            logmsg(LOGMSG_ERROR, "%s: scan: unexpected row %d\n", __func__, k);
+            rc = -1;
+            goto out;
+        }
+    }
+    rc = -1;
+    SPILLTEST_CHECK("scan rows", i, nrows);
+    rc = 0;
+
+out:
+    free(seen);
+    bdb_temp_table_close(bdb_state, tbl, &bdberr);
+    return rc;
+}
+
+/* Check that temptables which outgrow memory keep their cursors and rows. */
+int bdb_temp_table_spill_test(bdb_state_type *bdb_state)
+{
+    int rc;
+
+    if (bdb_state->parent)
+        bdb_state = bdb_state->parent;
+
+    rc = tmptbl_skiplist_spill_test(bdb_state);
+    if (rc == 0)
+        rc = tmptbl_hash_spill_test(bdb_state);
+    logmsg(LOGMSG_USER, "temptable spill test %s\n", rc ? "FAILED" : "passed");
+    return rc;
+}
@@ -88,6 +88,10 @@ static inline int try_set(int *thread_running)
     return CAS32(*thread_running, zero, 1);
 }
 
+extern int gbl_mpool_pace_writeback;
+extern int gbl_mpool_pace_msecs;
+extern int __memp_trickle_paced(DB_ENV *, int, int *);
+
 void *memp_trickle_thread(void *arg)
 {
     unsigned int time;
@@ -121,6 +125,19 @@ void *memp_trickle_thread(void *arg)
         /* time is in usecs, memptricklemsecs is in msecs */
         time = bdb_state->attr->memptricklemsecs * 1000;
 
+        if (gbl_mpool_pace_writeback) {
+            rc = __memp_trickle_paced(bdb_state->dbenv,
+                                      bdb_state->attr->checkpointtime, &nwrote);
+            BDB_RELLOCK();
+            if (db_is_exiting())
+                break;
+            if (rc == DB_LOCK_DESIRED)
+                sleep(1);
+            else
+                poll(0, 0, gbl_mpool_pace_msecs > 0 ? gbl_mpool_pace_msecs : 1);
+            continue;
+        }
+
     again:
         rc = bdb_state->dbenv->memp_trickle(
             bdb_state->dbenv, bdb_state->attr->memptricklepercent, &nwrote, 1);
@@ -274,6 +291,9 @@ void *coherency_lease_thread(void *arg)
         if (repinfo->master_host == repinfo->myhost) {
             send_coherency_leases(bdb_state, lease_time, &inc_wait);
 
+            /* Don't let a partial log batch sit while we're idle. */
+            bdb_rep_batch_flush(bdb_state);
+
             if (bdb_state->attr->durable_lsns) {
                 /* See if master has written a durable LSN */
                 bdb_state->dbenv->get_rep_gen(bdb_state->dbenv, &current_gen);
@@ -351,15 +371,53 @@ int64_t gbl_last_checkpoint_ms;
 int64_t gbl_total_checkpoint_ms;
 int gbl_checkpoint_count;
 int gbl_cache_flush_interval = 30;
+int gbl_load_cache_background = 1;
 int backend_opened(void);
 
+/* Set while a background cache load thread is running. */
+static volatile int loading_cache;
+
+/* Load the saved page list without holding up checkpoints. */
+static void *load_cache_thread(void *arg)
+{
+    bdb_state_type *bdb_state = (bdb_state_type *)arg;
+
+    thrman_register(THRTYPE_GENERIC);
+    thread_started("bdb load cache");
+    bdb_thread_event(bdb_state, BDBTHR_EVENT_START_RDONLY);
+
+    BDB_READLOCK("load_cache_thread");
+    bdb_state->dbenv->memp_load_default(bdb_state->dbenv);
+    BDB_RELLOCK();
+
+    bdb_thread_event(bdb_state, BDBTHR_EVENT_DONE_RDONLY);
+    loading_cache = 0;
+    return NULL;
+}
+
+/* A cache load that gave up early is started again, once a flush interval
+   and at most this many times, before its page list is dumped over. */
+#define CACHE_LOAD_RETRIES 3
+
+static int cache_load_stopped(bdb_state_type *bdb_state)
+{
+    int running, stopped, start, end;
+    uint64_t pages, pages_done, pages_read;
+
+    if (loading_cache)
+        return 0;
+    bdb_get_cache_warmup(bdb_state, &running, &stopped, &start, &end, &pages,
+                         &pages_done, &pages_read);
+    return stopped && !running;
+}
+
 void *checkpoint_thread(void *arg)
 {
     int rc, now;
     int checkpointtime;
     int checkpointtimepoll;
     int checkpointrand;
-    int loaded_cache = 0, last_cache_dump = 0;
+    int cache_loads = 0, last_cache_dump = 0;
     bdb_state_type *bdb_state;
     int start, end;
     int total_sleep_msec;
@@ -420,9 +478,19 @@ void *checkpoint_thread(void *arg)
          * cache until the backend has opened */
         if ((gbl_cache_flush_interval > 0) &&
             ((now = time(NULL)) - last_cache_dump) > gbl_cache_flush_interval) {
-            if (!loaded_cache) {
-                bdb_state->dbenv->memp_load_default(bdb_state->dbenv);
-                loaded_cache = 1;
+            if (cache_loads == 0 ||
+                (cache_loads <= CACHE_LOAD_RETRIES &&
+                 cache_load_stopped(bdb_state))) {
+                pthread_t tid;
+                loading_cache = gbl_load_cache_background;
+                if (!gbl_load_cache_background ||
+                    pthread_create(&tid, &gbl_pthread_attr_detached,
+                                   load_cache_thread, bdb_state) != 0) {
+                    loading_cache = 0;
+                    bdb_state->dbenv->memp_load_default(bdb_state->dbenv);
+                }
+                ++cache_loads;
+                last_cache_dump = now;
             } else {
                 bdb_state->dbenv->memp_dump_default(bdb_state->dbenv, 0);
                 last_cache_dump = now;
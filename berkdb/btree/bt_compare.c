@@ -56,6 +56,7 @@ static const char revid[] = "$Id: bt_compare.c,v 11.18 2003/01/08 04:00:56 bosti
 #include "dbinc/btree.h"
 
 #include <btree/bt_prefix.h>
+#include <btree/bt_keycmp.h>
 
 /*
  * __bam_cmp --
@@ -77,6 +78,7 @@ __bam_cmp(dbp, dbt, h, indx, func, cmpp)
 	BKEYDATA *bk;
 	BOVERFLOW *bo;
 	DBT pg_dbt;
+	u_int32_t lcp;
 
 	/*
 	 * Returns:
@@ -105,7 +107,11 @@ __bam_cmp(dbp, dbt, h, indx, func, cmpp)
 			pg_dbt.data = bk->data;
 			ASSIGN_ALIGN_DIFF(u_int32_t, pg_dbt.size,
 			    db_indx_t, bk->len);
-			*cmpp = func(dbp, dbt, &pg_dbt);
+			if (func == __bam_defcmp)
+				*cmpp = bt_keycmp_skip(dbt,
+				    pg_dbt.data, pg_dbt.size, 0, &lcp);
+			else
+				*cmpp = func(dbp, dbt, &pg_dbt);
 			return (0);
 		}
 		break;
@@ -139,7 +145,11 @@ __bam_cmp(dbp, dbt, h, indx, func, cmpp)
 			pg_dbt.app_data = NULL;
 			pg_dbt.data = bi->data;
 			pg_dbt.size = bi->len;
-			*cmpp = func(dbp, dbt, &pg_dbt);
+			if (func == __bam_defcmp)
+				*cmpp = bt_keycmp_skip(dbt,
+				    pg_dbt.data, pg_dbt.size, 0, &lcp);
+			else
+				*cmpp = func(dbp, dbt, &pg_dbt);
 			return (0);
 		}
 		break;
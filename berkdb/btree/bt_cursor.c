@@ -75,6 +75,10 @@ extern int gbl_disable_overflow_page_trace;
 int gbl_skip_cget_in_db_put = 1;
 __thread DB *prefault_dbp = NULL;
 
+/* Pages a page-order table scan reads ahead of the cursor, 0 to disable. */
+int gbl_pageorder_readahead = 64;
+#define	PGORDER_READAHEAD_MAX	256
+
 /*
  * Acquire a new page/lock.  If we hold a page/lock, discard the page, and
  * lock-couple the lock.
@@ -893,6 +897,10 @@ __bam_pgorder_next(dbc, pgno)
 	DBC *dbc;
 	db_pgno_t pgno;
 {
+	BTREE_CURSOR *cp;
+	db_pgno_t pgnos[PGORDER_READAHEAD_MAX], end, next;
+	int n;
+
 	static int lastpr=0;
 	if (gbl_enable_pageorder_trace && time(NULL) > lastpr + 1) {
 		logmsg(LOGMSG_USER, "Berkdb cursor %p page-order next to page"
@@ -901,6 +909,23 @@ __bam_pgorder_next(dbc, pgno)
 		lastpr=time(NULL);
 	}
 	dbc->nextcount++;
+
+	/*
+	 * Keep a window of reads in flight ahead of the scan; refill it as
+	 * a single batch each time half of it has been consumed.
+	 */
+	cp = (BTREE_CURSOR *)dbc->internal;
+	n = gbl_pageorder_readahead > PGORDER_READAHEAD_MAX ?
+	    PGORDER_READAHEAD_MAX : gbl_pageorder_readahead;
+	if (n > 0 && pgno + 1 + n / 2 >= cp->pgorder_ra) {
+		end = pgno + 1 + n;
+		next = cp->pgorder_ra > pgno + 1 ? cp->pgorder_ra : pgno + 1;
+		for (n = 0; next < end; ++next)
+			pgnos[n++] = next;
+		(void)__memp_prefetch(dbc->dbp->mpf, pgnos, n, NULL);
+		cp->pgorder_ra = end;
+	}
+
 	return pgno + 1;
 }
 
@@ -1034,6 +1059,7 @@ __bam_c_refresh(dbc)
 	cp->recno = RECNO_OOB;
 	cp->order = INVALID_ORDER;
 	cp->flags = 0;
+	cp->pgorder_ra = PGNO_INVALID;
 
 	/* Initialize for record numbers. */
 	if (F_ISSET(dbc, DBC_OPD) ||
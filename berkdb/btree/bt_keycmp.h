@@ -0,0 +1,71 @@
+#ifndef INCLUDE_BT_KEYCMP_H
+#define INCLUDE_BT_KEYCMP_H
+
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+ * Comdb2 keys are byte strings ordered by memcmp, so a search with the
+ * default comparison needn't call it: it can find where the key differs
+ * from a page key itself, 16 bytes at a time, and start from the prefix
+ * it already knows they share.
+ */
+
+/* Return how many leading bytes of a and b, both n long, are equal. */
+static inline u_int32_t
+bt_keycmp_lcp(const u_int8_t *a, const u_int8_t *b, u_int32_t n)
+{
+	u_int64_t x, y;
+	u_int32_t i;
+
+	i = 0;
+#if defined(__SSE2__)
+	for (; i + 16 <= n; i += 16) {
+		u_int32_t eq = (u_int32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(
+		    _mm_loadu_si128((const __m128i *)(a + i)),
+		    _mm_loadu_si128((const __m128i *)(b + i))));
+		if (eq != 0xffff)
+			return (i + __builtin_ctz(~eq));
+	}
+#endif
+	for (; i + 8 <= n; i += 8) {
+		memcpy(&x, a + i, sizeof(x));
+		memcpy(&y, b + i, sizeof(y));
+		if (x != y)
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+			return (i + (__builtin_clzll(x ^ y) >> 3));
+#else
+			return (i + (__builtin_ctzll(x ^ y) >> 3));
+#endif
+	}
+	for (; i < n && a[i] == b[i]; ++i)
+		;
+	return (i);
+}
+
+/*
+ * Compare key to a page key the way __bam_defcmp does, given that their
+ * first skip bytes are known to be equal.  The length of the prefix they
+ * share is returned through lcpp.
+ */
+static inline int
+bt_keycmp_skip(const DBT *key, const u_int8_t *data, u_int32_t size,
+    u_int32_t skip, u_int32_t *lcpp)
+{
+	const u_int8_t *kdata;
+	u_int32_t len, lcp;
+
+	kdata = key->data;
+	len = key->size < size ? key->size : size;
+	if (skip > len)
+		skip = len;
+	lcp = skip + bt_keycmp_lcp(kdata + skip, data + skip, len - skip);
+	*lcpp = lcp;
+	if (lcp < len)
+		return ((int)kdata[lcp] - (int)data[lcp]);
+	return ((long)key->size - (long)size);
+}
+
+#endif // end INCLUDE_BT_KEYCMP_H
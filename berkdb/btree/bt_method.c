@@ -20,6 +20,8 @@ static const char revid[] = "$Id: bt_method.c,v 11.34 2003/06/30 17:19:32 bostic
 #include "dbinc/btree.h"
 #include "dbinc/qam.h"
 
+static int __bam_get_bt_fillpct __P((DB *, u_int32_t *));
+static int __bam_set_bt_fillpct __P((DB *, u_int32_t));
 static int __bam_set_bt_maxkey __P((DB *, u_int32_t));
 static int __bam_get_bt_minkey __P((DB *, u_int32_t *));
 static int __bam_set_bt_minkey __P((DB *, u_int32_t));
@@ -56,6 +58,8 @@ __bam_db_create(dbp)
 	t->bt_compare = __bam_defcmp;
 	t->bt_prefix = __bam_defpfx;
 
+	dbp->get_bt_fillpct = __bam_get_bt_fillpct;
+	dbp->set_bt_fillpct = __bam_set_bt_fillpct;
 	dbp->set_bt_compare = __bam_set_bt_compare;
 	dbp->set_bt_maxkey = __bam_set_bt_maxkey;
 	dbp->get_bt_minkey = __bam_get_bt_minkey;
@@ -281,6 +285,50 @@ __bam_set_bt_minkey(dbp, bt_minkey)
 	return (0);
 }
 
+/*
+ * __bam_get_bt_fillpct --
+ *	Get the fill factor.
+ */
+static int
+__bam_get_bt_fillpct(dbp, bt_fillpctp)
+	DB *dbp;
+	u_int32_t *bt_fillpctp;
+{
+	BTREE *t;
+
+	DB_ILLEGAL_METHOD(dbp, DB_OK_BTREE);
+
+	t = dbp->bt_internal;
+	*bt_fillpctp = t->bt_fillpct;
+	return (0);
+}
+
+/*
+ * __bam_set_bt_fillpct --
+ *	Set how full, in percent, splits of the last page of the tree and
+ *	page compaction leave pages.  0 restores the default.  Unlike most
+ *	settings this may be changed while the tree is open.
+ */
+static int
+__bam_set_bt_fillpct(dbp, bt_fillpct)
+	DB *dbp;
+	u_int32_t bt_fillpct;
+{
+	BTREE *t;
+
+	DB_ILLEGAL_METHOD(dbp, DB_OK_BTREE);
+
+	t = dbp->bt_internal;
+
+	if (bt_fillpct != 0 && (bt_fillpct < 50 || bt_fillpct > 100)) {
+		__db_err(dbp->dbenv, "bt_fillpct must be 0 or from 50 to 100");
+		return (EINVAL);
+	}
+
+	t->bt_fillpct = bt_fillpct;
+	return (0);
+}
+
 /*
  * __bam_set_bt_prefix --
  *	Set the prefix function.
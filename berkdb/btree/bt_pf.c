@@ -39,6 +39,76 @@ static inline int advance_on_tree(DBC *dbc);
 
 #define LOAD(mpf,x) enqueue_touch_page(mpf, x);
 
+/*
+ * Largest number of pages handed to __memp_prefetch at a time.  0 goes back
+ * to queueing a touch job per page.
+ */
+int gbl_mpool_prefetch_batch = 64;
+
+/*
+ * The children of a parent page are collected while it is pinned and
+ * locked, and read only once it has been let go: the batch grows to hold
+ * all of them.
+ */
+typedef struct {
+	DB_ENV *dbenv;
+	db_pgno_t *pgnos;
+	int cnt;
+	int max;
+} btpf_batch;
+
+static inline void
+batch_init(DB_ENV *dbenv, btpf_batch *b)
+{
+	b->dbenv = dbenv;
+	b->cnt = 0;
+	b->max = gbl_mpool_prefetch_batch;
+	b->pgnos = NULL;
+	if (b->max > 0 &&
+	    __os_malloc(dbenv, b->max * sizeof(db_pgno_t), &b->pgnos) != 0)
+		b->pgnos = NULL;
+}
+
+static inline void
+batch_flush(DB_MPOOLFILE *mpf, btpf_batch *b)
+{
+	int i, n;
+
+	for (i = 0; i < b->cnt; i += n) {
+		n = b->cnt - i;
+		if (gbl_mpool_prefetch_batch > 0 && n > gbl_mpool_prefetch_batch)
+			n = gbl_mpool_prefetch_batch;
+		(void)__memp_prefetch(mpf, b->pgnos + i, n, NULL);
+	}
+	b->cnt = 0;
+}
+
+/* Queue a page, or load it the old way if we have no batch. */
+static inline void
+batch_load(DB_MPOOLFILE *mpf, btpf_batch *b, db_pgno_t pgno)
+{
+	if (b->pgnos == NULL) {
+		LOAD(mpf, pgno);
+		return;
+	}
+	if (b->cnt == b->max) {
+		if (__os_realloc(b->dbenv,
+		    2 * b->max * sizeof(db_pgno_t), &b->pgnos) != 0) {
+			LOAD(mpf, pgno);
+			return;
+		}
+		b->max *= 2;
+	}
+	b->pgnos[b->cnt++] = pgno;
+}
+
+static inline void
+batch_free(DB_ENV *dbenv, btpf_batch *b)
+{
+	if (b->pgnos != NULL)
+		__os_free(dbenv, b->pgnos);
+}
+
 #define LOAD_SYNC(mpf,x,page) {                                                     \
     __memp_fget(mpf, &x, DB_MPOOL_PFGET, &page);                                    \
     __memp_fput(mpf,page, 0);                                                       \
@@ -635,7 +705,9 @@ page_load_f(btpf * pf, DBC *dbc)
 	db_indx_t p_cnt = 0;
 	db_indx_t c = 0;
 	db_indx_t i;
+	btpf_batch batch;
 
+	batch_init(dbp->dbenv, &batch);
 	while (1) {
 		if ((ret = advance_on_tree(dbc)) != 0)
 			goto end;
@@ -662,7 +734,7 @@ page_load_f(btpf * pf, DBC *dbc)
 #if BTPF_DEBUG  
 			fprintf(stderr, "LOADING: %u from:%u indx:%d of:%d real:%d\n", t_pgno, pgno, pf->curindx[1] + i, pf->maxindx[1], h->entries );
 #endif
-			LOAD(mpf, t_pgno);
+			batch_load(mpf, &batch, t_pgno);
 
 		}
 
@@ -671,6 +743,9 @@ page_load_f(btpf * pf, DBC *dbc)
 		(void)__memp_fput(mpf, h, 0);
 		(void)__LPUT(dbc, lock);
 
+		/* Read outside of the parent's lock. */
+		batch_flush(mpf, &batch);
+
 		if (c >= pf->wndw)
 			break;
 	}
@@ -691,6 +766,7 @@ end:
 	if (ret != 0) {
 		pf->on = PF_OFF;
 	}
+	batch_free(dbp->dbenv, &batch);
     
 	ret = __db_c_close(dbc);
     
@@ -717,7 +793,9 @@ page_load_b(btpf * pf, DBC *dbc)
 	db_indx_t p_cnt = 0;
 	db_indx_t c = 0;
 	db_indx_t i;
+	btpf_batch batch;
 
+	batch_init(dbp->dbenv, &batch);
 	while (1) {
 		if ((ret = advanceb_on_tree(dbc)) != 0)
 			goto end;
@@ -745,7 +823,7 @@ page_load_b(btpf * pf, DBC *dbc)
 #if BTPF_DEBUG  
 			fprintf(stderr, "LOADING: %u from:%u indx:%d of:%d real:%d\n", t_pgno, pgno, i, pf->maxindx[1], h->entries );
 #endif            
-			LOAD(mpf,t_pgno);
+			batch_load(mpf, &batch, t_pgno);
 
 			if (i == 0)
 				break; // it's an unsigned type it overflows and loop forever otherwise
@@ -757,6 +835,9 @@ page_load_b(btpf * pf, DBC *dbc)
 		(void)__memp_fput(mpf, h, 0);
 		(void)__LPUT(dbc, lock);  // release lock
 
+		/* Read outside of the parent's lock. */
+		batch_flush(mpf, &batch);
+
 		if (c >= pf->wndw)
 			break;
 	}
@@ -776,6 +857,7 @@ end:
 	if (ret != 0) {
 		pf->on = PF_OFF;
 	}
+	batch_free(dbp->dbenv, &batch);
 	ret = __db_c_close(dbc);
 
 	if (ret)
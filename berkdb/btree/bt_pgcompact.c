@@ -626,21 +626,25 @@ unsigned int gbl_max_num_compact_pages_per_txn = ~(0U);
 
 /*
  * __bam_pgcompact --
- *  Light-weight page compaction.
+ *  Light-weight page compaction.  If npgsp is not NULL, the number of
+ *  pages merged away is returned through it.
  *
- * PUBLIC: int __bam_pgcompact __P((DBC *, DBT *, double, double));
+ * PUBLIC: int __bam_pgcompact __P((DBC *, DBT *, double, double,
+ * PUBLIC:     u_int32_t *));
  */
 int
-__bam_pgcompact(dbc, dbt, ff, tgtff)
+__bam_pgcompact(dbc, dbt, ff, tgtff, npgsp)
 	DBC *dbc;
 	DBT *dbt;
 	double ff;
 	double tgtff;
+	u_int32_t *npgsp;
 {
 	extern struct thdpool *gbl_pgcompact_thdpool;
 	int ret, t_ret, do_not_care;
-	u_int32_t ntb, nub, nfb; //, nsfb;
+	u_int32_t ntb, nub, nfb, nsfb;
 	int32_t snbl, snbr;
+	BTREE *t;
 	DB *dbp;
 	DBC *dupc;
 	DB_ENV *dbenv;
@@ -669,6 +673,7 @@ __bam_pgcompact(dbc, dbt, ff, tgtff)
 	dbp = dbc->dbp;
 	dbenv = dbp->dbenv;
 	dbmfp = dbp->mpf;
+	t = dbp->bt_internal;
 
 	pgno = ppgno = npgno = cpgno = PGNO_INVALID;
 	h = nh = ph = NULL;
@@ -682,6 +687,8 @@ __bam_pgcompact(dbc, dbt, ff, tgtff)
 	nhcp = alloca(dbp->pgsize);
 	newh = alloca(dbp->pgsize);
 	np_txn = 0;
+	if (npgsp != NULL)
+		*npgsp = 0;
 
 	/* Make a local copy to speed up. */
 	local_disable_backward = gbl_disable_backward_scan;
@@ -715,7 +722,13 @@ __bam_pgcompact(dbc, dbt, ff, tgtff)
 	ntb = dbp->pgsize - SIZEOF_PAGE;    /* total */
 	nub = ntb * ff;                     /* expected used */
 	nfb = ntb - nub;                    /* expected free */
-	//nsfb = (u_int32_t)((1 - tgtff) * (double)ntb); /* target free */
+	nsfb = 0;                           /* free space to keep */
+	if (t->bt_fillpct != 0) {
+		/* Don't fill pages past the tree's fill factor. */
+		nsfb = ntb - ntb * t->bt_fillpct / 100;
+		if (nfb < nsfb)
+			nfb = nsfb;
+	}
 
 	TRACE("(!) 0x%x %s %d: %s() I'm looking at pgno %d file %s.\n",
 			pthread_self(), __FILE__, __LINE__, __func__, PGNO(h), dbp->fname);
@@ -842,7 +855,7 @@ retry:
 		/* Copy over */
 		if (!IS_PREFIX(h) && !IS_PREFIX(nh)) {
 			snbl = dbp->pgsize - P_OVERHEAD(dbp) - P_FREESPACE(dbp, nh);
-			snbr = P_FREESPACE(dbp, h) /* - nsfb */;
+			snbr = (int32_t)P_FREESPACE(dbp, h) - (int32_t)nsfb;
 			if (snbl > snbr)
 				goto not_fit;
 
@@ -994,6 +1007,8 @@ retry:
 		if ((ret = __bam_dpages(dupc, dupcp->sp, 1)) != 0)
 			goto err_zero_h;
 		nh = NULL;
+		if (npgsp != NULL)
+			++*npgsp;
 
 		REASON(REASON_WHOAH);
 
@@ -1396,6 +1411,7 @@ __bam_ispgcompactible(dbc, pgno, dbt, ff)
 {
 	int ret, t_ret;
 	double pgff;
+	BTREE *t;
 	DB *dbp;
 	DB_MPOOLFILE *dbmfp;
 	PAGE *h;
@@ -1445,6 +1461,9 @@ __bam_ispgcompactible(dbc, pgno, dbt, ff)
 		goto error_out;
 	}
 
+	t = dbp->bt_internal;
+	if (t->bt_fillpct != 0 && ff > t->bt_fillpct / 100.0)
+		ff = t->bt_fillpct / 100.0;
 	pgff = P_FREESPACE(dbp, h) / (double)(dbp->pgsize - SIZEOF_PAGE);
 	if (pgff < (1 - ff)) { /* #5 */
 		REASON(REASON_FULL);
@@ -1469,3 +1488,106 @@ error_out:
 
 	return (ret);
 }
+
+/*
+ * __bam_pgcompact_scan --
+ *	Read a range of up to npages leaf pages, starting at the leaf holding
+ *	start (the first leaf if start is empty).  Return the number of pages
+ *	read and their free bytes, the first keys of up to *nkeysp of them
+ *	that are less than ff full, and in next the first key of the leaf
+ *	after the range, which is left empty if the range reached the last
+ *	leaf.  Keys are returned in DBTs owned by the caller.
+ *
+ * PUBLIC: int __bam_pgcompact_scan __P((DBC *, DBT *, u_int32_t, double,
+ * PUBLIC:     u_int32_t *, u_int64_t *, DBT *, u_int32_t *, DBT *));
+ */
+int
+__bam_pgcompact_scan(dbc, start, npages, ff, nreadp, nfreep, keys, nkeysp, next)
+	DBC *dbc;
+	DBT *start;
+	u_int32_t npages;
+	double ff;
+	u_int32_t *nreadp;
+	u_int64_t *nfreep;
+	DBT *keys;
+	u_int32_t *nkeysp;
+	DBT *next;
+{
+	BTREE_CURSOR *cp;
+	DB *dbp;
+	DB_LOCK lock, nlock;
+	DB_MPOOLFILE *dbmfp;
+	DBT *kp;
+	PAGE *h, *nh;
+	db_pgno_t npgno;
+	u_int32_t maxkeys, nfree, nfb;
+	int exact, ret, t_ret;
+
+	dbp = dbc->dbp;
+	dbmfp = dbp->mpf;
+	cp = (BTREE_CURSOR *)dbc->internal;
+
+	maxkeys = *nkeysp;
+	*nreadp = *nkeysp = 0;
+	*nfreep = 0;
+	next->size = 0;
+
+	/* Pages with at least this much free space are compaction targets. */
+	nfb = (dbp->pgsize - SIZEOF_PAGE) * (1 - ff);
+
+	if ((ret = __bam_search(dbc, PGNO_INVALID,
+	    start, S_READ, LEAFLEVEL, NULL, &exact)) != 0)
+		return (ret == DB_NOTFOUND ? 0 : ret);
+
+	/* Walk the leaves ourselves, coupling read locks left to right. */
+	h = cp->csp->page;
+	lock = cp->csp->lock;
+	BT_STK_CLR(cp);
+
+	for (;;) {
+		if (TYPE(h) != P_LBTREE)
+			break;
+		if (*nreadp == npages && NUM_ENT(h) != 0) {
+			/* The next range starts here. */
+			ret = __db_ret(dbp, h, 0, next, &next->data, &next->ulen);
+			break;
+		}
+		if (*nreadp < npages) {
+			++*nreadp;
+			nfree = P_FREESPACE(dbp, h);
+			*nfreep += nfree;
+			if (nfree > nfb && NUM_ENT(h) != 0 &&
+			    PGNO(h) != cp->root && *nkeysp < maxkeys) {
+				kp = &keys[(*nkeysp)++];
+				if ((ret = __db_ret(dbp,
+				    h, 0, kp, &kp->data, &kp->ulen)) != 0)
+					break;
+			}
+		}
+
+		if ((npgno = NEXT_PGNO(h)) == PGNO_INVALID)
+			break;
+		if ((ret = __db_lget(dbc,
+		    0, npgno, DB_LOCK_READ, 0, &nlock)) != 0)
+			break;
+		if ((ret = __memp_fget(dbmfp, &npgno, 0, &nh)) != 0) {
+			(void)__LPUT(dbc, nlock);
+			break;
+		}
+		if ((ret = __memp_fput(dbmfp, h, 0)) != 0) {
+			(void)__memp_fput(dbmfp, nh, 0);
+			(void)__LPUT(dbc, nlock);
+			h = NULL;
+			break;
+		}
+		(void)__LPUT(dbc, lock);
+		h = nh;
+		lock = nlock;
+	}
+
+	if (h != NULL && (t_ret = __memp_fput(dbmfp, h, 0)) != 0 && ret == 0)
+		ret = t_ret;
+	if ((t_ret = __LPUT(dbc, lock)) != 0 && ret == 0)
+		ret = t_ret;
+	return (ret);
+}
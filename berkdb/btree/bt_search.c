@@ -63,6 +63,7 @@ static const char revid[] = "$Id: bt_search.c,v 11.47 2003/06/30 17:19:35 bostic
 #include <thread_util.h>
 #include <btree/bt_prefix.h>
 #include <btree/bt_cache.h>
+#include <btree/bt_keycmp.h>
 
 #include <btree/bt_pf.h>
 
@@ -82,7 +83,7 @@ static const char revid[] = "$Id: bt_search.c,v 11.47 2003/06/30 17:19:35 bostic
  * PUBLIC:    u_int32_t, int (*)(DB *, const DBT *, const DBT *), int *));
  */
 static inline int
-__bam_cmp_inline(dbp, dbt, h, indx, func, cmpp, buf)
+__bam_cmp_inline(dbp, dbt, h, indx, func, cmpp, buf, skip, lcpp)
 	DB *dbp;
 	const DBT *dbt;
 	PAGE *h;
@@ -90,6 +91,7 @@ __bam_cmp_inline(dbp, dbt, h, indx, func, cmpp, buf)
 	int (*func)__P((DB *, const DBT *, const DBT *));
 	int *cmpp;
 	uint8_t *buf;
+	u_int32_t skip, *lcpp;
 {
 	BINTERNAL *bi;
 	BKEYDATA *bk;
@@ -108,7 +110,12 @@ __bam_cmp_inline(dbp, dbt, h, indx, func, cmpp, buf)
 	 * routine had better not be looking at fields other than data/size.
 	 * We don't clear it because we go through this path a lot and it's
 	 * expensive.
+	 *
+	 * With the default comparison, the first skip bytes of dbt are known
+	 * to match the record, and how many bytes match in all is returned
+	 * through lcpp.  Otherwise *lcpp is 0.
 	 */
+	*lcpp = 0;
 	switch (TYPE(h)) {
 	case P_LBTREE:
 	case P_LDUP:
@@ -123,14 +130,8 @@ __bam_cmp_inline(dbp, dbt, h, indx, func, cmpp, buf)
 			ASSIGN_ALIGN_DIFF(u_int32_t, pg_dbt.size, db_indx_t,
 			    bk->len);
 			if (likely(func == __bam_defcmp)) {
-				int len;
-				len = dbt->size > pg_dbt.size ? pg_dbt.size
-				    : dbt->size;
-				*cmpp = memcmp(dbt->data, pg_dbt.data, len);
-				if (unlikely(*cmpp == 0))
-					*cmpp =
-					    ((long)dbt->size -
-					    (long)pg_dbt.size);
+				*cmpp = bt_keycmp_skip(dbt, pg_dbt.data,
+				    pg_dbt.size, skip, lcpp);
 			} else {
 				*cmpp = func(dbp, dbt, &pg_dbt);
 			}
@@ -169,14 +170,8 @@ __bam_cmp_inline(dbp, dbt, h, indx, func, cmpp, buf)
 			pg_dbt.data = bi->data;
 			pg_dbt.size = bi->len;
 			if (likely(func == __bam_defcmp)) {
-				int len;
-
-				len = dbt->size > pg_dbt.size ? pg_dbt.size
-				    : dbt->size;
-				*cmpp = memcmp(dbt->data, pg_dbt.data, len);
-				if (unlikely((*cmpp == 0)))
-					*cmpp = ((long)dbt->size -
-					    (long)pg_dbt.size);
+				*cmpp = bt_keycmp_skip(dbt, pg_dbt.data,
+				    pg_dbt.size, skip, lcpp);
 			} else {
 				*cmpp = func(dbp, dbt, &pg_dbt);
 			}
@@ -318,6 +313,129 @@ timeval_add(struct timeval *tvp, struct timeval *uvp, struct timeval *vvp)
 	}
 }
 
+/*
+ * __bam_rcache_invalid --
+ *	Return the first of the pages a search took from the rcache that has
+ *	changed in the buffer pool since it was cached, or -1 if none has.
+ *	The buffer may since have been reused for another page, so check
+ *	that it's still the same page as well.
+ */
+static inline int
+__bam_rcache_invalid(rc, nrc)
+	RCACHE_PG *rc;
+	int nrc;
+{
+	PAGE *cached, *bfpool;
+	int i;
+
+	for (i = 0; i < nrc; ++i) {
+		cached = rc[i].cached_pg;
+		bfpool = rc[i].bfpool_pg;
+		if (rc[i].gen != GET_BH_GEN(bfpool) ||
+		    PGNO(bfpool) != PGNO(cached) ||
+		    memcmp(&LSN(cached), &LSN(bfpool), sizeof(DB_LSN)) != 0 ||
+		    rc[i].gen != GET_BH_GEN(bfpool))	//re-check. warm&fuzzy
+			return (i);
+	}
+	return (-1);
+}
+
+/*
+ * __bam_unlatched_bi --
+ *	Return an internal page entry, or NULL if it doesn't lie within the
+ *	page or isn't a plain key.
+ */
+static inline BINTERNAL *
+__bam_unlatched_bi(dbp, h, inp, nent, indx, lenp)
+	DB *dbp;
+	PAGE *h;
+	db_indx_t *inp, nent, indx;
+	u_int32_t *lenp;
+{
+	BINTERNAL *bi;
+	u_int32_t len, off;
+
+	off = inp[indx];
+	if (off < (u_int32_t)((u_int8_t *)(inp + nent) - (u_int8_t *)h) ||
+	    off + BINTERNAL_SIZE(0) > dbp->pgsize)
+		return (NULL);
+	bi = (BINTERNAL *)((u_int8_t *)h + off);
+	len = bi->len;
+	if (B_TYPE(bi) != B_KEYDATA || off + BINTERNAL_SIZE(len) > dbp->pgsize)
+		return (NULL);
+	*lenp = len;
+	return (bi);
+}
+
+/*
+ * __bam_search_unlatched --
+ *	Find the child to descend to on an internal page we hold no latch
+ *	on.  The page may be changing as we read it, so nothing on it is used
+ *	before it's checked to lie within the page.  A page that doesn't look
+ *	like an internal page, or would need an overflow key compared,
+ *	returns DB_LOCK_NOTGRANTED: the caller latches it instead.  Whatever
+ *	this returns means nothing until the page's latch version validates.
+ */
+static int
+__bam_search_unlatched(dbp, key, h, func, indxp, pgnop)
+	DB *dbp;
+	const DBT *key;
+	PAGE *h;
+	int (*func) __P((DB *, const DBT *, const DBT *));
+	db_indx_t *indxp;
+	db_pgno_t *pgnop;
+{
+	BINTERNAL *bi;
+	DBT pg_dbt;
+	db_indx_t base, indx, *inp, lim, nent;
+	u_int32_t hlcp, lcp, len, llcp;
+	int cmp;
+
+	nent = NUM_ENT(h);
+	inp = P_INP(dbp, h);
+	if (TYPE(h) != P_IBTREE || nent == 0 ||
+	    (u_int8_t *)(inp + nent) > (u_int8_t *)h + dbp->pgsize)
+		return (DB_LOCK_NOTGRANTED);
+
+	/* The same search as __bam_search's, for internal pages. */
+	llcp = hlcp = 0;
+	for (base = 0, lim = nent; lim != 0; lim >>= 1) {
+		indx = base + (lim >> 1);
+		lcp = 0;
+		if (indx == 0)
+			cmp = 1;
+		else {
+			if ((bi = __bam_unlatched_bi(dbp,
+			    h, inp, nent, indx, &len)) == NULL)
+				return (DB_LOCK_NOTGRANTED);
+			pg_dbt.app_data = NULL;
+			pg_dbt.data = bi->data;
+			pg_dbt.size = len;
+			if (likely(func == __bam_defcmp))
+				cmp = bt_keycmp_skip(key, pg_dbt.data, len,
+				    llcp < hlcp ? llcp : hlcp, &lcp);
+			else
+				cmp = func(dbp, key, &pg_dbt);
+		}
+		if (cmp == 0)
+			goto found;
+		if (cmp > 0) {
+			base = indx + O_INDX;
+			--lim;
+			llcp = lcp;
+		} else
+			hlcp = lcp;
+	}
+	indx = base > 0 ? base - O_INDX : base;
+
+found:	if (indx >= nent || (bi = __bam_unlatched_bi(dbp,
+	    h, inp, nent, indx, &len)) == NULL)
+		return (DB_LOCK_NOTGRANTED);
+	*indxp = indx;
+	*pgnop = bi->pgno;
+	return (0);
+}
+
 /*
  * __bam_search --
  *	Search a btree for a key.
@@ -345,12 +463,15 @@ __bam_search(dbc, root_pgno, key, flags, stop, recnop, exactp)
 	db_pgno_t pg;
 	db_recno_t recno;
 	int adjust, cmp, deloffset, ret, stack;
+	u_int32_t hlcp, lcp, llcp;
 	int (*func) __P((DB *, const DBT *, const DBT *));
-	void *cached_pg = NULL;
-	void *bfpool_pg = NULL;
+	RCACHE_PG rc[RCACHE_MAX_LEVELS];
+	int nrc = 0, rc_bad, rc_retry = 0;
+	u_int8_t rc_root_level = 0;
+	u_int32_t opt_version, child_version;
+	db_pgno_t opt_pg;
+	int opt, opt_off = 0;
 	bool save = false;
-	uint16_t gen;
-	uint32_t slot;
 	unsigned int hh = 0;
 	genid_hash *hash = NULL;
 	__genid_pgno *hashtbl = NULL;
@@ -392,6 +513,16 @@ try_again:
 
 	INTERNAL_PTR_CHECK(cp == dbc->internal);
 
+	/*
+	 * If opt is set, h is an internal page we read without latching it;
+	 * opt_version is its latch version.  Everything read from it is
+	 * validated against that before we rely on it, and if that fails we
+	 * search again from the root, latching every page.
+	 */
+	opt = 0;
+	opt_pg = PGNO_INVALID;
+	opt_version = 0;
+
 	pg = root_pgno == PGNO_INVALID ? cp->root : root_pgno;
 	stack = LF_ISSET(S_STACK) && F_ISSET(cp, C_RECNUM);
 	lock_mode = stack ? DB_LOCK_WRITE : DB_LOCK_READ;
@@ -401,12 +532,19 @@ try_again:
 
 	extern bool gbl_rcache;
 
-	if (gbl_rcache && pg == 1 && bfpool_pg == NULL &&
-	    lock_mode == DB_LOCK_READ && LF_ISSET(S_FIND)) {
+	/*
+	 * Pages taken from the rcache are private copies: we hold neither a
+	 * lock nor a pin on them, and so can't return them in the stack.
+	 */
+	if (gbl_rcache && pg == 1 && !rc_retry &&
+	    lock_mode == DB_LOCK_READ && LF_ISSET(S_FIND) &&
+	    !LF_ISSET(S_PARENT | S_STK_ONLY)) {
 		save = true;
-		if (rcache_find(
-		    dbp, &cached_pg, &bfpool_pg, &gen, &slot) == 0) {
-			h = cached_pg;
+		if (rcache_find(dbp, pg, &rc[0].cached_pg,
+		    &rc[0].bfpool_pg, &rc[0].gen, &rc[0].slot) == 0) {
+			h = rc[0].cached_pg;
+			rc_root_level = h->level;
+			nrc = 1;
 			goto got_pg;
 		}
 	}
@@ -531,10 +669,8 @@ hash_backup:
 	}
 
 	if (save && TYPE(h) == P_IBTREE) {	// WORKS ONLY WHEN ROOT IS INTERNAL
-		uint16_t gen = LSN(h).file + LSN(h).offset;
-
-		GET_BH_GEN(h) = gen;
-		rcache_save(dbp, h, gen);
+		rc_root_level = h->level;
+		rcache_save(dbp, h, h->pgno, GET_BH_GEN(h));
 	}
 
 	INTERNAL_PTR_CHECK(cp == dbc->internal);
@@ -581,6 +717,15 @@ got_pg:func = t->bt_compare;
 	INTERNAL_PTR_CHECK(cp == dbc->internal);
 
 	for (;;) {
+		if (opt) {
+			if (__bam_search_unlatched(dbp,
+			    key, h, func, &indx, &pg) != 0) {
+				(void)__memp_fput(mpf, h, 0);
+				goto opt_retry;
+			}
+			goto opt_next;
+		}
+
 		inp = P_INP(dbp, h);
 		/*
 		 * Do a binary search on the current page.  If we're searching
@@ -592,6 +737,12 @@ got_pg:func = t->bt_compare;
 		adjust = TYPE(h) == P_LBTREE ? P_INDX : O_INDX;
 		uint8_t buf[KEYBUF];
 
+		/*
+		 * Every key between the bounds of the search shares at least
+		 * as long a prefix with our key as both bounds do, so the
+		 * comparisons needn't look at it again.
+		 */
+		llcp = hlcp = 0;
 		for (base = 0,
 		    lim = NUM_ENT(h) / (db_indx_t) adjust; lim != 0;
 		    lim >>= 1) {
@@ -599,7 +750,7 @@ got_pg:func = t->bt_compare;
 
 			if ((ret =
 				__bam_cmp_inline(dbp, key, h, indx, func, &cmp,
-				    buf)) != 0)
+				    buf, llcp < hlcp ? llcp : hlcp, &lcp)) != 0)
 				goto err;
 			if (cmp == 0) {
 				if (TYPE(h) == P_LBTREE || TYPE(h) == P_LDUP)
@@ -609,7 +760,9 @@ got_pg:func = t->bt_compare;
 			if (cmp > 0) {
 				base = indx + adjust;
 				--lim;
-			}
+				llcp = lcp;
+			} else
+				hlcp = lcp;
 		}
 
 		/*
@@ -670,6 +823,7 @@ next:		if (recnop != NULL)
 		// ##################################################
 #endif
 
+opt_next:
 		if (LF_ISSET(S_STK_ONLY)) {
 			if (stop == h->level) {
 				INTERNAL_PTR_CHECK(cp == dbc->internal);
@@ -738,11 +892,62 @@ next:		if (recnop != NULL)
 			lock_mode = stack &&
 			    LF_ISSET(S_WRITE) ? DB_LOCK_WRITE : DB_LOCK_READ;
 
-			if (cached_pg) {
-				/* Used rcache to get here. Don't lck couple. */
+			if (nrc != 0) {
+				/*
+				 * Used rcache to get here.  Stay on cached pages
+				 * as far as we can, then lock the first page we
+				 * get from the buffer pool: there's nothing to
+				 * lock couple with.
+				 */
+				if (h->level - 1 > LEAFLEVEL &&
+				    nrc < RCACHE_MAX_LEVELS &&
+				    rc_root_level - (h->level - 1) <
+				    gbl_rcache_levels &&
+				    rcache_find(dbp, pg, &rc[nrc].cached_pg,
+				    &rc[nrc].bfpool_pg, &rc[nrc].gen,
+				    &rc[nrc].slot) == 0) {
+					h = rc[nrc++].cached_pg;
+					continue;
+				}
 				if ((ret = __db_lget(dbc, 0, pg, lock_mode, 0,
 					    &lock)) != 0)
 					goto err;
+			} else if (!stack && lock_mode == DB_LOCK_READ &&
+			    !opt_off && recnop == NULL &&
+			    __db_lversion(dbc, pg, &child_version) == 0) {
+				/*
+				 * Read the child without latching it.  pg is
+				 * the right child if h hasn't changed, which
+				 * the latch on h guarantees, or h's version
+				 * must confirm.  From here on the child's
+				 * version covers it.
+				 */
+				if (!opt)
+					(void)__LPUT(dbc, lock);
+				else if (__db_lvalidate(dbc,
+				    opt_pg, opt_version) != 0) {
+					(void)__memp_fput(mpf, h, 0);
+					goto opt_retry;
+				}
+				(void)__memp_fput(mpf, h, 0);
+				opt = 1;
+				opt_pg = pg;
+				opt_version = child_version;
+			} else if (opt) {
+				/*
+				 * There's no latch on h to couple with: latch
+				 * the child, then make sure h led to it.
+				 */
+				(void)__memp_fput(mpf, h, 0);
+				opt = 0;
+				if ((ret = __db_lget(dbc, 0, pg, lock_mode, 0,
+					    &lock)) != 0)
+					goto err;
+				if (__db_lvalidate(dbc,
+				    opt_pg, opt_version) != 0) {
+					(void)__LPUT(dbc, lock);
+					goto opt_retry;
+				}
 			} else {
 				(void)__memp_fput(mpf, h, 0);
 				if ((ret = __db_lget(dbc,
@@ -766,37 +971,43 @@ next:		if (recnop != NULL)
 #endif
 		ret = __memp_fget(mpf, &pg, 0, &h);
 		if (ret != 0) {
-			if (cached_pg) {
+			if (nrc != 0) {
 				/*
 				 * Used rcache and failed getting child
 				 * page. Let's retry w/o rcache.
 				 */
-				cached_pg = NULL;
-
-				rcache_invalidate(slot);
+				rcache_invalidate(rc[nrc - 1].slot);
+				nrc = 0;
+				rc_retry = 1;
 				__LPUT(dbc, lock);
 				goto try_again;
 			}
+			/* An unlatched child may have been freed. */
+			if (opt)
+				goto opt_retry;
 			goto err;
 		}
 
-		if (cached_pg) {
-			/* Used rcache and got child page. Validate rcache. */
-			DB_LSN *l1 = &LSN(cached_pg);
-			DB_LSN *l2 = &LSN(bfpool_pg);
-			cached_pg = NULL;
-
-			if (gen == GET_BH_GEN(bfpool_pg)
-			    && memcmp(l1, l2, sizeof(DB_LSN)) == 0 && gen == GET_BH_GEN(bfpool_pg)	//re-check. warm&fuzzy
-			    ) {
-				;
-			} else {
+		if (nrc != 0) {
+			/*
+			 * Used rcache and got child page.  Now that the child
+			 * is locked, the path to it is good if none of the
+			 * pages we took from the rcache has changed.
+			 */
+			if ((rc_bad = __bam_rcache_invalid(rc, nrc)) >= 0) {
 				__memp_fput(mpf, h, 0);
 				__LPUT(dbc, lock);
-				rcache_invalidate(slot);
+				rcache_invalidate(rc[rc_bad].slot);
+				nrc = 0;
+				rc_retry = 1;
 				goto try_again;
 			}
+			nrc = 0;
 		}
+
+		if (save && !opt && TYPE(h) == P_IBTREE &&
+		    rc_root_level - h->level < gbl_rcache_levels)
+			rcache_save(dbp, h, h->pgno, GET_BH_GEN(h));
 	}
 	/* NOTREACHED */
 
@@ -920,6 +1131,14 @@ found:	*exactp = 1;
 
 	return (0);
 
+opt_retry:
+	/*
+	 * A page we read without its latch changed under us.  We hold
+	 * nothing; start over, latching every page this time.
+	 */
+	opt_off = 1;
+	goto try_again;
+
 notfound:
 	INTERNAL_PTR_CHECK(cp == dbc->internal);
 	/* Keep the page locked for serializability. */
@@ -80,6 +80,17 @@ void genidsetzero(void *g);
 int bdb_relink_pglogs(void *bdb_state, unsigned char *fileid, db_pgno_t pgno,
 	db_pgno_t prev_pgno, db_pgno_t next_pgno, DB_LSN lsn);
 
+/*
+ * Once most recent leaf splits of a tree are of its last page, keys are
+ * being appended, if not quite in order.  Splits of the last page then
+ * leave this percentage of it on the left, unless the tree has its own
+ * fill factor.  0 always splits in half.
+ */
+int gbl_bt_append_split_pct = 90;
+
+#define	BT_RSPLITS_MAX		8
+#define	BT_RSPLITS_APPEND	4
+
 /*
  * __bam_split --
  *	Split a page.
@@ -1033,12 +1044,15 @@ __bam_psplit(dbc, cp, lp, rp, splitret)
 	PAGE *lp, *rp;
 	db_indx_t *splitret;
 {
+	BTREE *t;
 	DB *dbp;
 	PAGE *pp;
 	db_indx_t half, *inp, nbytes, off, splitp, top;
+	u_int32_t pct;
 	int adjust, cnt, iflag, isbigkey, ret;
 
 	dbp = dbc->dbp;
+	t = dbp->bt_internal;
 	pp = cp->page;
 	inp = P_INP(dbp, pp);
 	adjust = TYPE(pp) == P_LBTREE ? P_INDX : O_INDX;
@@ -1081,6 +1095,37 @@ __bam_psplit(dbc, cp, lp, rp, splitret)
 		off = NUM_ENT(pp) - adjust;
 	else if (PREV_PGNO(pp) == PGNO_INVALID && cp->indx == 0)
 		off = adjust;
+
+	/*
+	 * Appends rarely arrive in perfect order: concurrent writers insert
+	 * keys a little short of the end, and then a half-and-half split of
+	 * the last page leaves a half-empty page behind that nothing will
+	 * fill.  So track how many recent leaf splits were of the last page,
+	 * and while most are, split the last page at the append percentage
+	 * when the insert is past it.  A tree with a fill factor uses that
+	 * instead, and also leaves it on the left of a split for an ordered
+	 * append, keeping room on the page for its records to grow.
+	 */
+	pct = 0;
+	if (TYPE(pp) == P_LBTREE) {
+		if (NEXT_PGNO(pp) != PGNO_INVALID) {
+			if (t->bt_rsplits > 0)
+				--t->bt_rsplits;
+		} else {
+			if (t->bt_rsplits < BT_RSPLITS_MAX)
+				++t->bt_rsplits;
+			if (cp->indx >= NUM_ENT(pp) - adjust)
+				pct = t->bt_fillpct;
+			else if (t->bt_rsplits >= BT_RSPLITS_APPEND) {
+				pct = t->bt_fillpct != 0 ?
+				    t->bt_fillpct : gbl_bt_append_split_pct;
+				if (cp->indx < (u_int32_t)NUM_ENT(pp) * pct / 100)
+					pct = 0;
+			}
+		}
+	}
+	if (pct != 0 && pct < 100)
+		goto fill;
 	if (off != 0)
 		goto sort;
 
@@ -1105,8 +1150,9 @@ __bam_psplit(dbc, cp, lp, rp, splitret)
 	 * data into the same place in the database, we're probably going to
 	 * need more space soon anyway.
 	 */
-	top = NUM_ENT(pp) - adjust;
-	half = (dbp->pgsize - HOFFSET(pp)) / 2;
+	pct = 50;
+fill:	top = NUM_ENT(pp) - adjust;
+	half = (u_int32_t)(dbp->pgsize - HOFFSET(pp)) * pct / 100;
 	for (nbytes = 0, off = 0; off < top && nbytes < half; ++off)
 		switch (TYPE(pp)) {
 		case P_IBTREE:
@@ -1143,6 +1189,11 @@ __bam_psplit(dbc, cp, lp, rp, splitret)
 		default:
 			return (__db_pgfmt(dbp->dbenv, pp->pgno));
 		}
+
+	/* Put the new item on the right of an uneven split. */
+	if (pct != 50 && off > cp->indx && cp->indx >= adjust)
+		off = cp->indx;
+
 sort:	splitp = off;
 
 	/*
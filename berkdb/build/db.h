@@ -140,6 +140,7 @@ struct __db_ltran; typedef struct __db_ltran DB_LTRAN;
 struct __db_mpool;	typedef struct __db_mpool DB_MPOOL;
 struct __db_mpool_fstat;typedef struct __db_mpool_fstat DB_MPOOL_FSTAT;
 struct __db_mpool_stat;	typedef struct __db_mpool_stat DB_MPOOL_STAT;
+struct __db_mpool_warmup_stat; typedef struct __db_mpool_warmup_stat DB_MPOOL_WARMUP_STAT;
 struct __db_mpoolfile;	typedef struct __db_mpoolfile DB_MPOOLFILE;
 struct __db_preplist;	typedef struct __db_preplist DB_PREPLIST;
 struct __db_qam_stat;	typedef struct __db_qam_stat DB_QUEUE_STAT;
@@ -163,6 +164,7 @@ struct __dbenv_attr;    typedef struct __dbenv_attr DBENV_ATTR;
 struct __dbenv_envmap;	typedef struct __dbenv_envmap DBENV_MAP;
 struct __lc_cache_entry; typedef struct __lc_cache_entry LC_CACHE_ENTRY;
 struct __lc_cache;	typedef struct __lc_cache LC_CACHE;
+struct __lc_cache_stat;	typedef struct __lc_cache_stat DB_LC_CACHE_STAT;
 struct __lsn_collection; typedef struct __lsn_collection LSN_COLLECTION;
 
 struct __ltrans_descriptor; typedef struct __ltrans_descriptor LTDESC;
@@ -511,6 +513,13 @@ struct __db_lock_stat {
 	u_int64_t st_nlocktimeouts;	/* Number of lock timeouts. */
 	db_timeout_t st_txntimeout;	/* Transaction timeout. */
 	u_int64_t st_ntxntimeouts;	/* Number of transaction timeouts. */
+	u_int64_t st_nlatch_optimistic;	/* Pages read without a latch. */
+	u_int64_t st_nlatch_optimistic_fail;	/* ... and found changed. */
+	u_int64_t st_ndetects;		/* Deadlock detector passes. */
+	u_int64_t st_ndetects_skipped;	/* Passes skipped, nothing new. */
+	u_int64_t st_ndeadlock_cycles;	/* Cycles found by the detector. */
+	u_int64_t st_detect_usecs;	/* Time spent in detector passes. */
+	u_int64_t st_detect_max_usecs;	/* Longest detector pass. */
 	u_int64_t st_region_wait;	/* Region lock granted after wait. */
 	u_int64_t st_region_nowait;	/* Region lock granted without wait. */
 	u_int64_t st_regsize;		/* Region size. */
@@ -607,15 +616,19 @@ struct __db_ltran {
 
 /*
  * Application-specified log record types start at DB_user_BEGIN, and must not
- * equal or exceed DB_debug_FLAG.
+ * equal or exceed DB_lz4_FLAG.
  *
  * DB_debug_FLAG is the high-bit of the u_int32_t that specifies a log record
  * type.  If the flag is set, it's a log record that was logged for debugging
  * purposes only, even if it reflects a database change -- the change was part
  * of a non-durable transaction.
+ *
+ * DB_lz4_FLAG marks a record that was compressed when it was written.  Log
+ * cursors return it uncompressed, without the flag, unless DB_LOG_RAW is set.
  */
 #define	DB_user_BEGIN		10000
 #define	DB_debug_FLAG		0x80000000
+#define	DB_lz4_FLAG		0x40000000
 
 struct __db_log_cursor_stat {
     int incursor_count;
@@ -650,6 +663,11 @@ struct __db_log_cursor {
 
 	u_int32_t bp_maxrec;		/* Max record length in the log file. */
 
+	u_int8_t *c_zbuf;		/* Uncompressed record buffer. */
+	u_int32_t c_zbuflen;		/* Uncompressed record buffer length. */
+
+	struct __log_stream *c_stream;	/* Streaming read buffers. */
+
 					/* Methods. */
 	int (*close) __P((DB_LOGC *, u_int32_t));
 	int (*get) __P((DB_LOGC *, DB_LSN *, DBT *, u_int32_t));
@@ -672,6 +690,8 @@ struct __db_log_cursor {
 #define	DB_LOG_SILENT_ERR	0x04	/* Turn-off error messages. */
 #define DB_LOG_NO_PANIC		0x08    /* Don't panic on error. */
 #define DB_LOG_CUSTOM_SIZE  0x10    /* This cursor has a custom size */
+#define	DB_LOG_RAW		0x20	/* Don't uncompress records. */
+#define	DB_LOG_STREAM		0x40	/* Sequential reads with readahead. */
 	u_int32_t flags;
     struct __db_log_cursor *next;
     struct __db_log_cursor *prev;
@@ -713,6 +733,19 @@ struct __db_log_stat {
 	u_int32_t st_ondisk_get;	/* On-disk log_get. */
 	u_int32_t st_inmem_trav;	/* Mem-log steps for partial reads. */
 	u_int32_t st_wrap_copy;		/* Count of wrapped copies. */
+	u_int32_t st_gc_waits;		/* Flushes held to gather commits. */
+	u_int64_t st_gc_wait_usecs;	/* Time flushes were held. */
+	u_int64_t st_fsync_usecs;	/* Time spent syncing the log. */
+	u_int32_t st_lz4_records;	/* Records compressed. */
+	u_int64_t st_lz4_bytes_in;	/* Bytes before compression. */
+	u_int64_t st_lz4_bytes_out;	/* Bytes after compression. */
+	u_int32_t st_stream_reads;	/* Streaming cursor block reads. */
+	u_int32_t st_stream_ahead;	/* Of those, already read ahead. */
+#define	DB_LOG_HIST_BUCKETS	16
+	/* Commits per flush; bucket i counts flushes of up to 1 << i. */
+	u_int32_t st_commit_hist[DB_LOG_HIST_BUCKETS];
+	/* Sync latency; bucket i counts syncs of up to 16 << i usecs. */
+	u_int32_t st_fsync_hist[DB_LOG_HIST_BUCKETS];
 };
 
 /*******************************************************
@@ -919,6 +952,16 @@ struct __db_mpool_stat {
 	u_int64_t st_alloc_max_pages;	/* Max checked during allocation. */
 	u_int64_t st_ckp_pages_sync;	/* Number of pages sync'd using perfect ckp. */
 	u_int64_t st_ckp_pages_skip;	/* Number of pages skipped using perfect ckp. */
+	u_int64_t st_cold_hit;		/* Hits on probationary pages. */
+	u_int64_t st_hot_hit;		/* Hits on protected pages. */
+	u_int64_t st_promote;		/* Pages promoted to protected. */
+	u_int64_t st_cold_evict;	/* Probationary pages evicted. */
+	u_int64_t st_hot_evict;		/* Protected pages evicted. */
+	u_int64_t st_ccache_pages;	/* Pages in the compressed cache. */
+	u_int64_t st_ccache_bytes;	/* Memory used by the compressed cache. */
+	u_int64_t st_ccache_hit;	/* Pages found in the compressed cache. */
+	u_int64_t st_ccache_miss;	/* Pages not found in the compressed cache. */
+	u_int64_t st_ccache_evict;	/* Pages dropped from the compressed cache. */
 };
 
 /* Mpool file statistics structure. */
@@ -937,6 +980,25 @@ struct __db_mpool_fstat {
 	u_int64_t st_page_out;		/* Pages written out. */
 	u_int64_t st_ro_merges;		/* Read merges performed. */
 	u_int64_t st_rw_merges;		/* Write merges performed. */
+	u_int64_t st_flush_writes;	/* Writes issued to flush pages. */
+	u_int64_t st_flush_usecs;	/* Time spent in those writes. */
+	u_int64_t st_flush_max_usecs;	/* Longest single flush write. */
+	u_int64_t st_ccache_hit;	/* Pages found in the compressed cache. */
+	u_int64_t st_ccache_miss;	/* Pages not found in the compressed cache. */
+	u_int64_t st_ccache_put;	/* Pages put in the compressed cache. */
+	u_int64_t st_ccache_bytes_in;	/* Bytes put, before compression. */
+	u_int64_t st_ccache_bytes_out;	/* Bytes put, after compression. */
+};
+
+/* Cache warm-up progress. */
+struct __db_mpool_warmup_stat {
+	int st_running;			/* Warm-up in progress. */
+	int st_stopped;			/* Warm-up given up early. */
+	int32_t st_start;		/* Start time. */
+	int32_t st_end;			/* End time, or 0 while running. */
+	u_int64_t st_pages;		/* Pages in the saved list. */
+	u_int64_t st_pages_done;	/* Pages looked at so far. */
+	u_int64_t st_pages_read;	/* Pages read from disk so far. */
 };
 
 /*******************************************************
@@ -1602,7 +1664,9 @@ struct __db {
 	int  (*verify) __P((DB *,
 	    const char *, const char *, FILE *, u_int32_t));
 
+	int  (*get_bt_fillpct) __P((DB *, u_int32_t *));
 	int  (*get_bt_minkey) __P((DB *, u_int32_t *));
+	int  (*set_bt_fillpct) __P((DB *, u_int32_t));
 	int  (*set_bt_compare) __P((DB *,
 	    int (*)(DB *, const DBT *, const DBT *)));
 	int  (*set_bt_maxkey) __P((DB *, u_int32_t));
@@ -2080,6 +2144,7 @@ struct __lc_cache_entry {
 	u_int32_t txnid;
 	int cacheid;  /* offset in __lc_cache.ent */
 	DB_LSN last_seen_lsn;
+	int spilled;  /* record bodies dropped; only the LSNs are kept */
 	LINKC_T(struct __lc_cache_entry) lnk;
 	LSN_COLLECTION lc;
 };
@@ -2092,6 +2157,23 @@ struct __lc_cache {
 	LISTC_T(struct __lc_cache_entry) lru;
 	LISTC_T(struct __lc_cache_entry) avail;
 	pthread_mutex_t lk;
+	u_int64_t spilled_hits;
+	u_int64_t spills;
+	u_int64_t evictions;
+	u_int64_t drops;
+};
+
+struct __lc_cache_stat {
+	int st_txns;			/* Transactions being collected. */
+	int st_spilled_txns;		/* Of those, spilled to LSNs only. */
+	int st_memused;			/* Bytes held. */
+	int st_largest_txn;		/* Bytes held by the largest one. */
+	u_int64_t st_hits;		/* Commits found in the cache. */
+	u_int64_t st_spilled_hits;	/* Of those, spilled transactions. */
+	u_int64_t st_misses;		/* Commits collected from the log. */
+	u_int64_t st_spills;		/* Transactions spilled. */
+	u_int64_t st_evictions;		/* Transactions evicted for room. */
+	u_int64_t st_drops;		/* Transactions given up on. */
 };
 
 typedef int (*collect_locks_f)(void *args, int64_t threadid, int32_t lockerid,
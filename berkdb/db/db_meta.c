@@ -951,6 +951,51 @@ lck_couple:	couple[0].op = has_timeout? DB_LOCK_GET_TIMEOUT : DB_LOCK_GET;
 	     !F_ISSET(dbenv, DB_ENV_TIME_NOTGRANTED)) ? DB_LOCK_DEADLOCK : ret);
 }
 
+/*
+ * __db_lversion --
+ *	Begin reading a page without locking it, when pages are protected by
+ *	latches: return the page's latch version, to be checked with
+ *	__db_lvalidate once the page has been read.  Returns
+ *	DB_LOCK_NOTGRANTED if the caller has to lock the page instead.
+ *
+ * PUBLIC: int __db_lversion __P((DBC *, db_pgno_t, u_int32_t *));
+ */
+int
+__db_lversion(dbc, pgno, versionp)
+	DBC *dbc;
+	db_pgno_t pgno;
+	u_int32_t *versionp;
+{
+	DB_ENV *dbenv;
+
+	dbenv = dbc->dbp->dbenv;
+	if (CDB_LOCKING(dbenv) || !LOCKING_ON(dbenv) ||
+	    F_ISSET(dbc, DBC_COMPENSATE | DBC_RECOVER | DBC_OPD))
+		return (DB_LOCK_NOTGRANTED);
+
+	dbc->lock.pgno = pgno;
+	dbc->lock.type = DB_PAGE_LOCK;
+	return (__lock_latch_version(dbenv, &dbc->lock_dbt, versionp));
+}
+
+/*
+ * __db_lvalidate --
+ *	Return 0 if a page read since __db_lversion can't have changed.
+ *
+ * PUBLIC: int __db_lvalidate __P((DBC *, db_pgno_t, u_int32_t));
+ */
+int
+__db_lvalidate(dbc, pgno, version)
+	DBC *dbc;
+	db_pgno_t pgno;
+	u_int32_t version;
+{
+	dbc->lock.pgno = pgno;
+	dbc->lock.type = DB_PAGE_LOCK;
+	return (__lock_latch_validate(dbc->dbp->dbenv,
+	    &dbc->lock_dbt, version));
+}
+
 /*
  * __db_lput --
  *	The standard lock put call.
@@ -36,15 +36,17 @@
  * __db_pgcompact --
  *  Compact page.
  *
- * PUBLIC: int __db_pgcompact __P((DB *, DB_TXN *, DBT *, double, double));
+ * PUBLIC: int __db_pgcompact __P((DB *, DB_TXN *, DBT *, double, double,
+ * PUBLIC:     u_int32_t *));
  */
 int
-__db_pgcompact(dbp, txn, dbt, ff, tgtff)
+__db_pgcompact(dbp, txn, dbt, ff, tgtff, npgsp)
 	DB *dbp;
 	DB_TXN *txn;
 	DBT *dbt;
 	double ff;
 	double tgtff;
+	u_int32_t *npgsp;
 {
 	int ret, t_ret;
 	DBC *dbc;
@@ -68,7 +70,7 @@ __db_pgcompact(dbp, txn, dbt, ff, tgtff)
 	if (dbc->dbtype == DB_BTREE) {
 		/* Safeguard __bam_pgcompact(). I want to keep page compaction routine
 		   private for now, so don't make it a function pointer of DB struct.  */
-		ret = __bam_pgcompact(dbc, dbt, ff, tgtff);
+		ret = __bam_pgcompact(dbc, dbt, ff, tgtff, npgsp);
 	} else {
 		__db_err(dbenv, "__db_pgcompact: %s",
 				"Wrong access method or wrong cursor reference.");
@@ -119,3 +121,47 @@ __db_ispgcompactible(dbp, pgno, dbt, ff)
 		ret = t_ret;
 	return (ret);
 }
+
+/*
+ * __db_pgcompact_scan --
+ *	Sample a range of leaf pages for compaction.
+ *
+ * PUBLIC: int __db_pgcompact_scan __P((DB *, DBT *, u_int32_t, double,
+ * PUBLIC:     u_int32_t *, u_int64_t *, DBT *, u_int32_t *, DBT *));
+ */
+int
+__db_pgcompact_scan(dbp, start, npages, ff, nreadp, nfreep, keys, nkeysp, next)
+	DB *dbp;
+	DBT *start;
+	u_int32_t npages;
+	double ff;
+	u_int32_t *nreadp;
+	u_int64_t *nfreep;
+	DBT *keys;
+	u_int32_t *nkeysp;
+	DBT *next;
+{
+	int ret, t_ret;
+	DBC *dbc;
+	DB_ENV *dbenv;
+
+	dbenv = dbp->dbenv;
+
+	if ((ret = __db_cursor(dbp, NULL, &dbc, 0)) != 0) {
+		__db_err(dbenv, "__db_cursor: %s", strerror(ret));
+		return (ret);
+	}
+
+	if (dbc->dbtype == DB_BTREE) {
+		ret = __bam_pgcompact_scan(dbc, start,
+		    npages, ff, nreadp, nfreep, keys, nkeysp, next);
+	} else {
+		__db_err(dbenv, "__db_pgcompact_scan: %s",
+				"Wrong access method. Expect BTREE.");
+		ret = EINVAL;
+	}
+
+	if ((t_ret = __db_c_close(dbc)) != 0 && ret == 0)
+		ret = t_ret;
+	return (ret);
+}
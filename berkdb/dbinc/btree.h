@@ -205,6 +205,7 @@ struct __cursor {
 	u_int32_t order;	/* Relative order among deleted curs. */
 
 	db_pgno_t firstleaf;	/* Page initially found during a range-scan */
+	db_pgno_t pgorder_ra;	/* End of page-order scan readahead. */
 
 	/*
 	 * Btree:
@@ -312,6 +313,15 @@ struct __btree {			/* Btree access method. */
 	 */
 	db_pgno_t bt_lpgno;		/* Last insert location. */
 
+	/*
+	 * !!!
+	 * bt_fillpct and bt_rsplits are also advisory: the first may be
+	 * changed while the tree is open, and the second is a rough count
+	 * of how many recent leaf splits were of the last page of the tree.
+	 */
+	u_int32_t bt_fillpct;		/* Fill factor, 0 for the default. */
+	u_int32_t bt_rsplits;		/* Recent rightmost leaf splits. */
+
 	/*
 	 * !!!
 	 * The re_modified field is NOT protected by any mutex, and for this
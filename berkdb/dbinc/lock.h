@@ -112,6 +112,23 @@ BB_COMPILE_TIME_ASSERT(lockfluff_not_192, sizeof(PthreadMutexWithFluff) == 192);
 typedef SH_TAILQ_HEAD(LockerTab, __db_locker) LockerTab;
 typedef SH_TAILQ_HEAD(ObjTab, __db_lockobj) ObjTab;
 
+/*
+ * Per object partition, a generation bumped whenever a waits-for edge may
+ * have been added there: a lock starts waiting, or a lock is granted or
+ * upgraded on an object that has waiters.  Edges that go away don't count;
+ * removing them can't create a cycle.  The deadlock detector skips a pass
+ * if no generation moved since its last pass that found nothing.  Padded
+ * so partitions don't share a cache line.
+ */
+typedef struct {
+	u_int32_t	gen;
+	u_int8_t	pad[60];
+} DB_LOCKDDPART;
+
+/* The object partition must be locked. */
+#define	LOCK_DD_CHANGED(region, partition)				\
+	((region)->dd_parts[(partition)].gen++)
+
 struct __db_latch;
 struct __db_lock_lsn;
 struct __db_lockerid_latch_node;
@@ -153,6 +170,7 @@ typedef struct __db_lockregion {
 	PthreadMutexWithFluff	*obj_tab_mtx;
 	SH_TAILQ_HEAD(__fobj, __db_lockobj)	*free_objs;	/* free obj header */
 	uint8_t			*nwobj_scale;	/* scale num of objs to be added */
+	DB_LOCKDDPART		*dd_parts;	/* waits-for generations */
 
 	SH_TAILQ_HEAD(__flock, __db_lock)	*free_locks;	/* free lock header */
 	uint8_t			*nwlk_scale;	/* scale num of locks to be added */
@@ -222,6 +240,7 @@ typedef struct __db_latch {
 	DB_ILOCK_LATCH *listhead;	/* Multiple latches can hash to here */
 	u_int32_t count;		/* Number of locks in the locklist */
 	u_int32_t wrcount;		/* Number of wrlocks in the locklist */
+	u_int32_t version;		/* Odd while write-latched */
 	pthread_t tid;			/* Owner tid */
 	struct __db_latch *next;
 	struct __db_latch *prev;
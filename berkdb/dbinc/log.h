@@ -136,6 +136,15 @@ struct __hdr {
 #define	HDR_NORMAL_SZ	12
 #define	HDR_CRYPTO_SZ	12 + DB_MAC_KEY + DB_IV_BYTES
 
+/*
+ * A compressed record keeps the type (with DB_lz4_FLAG set), txnid and
+ * prev_lsn that begin every record, so the transaction's chain can still be
+ * walked.  Then comes the length of the whole uncompressed record, and the
+ * rest of the record compressed.
+ */
+#define	LOG_LZ4_PREFIX	(2 * sizeof(u_int32_t) + sizeof(DB_LSN))
+#define	LOG_LZ4_HDR	(LOG_LZ4_PREFIX + sizeof(u_int32_t))
+
 struct __log_persist {
 	u_int32_t magic;		/* DB_LOGMAGIC */
 	u_int32_t version;		/* DB_LOGVERSION */
@@ -62,6 +62,8 @@ struct __db_mpool {
 
 	u_int32_t   nreg;		/* N underlying cache regions. */
 	REGINFO	   *reginfo;		/* Underlying cache regions. */
+
+	int	    ccache;		/* Evicted pages go to mp_ccache.c. */
 };
 
 /*
@@ -92,6 +94,20 @@ struct __db_mpool {
 #define	NBUCKET(mc, mf_offset, pgno)					\
 	(((pgno) ^ (((intptr_t)mf_offset) << 9)) % (mc)->htab_buckets)
 
+/*
+ * MPOOL_SWEEP --
+ *	The allocation sweep over a cache's hash buckets is split into
+ *	partitions, each with its own cursor, so that concurrent allocators
+ *	walk disjoint ranges of buckets instead of taking turns advancing a
+ *	single cursor under the region lock.  Cursors are padded out to a
+ *	cache line and advanced atomically.
+ */
+#define	MPOOL_SWEEP_MAX_PARTS	64
+typedef struct __mpool_sweep {
+	u_int32_t cursor;		/* Next bucket offset in partition. */
+	u_int8_t  pad[60];
+} MPOOL_SWEEP;
+
 struct __fileid_mpf {
 	u_int8_t fileid[DB_FILE_ID_LEN];
 	LISTC_T(struct __mpoolfile) mpflist;
@@ -142,14 +158,20 @@ struct __mpool {
 	 * The htab and htab_buckets fields are not thread protected as they
 	 * are initialized during mpool creation, and not modified again.
 	 *
-	 * The last_checked and lru_count fields are thread protected by
-	 * the region lock.
+	 * The lru_count field is thread protected by the region lock.
 	 */
 	int	  htab_buckets;	/* Number of hash table entries. */
 	roff_t	  htab;		/* Hash table offset. */
-	u_int32_t last_checked;	/* Last bucket checked for free. */
 	u_int32_t lru_count;	/* Counter for buffer LRU */
 
+	/*
+	 * The sweep partitions are not protected by the region lock: the
+	 * cursors are only ever advanced atomically, and sweep_next is only
+	 * used to spread allocators across partitions.
+	 */
+	u_int32_t sweep_next;	/* Next partition to hand out. */
+	MPOOL_SWEEP sweep[MPOOL_SWEEP_MAX_PARTS];
+
 	/*
 	 * The stat fields are generally not thread protected, and cannot be
 	 * trusted.  Note that st_pages is an exception, and is always updated
@@ -158,6 +180,14 @@ struct __mpool {
 	 */
 	DB_MPOOL_STAT stat;		/* Per-cache mpool statistics. */
 
+	/*
+	 * Hits and misses are otherwise only counted per file; these let us
+	 * see how the load is spread over the cache regions and NUMA nodes.
+	 */
+	int	  numa_node;		/* Preferred NUMA node, or -1. */
+	u_int64_t reg_hit;		/* Buffers found in this region. */
+	u_int64_t reg_miss;		/* Buffers read into this region. */
+
 	/*
 	 * We track page puts so that we can decide when allocation is never
 	 * going to succeed.  We don't lock the field, all we care about is
@@ -310,10 +340,12 @@ struct __bh {
 #define	BH_TRASH	0x020		/* Page is garbage. */
 #define BH_NOINCR	0x040		/* Don't increment lru_cache. */
 #define BH_PREFAULT	0x080		/* prefault pages */
+#define	BH_HOT		0x100		/* Re-referenced: protected segment. */
 	u_int16_t	flags;
 	u_int16_t	generation;	/* This changes before page changes */
 	u_int32_t	priority;	/* LRU priority. */
 	u_int32_t	fget_count;	/* Number memp_fgets. */
+	u_int32_t	admit_lru;	/* LRU counter when page was admitted. */
 	SH_TAILQ_ENTRY(__bh) hq;	/* MPOOL hash bucket queue. */
 
 	db_pgno_t pgno;			/* Underlying MPOOLFILE page number. */
@@ -34,19 +34,25 @@
 
 /*
  * __dbenv_pgcompact --
- *  Compact page.
+ *  Compact page.  If npgsp and logbytesp are not NULL, the number of pages
+ *  merged away and the bytes logged doing it are returned through them.
  *
- * PUBLIC: int __dbenv_pgcompact __P((DB_ENV *, int32_t, DBT *, double, double));
+ * PUBLIC: int __dbenv_pgcompact __P((DB_ENV *, int32_t, DBT *, double, double,
+ * PUBLIC:     u_int32_t *, u_int64_t *));
  */
 int
-__dbenv_pgcompact(dbenv, fileid, dbt, ff, tgtff)
+__dbenv_pgcompact(dbenv, fileid, dbt, ff, tgtff, npgsp, logbytesp)
 	DB_ENV *dbenv;
     int32_t fileid;
 	DBT *dbt;
 	double ff;
 	double tgtff;
+	u_int32_t *npgsp;
+	u_int64_t *logbytesp;
 {
 	int ret, nretries;
+	u_int32_t npgs;
+	u_int64_t logbytes;
 	DB *dbp;
 	DB_TXN *txn;
 
@@ -71,13 +77,20 @@ retry:
         goto err;
 	}
 
-	ret = __db_pgcompact(dbp, txn, dbt, ff, tgtff);
+	npgs = 0;
+	ret = __db_pgcompact(dbp, txn, dbt, ff, tgtff, &npgs);
 
 err:
 	__dbreg_prefault_complete(dbenv, fileid);
-	if (ret == 0)
-		ret = __txn_commit(txn, DB_TXN_NOSYNC);
-	else
+	logbytes = txn->logbytes;
+	if (ret == 0) {
+		if ((ret = __txn_commit(txn, DB_TXN_NOSYNC)) == 0) {
+			if (npgsp != NULL)
+				*npgsp = npgs;
+			if (logbytesp != NULL)
+				*logbytesp = logbytes;
+		}
+	} else
 		(void)__txn_abort(txn);
 	txn = NULL;
 
@@ -117,3 +130,42 @@ __dbenv_ispgcompactible(dbenv, fileid, pgno, dbt, ff)
 
 	return ret;
 }
+
+/*
+ * __dbenv_pgcompact_scan --
+ *	Sample a range of leaf pages for compaction.
+ *
+ * PUBLIC: int __dbenv_pgcompact_scan __P((DB_ENV *, int32_t, DBT *,
+ * PUBLIC:     u_int32_t, double, u_int32_t *, u_int64_t *, DBT *, u_int32_t *,
+ * PUBLIC:     DBT *));
+ */
+int
+__dbenv_pgcompact_scan(dbenv, fileid, start, npages, ff, nreadp, nfreep, keys,
+    nkeysp, next)
+	DB_ENV *dbenv;
+	int32_t fileid;
+	DBT *start;
+	u_int32_t npages;
+	double ff;
+	u_int32_t *nreadp;
+	u_int64_t *nfreep;
+	DBT *keys;
+	u_int32_t *nkeysp;
+	DBT *next;
+{
+	int ret;
+	DB *dbp;
+
+	if ((ret = __dbreg_id_to_db_prefault(dbenv,
+	    NULL, &dbp, fileid, 0)) != 0) {
+		__db_err(dbenv, "%s __dbreg_id_to_db_prefault: %s %d",
+				__func__, strerror(ret), fileid);
+		return (ret);
+	}
+
+	ret = __db_pgcompact_scan(dbp,
+	    start, npages, ff, nreadp, nfreep, keys, nkeysp, next);
+
+	__dbreg_prefault_complete(dbenv, fileid);
+	return (ret);
+}
@@ -63,6 +63,7 @@ void bdb_rellock(void *bdb_state, const char *funcname, int line);
 int bdb_is_open(void *bdb_state);
 
 extern int gbl_is_physical_replicant;
+extern int gbl_parallel_recovery_threads;
 
 #define BDB_WRITELOCK(idstr)	bdb_get_writelock(bdb_state, (idstr), __func__, __LINE__)
 #define BDB_RELLOCK()		   bdb_rellock(bdb_state, __func__, __LINE__)
@@ -962,11 +963,13 @@ __db_apprec(dbenv, max_lsn, trunclsn, update, flags)
 	char *p, *pass, t1[60], t2[60];
 	void *txninfo;
 	DB_LSN logged_checkpoint_lsn;
+	DB_ROLL *roll;
 	int start_recovery_at_dbregs;
 
 	COMPQUIET(nfiles, (double)0);
 
 	logc = NULL;
+	roll = NULL;
 	ckp_args = NULL;
 	dtab = NULL;
 
@@ -1424,6 +1427,9 @@ __db_apprec(dbenv, max_lsn, trunclsn, update, flags)
 
 	logmsg(LOGMSG_WARN, "running forward pass from %u:%u -> %u:%u\n",
 		lsn.file, lsn.offset, stop_lsn.file, stop_lsn.offset);
+	if (gbl_parallel_recovery_threads > 1 && (ret = __db_roll_open(dbenv,
+		gbl_parallel_recovery_threads, &roll)) != 0)
+		goto err;
 	for (ret = __log_c_get(logc, &lsn, &data, DB_NEXT);
 		ret == 0; ret = __log_c_get(logc, &lsn, &data, DB_NEXT)) {
 		/*
@@ -1446,9 +1452,12 @@ __db_apprec(dbenv, max_lsn, trunclsn, update, flags)
 			dbenv->db_feedback(dbenv, DB_RECOVER, progress);
 		}
 
-		ret = __db_dispatch(dbenv, dbenv->recover_dtab,
-			dbenv->recover_dtab_size, &data, &lsn,
-			DB_TXN_FORWARD_ROLL, txninfo);
+		if (roll != NULL)
+			ret = __db_roll_dispatch(roll, &data, &lsn, txninfo);
+		else
+			ret = __db_dispatch(dbenv, dbenv->recover_dtab,
+				dbenv->recover_dtab_size, &data, &lsn,
+				DB_TXN_FORWARD_ROLL, txninfo);
 		if (ret != 0) {
 			if (ret != DB_TXN_CKP)
 				goto msgerr;
@@ -1458,6 +1467,14 @@ __db_apprec(dbenv, max_lsn, trunclsn, update, flags)
 
 	}
 
+	/* Everything must be redone before the limbo pass and checkpoint. */
+	if (roll != NULL) {
+		t_ret = __db_roll_close(roll);
+		roll = NULL;
+		if (t_ret != 0 && (ret == 0 || ret == DB_NOTFOUND))
+			ret = t_ret;
+	}
+
 	if (ret != 0 && ret != DB_NOTFOUND)
 		goto err;
 	dbenv->recovery_pass = DB_TXN_NOT_IN_RECOVERY;
@@ -1663,7 +1680,10 @@ msgerr:	__db_err(dbenv,
 #endif
 	}
 
-err:	if (logc != NULL && (t_ret = __log_c_close(logc)) != 0 && ret == 0)
+err:	if (roll != NULL)
+		(void)__db_roll_close(roll);
+
+	if (logc != NULL && (t_ret = __log_c_close(logc)) != 0 && ret == 0)
 		ret = t_ret;
 
 	if (txninfo != NULL)
@@ -0,0 +1,437 @@
+/*-
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 1996-2003
+ *	Sleepycat Software.  All rights reserved.
+ */
+#include "db_config.h"
+
+#ifndef NO_SYSTEM_INCLUDES
+#include <sys/types.h>
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#endif
+
+#include "db_int.h"
+#include "dbinc/db_page.h"
+#include "dbinc/btree.h"
+#include "dbinc/db_am.h"
+#include "dbinc/db_swap.h"
+#include "dbinc/log.h"
+#include "dbinc/mp.h"
+#include "dbinc/txn.h"
+
+#include "locks_wrap.h"
+#include "logmsg.h"
+#include "thrman.h"
+#include "thread_util.h"
+
+void bdb_thread_start_rw(void);
+void bdb_thread_done_rw(void);
+
+/*
+ * Parallel roll-forward.  The forward pass of recovery redoes committed
+ * page updates, and two updates only have to be ordered if they touch the
+ * same page.  Records that change a known set of btree pages are handed to
+ * worker threads picked by hashing the file and page number, so every page
+ * sees its records in LSN order while different pages are redone at the
+ * same time.  Everything else (transaction and file registration records,
+ * page allocation and free, which also touch the limbo list, and anything
+ * we can't place) is a barrier: the workers drain and the record is
+ * dispatched inline, exactly as the serial loop would have done it.
+ *
+ * The workers never look at the transaction list; whether a record is
+ * redone at all is decided here, on the thread that owns it.
+ */
+#define	ROLL_MAX_THREADS	64	/* Workers; one bit each in a mask. */
+#define	ROLL_QUEUE_MAX		4096	/* Records queued per worker. */
+
+struct __roll_rec {
+	struct __roll_rec *next;
+	DB_LSN lsn;
+	u_int32_t size;
+	u_int8_t data[1];
+};
+
+struct __roll_worker {
+	DB_ROLL *roll;
+	pthread_t tid;
+	pthread_mutex_t lk;
+	pthread_cond_t cond;
+	struct __roll_rec *head, *tail;
+	u_int32_t nrecs;		/* Queued or being redone. */
+	int stop;
+	int ret;			/* First failure. */
+	DB_LSN err_lsn;
+};
+
+struct __db_roll {
+	DB_ENV *dbenv;
+	struct __roll_worker *workers;
+	int nworkers;
+	TXN_RECS t;			/* Pages of the current record. */
+	int32_t last_fid;		/* Last file looked up ... */
+	MPOOLFILE *last_mfp;		/* ... and its buffer pool file. */
+	u_int64_t nparallel;
+	u_int64_t ninline;
+	u_int64_t nbarrier;
+};
+
+/*
+ * __db_roll_pageop --
+ *	Return if a record type's forward roll only redoes the pages named
+ *	in the record and doesn't need the transaction list.  Replicants
+ *	use this too, to schedule applying a transaction by page.
+ *
+ * PUBLIC: int __db_roll_pageop __P((u_int32_t));
+ */
+int
+__db_roll_pageop(rectype)
+	u_int32_t rectype;
+{
+	switch (rectype) {
+	case DB___bam_split:
+	case DB___bam_rsplit:
+	case DB___bam_adj:
+	case DB___bam_cadjust:
+	case DB___bam_cdel:
+	case DB___bam_repl:
+	case DB___bam_root:
+	case DB___bam_curadj:
+	case DB___bam_rcuradj:
+	case DB___bam_prefix:
+	case DB___bam_pgcompact:
+	case DB___db_addrem:
+	case DB___db_big:
+	case DB___db_ovref:
+	case DB___db_relink:
+		return (1);
+	default:
+		return (0);
+	}
+}
+
+static void *
+__roll_worker_thd(arg)
+	void *arg;
+{
+	struct __roll_rec *rec;
+	struct __roll_worker *w;
+	DB_ENV *dbenv;
+	DBT dbt;
+	u_int32_t rectype;
+	int ret;
+
+	w = arg;
+	dbenv = w->roll->dbenv;
+
+	bdb_thread_start_rw();
+	thrman_register(THRTYPE_GENERIC);
+	thread_started("recovery roll forward");
+
+	Pthread_mutex_lock(&w->lk);
+	for (;;) {
+		while (w->head == NULL && !w->stop)
+			Pthread_cond_wait(&w->cond, &w->lk);
+		if ((rec = w->head) == NULL)
+			break;
+		if ((w->head = rec->next) == NULL)
+			w->tail = NULL;
+		Pthread_mutex_unlock(&w->lk);
+
+		/* After a failure, just empty the queue. */
+		ret = 0;
+		if (w->ret == 0) {
+			memset(&dbt, 0, sizeof(dbt));
+			dbt.data = rec->data;
+			dbt.size = rec->size;
+			LOGCOPY_32(&rectype, rec->data);
+			ret = dbenv->recover_dtab[rectype](dbenv,
+			    &dbt, &rec->lsn, DB_TXN_FORWARD_ROLL, NULL);
+		}
+
+		Pthread_mutex_lock(&w->lk);
+		if (ret != 0 && w->ret == 0) {
+			w->ret = ret;
+			w->err_lsn = rec->lsn;
+		}
+		--w->nrecs;
+		Pthread_cond_broadcast(&w->cond);
+		__os_free(dbenv, rec);
+	}
+	Pthread_mutex_unlock(&w->lk);
+
+	bdb_thread_done_rw();
+	return (NULL);
+}
+
+/*
+ * __roll_drain --
+ *	Wait for a worker to redo everything it's been given.
+ */
+static int
+__roll_drain(w)
+	struct __roll_worker *w;
+{
+	int ret;
+
+	Pthread_mutex_lock(&w->lk);
+	while (w->nrecs != 0)
+		Pthread_cond_wait(&w->cond, &w->lk);
+	if ((ret = w->ret) != 0)
+		__db_err(w->roll->dbenv,
+		    "Recovery function for LSN %lu %lu failed on forward pass",
+		    (u_long)w->err_lsn.file, (u_long)w->err_lsn.offset);
+	Pthread_mutex_unlock(&w->lk);
+	return (ret);
+}
+
+/*
+ * __roll_drain_mask --
+ *	Drain the workers in a mask, or all of them if the mask is 0.
+ */
+static int
+__roll_drain_mask(roll, mask)
+	DB_ROLL *roll;
+	u_int64_t mask;
+{
+	int i, ret, t_ret;
+
+	ret = 0;
+	for (i = 0; i < roll->nworkers; ++i)
+		if ((mask == 0 || (mask & (1ULL << i)) != 0) &&
+		    (t_ret = __roll_drain(&roll->workers[i])) != 0 && ret == 0)
+			ret = t_ret;
+	return (ret);
+}
+
+/*
+ * __roll_enqueue --
+ *	Hand a copy of a record to a worker, waiting if it's too far behind.
+ */
+static int
+__roll_enqueue(w, data, lsnp)
+	struct __roll_worker *w;
+	DBT *data;
+	DB_LSN *lsnp;
+{
+	struct __roll_rec *rec;
+	int ret;
+
+	if ((ret = __os_malloc(w->roll->dbenv,
+	    sizeof(struct __roll_rec) + data->size, &rec)) != 0)
+		return (ret);
+	rec->next = NULL;
+	rec->lsn = *lsnp;
+	rec->size = data->size;
+	memcpy(rec->data, data->data, data->size);
+
+	Pthread_mutex_lock(&w->lk);
+	while (w->nrecs >= ROLL_QUEUE_MAX && w->ret == 0)
+		Pthread_cond_wait(&w->cond, &w->lk);
+	if ((ret = w->ret) != 0) {
+		Pthread_mutex_unlock(&w->lk);
+		__os_free(w->roll->dbenv, rec);
+		return (__roll_drain(w));
+	}
+	if (w->tail == NULL)
+		w->head = rec;
+	else
+		w->tail->next = rec;
+	w->tail = rec;
+	if (++w->nrecs == 1)
+		Pthread_cond_broadcast(&w->cond);
+	Pthread_mutex_unlock(&w->lk);
+	return (0);
+}
+
+/*
+ * __roll_place --
+ *	Work out which workers own the pages a record touches.  Returns
+ *	non-zero if the record can't be placed.
+ */
+static int
+__roll_place(roll, data, lsnp, maskp, firstp)
+	DB_ROLL *roll;
+	DBT *data;
+	DB_LSN *lsnp;
+	u_int64_t *maskp;
+	int *firstp;
+{
+	DB *dbp;
+	DB_ENV *dbenv;
+	LSN_PAGE *pg;
+	u_int32_t h;
+	int i, ret;
+
+	dbenv = roll->dbenv;
+	roll->t.npages = 0;
+	if ((ret = __db_dispatch(dbenv, dbenv->pgnos_dtab,
+	    dbenv->pgnos_dtab_size, data, lsnp, DB_TXN_GETALLPGNOS,
+	    &roll->t)) != 0 || roll->t.npages == 0)
+		return (1);
+
+	*maskp = 0;
+	for (i = 0; i < roll->t.npages; ++i) {
+		pg = &roll->t.array[i];
+		/*
+		 * Hash the buffer pool file rather than the log file id:
+		 * two ids can name the same file.
+		 */
+		if (roll->last_mfp == NULL || pg->fid != roll->last_fid) {
+			if (__dbreg_id_to_db(dbenv,
+			    NULL, &dbp, pg->fid, 0, lsnp, 0) != 0 ||
+			    dbp->mpf == NULL)
+				return (1);
+			roll->last_fid = pg->fid;
+			roll->last_mfp = dbp->mpf->mfp;
+		}
+		h = (u_int32_t)(((uintptr_t)roll->last_mfp >> 4) ^
+		    (pg->pgdesc.pgno * 2654435761U)) % roll->nworkers;
+		if (i == 0)
+			*firstp = h;
+		*maskp |= 1ULL << h;
+	}
+	return (0);
+}
+
+/*
+ * __db_roll_open --
+ *	Start the workers for a parallel forward pass.
+ *
+ * PUBLIC: int __db_roll_open __P((DB_ENV *, int, DB_ROLL **));
+ */
+int
+__db_roll_open(dbenv, nthreads, rollp)
+	DB_ENV *dbenv;
+	int nthreads;
+	DB_ROLL **rollp;
+{
+	DB_ROLL *roll;
+	struct __roll_worker *w;
+	int i, ret;
+
+	*rollp = NULL;
+	if (nthreads > ROLL_MAX_THREADS)
+		nthreads = ROLL_MAX_THREADS;
+
+	if ((ret = __os_calloc(dbenv, 1, sizeof(DB_ROLL), &roll)) != 0)
+		return (ret);
+	if ((ret = __os_calloc(dbenv,
+	    nthreads, sizeof(struct __roll_worker), &roll->workers)) != 0) {
+		__os_free(dbenv, roll);
+		return (ret);
+	}
+	roll->dbenv = dbenv;
+
+	for (i = 0; i < nthreads; ++i) {
+		w = &roll->workers[i];
+		w->roll = roll;
+		Pthread_mutex_init(&w->lk, NULL);
+		Pthread_cond_init(&w->cond, NULL);
+		Pthread_create(&w->tid, NULL, __roll_worker_thd, w);
+		roll->nworkers = i + 1;
+	}
+
+	logmsg(LOGMSG_INFO,
+	    "forward pass using %d roll forward threads\n", roll->nworkers);
+	*rollp = roll;
+	return (0);
+}
+
+/*
+ * __db_roll_dispatch --
+ *	Redo one record of the forward pass, in the background if we can.
+ *	Takes and returns the same as __db_dispatch for DB_TXN_FORWARD_ROLL.
+ *
+ * PUBLIC: int __db_roll_dispatch __P((DB_ROLL *, DBT *, DB_LSN *, void *));
+ */
+int
+__db_roll_dispatch(roll, data, lsnp, info)
+	DB_ROLL *roll;
+	DBT *data;
+	DB_LSN *lsnp;
+	void *info;
+{
+	DB_ENV *dbenv;
+	u_int64_t mask;
+	u_int32_t rectype, txnid;
+	int first, ret;
+
+	dbenv = roll->dbenv;
+	LOGCOPY_32(&rectype, data->data);
+	LOGCOPY_32(&txnid, (u_int8_t *)data->data + sizeof(rectype));
+
+	if (!__db_roll_pageop(rectype) || txnid == 0 ||
+	    __roll_place(roll, data, lsnp, &mask, &first) != 0) {
+		/* A barrier. */
+		++roll->nbarrier;
+		roll->last_mfp = NULL;
+		if ((ret = __roll_drain_mask(roll, 0)) != 0)
+			return (ret);
+		goto serial;
+	}
+
+	/* Records of transactions that didn't commit aren't redone. */
+	if (__db_txnlist_find(dbenv, info, txnid) != TXN_COMMIT)
+		goto serial;
+
+	/* All the pages belong to one worker. */
+	if ((mask & (mask - 1)) == 0) {
+		++roll->nparallel;
+		return (__roll_enqueue(&roll->workers[first], data, lsnp));
+	}
+
+	/*
+	 * The pages are spread across workers: wait for the ones involved
+	 * and redo the record here; the others can't touch its pages.
+	 */
+	if ((ret = __roll_drain_mask(roll, mask)) != 0)
+		return (ret);
+
+serial:	++roll->ninline;
+	return (__db_dispatch(dbenv, dbenv->recover_dtab,
+	    dbenv->recover_dtab_size, data, lsnp, DB_TXN_FORWARD_ROLL, info));
+}
+
+/*
+ * __db_roll_close --
+ *	Wait for the workers to finish, stop them, and free everything.
+ *	Returns the first error any of them hit.
+ *
+ * PUBLIC: int __db_roll_close __P((DB_ROLL *));
+ */
+int
+__db_roll_close(roll)
+	DB_ROLL *roll;
+{
+	DB_ENV *dbenv;
+	struct __roll_worker *w;
+	int i, ret;
+
+	dbenv = roll->dbenv;
+	ret = __roll_drain_mask(roll, 0);
+
+	for (i = 0; i < roll->nworkers; ++i) {
+		w = &roll->workers[i];
+		Pthread_mutex_lock(&w->lk);
+		w->stop = 1;
+		Pthread_cond_broadcast(&w->cond);
+		Pthread_mutex_unlock(&w->lk);
+		Pthread_join(w->tid, NULL);
+		Pthread_cond_destroy(&w->cond);
+		Pthread_mutex_destroy(&w->lk);
+	}
+
+	logmsg(LOGMSG_INFO, "forward pass: %"PRIu64" records redone in "
+	    "parallel, %"PRIu64" inline, %"PRIu64" barriers\n",
+	    roll->nparallel, roll->ninline, roll->nbarrier);
+
+	if (roll->t.array != NULL)
+		__os_free(dbenv, roll->t.array);
+	__os_free(dbenv, roll->workers);
+	__os_free(dbenv, roll);
+	return (ret);
+}
@@ -46,6 +46,7 @@ static const char revid[] = "$Id: lock.c,v 11.134 2003/11/18 21:30:38 ubell Exp
 #include "thread_stats.h"
 #include "tohex.h"
 #include "txn_properties.h"
+#include "comdb2_atomic.h"
 
 
 #ifdef TRACE_ON_ADDING_LOCKS
@@ -596,6 +597,27 @@ latchhash(DB_ENV *dbenv, const DBT *obj)
 	return (h % region->max_latch);
 }
 
+/*
+ * Each latch carries a version for readers that search a page without
+ * latching it (see __lock_latch_version): it's odd while the latch is held
+ * for writing, and moves on again when the last write hold is released.
+ */
+static inline void
+__latch_wrcount_inc(latch)
+	DB_LATCH *latch;
+{
+	if (latch->wrcount++ == 0)
+		ATOMIC_ADD32(latch->version, 1);
+}
+
+static inline void
+__latch_wrcount_dec(latch)
+	DB_LATCH *latch;
+{
+	if (--latch->wrcount == 0)
+		ATOMIC_ADD32(latch->version, 1);
+}
+
 static inline u_int32_t
 lockeridhash(DB_ENV *dbenv, u_int32_t lockerid)
 {
@@ -785,6 +807,129 @@ use_page_latches(dbenv)
 	    (!IS_REP_CLIENT(dbenv) || gbl_replicant_latches));
 }
 
+/*
+ * Let btree searches read internal pages without taking their latch,
+ * validating the latch version afterwards instead.
+ */
+int gbl_page_latches_optimistic = 1;
+
+/*
+ * Optimistic reads happen on every internal page of every search, so
+ * they're counted per thread rather than in the shared region stats:
+ * each thread takes a slot of its own, round robin, and __lock_stat adds
+ * the slots up.  Threads only share a slot when there are more than
+ * LATCH_OPT_SLOTS of them.
+ */
+#define	LATCH_OPT_SLOTS	256
+
+static struct __latch_opt_count {
+	u_int64_t n;
+	u_int64_t fail;
+} __attribute__((aligned(64))) latch_opt_counts[LATCH_OPT_SLOTS];
+static u_int32_t latch_opt_next;
+static __thread struct __latch_opt_count *latch_opt_count;
+
+static inline struct __latch_opt_count *
+__lock_latch_opt_count(void)
+{
+	if (latch_opt_count == NULL)
+		latch_opt_count = &latch_opt_counts[
+		    ATOMIC_ADD32(latch_opt_next, 1) % LATCH_OPT_SLOTS];
+	return (latch_opt_count);
+}
+
+/*
+ * __lock_latch_opt_stat --
+ *	Add up the optimistic read counts, clearing them if asked.
+ *
+ * PUBLIC: void __lock_latch_opt_stat __P((u_int64_t *, u_int64_t *, int));
+ */
+void
+__lock_latch_opt_stat(np, failp, clear)
+	u_int64_t *np, *failp;
+	int clear;
+{
+	u_int32_t i;
+
+	*np = *failp = 0;
+	for (i = 0; i < LATCH_OPT_SLOTS; ++i) {
+		*np += __atomic_load_n(&latch_opt_counts[i].n,
+		    __ATOMIC_RELAXED);
+		*failp += __atomic_load_n(&latch_opt_counts[i].fail,
+		    __ATOMIC_RELAXED);
+		if (clear) {
+			__atomic_store_n(&latch_opt_counts[i].n, 0,
+			    __ATOMIC_RELAXED);
+			__atomic_store_n(&latch_opt_counts[i].fail, 0,
+			    __ATOMIC_RELAXED);
+		}
+	}
+}
+
+/*
+ * __lock_latch_version --
+ *	Begin an optimistic read of the page named by a page lock object:
+ *	return the version of its latch, or DB_LOCK_NOTGRANTED if page
+ *	latches aren't in use or the latch is held for writing.  Nothing is
+ *	acquired, so there's nothing to release.
+ *
+ * PUBLIC: int __lock_latch_version __P((DB_ENV *, const DBT *, u_int32_t *));
+ */
+int
+__lock_latch_version(dbenv, obj, versionp)
+	DB_ENV *dbenv;
+	const DBT *obj;
+	u_int32_t *versionp;
+{
+	DB_LOCKTAB *lt;
+	DB_LOCKREGION *region;
+	u_int32_t version;
+
+	if (!gbl_page_latches_optimistic ||
+	    F_ISSET(dbenv, DB_ENV_NOLOCKING) || !use_page_latches(dbenv))
+		return (DB_LOCK_NOTGRANTED);
+
+	lt = dbenv->lk_handle;
+	region = lt->reginfo.primary;
+	version = ATOMIC_LOAD32(region->latches[latchhash(dbenv, obj)].version);
+	if (version & 1)
+		return (DB_LOCK_NOTGRANTED);
+	*versionp = version;
+	__atomic_fetch_add(&__lock_latch_opt_count()->n, 1, __ATOMIC_RELAXED);
+	return (0);
+}
+
+/*
+ * __lock_latch_validate --
+ *	End an optimistic read: return 0 if the page's latch hasn't been held
+ *	for writing since __lock_latch_version returned version, and
+ *	DB_LOCK_NOTGRANTED if it may have been, in which case nothing read
+ *	from the page in between can be trusted.
+ *
+ * PUBLIC: int __lock_latch_validate __P((DB_ENV *, const DBT *, u_int32_t));
+ */
+int
+__lock_latch_validate(dbenv, obj, version)
+	DB_ENV *dbenv;
+	const DBT *obj;
+	u_int32_t version;
+{
+	DB_LOCKTAB *lt;
+	DB_LOCKREGION *region;
+
+	lt = dbenv->lk_handle;
+	region = lt->reginfo.primary;
+
+	/* The page reads must complete before we look at the version. */
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (ATOMIC_LOAD32(
+	    region->latches[latchhash(dbenv, obj)].version) == version)
+		return (0);
+	__atomic_fetch_add(&__lock_latch_opt_count()->fail,
+	    1, __ATOMIC_RELAXED);
+	return (DB_LOCK_NOTGRANTED);
+}
+
 int
 init_latches(dbenv, lt)
 	DB_ENV *dbenv;
@@ -1026,7 +1171,7 @@ __put_page_latch_int(dbenv, lock)
 
 		latch->count--;
 		if (IS_WRITELOCK(lnode->lock_mode))
-			latch->wrcount--;
+			__latch_wrcount_dec(latch);
 
 		__deallocate_ilock_latch(dbenv, lnode);
 
@@ -1126,7 +1271,7 @@ __get_page_latch_int(lt, locker, flags, obj, lock_mode, lock)
 		assert(lnode->latch == latch);
 		assert(latch->lockerid == locker);
 		if (!IS_WRITELOCK(lnode->lock_mode))
-			latch->wrcount++;
+			__latch_wrcount_inc(latch);
 		lnode->lock_mode = lock_mode;
 		return (0);
 	}
@@ -1211,11 +1356,11 @@ __get_page_latch_int(lt, locker, flags, obj, lock_mode, lock)
 		latch->listhead = lnode;
 		latch->count++;
 		if (IS_WRITELOCK(lock_mode))
-			latch->wrcount++;
+			__latch_wrcount_inc(latch);
 	} else if (IS_WRITELOCK(lock_mode)) {
 		assert(lock_mode == DB_LOCK_WRITE);
 		if (!IS_WRITELOCK(lnode->lock_mode))
-			latch->wrcount++;
+			__latch_wrcount_inc(latch);
 		lnode->lock_mode = lock_mode;
 	}
 
@@ -1583,7 +1728,7 @@ __lock_vec(dbenv, locker, flags, list, nlist, elistp)
 						latch->count--;
 						if (IS_WRITELOCK(lnode->
 							lock_mode)) {
-							latch->wrcount--;
+							__latch_wrcount_dec(latch);
 							nwrites--;
 							nwritelatches--;
 						}
@@ -2605,6 +2750,8 @@ upgrade:
 		if (IS_WRITELOCK(lock_mode) && !IS_WRITELOCK(lp->mode))
 			sh_locker->nwrites++;
 		lp->mode = lock_mode;
+		if (SH_TAILQ_FIRST(&sh_obj->waiters, __db_lock) != NULL)
+			LOCK_DD_CHANGED(region, sh_obj->partition);
 		if (is_pagelock(sh_obj) &&
 		    IS_WRITELOCK(lock_mode) &&
 		    F_ISSET(sh_locker, DB_LOCKER_TRACK_WRITELOCKS) &&
@@ -2640,6 +2787,8 @@ upgrade:
 	case GRANT:
 		newl->status = DB_LSTAT_HELD;
 		SH_TAILQ_INSERT_TAIL(&sh_obj->holders, newl, links);
+		if (SH_TAILQ_FIRST(&sh_obj->waiters, __db_lock) != NULL)
+			LOCK_DD_CHANGED(region, sh_obj->partition);
 		break;
 	case HEAD:
 	case TAIL:
@@ -2686,6 +2835,7 @@ upgrade:
 		default:
 			DB_ASSERT(0);
 		}
+		LOCK_DD_CHANGED(region, sh_obj->partition);
 
 		/*
 		 * This is really a blocker for the thread.  It should be
@@ -2908,8 +3058,15 @@ expired:			obj_ndx = sh_obj->index;
 			SH_TAILQ_REMOVE(&sh_obj->holders, newl, links,
 			    __db_lock);
 			goto upgrade;
-		} else
+		} else {
+			/*
+			 * The detector ignores promoted locks until they're
+			 * held, so this is when waiters start waiting on us.
+			 */
 			newl->status = DB_LSTAT_HELD;
+			if (SH_TAILQ_FIRST(&sh_obj->waiters, __db_lock) != NULL)
+				LOCK_DD_CHANGED(region, sh_obj->partition);
+		}
 	}
 
 	lock->off = R_OFFSET(&lt->reginfo, newl);
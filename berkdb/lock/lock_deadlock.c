@@ -33,6 +33,7 @@ static const char revid[] = "$Id: lock_deadlock.c,v 11.66 2003/11/19 19:59:02 ub
 #include "debug_switches.h"
 #include "logmsg.h"
 #include "locks_wrap.h"
+#include <epochlib.h>
 
 extern int verbose_deadlocks;
 extern int gbl_sparse_lockerid_map;
@@ -461,6 +462,71 @@ __dd_print_tracked(idmap, deadmap, nlockers, victim)
 uint64_t detect_skip = 0;
 uint64_t detect_run = 0;
 
+/*
+ * Skip detector passes when no partition's waits-for generation has moved
+ * since the last pass that found no deadlock.
+ */
+int gbl_deadlock_detect_incremental = 1;
+
+/* Generations seen by the last pass, and whether it found nothing. */
+static u_int32_t *dd_seen_gen;
+static int dd_seen_clean;
+static int dd_seen_time;
+
+/* Make a full pass at least this often regardless. */
+#define	DD_FULL_PASS_SECS	10
+
+/*
+ * __dd_unchanged --
+ *	Return if no waits-for edge can have appeared since the last clean
+ *	pass: any new cycle has to use a new edge, and every new edge bumps
+ *	its object partition's generation.  Expired lock timeouts still need
+ *	a pass to find them.
+ */
+static int
+__dd_unchanged(dbenv, region)
+	DB_ENV *dbenv;
+	DB_LOCKREGION *region;
+{
+	db_timeval_t now;
+	u_int32_t i;
+
+	if (!gbl_deadlock_detect_incremental || !dd_seen_clean ||
+	    comdb2_time_epoch() - dd_seen_time >= DD_FULL_PASS_SECS)
+		return (0);
+
+	LOCK_SET_TIME_INVALID(&now);
+	if (LOCK_TIME_ISVALID(&region->next_timeout) &&
+	    __lock_expired(dbenv, &now, &region->next_timeout))
+		return (0);
+
+	for (i = 0; i < gbl_lk_parts; ++i)
+		if (region->dd_parts[i].gen != dd_seen_gen[i])
+			return (0);
+	return (1);
+}
+
+/*
+ * __dd_snapshot --
+ *	Remember the partition generations before building the waits-for
+ *	graph; anything that changes while we build makes the next pass run.
+ */
+static void
+__dd_snapshot(dbenv, region)
+	DB_ENV *dbenv;
+	DB_LOCKREGION *region;
+{
+	u_int32_t i;
+
+	dd_seen_clean = 0;
+	dd_seen_time = comdb2_time_epoch();
+	if (dd_seen_gen == NULL && __os_calloc(dbenv,
+	    gbl_lk_parts, sizeof(u_int32_t), &dd_seen_gen) != 0)
+		return;
+	for (i = 0; i < gbl_lk_parts; ++i)
+		dd_seen_gen[i] = region->dd_parts[i].gen;
+}
+
 #define LOCK_DETECT_Q 1
 
 #if LOCK_DETECT_Q
@@ -535,8 +601,10 @@ __lock_detect_int(dbenv, atype, abortp, can_retry)
 	int policy_override = gbl_deadlock_policy_override;
 	int is_client;
 	int ret;
+	u_int64_t start, usecs;
 
 	++detect_run;
+	start = comdb2_time_epochus();
 	is_client = __rep_is_client(dbenv);
 
 	if (!is_client) {
@@ -572,6 +640,15 @@ __lock_detect_int(dbenv, atype, abortp, can_retry)
 
 	/* Make a pass only if auto-detect would run. */
 	region = lt->reginfo.primary;
+
+	if (__dd_unchanged(dbenv, region)) {
+		region->need_dd = 0;
+		++region->stat.st_ndetects_skipped;
+		UNLOCKREGION(dbenv, lt);
+		return (0);
+	}
+	__dd_snapshot(dbenv, region);
+
 	lock_lockers(region);
 
 	keeper = BAD_KILLID;
@@ -621,10 +698,12 @@ __lock_detect_int(dbenv, atype, abortp, can_retry)
 	} else
 		txn_max = TXN_MAXIMUM;
 	if (ret !=0 || atype == DB_LOCK_EXPIRE)
-		return (ret);
+		goto done;
 
-	if (nlockers == 0)
-		return (0);
+	if (nlockers == 0) {
+		dd_seen_clean = (dd_seen_gen != NULL);
+		goto done;
+	}
 #ifdef DIAGNOSTIC
 	if (FLD_ISSET(dbenv->verbose, DB_VERB_WAITSFOR))
 		 __dd_debug(dbenv, idmap, bitmap, sparse_map, nlockers, nalloc);
@@ -657,6 +736,8 @@ __lock_detect_int(dbenv, atype, abortp, can_retry)
 	killid = BAD_KILLID;
 	free_me = deadp;
 	free_me_2 = deadwho;
+	if (*deadp == NULL)
+		dd_seen_clean = (dd_seen_gen != NULL);
 
 	/* dd_find creates an array of bitmaps, each of which describes a deadlock.
 	 * A single locker is only allowed to be detected in a single deadlock (the first
@@ -664,6 +745,7 @@ __lock_detect_int(dbenv, atype, abortp, can_retry)
 	for (dwhoix = 0; *deadp != NULL; deadp++, dwhoix++) {
 		if (abortp != NULL)
 			++*abortp;
+		++region->stat.st_ndeadlock_cycles;
 		if (sparse_map) {
 			killid = deadwho[dwhoix];
 		} else
@@ -921,6 +1003,11 @@ err:
 	if (sparse_copymap)
 		free_sparse_map(dbenv, sparse_copymap);
 
+done:	usecs = comdb2_time_epochus() - start;
+	++region->stat.st_ndetects;
+	region->stat.st_detect_usecs += usecs;
+	if (usecs > region->stat.st_detect_max_usecs)
+		region->stat.st_detect_max_usecs = usecs;
 	return (ret);
 }
 
@@ -318,6 +318,11 @@ __lock_init(dbenv, lt)
 	    &region->nwlk_scale)) != 0) {
 		goto mem_err;
 	}
+	if ((ret = __db_shalloc(lt->reginfo.addr,
+	    sizeof(region->dd_parts[0]) * gbl_lk_parts, 0,
+	    &region->dd_parts)) != 0) {
+		goto mem_err;
+	}
 	if ((ret = __db_shalloc(lt->reginfo.addr,
 	    sizeof(region->nwobj_scale[0]) * gbl_lk_parts, 0,
 	    &region->nwobj_scale)) != 0) {
@@ -332,6 +337,7 @@ __lock_init(dbenv, lt)
 	for (i = 0; i < gbl_lk_parts; ++i) {
 		region->nwlk_scale[i] = 0;
 		region->nwobj_scale[i] = 0;
+		region->dd_parts[i].gen = 0;
 		/* Allocate room for the object hash table and initialize it. */
 		Pthread_mutex_init(&region->obj_tab_mtx[i].mtx, NULL);
 		bzero(region->obj_tab_mtx[i].fluff,
@@ -506,6 +512,7 @@ __lock_region_size(dbenv)
 
 	retval += sizeof(region->obj_tab[0]) * gbl_lk_parts;
 	retval += sizeof(region->obj_tab_mtx[0]) * gbl_lk_parts;
+	retval += sizeof(region->dd_parts[0]) * gbl_lk_parts;
 
 	/* And we keep getting this wrong, let's be generous. */
 	retval += retval / 5;
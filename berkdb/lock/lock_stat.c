@@ -118,6 +118,8 @@ __lock_stat(dbenv, statp, flags)
 	stats->st_region_wait = lt->reginfo.rp->mutex.mutex_set_wait;
 	stats->st_region_nowait = lt->reginfo.rp->mutex.mutex_set_nowait;
 	stats->st_regsize = lt->reginfo.rp->size;
+	__lock_latch_opt_stat(&stats->st_nlatch_optimistic,
+	    &stats->st_nlatch_optimistic_fail, LF_ISSET(DB_STAT_CLEAR));
 	if (LF_ISSET(DB_STAT_CLEAR)) {
 		tmp = region->stat;
 		memset(&region->stat, 0, sizeof(region->stat));
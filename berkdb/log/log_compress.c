@@ -0,0 +1,181 @@
+/*-
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 1996-2003
+ *	Sleepycat Software.  All rights reserved.
+ */
+#include "db_config.h"
+
+#ifndef NO_SYSTEM_INCLUDES
+#include <sys/types.h>
+
+#include <string.h>
+#endif
+
+#include "db_int.h"
+#include "dbinc/log.h"
+#include "dbinc/db_swap.h"
+#include "dbinc/txn.h"
+#include "dbinc_auto/dbreg_auto.h"
+#include "dbinc_auto/db_auto.h"
+
+#include <lz4.h>
+
+#if LZ4_VERSION_NUMBER < 10701
+#define LZ4_compress_default LZ4_compress_limitedOutput
+#endif
+
+/*
+ * Log records at least this many bytes long are written LZ4-compressed;
+ * 0 disables compression.
+ */
+int gbl_log_compress_threshold = 0;
+
+/*
+ * __log_compressible --
+ *	Return if a record type may be compressed.  Replication looks at
+ *	commits, checkpoints and file registrations as they arrive, before
+ *	they've been through a log cursor, so those are always left alone.
+ */
+static int
+__log_compressible(rectype)
+	u_int32_t rectype;
+{
+	if (rectype & DB_lz4_FLAG)
+		return (0);
+
+	switch (rectype & ~DB_debug_FLAG) {
+	case DB___txn_regop:
+	case DB___txn_ckp:
+	case DB___txn_child:
+	case DB___txn_xa_regop:
+	case DB___txn_recycle:
+	case DB___txn_regop_rowlocks:
+	case DB___txn_regop_gen:
+	case DB___dbreg_register:
+	case DB___db_debug:
+		return (0);
+	}
+	return (1);
+}
+
+/*
+ * __log_compress --
+ *	Compress a log record that's about to be written.  Sets zrec to a
+ *	new record the caller must free, or leaves zrec->data NULL if the
+ *	record shouldn't be compressed or doesn't compress well enough.
+ *
+ * PUBLIC: int __log_compress __P((DB_ENV *, const DBT *, DBT *));
+ */
+int
+__log_compress(dbenv, rec, zrec)
+	DB_ENV *dbenv;
+	const DBT *rec;
+	DBT *zrec;
+{
+	u_int32_t rectype;
+	u_int8_t *zp;
+	int bound, ret, zlen;
+
+	memset(zrec, 0, sizeof(*zrec));
+
+	if (gbl_log_compress_threshold <= 0 ||
+	    rec->size < (u_int32_t)gbl_log_compress_threshold ||
+	    rec->size <= LOG_LZ4_HDR)
+		return (0);
+	LOGCOPY_32(&rectype, rec->data);
+	if (!__log_compressible(rectype))
+		return (0);
+
+	bound = LZ4_COMPRESSBOUND(rec->size - LOG_LZ4_PREFIX);
+	if ((ret = __os_malloc(dbenv, LOG_LZ4_HDR + bound, &zp)) != 0)
+		return (ret);
+
+	zlen = LZ4_compress_default((char *)rec->data + LOG_LZ4_PREFIX,
+	    (char *)zp + LOG_LZ4_HDR, rec->size - LOG_LZ4_PREFIX, bound);
+
+	/* Not worth it unless it saves an eighth of the record. */
+	if (zlen <= 0 || LOG_LZ4_HDR + zlen > rec->size - rec->size / 8) {
+		__os_free(dbenv, zp);
+		return (0);
+	}
+
+	rectype |= DB_lz4_FLAG;
+	LOGCOPY_32(zp, &rectype);
+	memcpy(zp + sizeof(u_int32_t), (u_int8_t *)rec->data +
+	    sizeof(u_int32_t), LOG_LZ4_PREFIX - sizeof(u_int32_t));
+	LOGCOPY_32(zp + LOG_LZ4_PREFIX, &rec->size);
+
+	zrec->data = zp;
+	zrec->size = LOG_LZ4_HDR + zlen;
+	return (0);
+}
+
+/*
+ * __log_is_compressed --
+ *	Return if a log record was compressed when it was written.
+ *
+ * PUBLIC: int __log_is_compressed __P((const DBT *));
+ */
+int
+__log_is_compressed(rec)
+	const DBT *rec;
+{
+	u_int32_t rectype;
+
+	if (rec->size <= LOG_LZ4_HDR)
+		return (0);
+	LOGCOPY_32(&rectype, rec->data);
+	return ((rectype & DB_lz4_FLAG) != 0);
+}
+
+/*
+ * __log_uncompress --
+ *	Uncompress a log record into a buffer, growing it if needed.  The
+ *	buffer's address and length are passed by reference; the record's
+ *	length is returned through sizep.
+ *
+ * PUBLIC: int __log_uncompress
+ * PUBLIC:     __P((DB_ENV *, const DBT *, void *, u_int32_t *, u_int32_t *));
+ */
+int
+__log_uncompress(dbenv, zrec, bufp, buflenp, sizep)
+	DB_ENV *dbenv;
+	const DBT *zrec;
+	void *bufp;
+	u_int32_t *buflenp, *sizep;
+{
+	u_int32_t rectype, size;
+	u_int8_t *buf, *zp;
+	int ret;
+
+	zp = zrec->data;
+	LOGCOPY_32(&rectype, zp);
+	LOGCOPY_32(&size, zp + LOG_LZ4_PREFIX);
+	if (size <= LOG_LZ4_PREFIX)
+		goto corrupt;
+
+	if (*buflenp < size) {
+		if ((ret = __os_realloc(dbenv, size, bufp)) != 0)
+			return (ret);
+		*buflenp = size;
+	}
+	buf = *(u_int8_t **)bufp;
+
+	rectype &= ~DB_lz4_FLAG;
+	LOGCOPY_32(buf, &rectype);
+	memcpy(buf + sizeof(u_int32_t), zp + sizeof(u_int32_t),
+	    LOG_LZ4_PREFIX - sizeof(u_int32_t));
+	if (LZ4_decompress_safe((char *)zp + LOG_LZ4_HDR,
+	    (char *)buf + LOG_LZ4_PREFIX, zrec->size - LOG_LZ4_HDR,
+	    size - LOG_LZ4_PREFIX) != (int)(size - LOG_LZ4_PREFIX))
+		goto corrupt;
+
+	*sizep = size;
+	return (0);
+
+corrupt:
+	__db_err(dbenv, "compressed log record of type %lu is corrupt",
+	    (u_long)(rectype & ~DB_lz4_FLAG));
+	return (EINVAL);
+}
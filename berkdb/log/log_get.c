@@ -13,7 +13,9 @@ static const char revid[] = "$Id: log_get.c,v 11.98 2003/09/13 19:20:38 bostic E
 #ifndef NO_SYSTEM_INCLUDES
 #include <sys/types.h>
 
+#include <errno.h>
 #include <string.h>
+#include <unistd.h>
 #endif
 
 #include <assert.h>
@@ -26,6 +28,7 @@ static const char revid[] = "$Id: log_get.c,v 11.98 2003/09/13 19:20:38 bostic E
 #include "dbinc/hash.h"
 #include <epochlib.h>
 #include <locks_wrap.h>
+#include <thdpool.h>
 
 typedef enum { L_ALREADY, L_ACQUIRED, L_NONE } RLOCK;
 
@@ -47,6 +50,183 @@ static int __log_c_ondisk __P((DB_LOGC *,
 	       DB_LSN *, DB_LSN *, int, HDR *, u_int8_t **, int *));
 static int __log_c_set_maxrec __P((DB_LOGC *, char *));
 static int __log_c_shortread __P((DB_LOGC *, DB_LSN *, int));
+static int __log_c_stream __P((DB_LOGC *,
+    DB_LSN *, DB_LSN *, HDR *, u_int8_t **, int *));
+static void __log_c_stream_close __P((DB_LOGC *));
+
+/*
+ * Streaming cursors (DB_LOG_STREAM) read the log forward in large aligned
+ * blocks, double buffered: while records are handed out of one block, a
+ * readahead thread fills the other with the block after it.  A record that
+ * straddles the two has its start carried over in front of the new block,
+ * so it's still contiguous.  Anything out of the ordinary (direction
+ * changes, records bigger than a block, the end of the log) falls back to
+ * the regular single-record reads.
+ *
+ * Size of each streaming block in bytes; 0 disables streaming.
+ */
+int gbl_log_stream_bufsize = 1 << 20;
+
+#define	LOG_STREAM_ALIGN	4096
+#define	LOG_STREAM_PAD		(64 * 1024)	/* Room for a carried record. */
+
+struct __log_stream_buf {
+	u_int8_t *mem;			/* LOG_STREAM_PAD + size bytes. */
+	u_int8_t *data;			/* The log from lsn on. */
+	DB_LSN lsn;
+	u_int32_t rlen;			/* Valid bytes at data. */
+};
+
+struct __log_stream {
+	struct __log_stream_buf b[2];
+	int cur;			/* Block records come from. */
+	u_int32_t size;
+
+	pthread_mutex_t lk;
+	pthread_cond_t cond;
+	int ra_pending;			/* Readahead queued or running. */
+	int ra_valid;			/* Readahead done, not yet used. */
+	int ra_fd;
+	DB_LSN ra_lsn;			/* Where the readahead starts. */
+	size_t ra_len;			/* Bytes asked for. */
+	size_t ra_nr;			/* Bytes read. */
+	int ra_ret;
+};
+
+static pthread_once_t log_stream_once = PTHREAD_ONCE_INIT;
+static struct thdpool *log_stream_thdpool;
+
+static void
+__log_stream_pool_init(void)
+{
+	log_stream_thdpool = thdpool_create("logreadahead", 0);
+	thdpool_set_linger(log_stream_thdpool, 10);
+	thdpool_set_minthds(log_stream_thdpool, 0);
+	thdpool_set_maxthds(log_stream_thdpool, 16);
+	thdpool_set_maxqueue(log_stream_thdpool, 64);
+	thdpool_set_wait(log_stream_thdpool, 0);
+}
+
+/*
+ * __log_stream_wait --
+ *	Wait for a stream's readahead, if any, to finish.
+ */
+static void
+__log_stream_wait(s)
+	struct __log_stream *s;
+{
+	Pthread_mutex_lock(&s->lk);
+	while (s->ra_pending)
+		Pthread_cond_wait(&s->cond, &s->lk);
+	Pthread_mutex_unlock(&s->lk);
+}
+
+/*
+ * __log_stream_read_ahead --
+ *	Thread pool work function: read the next block into the buffer
+ *	records aren't being read from.
+ */
+static void
+__log_stream_read_ahead(pool, work, thddata, op)
+	struct thdpool *pool;
+	void *work, *thddata;
+	int op;
+{
+	struct __log_stream *s;
+	u_int8_t *p;
+	size_t nr;
+	ssize_t n;
+	int ret;
+
+	s = work;
+	nr = 0;
+	ret = 0;
+	if (op == THD_RUN) {
+		p = s->b[!s->cur].mem + LOG_STREAM_PAD;
+		while (nr < s->ra_len) {
+			n = pread(s->ra_fd, p + nr,
+			    s->ra_len - nr, (off_t)s->ra_lsn.offset + nr);
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n < 0)
+				ret = errno;
+			if (n <= 0)
+				break;
+			nr += n;
+		}
+	} else
+		ret = EAGAIN;		/* Never ran. */
+
+	Pthread_mutex_lock(&s->lk);
+	s->ra_nr = nr;
+	s->ra_ret = ret;
+	s->ra_pending = 0;
+	s->ra_valid = 1;
+	Pthread_cond_signal(&s->cond);
+	Pthread_mutex_unlock(&s->lk);
+}
+
+/*
+ * __log_stream_alloc --
+ *	Set up a cursor's streaming buffers.
+ */
+static int
+__log_stream_alloc(logc)
+	DB_LOGC *logc;
+{
+	struct __log_stream *s;
+	DB_ENV *dbenv;
+	u_int32_t size;
+	int i, ret;
+
+	dbenv = logc->dbenv;
+	size = (u_int32_t)gbl_log_stream_bufsize;
+	if (size < LOG_STREAM_PAD)
+		size = LOG_STREAM_PAD;
+	size = (size + LOG_STREAM_ALIGN - 1) & ~(LOG_STREAM_ALIGN - 1);
+
+	if ((ret = __os_calloc(dbenv, 1, sizeof(*s), &s)) != 0)
+		return (ret);
+	for (i = 0; i < 2; ++i)
+		if ((ret = __os_malloc(dbenv,
+		    LOG_STREAM_PAD + size, &s->b[i].mem)) != 0) {
+			if (i == 1)
+				__os_free(dbenv, s->b[0].mem);
+			__os_free(dbenv, s);
+			return (ret);
+		}
+	s->size = size;
+	Pthread_mutex_init(&s->lk, NULL);
+	Pthread_cond_init(&s->cond, NULL);
+	pthread_once(&log_stream_once, __log_stream_pool_init);
+
+	logc->c_stream = s;
+	return (0);
+}
+
+/*
+ * __log_c_stream_close --
+ *	Release a cursor's streaming buffers.
+ */
+static void
+__log_c_stream_close(logc)
+	DB_LOGC *logc;
+{
+	struct __log_stream *s;
+	DB_ENV *dbenv;
+
+	if ((s = logc->c_stream) == NULL)
+		return;
+	dbenv = logc->dbenv;
+
+	__log_stream_wait(s);
+	Pthread_cond_destroy(&s->cond);
+	Pthread_mutex_destroy(&s->lk);
+	__os_free(dbenv, s->b[0].mem);
+	__os_free(dbenv, s->b[1].mem);
+	__os_free(dbenv, s);
+	logc->c_stream = NULL;
+}
 
 /*
  * __log_cursor_pp --
@@ -224,6 +404,8 @@ __log_c_close(logc)
         if (logc->c_dbt.data != NULL)
             __os_free(dbenv, logc->c_dbt.data);
         memset(&logc->c_dbt, 0, sizeof(DBT));
+        F_CLR(logc, DB_LOG_RAW | DB_LOG_STREAM);
+        __log_c_stream_close(logc);
         ZERO_LSN(logc->bp_lsn);
         logc->bp_maxrec = 0;
         logc->bp_rlen = 0;
@@ -240,6 +422,7 @@ __log_c_close(logc)
         return (0);
     }
 
+	__log_c_stream_close(logc);
 	if (logc->c_fhp != NULL) {
 		(void)__os_closehandle(dbenv, logc->c_fhp);
 		logc->c_fhp = NULL;
@@ -247,6 +430,8 @@ __log_c_close(logc)
 
 	if (logc->c_dbt.data != NULL)
 		__os_free(dbenv, logc->c_dbt.data);
+	if (logc->c_zbuf != NULL)
+		__os_free(dbenv, logc->c_zbuf);
 
 	__os_free(dbenv, logc->bp);
 	__os_free(dbenv, logc);
@@ -472,7 +657,7 @@ __log_c_get_int(logc, alsn, dbt, flags)
 	LOG *lp;
 	RLOCK rlock;
 	logfile_validity status;
-	u_int32_t cnt;
+	u_int32_t cnt, zlen;
 	u_int8_t *rp;
 	int eof, is_hmac, ret, st, tot;
 
@@ -651,6 +836,24 @@ next_file:	++nlsn.file;
 		rlock = L_NONE;
 		R_UNLOCK(dbenv, &dblp->reginfo);
 	}
+	if (F_ISSET(logc, DB_LOG_STREAM) && gbl_log_stream_bufsize > 0 &&
+	    (flags == DB_NEXT || flags == DB_FIRST)) {
+		if ((ret = __log_c_stream(logc,
+		    &nlsn, &last_lsn, &hdr, &rp, &eof)) != 0) {
+			if (ret == EIO)
+				ret = DB_NOTFOUND;
+			goto err;
+		}
+		if (eof == 1) {
+			if (flags != DB_NEXT || nlsn.offset == 0)
+				return (DB_NOTFOUND);
+			goto next_file;
+		}
+		if (rp != NULL) {
+			F_SET(logc, DB_LOG_DISK);
+			goto cksum;
+		}
+	}
 	if ((ret =
 		__log_c_ondisk(logc, &nlsn, &last_lsn, flags, &hdr, &rp,
 		    &eof)) != 0) {
@@ -745,8 +948,18 @@ cksum:	/*
 		}
 	}
 
-	/* Copy the record into the user's DBT. */
-	if ((ret = __db_retcopy(dbenv, dbt, rp + hdr.size,
+	/*
+	 * Copy the record into the user's DBT.  A streaming cursor whose
+	 * caller leaves the memory to the cursor gets a pointer into the
+	 * cursor's buffer instead; like a copy, it's good until the next
+	 * call on the cursor.
+	 */
+	if (F_ISSET(logc, DB_LOG_STREAM) && !CRYPTO_ON(dbenv) &&
+	    !F_ISSET(dbt, DB_DBT_MALLOC | DB_DBT_REALLOC |
+	    DB_DBT_USERMEM | DB_DBT_PARTIAL)) {
+		dbt->data = rp + hdr.size;
+		dbt->size = (u_int32_t)(hdr.len - hdr.size);
+	} else if ((ret = __db_retcopy(dbenv, dbt, rp + hdr.size,
 	    (u_int32_t)(hdr.len - hdr.size),
 	    &logc->c_dbt.data, &logc->c_dbt.ulen)) != 0)
 		goto err;
@@ -774,6 +987,24 @@ cksum:	/*
 		dbt->size = hdr.orig_size;
 	}
 
+	/*
+	 * Uncompress compressed records into the cursor's buffer and hand
+	 * the caller that instead.  Log file headers are never compressed.
+	 */
+	if (nlsn.offset != 0 && !F_ISSET(logc, DB_LOG_RAW) &&
+	    !F_ISSET(dbt, DB_DBT_PARTIAL) && __log_is_compressed(dbt)) {
+		if ((ret = __log_uncompress(dbenv, dbt,
+		    &logc->c_zbuf, &logc->c_zbuflen, &zlen)) != 0)
+			goto err;
+		if (F_ISSET(dbt, DB_DBT_MALLOC)) {
+			__os_ufree(dbenv, dbt->data);
+			dbt->data = NULL;
+		}
+		if ((ret = __db_retcopy(dbenv, dbt, logc->c_zbuf, zlen,
+		    &logc->c_dbt.data, &logc->c_dbt.ulen)) != 0)
+			goto err;
+	}
+
 	/* Update the cursor and the returned LSN. */
 	*alsn = nlsn;
 	logc->c_lsn = nlsn;
@@ -812,12 +1043,16 @@ __log_hdrswap(hdr, is_hmac)
 
 
 /*
- * __log_c_incursor --
- *	Check to see if the requested record is in the cursor's buffer.
+ * __log_c_inbuf --
+ *	Check to see if the requested record is in a buffer holding the log
+ *	from buf_lsn on.
  */
 static int
-__log_c_incursor_int(logc, lsn, hdr, pp)
+__log_c_inbuf(logc, buf, buf_lsn, buf_rlen, lsn, hdr, pp)
 	DB_LOGC *logc;
+	u_int8_t *buf;
+	DB_LSN *buf_lsn;
+	u_int32_t buf_rlen;
 	DB_LSN *lsn;
 	HDR *hdr;
 	u_int8_t **pp;
@@ -825,12 +1060,9 @@ __log_c_incursor_int(logc, lsn, hdr, pp)
 	u_int8_t *p;
 	int eof;
 	DB_ENV *dbenv;
-	LOG *lp;
 
 	dbenv = logc->dbenv;
 
-	*pp = NULL;
-
 	/*
 	 * Test to see if the requested LSN could be part of the cursor's
 	 * buffer.
@@ -841,11 +1073,11 @@ __log_c_incursor_int(logc, lsn, hdr, pp)
 	 * The record must not start at a byte offset after the cursor
 	 * buffer's end.
 	 */
-	if (logc->bp_lsn.file != lsn->file)
+	if (buf_lsn->file != lsn->file)
 		return (0);
-	if (logc->bp_lsn.offset > lsn->offset)
+	if (buf_lsn->offset > lsn->offset)
 		return (0);
-	if (logc->bp_lsn.offset + logc->bp_rlen <= lsn->offset + hdr->size)
+	if (buf_lsn->offset + buf_rlen <= lsn->offset + hdr->size)
 		return (0);
 
 	/*
@@ -858,16 +1090,51 @@ __log_c_incursor_int(logc, lsn, hdr, pp)
 	 * If the header check fails for any reason, it must be because the
 	 * LSN is bogus.  Fail hard.
 	 */
-	p = logc->bp + (lsn->offset - logc->bp_lsn.offset);
+	p = buf + (lsn->offset - buf_lsn->offset);
 	memcpy(hdr, p, hdr->size);
 	if (LOG_SWAPPED())
 		__log_hdrswap(hdr, CRYPTO_ON(dbenv));
 	if (__log_c_hdrchk(logc, lsn, hdr, &eof))
 		return (DB_NOTFOUND);
-	if (eof || logc->bp_lsn.offset + logc->bp_rlen < lsn->offset + hdr->len)
+	if (eof || buf_lsn->offset + buf_rlen < lsn->offset + hdr->len)
 		return (0);
 
 	*pp = p;		/* Success. */
+	return (0);
+}
+
+/*
+ * __log_c_incursor --
+ *	Check to see if the requested record is in the cursor's buffer.
+ */
+static int
+__log_c_incursor_int(logc, lsn, hdr, pp)
+	DB_LOGC *logc;
+	DB_LSN *lsn;
+	HDR *hdr;
+	u_int8_t **pp;
+{
+	struct __log_stream_buf *sb;
+	DB_ENV *dbenv;
+	LOG *lp;
+	int ret;
+
+	dbenv = logc->dbenv;
+
+	*pp = NULL;
+
+	/* A streaming cursor's current block is the likelier hit. */
+	if (logc->c_stream != NULL) {
+		sb = &logc->c_stream->b[logc->c_stream->cur];
+		if ((ret = __log_c_inbuf(logc,
+		    sb->data, &sb->lsn, sb->rlen, lsn, hdr, pp)) != 0)
+			return (ret);
+	}
+	if (*pp == NULL && (ret = __log_c_inbuf(logc, logc->bp,
+	    &logc->bp_lsn, logc->bp_rlen, lsn, hdr, pp)) != 0)
+		return (ret);
+	if (*pp == NULL)
+		return (0);
 
 	/* Get to stats. */
 	lp = ((DB_LOG *)dbenv->lg_handle)->reginfo.primary;
@@ -1526,6 +1793,182 @@ __log_c_ondisk(logc, lsn, last_lsn, flags, hdr, pp, eofp)
 	return rc;
 }
 
+/*
+ * __log_stream_fill --
+ *	Read the block holding an LSN into a stream buffer, without reading
+ *	past last_lsn.
+ */
+static int
+__log_stream_fill(logc, sb, lsn, last_lsn, eofp)
+	DB_LOGC *logc;
+	struct __log_stream_buf *sb;
+	DB_LSN *lsn, *last_lsn;
+	int *eofp;
+{
+	size_t nr;
+	u_int32_t offset;
+	int ret;
+
+	offset = lsn->offset & ~(LOG_STREAM_ALIGN - 1);
+	nr = logc->c_stream->size;
+	if (lsn->file == last_lsn->file && offset + nr >= last_lsn->offset)
+		nr = last_lsn->offset > offset ? last_lsn->offset - offset : 0;
+
+	sb->rlen = 0;
+	if (nr == 0)
+		return (0);
+	if ((ret = __log_c_io(logc, lsn->file,
+	    offset, sb->mem + LOG_STREAM_PAD, &nr, eofp)) != 0 || *eofp)
+		return (ret);
+
+	/*
+	 * The cursor's file handle follows bp_lsn; the cursor's own buffer
+	 * is stale now either way.
+	 */
+	logc->bp_lsn.file = lsn->file;
+	logc->bp_lsn.offset = 0;
+	logc->bp_rlen = 0;
+
+	sb->data = sb->mem + LOG_STREAM_PAD;
+	sb->lsn.file = lsn->file;
+	sb->lsn.offset = offset;
+	sb->rlen = (u_int32_t)nr;
+	return (0);
+}
+
+/*
+ * __log_stream_start --
+ *	Start reading the block after the current one into the other
+ *	buffer.
+ */
+static void
+__log_stream_start(logc, last_lsn)
+	DB_LOGC *logc;
+	DB_LSN *last_lsn;
+{
+	struct __log_stream *s;
+	struct __log_stream_buf *sb;
+	DB_FH *fhp;
+	size_t len;
+	u_int32_t end;
+
+	s = logc->c_stream;
+	sb = &s->b[s->cur];
+	end = sb->lsn.offset + sb->rlen;
+
+	/* The readahead borrows the cursor's handle; it must be this file. */
+	fhp = logc->c_fhp;
+	if (fhp == NULL || F_ISSET(fhp, DB_FH_DIRECT) ||
+	    logc->bp_lsn.file != sb->lsn.file)
+		return;
+
+	len = s->size;
+	if (sb->lsn.file == last_lsn->file) {
+		if (end >= last_lsn->offset)
+			return;
+		if (end + len > last_lsn->offset)
+			len = last_lsn->offset - end;
+	}
+
+	s->ra_fd = fhp->fd;
+	s->ra_lsn.file = sb->lsn.file;
+	s->ra_lsn.offset = end;
+	s->ra_len = len;
+	s->ra_valid = 0;
+	s->ra_pending = 1;
+	if (thdpool_enqueue(log_stream_thdpool,
+	    __log_stream_read_ahead, s, 0, NULL, 0) != 0)
+		s->ra_pending = 0;
+}
+
+/*
+ * __log_c_stream --
+ *	Find the next record for a streaming cursor.  Leaves *pp NULL if the
+ *	record has to be read the regular way.
+ */
+static int
+__log_c_stream(logc, lsn, last_lsn, hdr, pp, eofp)
+	DB_LOGC *logc;
+	DB_LSN *lsn, *last_lsn;
+	HDR *hdr;
+	u_int8_t **pp;
+	int *eofp;
+{
+	struct __log_stream *s;
+	struct __log_stream_buf *ob, *sb;
+	DB_ENV *dbenv;
+	LOG *lp;
+	u_int32_t carry, end;
+	u_int8_t *p;
+	int filled, ret;
+
+	dbenv = logc->dbenv;
+	lp = ((DB_LOG *)dbenv->lg_handle)->reginfo.primary;
+	*pp = NULL;
+	*eofp = 0;
+
+	if (logc->c_stream == NULL && __log_stream_alloc(logc) != 0)
+		return (0);
+	s = logc->c_stream;
+
+	/*
+	 * Use the readahead if it picks up where the current block ends,
+	 * carrying the start of the record over in front of it.
+	 */
+	__log_stream_wait(s);
+	ob = &s->b[s->cur];
+	sb = &s->b[!s->cur];
+	filled = 0;
+	if (s->ra_valid) {
+		s->ra_valid = 0;
+		end = ob->lsn.offset + ob->rlen;
+		if (s->ra_ret == 0 && s->ra_nr != 0 &&
+		    ob->lsn.file == lsn->file && s->ra_lsn.file == lsn->file &&
+		    s->ra_lsn.offset == end && ob->lsn.offset <= lsn->offset &&
+		    lsn->offset <= end && end - lsn->offset <= LOG_STREAM_PAD) {
+			carry = end - lsn->offset;
+			sb->data = sb->mem + LOG_STREAM_PAD - carry;
+			memcpy(sb->data,
+			    ob->data + (lsn->offset - ob->lsn.offset), carry);
+			sb->lsn = *lsn;
+			sb->rlen = carry + (u_int32_t)s->ra_nr;
+			++lp->stat.st_stream_ahead;
+			goto have;
+		}
+	}
+
+fill:	if ((ret =
+	    __log_stream_fill(logc, sb, lsn, last_lsn, eofp)) != 0 || *eofp)
+		return (ret);
+	filled = 1;
+
+have:	s->cur = (int)(sb - s->b);
+	++lp->stat.st_stream_reads;
+
+	/* Let the regular path sort out short reads and the end of file. */
+	if (sb->lsn.offset + sb->rlen < lsn->offset + hdr->size)
+		return (0);
+
+	p = sb->data + (lsn->offset - sb->lsn.offset);
+	memcpy(hdr, p, hdr->size);
+	if (LOG_SWAPPED())
+		__log_hdrswap(hdr, CRYPTO_ON(dbenv));
+	if ((ret = __log_c_hdrchk(logc, lsn, hdr, eofp)) != 0 || *eofp)
+		return (ret);
+
+	if (sb->lsn.offset + sb->rlen < lsn->offset + hdr->len) {
+		/* Read it again from the front, if the block can hold it. */
+		if (filled || hdr->len > s->size - LOG_STREAM_ALIGN)
+			return (0);
+		sb = &s->b[!s->cur];
+		goto fill;
+	}
+
+	*pp = p;
+	__log_stream_start(logc, last_lsn);
+	return (0);
+}
+
 
 /*
  * __log_c_hdrchk --
@@ -1638,6 +2081,9 @@ __log_c_io(logc, fnum, offset, p, nrp, eofp)
 	 * a new one.
 	 */
 	if (logc->c_fhp != NULL && logc->bp_lsn.file != fnum) {
+		/* Readahead may be using the handle. */
+		if (logc->c_stream != NULL)
+			__log_stream_wait(logc->c_stream);
 		ret = __os_closehandle(dbenv, logc->c_fhp);
 		logc->c_fhp = NULL;
 		if (ret != 0)
@@ -45,6 +45,7 @@ static const char revid[] = "$Id: log_put.c,v 11.145 2003/09/13 19:20:39 bostic
 #include "logmsg.h"
 #include <locks_wrap.h>
 #include <poll.h>
+#include <epochlib.h>
 
 extern unsigned long long get_commit_context(const void *, uint32_t generation);
 extern int bdb_update_startlwm_berk(void *statearg, unsigned long long ltranid,
@@ -81,6 +82,31 @@ extern int gbl_inflate_log;
 pthread_cond_t gbl_logput_cond = PTHREAD_COND_INITIALIZER;
 pthread_mutex_t gbl_logput_lk = PTHREAD_MUTEX_INITIALIZER;
 
+/*
+ * Group commit.  A committer that finds a flush running queues itself on
+ * lp->commits and the flushing thread's sync covers it.  A committer that
+ * would start a flush itself may first hold off for a short window so the
+ * commits arriving behind it share its sync.  The window is sized from
+ * how long syncs take and how fast commits arrive, and is skipped when
+ * nobody is likely to show up in time.
+ *
+ * gbl_group_commit_max_usecs caps the window; 0 disables waiting.
+ * gbl_group_commit_max_batch ends the window once that many are queued.
+ */
+int gbl_group_commit_max_usecs = 1000;
+int gbl_group_commit_max_batch = 64;
+
+static pthread_mutex_t gc_lk = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gc_cond = PTHREAD_COND_INITIALIZER;
+static int gc_gathering;		/* A leader is waiting on gc_cond. */
+
+/* Moving averages; protected by the log region lock. */
+static u_int64_t gc_fsync_avg;		/* Sync time, usecs. */
+static u_int64_t gc_arrival_avg;	/* Time between committers, usecs. */
+static u_int64_t gc_last_arrival;
+
+#define	GC_AVG(avg, v)	((avg) = (avg) == 0 ? (v) : ((avg) * 7 + (v)) / 8)
+
 /* TODO: Delete once finished with testing on local reps */
 extern int gbl_is_physical_replicant;
 int gbl_abort_on_illegal_log_put = 0;
@@ -159,12 +185,13 @@ __log_put_int_int(dbenv, lsnp, contextp, udbt, flags, off_context, usr_ptr)
 	void *usr_ptr;
 {
 	DB_CIPHER *db_cipher;
-	DBT *dbt, t;
+	DBT *dbt, t, zdbt;
 	DB_LOG *dblp;
 	DB_LSN lsn, old_lsn;
 	HDR hdr;
 	LOG *lp;
 	int lock_held, need_free, ret;
+	u_int32_t zorig;
 	u_int8_t *key;
 	int rectype = 0;
 	int delay;
@@ -178,6 +205,8 @@ __log_put_int_int(dbenv, lsnp, contextp, udbt, flags, off_context, usr_ptr)
     int adjsize = 0;
 
 	lock_held = need_free = 0;
+	zdbt.data = NULL;
+	zorig = udbt->size;
 	flags &= (~(DB_LOG_DONT_LOCK | DB_LOG_DONT_INFLATE));
 
 	{
@@ -201,6 +230,21 @@ __log_put_int_int(dbenv, lsnp, contextp, udbt, flags, off_context, usr_ptr)
 			abort();
 	}
 
+	/*
+	 * Compress big records.  From here on the compressed record is the
+	 * record: it's what we write, and what replication clients get so
+	 * their logs stay byte for byte the same as ours.  Commits carry a
+	 * context we fill in after the put, so they're never compressed.
+	 */
+	if (off_context < 0) {
+		if ((ret = __log_compress(dbenv, udbt, &zdbt)) != 0)
+			goto err;
+		if (zdbt.data != NULL) {
+			udbt = &zdbt;
+			t = zdbt;
+		}
+	}
+
 	/*
 	 * If we are coming from the logging code, we use an internal flag,
 	 * DB_LOG_NOCOPY, because we know we can overwrite/encrypt the log
@@ -261,6 +305,12 @@ __log_put_int_int(dbenv, lsnp, contextp, udbt, flags, off_context, usr_ptr)
 	R_LOCK(dbenv, &dblp->reginfo);
 	lock_held = 1;
 
+	if (zdbt.data != NULL) {
+		++lp->stat.st_lz4_records;
+		lp->stat.st_lz4_bytes_in += zorig;
+		lp->stat.st_lz4_bytes_out += zdbt.size;
+	}
+
 	ZERO_LSN(old_lsn);
 
     Pthread_mutex_lock(&gbl_logput_lk);
@@ -390,6 +440,8 @@ err:
 		R_UNLOCK(dbenv, &dblp->reginfo);
 	if (need_free)
 		__os_free(dbenv, dbt->data);
+	if (zdbt.data != NULL)
+		__os_free(dbenv, zdbt.data);
 
 	if (IS_REP_MASTER(dbenv) && is_commit_record(rectype) && 
 			(delay = bdb_commitdelay(dbenv->app_private))) {
@@ -1288,6 +1340,84 @@ __log_lwr_lsn(dblp)
 	}
 }
 
+/*
+ * __log_hist_add --
+ *	Count a value in a power-of-two histogram whose first bucket holds
+ *	values up to base.
+ */
+static inline void
+__log_hist_add(hist, v, base)
+	u_int32_t *hist;
+	u_int64_t v, base;
+{
+	int i;
+
+	for (i = 0; i < DB_LOG_HIST_BUCKETS - 1 && v > (base << i); ++i)
+		;
+	++hist[i];
+}
+
+/*
+ * __log_gc_gather --
+ *	Hold a flush we're about to lead for a while so that committers
+ *	arriving behind us queue up and share the sync.  Called and returns
+ *	with the region locked; updates the flush LSN to cover the queue.
+ */
+static void
+__log_gc_gather(dblp, flush_lsnp)
+	DB_LOG *dblp;
+	DB_LSN *flush_lsnp;
+{
+	DB_ENV *dbenv;
+	LOG *lp;
+	struct timespec ts;
+	u_int64_t end, now, start, window;
+	u_int32_t target;
+
+	dbenv = dblp->dbenv;
+	lp = dblp->reginfo.primary;
+
+	/*
+	 * Wait no longer than half a sync: past that, starting the sync now
+	 * and letting newcomers queue behind it is cheaper.  If commits don't
+	 * arrive at least once a window, waiting only adds latency.
+	 */
+	window = gc_fsync_avg / 2;
+	if (window > (u_int64_t)gbl_group_commit_max_usecs)
+		window = gbl_group_commit_max_usecs;
+	if (window == 0 || gc_arrival_avg == 0 || gc_arrival_avg > window)
+		return;
+	target = window / gc_arrival_avg;
+	if (target > (u_int32_t)gbl_group_commit_max_batch)
+		target = gbl_group_commit_max_batch;
+	if (lp->ncommit >= target)
+		return;
+
+	/* Look busy so newcomers queue on lp->commits rather than flush. */
+	lp->in_flush++;
+	Pthread_mutex_lock(&gc_lk);
+	gc_gathering = 1;
+	R_UNLOCK(dbenv, &dblp->reginfo);
+
+	start = now = comdb2_time_epochus();
+	end = start + window;
+	while (lp->ncommit < target && now < end) {
+		ts.tv_sec = end / 1000000;
+		ts.tv_nsec = (end % 1000000) * 1000;
+		pthread_cond_timedwait(&gc_cond, &gc_lk, &ts);
+		now = comdb2_time_epochus();
+	}
+	gc_gathering = 0;
+	Pthread_mutex_unlock(&gc_lk);
+
+	R_LOCK(dbenv, &dblp->reginfo);
+	lp->in_flush--;
+	++lp->stat.st_gc_waits;
+	lp->stat.st_gc_wait_usecs += now - start;
+	if (log_compare(&lp->t_lsn, flush_lsnp) > 0)
+		*flush_lsnp = lp->t_lsn;
+}
+
 /*
  * __log_flush_int --
  *	Write all records less than or equal to the specified LSN; internal
@@ -1310,6 +1440,7 @@ __log_flush_int(dblp, lsnp, release)
 	DB_LSN flush_lsn, f_lsn, s_lsn;
 	DB_MUTEX *flush_mutexp;
 	LOG *lp;
+	u_int64_t now, sync_start;
 	u_int32_t ncommit, w_off, listcnt;
 	int do_flush, first, ret, wrote_inmem;
 
@@ -1360,6 +1491,13 @@ __log_flush_int(dblp, lsnp, release)
 		flush_lsn = *lsnp;
 	}
 
+	if (release) {
+		now = comdb2_time_epochus();
+		if (gc_last_arrival != 0 && now > gc_last_arrival)
+			GC_AVG(gc_arrival_avg, now - gc_last_arrival);
+		gc_last_arrival = now;
+	}
+
 	/*
 	 * Comdb2 modification: skip this logic if we are a replicant.
 	 */
@@ -1426,6 +1564,11 @@ __log_flush_int(dblp, lsnp, release)
 		commit->lsn = flush_lsn;
 		SH_TAILQ_INSERT_HEAD(
 		    &lp->commits, commit, links, __db_commit);
+		if (gc_gathering) {
+			Pthread_mutex_lock(&gc_lk);
+			Pthread_cond_signal(&gc_cond);
+			Pthread_mutex_unlock(&gc_lk);
+		}
 		R_UNLOCK(dbenv, &dblp->reginfo);
 		/* Wait here for the in-progress flush to finish. */
 		MUTEX_LOCK(dbenv, &commit->mutex);
@@ -1448,6 +1591,10 @@ __log_flush_int(dblp, lsnp, release)
 			return (0);
 	}
 
+	/* We're leading the next flush: give followers a chance to join. */
+	if (release && gbl_group_commit_max_usecs > 0)
+		__log_gc_gather(dblp, &flush_lsn);
+
 	/*
 	 * Protect flushing with its own mutex so we can release
 	 * the region lock except during file switches.
@@ -1538,6 +1685,7 @@ flush:	MUTEX_LOCK(dbenv, flush_mutexp);
 		R_UNLOCK(dbenv, &dblp->reginfo);
 
 	/* Sync all writes to disk. */
+	sync_start = comdb2_time_epochus();
 	if ((ret = __os_fsync(dbenv, dblp->lfhp)) != 0) {
 		MUTEX_UNLOCK(dbenv, flush_mutexp);
 		if (release)
@@ -1571,6 +1719,12 @@ flush:	MUTEX_LOCK(dbenv, flush_mutexp);
 	lp->in_flush--;
 	++lp->stat.st_scount;
 
+	now = comdb2_time_epochus();
+	now = now > sync_start ? now - sync_start : 0;
+	lp->stat.st_fsync_usecs += now;
+	__log_hist_add(lp->stat.st_fsync_hist, now, 16);
+	GC_AVG(gc_fsync_avg, now);
+
 	/*
 	 * How many flush calls (usually commits) did this call actually sync?
 	 * At least one, if it got here.
@@ -1655,6 +1809,8 @@ done:	listcnt = 0;
 	if (lp->stat.st_mincommitperflush > ncommit ||
 	    lp->stat.st_mincommitperflush == 0)
 		lp->stat.st_mincommitperflush = ncommit;
+	if (ncommit != 0)
+		__log_hist_add(lp->stat.st_commit_hist, ncommit, 1);
 
 	return (ret);
 }
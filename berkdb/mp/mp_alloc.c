@@ -33,6 +33,7 @@ static const char revid[] = "$Id: mp_alloc.c,v 11.40 2003/07/03 02:24:34 bostic
 #include <cdb2_constants.h>
 #include "logmsg.h"
 #include "locks_wrap.h"
+#include "comdb2_atomic.h"
 
 typedef struct {
 	DB_MPOOL_HASH *bucket;
@@ -214,6 +215,13 @@ static void dump_page_stats(DB_ENV *dbenv) {
 		logmsgf(LOGMSG_USER, out, "  st_page_out   : %"PRId64"\n", (*fsp)->st_page_out);
 		logmsgf(LOGMSG_USER, out, "  st_ro_merges  : %"PRId64"\n", (*fsp)->st_ro_merges);
 		logmsgf(LOGMSG_USER, out, "  st_rw_merges  : %"PRId64"\n", (*fsp)->st_rw_merges);
+		logmsgf(LOGMSG_USER, out, "  st_flush_writes: %"PRId64"\n", (*fsp)->st_flush_writes);
+		logmsgf(LOGMSG_USER, out, "  st_flush_usecs: %"PRId64"\n", (*fsp)->st_flush_usecs);
+		logmsgf(LOGMSG_USER, out, "  st_flush_max_usecs: %"PRId64"\n",
+			(*fsp)->st_flush_max_usecs);
+		logmsgf(LOGMSG_USER, out, "  st_ccache_hit : %"PRId64"\n", (*fsp)->st_ccache_hit);
+		logmsgf(LOGMSG_USER, out, "  st_ccache_miss: %"PRId64"\n", (*fsp)->st_ccache_miss);
+		logmsgf(LOGMSG_USER, out, "  st_ccache_put : %"PRId64"\n", (*fsp)->st_ccache_put);
 	}
 
 	free(mpool_stats);
@@ -226,6 +234,38 @@ static void dump_page_stats(DB_ENV *dbenv) {
 
 int gbl_debug_memp_alloc_size = 0;
 static pthread_mutex_t dump_once_lk = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Replacement policy.  Buffers are admitted on probation and placed
+ * gbl_mpool_cold_priority_pct of the pool behind the LRU head when they
+ * are put; a buffer referenced again more than gbl_mpool_promote_window
+ * puts after its admission is promoted and is put at full priority from
+ * then on.  This is a 2Q-style policy expressed in the existing priority
+ * space, so a scan or analyze evicts its own pages before the hot set.
+ */
+int gbl_mpool_scan_resistant = 1;
+int gbl_mpool_cold_priority_pct = 50;
+int gbl_mpool_promote_window = 256;
+int gbl_mpool_sweep_partitions = 16;
+
+/*
+ * __memp_sweep_bucket --
+ *	Return the next hash bucket to examine in a sweep partition.
+ */
+static inline DB_MPOOL_HASH *
+__memp_sweep_bucket(c_mp, dbht, nparts, part)
+	MPOOL *c_mp;
+	DB_MPOOL_HASH *dbht;
+	u_int32_t nparts, part;
+{
+	u_int32_t lo, hi, off;
+
+	lo = (u_int32_t)(((u_int64_t)c_mp->htab_buckets * part) / nparts);
+	hi = (u_int32_t)
+	    (((u_int64_t)c_mp->htab_buckets * (part + 1)) / nparts);
+	off = ATOMIC_ADD32(c_mp->sweep[part].cursor, 1);
+	return (&dbht[lo + off % (hi - lo)]);
+}
 /*
  * PUBLIC: int __memp_alloc_flags __P((DB_MPOOL *, REGINFO *,
  * PUBLIC:     MPOOLFILE *, size_t, roff_t *, u_int32_t, void *));
@@ -242,13 +282,13 @@ __memp_alloc_flags(dbmp, memreg, mfp, len, offsetp, flags, retp)
 {
 	BH *bhp;
 	DB_ENV *dbenv;
-	DB_MPOOL_HASH *dbht, *hp, *hp_end, *hp_tmp;
+	DB_MPOOL_HASH *dbht, *hp, *hp_tmp;
 	DB_MUTEX *mutexp;
 	MPOOL *c_mp;
 	MPOOLFILE *bh_mfp;
 	size_t freed_space;
 	u_int32_t buckets, buffers, high_priority, priority, put_counter;
-	u_int32_t total_buckets;
+	u_int32_t total_buckets, nparts, home, part;
 	int aggressive, giveup, ret;
 	void *p;
 	int sleeptime = 0;
@@ -262,7 +302,6 @@ __memp_alloc_flags(dbmp, memreg, mfp, len, offsetp, flags, retp)
 	dbenv = dbmp->dbenv;
 	c_mp = memreg->primary;
 	dbht = R_ADDR(memreg, c_mp->htab);
-	hp_end = &dbht[c_mp->htab_buckets];
 
 	buckets = buffers = put_counter = total_buckets = 0;
 	aggressive = giveup = 0;
@@ -270,6 +309,18 @@ __memp_alloc_flags(dbmp, memreg, mfp, len, offsetp, flags, retp)
 
 	c_mp->stat.st_alloc++;
 
+	/*
+	 * Pick the sweep partition this allocation starts from.  Concurrent
+	 * allocators are handed out partitions round-robin.
+	 */
+	nparts = gbl_mpool_sweep_partitions < 1 ? 1 :
+	    (u_int32_t)gbl_mpool_sweep_partitions;
+	if (nparts > MPOOL_SWEEP_MAX_PARTS)
+		nparts = MPOOL_SWEEP_MAX_PARTS;
+	if (nparts > (u_int32_t)c_mp->htab_buckets)
+		nparts = c_mp->htab_buckets;
+	home = ATOMIC_ADD32(c_mp->sweep_next, 1) % nparts;
+
 	/*
 	 * If we're allocating a buffer, and the one we're discarding is the
 	 * same size, we don't want to waste the time to re-integrate it into
@@ -357,18 +408,22 @@ found:		if (offsetp != NULL)
 	 * Walk the hash buckets and find the next two with potentially useful
 	 * buffers.  Free the buffer with the lowest priority from the buckets'
 	 * chains.
+	 *
+	 * The sweep doesn't need the region lock: partition cursors are
+	 * advanced atomically and bucket priorities are re-checked under the
+	 * bucket mutex.  We start in our home partition and move on to the
+	 * next one each time we have looked at a partition's worth of buckets,
+	 * so a full pass still visits every bucket in the cache.
 	 */
+	R_UNLOCK(dbenv, memreg);
 	for (;;) {
 		/* All pages have been freed, make one last try */
 		if (c_mp->stat.st_pages == 0)
-			goto alloc;
+			goto relock;
 
-		/* Check for wrap around. */
-		hp = &dbht[c_mp->last_checked++];
-		if (hp >= hp_end) {
-			c_mp->last_checked = 0;
-			hp = &dbht[c_mp->last_checked++];
-		}
+		part = (home + (u_int32_t)(((u_int64_t)buckets * nparts) /
+		    c_mp->htab_buckets)) % nparts;
+		hp = __memp_sweep_bucket(c_mp, dbht, nparts, part);
 
 		/*
 		 * The failure mode is when there are too many buffers we can't
@@ -402,8 +457,7 @@ found:		if (offsetp != NULL)
 		 */
 		if (buckets++ == c_mp->htab_buckets) {
 			if (freed_space > 0)
-				goto alloc;
-			R_UNLOCK(dbenv, memreg);
+				goto relock;
 
 			switch (++aggressive) {
 			case 1:
@@ -435,8 +489,7 @@ found:		if (offsetp != NULL)
 				break;
 			}
 
-			R_LOCK(dbenv, memreg);
-			goto alloc;
+			goto relock;
 		}
 
 		/*
@@ -471,8 +524,7 @@ found:		if (offsetp != NULL)
 		/* Remember the priority of the buffer we're looking for. */
 		priority = hp->hash_priority;
 
-		/* Unlock the region and lock the hash bucket. */
-		R_UNLOCK(dbenv, memreg);
+		/* Lock the hash bucket. */
 		mutexp = &hp->hash_mutex;
 		MUTEX_LOCK(dbenv, mutexp);
 
@@ -546,6 +598,20 @@ found:		if (offsetp != NULL)
 			goto next_hb;
 		}
 
+		/*
+		 * The buffer matches the file now; keep a compressed copy.
+		 * That drops the hash bucket lock, and someone may want the
+		 * buffer by the time we have it back.
+		 */
+		if (dbmp->ccache && !F_ISSET(bhp, BH_CALLPGIN | BH_TRASH) &&
+		    __memp_ccache_put(dbmp, hp, bh_mfp, bhp) != 0)
+			goto next_hb;
+
+		if (F_ISSET(bhp, BH_HOT))
+			++c_mp->stat.st_hot_evict;
+		else
+			++c_mp->stat.st_cold_evict;
+
 		/*
 		 * Check to see if the buffer is the size we're looking for.
 		 * If so, we can simply reuse it.  Else, free the buffer and
@@ -565,14 +631,13 @@ found:		if (offsetp != NULL)
 			aggressive = 1;
 
 		/*
-		 * Unlock this hash bucket and re-acquire the region lock. If
-		 * we're reaching here as a result of calling memp_bhfree, the
-		 * hash bucket lock has already been discarded.
+		 * Unlock this hash bucket.  If we're reaching here as a result
+		 * of calling memp_bhfree, the hash bucket lock has already been
+		 * discarded.
 		 */
 		if (0) {
 next_hb:		MUTEX_UNLOCK(dbenv, mutexp);
 		}
-		R_LOCK(dbenv, memreg);
 
 		/*
 		 * Retry the allocation as soon as we've freed up sufficient
@@ -581,9 +646,11 @@ next_hb:		MUTEX_UNLOCK(dbenv, mutexp);
 		 * we'll succeed.
 		 */
 		if (freed_space >= 3 * len)
-			goto alloc;
+			goto relock;
 	}
-	/* NOTREACHED */
+
+relock:	R_LOCK(dbenv, memreg);
+	goto alloc;
 }
 
 
@@ -412,6 +412,7 @@ __memp_pgread(dbmfp, hp, bhp, can_create, is_recovery_page)
 	int is_recovery_page;
 {
 	DB_ENV *dbenv;
+	DB_MPOOL *dbmp;
 	MPOOLFILE *mfp;
 	DB_MUTEX *mutexp;
 	size_t len, nr, pagesize;
@@ -419,6 +420,7 @@ __memp_pgread(dbmfp, hp, bhp, can_create, is_recovery_page)
 
 	mutexp = &hp->hash_mutex;
 	dbenv = dbmfp->dbenv;
+	dbmp = dbenv->mp_handle;
 	mfp = dbmfp->mfp;
 	pagesize = mfp->stat.st_pagesize;
 	try_recover = 0;
@@ -431,6 +433,14 @@ __memp_pgread(dbmfp, hp, bhp, can_create, is_recovery_page)
 	MUTEX_LOCK(dbenv, &bhp->mutex);
 	MUTEX_UNLOCK(dbenv, mutexp);
 
+	/*
+	 * The compressed cache holds the image we evicted, which has already
+	 * been through pgin: there's nothing left to do if it's there.
+	 */
+	if (dbmp->ccache &&
+	    (ret = __memp_ccache_get(dbmfp, bhp)) == 0)
+		goto err;
+
 	/*
 	 * Temporary files may not yet have been created.  We don't create
 	 * them now, we create them when the pages have to be flushed.
@@ -733,6 +743,9 @@ __memp_pgwrite_int(dbenv, dbmfp, hp, bhp, wrrec)
 	return __memp_pgwrite_multi(dbenv, dbmfp, &hp, &bhp, 1, wrrec);
 }
 
+/* Pages written and time spent writing them, for the writeback pacer. */
+u_int64_t gbl_memp_flush_pages = 0;
+u_int64_t gbl_memp_flush_usecs = 0;
 
 /*
  * __memp_pgwrite_multi --
@@ -757,6 +770,7 @@ __memp_pgwrite_multi(dbenv, dbmfp, hps, bhps, numpages, wrrec)
 	DB_MPOOL *dbmp;
 	MPOOL *c_mp;
 	u_int32_t n_cache;
+	u_int64_t start_us, write_us;
 	int ret, i, idx;
 
 	mfp = dbmfp == NULL ? NULL : dbmfp->mfp;
@@ -1006,6 +1020,7 @@ __memp_pgwrite_multi(dbenv, dbmfp, hps, bhps, numpages, wrrec)
 	}
 
 	/* Write the page. */
+	start_us = bb_berkdb_fasttime();
 	if ((ret = __os_iov(dbenv, DB_IO_WRITE, dbmfp->fhp,
 		    bhps[0]->pgno, mfp->stat.st_pagesize,
 		    bparray, numpages, &nw)) != 0) {
@@ -1013,6 +1028,7 @@ __memp_pgwrite_multi(dbenv, dbmfp, hps, bhps, numpages, wrrec)
 		    __memp_fn(dbmfp), (u_long) bhp->pgno);
 		goto err;
 	}
+	write_us = bb_berkdb_fasttime() - start_us;
 
 
 	/* Fsync datafiles before reusing indexes. */
@@ -1022,6 +1038,12 @@ __memp_pgwrite_multi(dbenv, dbmfp, hps, bhps, numpages, wrrec)
 	mfp->file_written = 1;
 	mfp->stat.st_page_out += numpages;
 	mfp->stat.st_rw_merges += numpages - 1;
+	mfp->stat.st_flush_writes++;
+	mfp->stat.st_flush_usecs += write_us;
+	if (write_us > mfp->stat.st_flush_max_usecs)
+		mfp->stat.st_flush_max_usecs = write_us;
+	gbl_memp_flush_pages += numpages;
+	gbl_memp_flush_usecs += write_us;
 
 err:
 file_dead:
@@ -0,0 +1,407 @@
+/*-
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 1996-2003
+ *	Sleepycat Software.  All rights reserved.
+ */
+#include "db_config.h"
+
+#ifndef NO_SYSTEM_INCLUDES
+#include <sys/types.h>
+
+#include <alloca.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#endif
+
+#include "db_int.h"
+#include "dbinc/db_shash.h"
+#include "dbinc/mp.h"
+
+#include <lz4.h>
+#include "locks_wrap.h"
+#include "logmsg.h"
+
+#if LZ4_VERSION_NUMBER < 10701
+#define LZ4_compress_default LZ4_compress_limitedOutput
+#endif
+
+/*
+ * The compressed cache is a second tier beneath the buffer pool.  Clean
+ * pages evicted by __memp_alloc are compressed into process memory, and
+ * __memp_pgread looks there before going to disk.  A page is in at most
+ * one of the two tiers: finding it here removes it, and it comes back only
+ * when the buffer pool evicts it again, so what we hold always matches the
+ * file.  The images are post-pgin, so a hit is a decompress and nothing
+ * else.
+ *
+ * Size of the compressed cache in megabytes; 0 disables it.
+ */
+int gbl_mpool_ccache_mb = 0;
+
+#define	CCACHE_PARTS	64		/* Independently locked partitions. */
+#define	CCACHE_AVG_PAGE	2048		/* Guess at a compressed page size. */
+
+struct __cc_page {
+	struct __cc_page *next;		/* Hash chain. */
+	TAILQ_ENTRY(__cc_page) lru;	/* Most recently put first. */
+	MPOOLFILE *mfp;
+	db_pgno_t pgno;
+	u_int32_t len;			/* Stored length; pagesize if raw. */
+	u_int8_t data[1];
+};
+
+struct __cc_part {
+	pthread_mutex_t lk;
+	struct __cc_page **htab;
+	u_int32_t nbuckets;
+	TAILQ_HEAD(__cc_lru, __cc_page) lru;
+	size_t bytes;			/* Memory held, headers included. */
+	u_int64_t pages;
+	u_int64_t hits;
+	u_int64_t misses;
+	u_int64_t evicts;
+};
+
+static pthread_mutex_t ccache_lk = PTHREAD_MUTEX_INITIALIZER;
+static struct __cc_part *ccache;
+static size_t ccache_part_max;
+
+#define	CC_HASH(mfp, pgno)						\
+	((u_int32_t)(((uintptr_t)(mfp) >> 4) ^ ((pgno) * 2654435761U)))
+#define	CC_SIZE(cp)	(sizeof(struct __cc_page) + (cp)->len)
+
+/*
+ * __memp_ccache_init --
+ *	Set up the compressed cache for an environment's buffer pool, if
+ *	it's configured.
+ *
+ * PUBLIC: int __memp_ccache_init __P((DB_ENV *, DB_MPOOL *));
+ */
+int
+__memp_ccache_init(dbenv, dbmp)
+	DB_ENV *dbenv;
+	DB_MPOOL *dbmp;
+{
+	struct __cc_part *parts;
+	u_int32_t i, nbuckets;
+	int ret;
+
+	/* Temp tables have their own small caches; leave them alone. */
+	if (gbl_mpool_ccache_mb <= 0 || dbenv->is_tmp_tbl)
+		return (0);
+
+	ret = 0;
+	Pthread_mutex_lock(&ccache_lk);
+	if (ccache != NULL)
+		goto done;
+
+	ccache_part_max = ((size_t)gbl_mpool_ccache_mb << 20) / CCACHE_PARTS;
+	for (nbuckets = 1024;
+	    nbuckets < ccache_part_max / CCACHE_AVG_PAGE; nbuckets <<= 1)
+		;
+
+	if ((ret = __os_calloc(NULL,
+	    CCACHE_PARTS, sizeof(struct __cc_part), &parts)) != 0)
+		goto done;
+	for (i = 0; i < CCACHE_PARTS; ++i) {
+		if ((ret = __os_calloc(NULL, nbuckets,
+		    sizeof(struct __cc_page *), &parts[i].htab)) != 0) {
+			while (i-- > 0)
+				__os_free(NULL, parts[i].htab);
+			__os_free(NULL, parts);
+			goto done;
+		}
+		Pthread_mutex_init(&parts[i].lk, NULL);
+		parts[i].nbuckets = nbuckets;
+		TAILQ_INIT(&parts[i].lru);
+	}
+	ccache = parts;
+	logmsg(LOGMSG_INFO, "mpool compressed cache: %d MB, %u buckets\n",
+	    gbl_mpool_ccache_mb, CCACHE_PARTS * nbuckets);
+
+done:	Pthread_mutex_unlock(&ccache_lk);
+	if (ret == 0)
+		dbmp->ccache = 1;
+	return (ret);
+}
+
+/*
+ * __cc_unlink --
+ *	Remove a page from its partition; the partition must be locked.
+ */
+static void
+__cc_unlink(part, cpp, cp)
+	struct __cc_part *part;
+	struct __cc_page **cpp, *cp;
+{
+	*cpp = cp->next;
+	TAILQ_REMOVE(&part->lru, cp, lru);
+	part->bytes -= CC_SIZE(cp);
+	--part->pages;
+}
+
+/*
+ * __cc_lookup --
+ *	Return the address of the hash chain link pointing at a page, or
+ *	at the end of the chain if it isn't there.
+ */
+static inline struct __cc_page **
+__cc_lookup(part, h, mfp, pgno)
+	struct __cc_part *part;
+	u_int32_t h;
+	MPOOLFILE *mfp;
+	db_pgno_t pgno;
+{
+	struct __cc_page **cpp;
+
+	for (cpp = &part->htab[(h / CCACHE_PARTS) & (part->nbuckets - 1)];
+	    *cpp != NULL; cpp = &(*cpp)->next)
+		if ((*cpp)->pgno == pgno && (*cpp)->mfp == mfp)
+			break;
+	return (cpp);
+}
+
+/*
+ * __memp_ccache_put --
+ *	Keep a copy of a buffer the pool is evicting.  The caller holds the
+ *	buffer's hash bucket lock and knows the buffer matches the file.
+ *	The bucket lock is dropped while the page is compressed, and held
+ *	again on return; if someone came for the buffer in the meantime,
+ *	nothing is kept and 1 is returned: the buffer can't be evicted.
+ *
+ * PUBLIC: int __memp_ccache_put
+ * PUBLIC:     __P((DB_MPOOL *, DB_MPOOL_HASH *, MPOOLFILE *, BH *));
+ */
+int
+__memp_ccache_put(dbmp, hp, mfp, bhp)
+	DB_MPOOL *dbmp;
+	DB_MPOOL_HASH *hp;
+	MPOOLFILE *mfp;
+	BH *bhp;
+{
+	struct __cc_page *cp, *old, **cpp;
+	struct __cc_part *part;
+	DB_ENV *dbenv;
+	size_t pagesize;
+	u_int32_t h;
+	char *zbuf;
+	int zlen;
+
+	if (mfp->deadfile || mfp->no_backing_file || F_ISSET(mfp, MP_TEMP))
+		return (0);
+
+	/*
+	 * Trade the bucket lock for the buffer lock, as for I/O: anyone who
+	 * wants the page waits, and it can't change while we compress it.
+	 */
+	dbenv = dbmp->dbenv;
+	++bhp->ref;
+	F_SET(bhp, BH_LOCKED);
+	MUTEX_LOCK(dbenv, &bhp->mutex);
+	MUTEX_UNLOCK(dbenv, &hp->hash_mutex);
+
+	pagesize = mfp->stat.st_pagesize;
+	zbuf = alloca(LZ4_COMPRESSBOUND(pagesize));
+	zlen = LZ4_compress_default((char *)bhp->buf,
+	    zbuf, pagesize, LZ4_COMPRESSBOUND(pagesize));
+
+	/* Keep incompressible pages as they are: it still saves a read. */
+	if (zlen <= 0 || (size_t)zlen >= pagesize)
+		zlen = 0;
+
+	cp = NULL;
+	if (__os_malloc(NULL, sizeof(struct __cc_page) +
+	    (zlen ? zlen : pagesize), &cp) == 0) {
+		cp->mfp = mfp;
+		cp->pgno = bhp->pgno;
+		cp->len = zlen ? zlen : pagesize;
+		memcpy(cp->data, zlen ? zbuf : (char *)bhp->buf, cp->len);
+	}
+
+	MUTEX_UNLOCK(dbenv, &bhp->mutex);
+	MUTEX_LOCK(dbenv, &hp->hash_mutex);
+	F_CLR(bhp, BH_LOCKED);
+	if (--bhp->ref != 0) {
+		if (cp != NULL)
+			__os_free(NULL, cp);
+		return (1);
+	}
+	if (cp == NULL)
+		return (0);
+
+	++mfp->stat.st_ccache_put;
+	mfp->stat.st_ccache_bytes_in += pagesize;
+	mfp->stat.st_ccache_bytes_out += cp->len;
+
+	h = CC_HASH(mfp, cp->pgno);
+	part = &ccache[h % CCACHE_PARTS];
+	Pthread_mutex_lock(&part->lk);
+	cpp = __cc_lookup(part, h, mfp, cp->pgno);
+	if ((old = *cpp) != NULL) {
+		__cc_unlink(part, cpp, old);
+		__os_free(NULL, old);
+	}
+	cp->next = *cpp;
+	*cpp = cp;
+	TAILQ_INSERT_HEAD(&part->lru, cp, lru);
+	part->bytes += CC_SIZE(cp);
+	++part->pages;
+
+	/* Make room by dropping the least recently evicted pages. */
+	while (part->bytes > ccache_part_max &&
+	    (old = TAILQ_LAST(&part->lru, __cc_lru)) != cp) {
+		h = CC_HASH(old->mfp, old->pgno);
+		__cc_unlink(part, __cc_lookup(part, h, old->mfp, old->pgno),
+		    old);
+		__os_free(NULL, old);
+		++part->evicts;
+	}
+	Pthread_mutex_unlock(&part->lk);
+	return (0);
+}
+
+/*
+ * __memp_ccache_get --
+ *	Fill a buffer from the compressed cache, removing the page from it.
+ *	Returns DB_NOTFOUND if the page isn't there.
+ *
+ * PUBLIC: int __memp_ccache_get __P((DB_MPOOLFILE *, BH *));
+ */
+int
+__memp_ccache_get(dbmfp, bhp)
+	DB_MPOOLFILE *dbmfp;
+	BH *bhp;
+{
+	struct __cc_page *cp, **cpp;
+	struct __cc_part *part;
+	MPOOLFILE *mfp;
+	size_t pagesize;
+	u_int32_t h;
+	int ret;
+
+	mfp = dbmfp->mfp;
+	pagesize = mfp->stat.st_pagesize;
+
+	h = CC_HASH(mfp, bhp->pgno);
+	part = &ccache[h % CCACHE_PARTS];
+	Pthread_mutex_lock(&part->lk);
+	cpp = __cc_lookup(part, h, mfp, bhp->pgno);
+	if ((cp = *cpp) == NULL) {
+		++part->misses;
+		Pthread_mutex_unlock(&part->lk);
+		++mfp->stat.st_ccache_miss;
+		return (DB_NOTFOUND);
+	}
+	__cc_unlink(part, cpp, cp);
+	++part->hits;
+	Pthread_mutex_unlock(&part->lk);
+
+	ret = 0;
+	if (cp->len == pagesize)
+		memcpy(bhp->buf, cp->data, pagesize);
+	else if (LZ4_decompress_safe((char *)cp->data,
+	    (char *)bhp->buf, cp->len, pagesize) != (int)pagesize) {
+		__db_err(dbmfp->dbenv,
+		    "%s: page %lu: compressed cache image is corrupt",
+		    __memp_fn(dbmfp), (u_long)bhp->pgno);
+		ret = DB_NOTFOUND;
+	}
+	__os_free(NULL, cp);
+
+	if (ret == 0)
+		++mfp->stat.st_ccache_hit;
+	else
+		++mfp->stat.st_ccache_miss;
+	return (ret);
+}
+
+/*
+ * __memp_ccache_invalidate --
+ *	Drop a page that's being created in the buffer pool without being
+ *	read: whatever we hold for it is from an earlier life of the page.
+ *
+ * PUBLIC: void __memp_ccache_invalidate __P((MPOOLFILE *, db_pgno_t));
+ */
+void
+__memp_ccache_invalidate(mfp, pgno)
+	MPOOLFILE *mfp;
+	db_pgno_t pgno;
+{
+	struct __cc_page *cp, **cpp;
+	struct __cc_part *part;
+	u_int32_t h;
+
+	h = CC_HASH(mfp, pgno);
+	part = &ccache[h % CCACHE_PARTS];
+	Pthread_mutex_lock(&part->lk);
+	cpp = __cc_lookup(part, h, mfp, pgno);
+	if ((cp = *cpp) != NULL)
+		__cc_unlink(part, cpp, cp);
+	Pthread_mutex_unlock(&part->lk);
+	if (cp != NULL)
+		__os_free(NULL, cp);
+}
+
+/*
+ * __memp_ccache_discard --
+ *	Drop every page of a file that's leaving the buffer pool, or whose
+ *	contents are going away with a remove or truncate.
+ *
+ * PUBLIC: void __memp_ccache_discard __P((MPOOLFILE *));
+ */
+void
+__memp_ccache_discard(mfp)
+	MPOOLFILE *mfp;
+{
+	struct __cc_page *cp, *next;
+	struct __cc_part *part;
+	u_int32_t h, i;
+
+	for (i = 0; i < CCACHE_PARTS; ++i) {
+		part = &ccache[i];
+		Pthread_mutex_lock(&part->lk);
+		for (cp = TAILQ_FIRST(&part->lru); cp != NULL; cp = next) {
+			next = TAILQ_NEXT(cp, lru);
+			if (cp->mfp != mfp)
+				continue;
+			h = CC_HASH(cp->mfp, cp->pgno);
+			__cc_unlink(part,
+			    __cc_lookup(part, h, cp->mfp, cp->pgno), cp);
+			__os_free(NULL, cp);
+		}
+		Pthread_mutex_unlock(&part->lk);
+	}
+}
+
+/*
+ * __memp_ccache_stat --
+ *	Add the compressed cache totals to the buffer pool statistics.
+ *
+ * PUBLIC: void __memp_ccache_stat __P((DB_MPOOL_STAT *, u_int32_t));
+ */
+void
+__memp_ccache_stat(sp, flags)
+	DB_MPOOL_STAT *sp;
+	u_int32_t flags;
+{
+	struct __cc_part *part;
+	u_int32_t i;
+
+	if (ccache == NULL)
+		return;
+
+	for (i = 0; i < CCACHE_PARTS; ++i) {
+		part = &ccache[i];
+		Pthread_mutex_lock(&part->lk);
+		sp->st_ccache_pages += part->pages;
+		sp->st_ccache_bytes += part->bytes;
+		sp->st_ccache_hit += part->hits;
+		sp->st_ccache_miss += part->misses;
+		sp->st_ccache_evict += part->evicts;
+		if (LF_ISSET(DB_STAT_CLEAR))
+			part->hits = part->misses = part->evicts = 0;
+		Pthread_mutex_unlock(&part->lk);
+	}
+}
@@ -50,6 +50,8 @@ struct bdb_state_tag;
 typedef struct bdb_state_tag bdb_state_type;
 
 extern int gbl_prefault_udp;
+extern int gbl_mpool_scan_resistant;
+extern int gbl_mpool_promote_window;
 extern __thread int send_prefault_udp;
 extern __thread DB *prefault_dbp;
 
@@ -397,6 +399,26 @@ retry:	st_hsearch = 0;
 			++mfp->stat.st_cache_lhit;
 
 		++mfp->stat.st_cache_hit;
+		++c_mp->reg_hit;
+
+		/*
+		 * Scan resistance: a page is admitted on probation and only
+		 * promoted once it is referenced again outside of the window
+		 * of correlated references that follows its admission.
+		 */
+		if (F_ISSET(bhp, BH_HOT))
+			++c_mp->stat.st_hot_hit;
+		else {
+			++c_mp->stat.st_cold_hit;
+			if (gbl_mpool_scan_resistant &&
+			    !LF_ISSET(DB_MPOOL_PFGET | DB_MPOOL_NOCACHE) &&
+			    c_mp->lru_count > bhp->admit_lru &&
+			    c_mp->lru_count - bhp->admit_lru >
+			    (u_int32_t)gbl_mpool_promote_window) {
+				F_SET(bhp, BH_HOT);
+				++c_mp->stat.st_promote;
+			}
+		}
 
         if (LF_ISSET(DB_MPOOL_PFGET))
             ++c_mp->stat.st_page_pf_in_late;
@@ -655,6 +677,7 @@ alloc:		/*
 		memset(bhp, 0, sizeof(BH));
 		bhp->ref = 1;
 		bhp->priority = UINT32_T_MAX;
+		bhp->admit_lru = c_mp->lru_count;
 		bhp->pgno = *pgnoaddr;
 		bhp->mpf = mfp;
 		SH_TAILQ_INSERT_TAIL(&hp->hash_bucket, bhp, hq);
@@ -702,6 +725,10 @@ alloc:		/*
 		 * if DB_MPOOL_CREATE is set.
 		 */
 		if (extending) {
+			/* Anything the compressed cache has is out of date. */
+			if (dbmp->ccache)
+				__memp_ccache_invalidate(mfp, *pgnoaddr);
+
 			if (mfp->clear_len == 0)
 				memset(bhp->buf, 0, mfp->stat.st_pagesize);
 			else {
@@ -720,6 +747,7 @@ alloc:		/*
 
 			F_SET(bhp, BH_TRASH);
 			++mfp->stat.st_cache_miss;
+			++c_mp->reg_miss;
 			if (LF_ISSET(DB_MPOOL_PFGET)) {
 				++c_mp->stat.st_page_pf_in;
                 
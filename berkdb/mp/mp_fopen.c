@@ -825,6 +825,8 @@ __memp_fopen(dbmfp, mfp, path, flags, mode, pagesize)
 				MUTEX_LOCK(dbenv, &loop_mfp->mutex);
 				loop_mfp->deadfile = 1;
 				MUTEX_UNLOCK(dbenv, &loop_mfp->mutex);
+				if (dbmp->ccache)
+					__memp_ccache_discard(loop_mfp);
 				continue;
 			}
 
@@ -1421,6 +1423,10 @@ __memp_mf_discard(dbmp, mfp)
 	/* Discard the mutex we're holding. */
 	MUTEX_UNLOCK(dbenv, &mfp->mutex);
 
+	/* Its compressed pages can't be found again: free them. */
+	if (dbmp->ccache)
+		__memp_ccache_discard(mfp);
+
 	/* Delete from the list of MPOOLFILEs. */
 	R_LOCK(dbenv, dbmp->reginfo);
 	SH_TAILQ_REMOVE(&mp->mpfq, mfp, q, __mpoolfile);
@@ -25,6 +25,8 @@ static const char revid[] = "$Id: mp_fput.c,v 11.48 2003/09/30 17:12:00 sue Exp
 #include "comdb2_atomic.h"
 
 extern int gbl_enable_cache_internal_nodes;
+extern int gbl_mpool_scan_resistant;
+extern int gbl_mpool_cold_priority_pct;
 
 static void __memp_reset_lru __P((DB_ENV *, REGINFO *));
 
@@ -248,6 +250,16 @@ __memp_fput_internal(dbmfp, pgaddr, flags, pgorder)
 		    TYPE(pgaddr) == P_IBTREE)
 			adjust += c_mp->stat.st_pages / MPOOL_PRI_INTERNAL;
 
+		/*
+		 * Pages which have not been re-referenced since they were
+		 * admitted go back in behind the protected pages, so a single
+		 * large scan cycles through the probationary segment instead
+		 * of pushing out the working set.
+		 */
+		if (gbl_mpool_scan_resistant && !F_ISSET(bhp, BH_HOT))
+			adjust -= (int)(((u_int64_t)c_mp->stat.st_pages *
+			    gbl_mpool_cold_priority_pct) / 100);
+
 		if (adjust > 0) {
 			if (UINT32_T_MAX - bhp->priority >= (u_int32_t)adjust)
 				bhp->priority += adjust;
@@ -315,7 +327,7 @@ done:
 	 */
 	if (incr_count) {
 		if (++c_mp->lru_count >= (UINT32_T_MAX - 1024))
-			__memp_reset_lru(dbenv, dbmp->reginfo);
+			__memp_reset_lru(dbenv, &dbmp->reginfo[n_cache]);
 	}
 
 	return (0);
@@ -377,10 +389,77 @@ __memp_reset_lru(dbenv, memreg)
 
 		MUTEX_LOCK(dbenv, &hp->hash_mutex);
 		for (bhp = SH_TAILQ_FIRST(&hp->hash_bucket, __bh);
-		    bhp != NULL; bhp = SH_TAILQ_NEXT(bhp, hq, __bh))
+		    bhp != NULL; bhp = SH_TAILQ_NEXT(bhp, hq, __bh)) {
 			if (bhp->priority != UINT32_T_MAX &&
 			    bhp->priority > MPOOL_BASE_DECREMENT)
 				bhp->priority -= MPOOL_BASE_DECREMENT;
+			/*
+			 * The admission stamp moves with the counter, or a
+			 * probationary page would look older than any window.
+			 * A page admitted before the new base is older than
+			 * that anyway.
+			 */
+			if (bhp->admit_lru > MPOOL_BASE_DECREMENT)
+				bhp->admit_lru -= MPOOL_BASE_DECREMENT;
+			else
+				bhp->admit_lru = 0;
+		}
 		MUTEX_UNLOCK(dbenv, &hp->hash_mutex);
 	}
 }
+
+/*
+ * __memp_lru_fastforward --
+ *	Move the LRU counter of every cache region up to just short of the
+ *	point where it is rebased, keeping the relative age of every buffer.
+ *	Lets tests get at __memp_reset_lru without billions of puts.
+ *
+ * PUBLIC: void __memp_lru_fastforward __P((DB_ENV *));
+ */
+void
+__memp_lru_fastforward(dbenv)
+	DB_ENV *dbenv;
+{
+	BH *bhp;
+	DB_MPOOL *dbmp;
+	DB_MPOOL_HASH *hp;
+	MPOOL *mp, *c_mp;
+	REGINFO *memreg;
+	u_int32_t bucket, i, incr;
+
+	dbmp = dbenv->mp_handle;
+	mp = dbmp->reginfo[0].primary;
+
+	for (i = 0; i < mp->nreg; ++i) {
+		memreg = &dbmp->reginfo[i];
+		c_mp = memreg->primary;
+
+		R_LOCK(dbenv, memreg);
+		if (c_mp->lru_count >= UINT32_T_MAX - 2048) {
+			R_UNLOCK(dbenv, memreg);
+			continue;
+		}
+		incr = (UINT32_T_MAX - 2048) - c_mp->lru_count;
+		c_mp->lru_count += incr;
+
+		for (hp = R_ADDR(memreg, c_mp->htab),
+		    bucket = 0; bucket < c_mp->htab_buckets; ++hp, ++bucket) {
+			if (SH_TAILQ_FIRST(&hp->hash_bucket, __bh) == NULL)
+				continue;
+
+			MUTEX_LOCK(dbenv, &hp->hash_mutex);
+			for (bhp = SH_TAILQ_FIRST(&hp->hash_bucket, __bh);
+			    bhp != NULL; bhp = SH_TAILQ_NEXT(bhp, hq, __bh)) {
+				if (bhp->priority < UINT32_T_MAX - 1 - incr)
+					bhp->priority += incr;
+				else if (bhp->priority != UINT32_T_MAX)
+					bhp->priority = UINT32_T_MAX - 1;
+				bhp->admit_lru += incr;
+			}
+			hp->hash_priority =
+			    SH_TAILQ_FIRST(&hp->hash_bucket, __bh)->priority;
+			MUTEX_UNLOCK(dbenv, &hp->hash_mutex);
+		}
+		R_UNLOCK(dbenv, memreg);
+	}
+}
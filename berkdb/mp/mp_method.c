@@ -396,6 +396,8 @@ __memp_nameop(dbenv, fileid, newname, fullold, fullnew)
 				MUTEX_LOCK(dbenv, &mfp->mutex);
 				mfp->deadfile = 1;
 				MUTEX_UNLOCK(dbenv, &mfp->mutex);
+				if (dbmp->ccache)
+					__memp_ccache_discard(mfp);
 			} else {
 				/*
 				 * Else, it's a rename.  We've allocated memory
@@ -0,0 +1,310 @@
+/*-
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 1996-2003
+ *	Sleepycat Software.  All rights reserved.
+ */
+#include "db_config.h"
+
+#ifndef NO_SYSTEM_INCLUDES
+#include <sys/types.h>
+
+#include <stdlib.h>
+#include <string.h>
+#endif
+
+#include "db_int.h"
+#include "dbinc/db_shash.h"
+#include "dbinc/mp.h"
+
+#include "logmsg.h"
+
+extern u_int64_t gbl_memp_pgreads;
+extern int gbl_iouring_queue_depth;
+
+/*
+ * Bigger requests are broken up into batches of as many pages as a thread
+ * keeps reads in flight.  Every buffer in a batch stays locked until the
+ * whole batch has been read, so a reader of the first page may wait on the
+ * last one's read: a batch is no longer than one fill of the ring.
+ */
+static inline int
+__memp_prefetch_max()
+{
+	return (gbl_iouring_queue_depth < 1 ? 1 :
+	    gbl_iouring_queue_depth > 4096 ? 4096 : gbl_iouring_queue_depth);
+}
+
+struct __pf_slot {
+	BH *bhp;
+	DB_MPOOL_HASH *hp;
+	u_int32_t n_cache;
+};
+
+/*
+ * __memp_prefetch_hp --
+ *	Return the hash bucket for a page.
+ */
+static inline DB_MPOOL_HASH *
+__memp_prefetch_hp(dbmp, mfp, pgno, n_cachep)
+	DB_MPOOL *dbmp;
+	MPOOLFILE *mfp;
+	db_pgno_t pgno;
+	u_int32_t *n_cachep;
+{
+	DB_MPOOL_HASH *hp;
+	MPOOL *c_mp;
+
+	*n_cachep = NCACHE(dbmp->reginfo[0].primary, mfp, pgno);
+	c_mp = dbmp->reginfo[*n_cachep].primary;
+	hp = R_ADDR(&dbmp->reginfo[*n_cachep], c_mp->htab);
+	return (&hp[NBUCKET(c_mp, mfp, pgno)]);
+}
+
+/*
+ * __memp_prefetch_cached --
+ *	Return if a page is in the cache; the hash bucket must be locked.
+ */
+static inline int
+__memp_prefetch_cached(dbenv, hp, mfp, pgno)
+	DB_ENV *dbenv;
+	DB_MPOOL_HASH *hp;
+	MPOOLFILE *mfp;
+	db_pgno_t pgno;
+{
+	BH *bhp;
+
+	for (bhp = SH_TAILQ_FIRST(&hp->hash_bucket, __bh);
+	    bhp != NULL; bhp = SH_TAILQ_NEXT(bhp, hq, __bh))
+		if (bhp->pgno == pgno && bhp->mpf == mfp)
+			return (1);
+	return (0);
+}
+
+/*
+ * __memp_prefetch_one --
+ *	Read up to __memp_prefetch_max() pages in a single batch.
+ */
+static int
+__memp_prefetch_one(dbmfp, pgnos, n, nreadp)
+	DB_MPOOLFILE *dbmfp;
+	db_pgno_t *pgnos;
+	int n, *nreadp;
+{
+	struct __pf_slot *slots;
+	BH *bhp;
+	DB_ENV *dbenv;
+	DB_MPOOL *dbmp;
+	DB_MPOOL_HASH *hp;
+	MPOOL *c_mp;
+	MPOOLFILE *mfp;
+	db_pgno_t *rpgnos;
+	size_t *niop, pagesize;
+	u_int32_t n_cache;
+	u_int8_t **bufs;
+	int cached, i, nalloc, nio, ret;
+
+	dbenv = dbmfp->dbenv;
+	dbmp = dbenv->mp_handle;
+	mfp = dbmfp->mfp;
+	pagesize = mfp->stat.st_pagesize;
+	ret = 0;
+
+	if ((ret = __os_malloc(dbenv, n * (sizeof(struct __pf_slot) +
+	    sizeof(db_pgno_t) + sizeof(u_int8_t *) + sizeof(size_t)),
+	    &slots)) != 0)
+		return (ret);
+	niop = (size_t *)&slots[n];
+	bufs = (u_int8_t **)&niop[n];
+	rpgnos = (db_pgno_t *)&bufs[n];
+
+	/*
+	 * Allocate every buffer before inserting any of them.  Allocation
+	 * may have to wait on or write out other buffers, and we mustn't be
+	 * holding the buffer mutexes of pages we've promised to read.
+	 */
+	for (nalloc = 0, i = 0; i < n; ++i) {
+		hp = __memp_prefetch_hp(dbmp, mfp, pgnos[i], &n_cache);
+		MUTEX_LOCK(dbenv, &hp->hash_mutex);
+		cached = __memp_prefetch_cached(dbenv, hp, mfp, pgnos[i]);
+		MUTEX_UNLOCK(dbenv, &hp->hash_mutex);
+		if (cached)
+			continue;
+
+		R_LOCK(dbenv, dbmp->reginfo);
+		if (pgnos[i] > mfp->last_pgno) {
+			R_UNLOCK(dbenv, dbmp->reginfo);
+			break;
+		}
+		R_UNLOCK(dbenv, dbmp->reginfo);
+
+		if ((ret = __memp_alloc(dbmp,
+		    &dbmp->reginfo[n_cache], mfp, 0, NULL, &bhp)) != 0)
+			break;
+		slots[nalloc].bhp = bhp;
+		slots[nalloc].hp = hp;
+		slots[nalloc].n_cache = n_cache;
+		rpgnos[nalloc] = pgnos[i];
+		++nalloc;
+	}
+	/* Running out of buffer space just makes the batch shorter. */
+	if (ret == ENOMEM)
+		ret = 0;
+
+	/*
+	 * Instantiate the pages exactly as __memp_fget does for a
+	 * DB_MPOOL_PFGET miss, except that the buffer is left locked for
+	 * the read: anyone else who wants the page waits on its mutex.
+	 */
+	for (nio = 0, i = 0; i < nalloc; ++i) {
+		hp = slots[i].hp;
+		n_cache = slots[i].n_cache;
+		c_mp = dbmp->reginfo[n_cache].primary;
+		bhp = slots[i].bhp;
+
+		MUTEX_LOCK(dbenv, &hp->hash_mutex);
+		if (ret != 0 ||
+		    __memp_prefetch_cached(dbenv, hp, mfp, rpgnos[i])) {
+			MUTEX_UNLOCK(dbenv, &hp->hash_mutex);
+			R_LOCK(dbenv, &dbmp->reginfo[n_cache]);
+			__db_shalloc_free(dbmp->reginfo[n_cache].addr, bhp);
+			c_mp->stat.st_pages--;
+			R_UNLOCK(dbenv, &dbmp->reginfo[n_cache]);
+			continue;
+		}
+
+		memset(bhp, 0, sizeof(BH));
+		bhp->ref = 1;
+		bhp->priority = UINT32_T_MAX;
+		bhp->admit_lru = c_mp->lru_count;
+		bhp->pgno = rpgnos[i];
+		bhp->mpf = mfp;
+		SH_TAILQ_INSERT_TAIL(&hp->hash_bucket, bhp, hq);
+		hp->hash_priority =
+		    SH_TAILQ_FIRST(&hp->hash_bucket, __bh)->priority;
+
+		++mfp->stat.st_cache_miss;
+		++c_mp->reg_miss;
+		++c_mp->stat.st_page_pf_in;
+
+		MUTEX_LOCK(dbenv, &mfp->mutex);
+		++mfp->block_cnt;
+		MUTEX_UNLOCK(dbenv, &mfp->mutex);
+
+		if ((ret = __db_mutex_setup(dbenv,
+		    &dbmp->reginfo[n_cache], &bhp->mutex, 0)) != 0) {
+			__memp_bhfree(dbmp, hp, bhp, 1);
+			continue;
+		}
+
+		/* Pages in the compressed cache don't need reading. */
+		if (dbmp->ccache && __memp_ccache_get(dbmfp, bhp) == 0) {
+			F_SET(bhp, BH_PREFAULT);
+			MUTEX_UNLOCK(dbenv, &hp->hash_mutex);
+#ifdef DIAGNOSTIC
+			R_LOCK(dbenv, dbmp->reginfo);
+			++dbmfp->pinref;
+			R_UNLOCK(dbenv, dbmp->reginfo);
+#endif
+			(void)__memp_fput(dbmfp, bhp->buf, DB_MPOOL_PFPUT);
+			continue;
+		}
+
+		F_SET(bhp, BH_LOCKED | BH_TRASH | BH_PREFAULT);
+		MUTEX_LOCK(dbenv, &bhp->mutex);
+		MUTEX_UNLOCK(dbenv, &hp->hash_mutex);
+
+		slots[nio] = slots[i];
+		rpgnos[nio] = rpgnos[i];
+		bufs[nio] = bhp->buf;
+		++nio;
+	}
+
+	if (nio != 0)
+		(void)__os_io_batch(dbenv,
+		    dbmfp->fhp, rpgnos, bufs, nio, pagesize, niop);
+
+	/*
+	 * Complete each read as __memp_pgread would, but never create or
+	 * repair a page: anything short or failing pgin is discarded, and
+	 * the next real __memp_fget of the page takes the normal path.
+	 */
+	for (i = 0; i < nio; ++i) {
+		bhp = slots[i].bhp;
+		hp = slots[i].hp;
+
+		if (niop[i] < pagesize ||
+		    (mfp->ftype != 0 && __memp_pg(dbmfp, bhp, 1) != 0))
+			niop[i] = 0;
+		else {
+			++mfp->stat.st_page_in;
+			gbl_memp_pgreads++;
+			++*nreadp;
+		}
+
+		MUTEX_UNLOCK(dbenv, &bhp->mutex);
+		MUTEX_LOCK(dbenv, &hp->hash_mutex);
+		F_CLR(bhp, BH_LOCKED);
+
+		if (niop[i] == 0) {
+			if (bhp->ref == 1)
+				__memp_bhfree(dbmp, hp, bhp, 1);
+			else {
+				--bhp->ref;
+				MUTEX_UNLOCK(dbenv, &hp->hash_mutex);
+			}
+			continue;
+		}
+
+		F_CLR(bhp, BH_TRASH);
+		MUTEX_UNLOCK(dbenv, &hp->hash_mutex);
+#ifdef DIAGNOSTIC
+		R_LOCK(dbenv, dbmp->reginfo);
+		++dbmfp->pinref;
+		R_UNLOCK(dbenv, dbmp->reginfo);
+#endif
+		(void)__memp_fput(dbmfp, bhp->buf, DB_MPOOL_PFPUT);
+	}
+
+	__os_free(dbenv, slots);
+	return (ret);
+}
+
+/*
+ * __memp_prefetch --
+ *	Bring a list of pages into the cache without pinning them, reading
+ *	whatever isn't already cached as a single batch so the reads can be
+ *	in flight together.  Pages past the end of the file end the list.
+ *	The number of pages read is returned through nreadp if non-NULL.
+ *
+ * PUBLIC: int __memp_prefetch __P((DB_MPOOLFILE *, db_pgno_t *, int, int *));
+ */
+int
+__memp_prefetch(dbmfp, pgnos, n, nreadp)
+	DB_MPOOLFILE *dbmfp;
+	db_pgno_t *pgnos;
+	int n, *nreadp;
+{
+	int cnt, max, nread, ret;
+
+	nread = 0;
+	ret = 0;
+
+	/*
+	 * Temporary files may not exist yet, and mmap'd files don't go
+	 * through the buffer pool at all.
+	 */
+	if (dbmfp->fhp == NULL || dbmfp->addr != NULL ||
+	    F_ISSET(dbmfp->mfp, MP_TEMP))
+		goto done;
+
+	max = __memp_prefetch_max();
+	for (; n > 0 && ret == 0; pgnos += cnt, n -= cnt) {
+		cnt = n > max ? max : n;
+		ret = __memp_prefetch_one(dbmfp, pgnos, cnt, &nread);
+	}
+
+done:	if (nreadp != NULL)
+		*nreadp = nread;
+	return (ret);
+}
@@ -186,6 +186,9 @@ __memp_open(dbenv)
 	    MUTEX_ALLOC | MUTEX_THREAD)) != 0)
 		goto err;
 
+	if ((ret = __memp_ccache_init(dbenv, dbmp)) != 0)
+		goto err;
+
 	dbenv->mp_handle = dbmp;
 	return (0);
 
@@ -235,6 +238,7 @@ __mpool_init(dbenv, dbmp, reginfo_off, htab_buckets)
 	reginfo->rp->primary = R_OFFSET(reginfo, reginfo->primary);
 	mp = reginfo->primary;
 	memset(mp, 0, sizeof(*mp));
+	mp->numa_node = reginfo->numa_node;
 
 #ifdef	HAVE_MUTEX_SYSTEM_RESOURCES
 	maint_size = __mpool_region_maint(reginfo);
@@ -170,6 +170,11 @@ __memp_stat(dbenv, gspp, fspp, flags)
 				    c_mp->stat.st_alloc_max_pages;
 			sp->st_ckp_pages_sync += c_mp->stat.st_ckp_pages_sync;
 			sp->st_ckp_pages_skip += c_mp->stat.st_ckp_pages_skip;
+			sp->st_cold_hit += c_mp->stat.st_cold_hit;
+			sp->st_hot_hit += c_mp->stat.st_hot_hit;
+			sp->st_promote += c_mp->stat.st_promote;
+			sp->st_cold_evict += c_mp->stat.st_cold_evict;
+			sp->st_hot_evict += c_mp->stat.st_hot_evict;
 
 			if (LF_ISSET(DB_STAT_CLEAR)) {
 				dbmp->reginfo[i].rp->mutex.mutex_set_wait = 0;
@@ -214,6 +219,9 @@ __memp_stat(dbenv, gspp, fspp, flags)
 			}
 		}
 		R_UNLOCK(dbenv, dbmp->reginfo);
+
+		if (dbmp->ccache)
+			__memp_ccache_stat(sp, flags);
 	}
 
 	if (LF_ISSET(DB_STAT_MINIMAL))
@@ -315,7 +323,7 @@ __memp_dump_region(dbenv, area, fp)
 	};
 	DB_MPOOL *dbmp;
 	DB_MPOOLFILE *dbmfp;
-	MPOOL *mp;
+	MPOOL *c_mp, *mp;
 	MPOOLFILE *mfp;
 	MPOOLFILE *fmap[FMAP_ENTRIES + 1];
 	u_int32_t i, flags, mfp_flags;
@@ -401,7 +409,11 @@ __memp_dump_region(dbenv, area, fp)
 
 	/* Dump the memory pools. */
 	for (i = 0; i < mp->nreg; ++i) {
-		(void)logmsgf(LOGMSG_USER, fp, "%s\nCache #%d:\n", DB_LINE, i + 1);
+		c_mp = dbmp->reginfo[i].primary;
+		(void)logmsgf(LOGMSG_USER, fp,
+		    "%s\nCache #%d: node %d; hit %llu; miss %llu\n", DB_LINE,
+		    i + 1, c_mp->numa_node, (unsigned long long)c_mp->reg_hit,
+		    (unsigned long long)c_mp->reg_miss);
 		__memp_dumpcache(
 		    dbenv, dbmp, &dbmp->reginfo[i], fmap, fp, flags);
 	}
@@ -561,6 +561,15 @@ int gbl_ref_sync_wait_txnlist = 0;
 void collect_txnids(DB_ENV *dbenv, u_int32_t *txnarray, int max, int *count);
 int still_running(DB_ENV *dbenv, u_int32_t *txnarray, int count);
 
+/* Gather runs of adjacent dirty pages into one write even without sgio. */
+int gbl_mpool_coalesce_writes = 1;
+
+/*
+ * Split a file's dirty pages into ranges of about this many pages so a
+ * large file is flushed by several threads; 0 gives each file one thread.
+ */
+int gbl_mpool_flush_range_pages = 8192;
+
 static void
 trickle_do_work(struct thdpool *thdpool, void *work, void *thddata, int thd_op)
 {
@@ -580,6 +589,7 @@ trickle_do_work(struct thdpool *thdpool, void *work, void *thddata, int thd_op)
 	int ar_cnt, hb_lock, i, j, pass, remaining, ret;
 	int wait_cnt, write_cnt, wrote;
 	int sgio, gathered, delay_write, total_txns = 0;
+	int max_gather;
 	db_pgno_t off_gather;
 
 	ret = 0;
@@ -597,6 +607,12 @@ trickle_do_work(struct thdpool *thdpool, void *work, void *thddata, int thd_op)
 	wrote = gathered = delay_write = 0;
 	off_gather = 0;
 
+	/* Don't hold more buffers locked than we can write at once. */
+	max_gather = ar_cnt > 0 ?
+	    dbenv->attr.sgio_max / bharray[0].track_mfp->stat.st_pagesize : 1;
+	if (max_gather < 1)
+		max_gather = 1;
+
 	/*
 	 * Walk the array, writing buffers.  When we write a buffer, we NULL
 	 * out its hash bucket pointer so we don't process a slot more than
@@ -779,6 +795,7 @@ trickle_do_work(struct thdpool *thdpool, void *work, void *thddata, int thd_op)
 			 * one I/O.
 			 */
 			if (sgio && i < ar_cnt - 1 &&
+			    gathered + 1 < max_gather &&
 			    bharray[i + 1].track_mfp == bhp->mpf &&
 			    bharray[i + 1].track_pgno == bhp->pgno + 1) {
 				bhparray[i] = bhp;
@@ -1055,6 +1072,7 @@ int gbl_load_cache_threads = 8;
 int gbl_load_cache_max_pages = 0;
 int gbl_dump_cache_max_pages = 0;
 int gbl_max_pages_per_cache_thread = 8192;
+int gbl_load_cache_batch = 256;
 
 void init_trickle_threads(void)
 {
@@ -1402,7 +1420,7 @@ __memp_sync_int(dbenv, dbmfp, trickle_max, op, wrotep, restartable,
 	pt->dbmp = dbmp;
 	pt->op = op;
 	pt->restartable = restartable;
-	pt->sgio = dbenv->attr.sgio_enabled;
+	pt->sgio = dbenv->attr.sgio_enabled || gbl_mpool_coalesce_writes;
 			
 	pt->total_pages = pt->done_pages = pt->written_pages = 0;
 	pt->ret = pt->nwaits = 0;
@@ -1411,14 +1429,20 @@ __memp_sync_int(dbenv, dbmfp, trickle_max, op, wrotep, restartable,
 
 	/*
 	 * Flush each file by passing it to a thread. This serializes writes
-	 * to a file, which may help throughput and performance.
+	 * to a file, which may help throughput and performance.  Large files
+	 * are cut into several ranges, but never in the middle of a run of
+	 * adjacent pages, which can go out as a single write.
 	 */
 	if (do_parallel &&
 	    (op == DB_SYNC_TRICKLE || op == DB_SYNC_LRU ||
 		op == DB_SYNC_CACHE)) {
 
 		for (i = 1, j = 0; i < ar_cnt; ++i) {
-			if (bharray[j].track_mfp != bharray[i].track_mfp) {
+			if (bharray[j].track_mfp != bharray[i].track_mfp ||
+			    (gbl_mpool_flush_range_pages > 0 &&
+			    i - j >= gbl_mpool_flush_range_pages &&
+			    bharray[i].track_pgno !=
+			    bharray[i - 1].track_pgno + 1)) {
 				Pthread_mutex_lock(&pgpool_lk);
 				range = pool_getablk(pgpool);
 				Pthread_mutex_unlock(&pgpool_lk);
@@ -1930,8 +1954,31 @@ typedef struct fileid_page_env
 	int *active_threads;
 } fileid_page_env_t;
 
-void touch_page(DB_MPOOLFILE *mpf, db_pgno_t pgno);
+/* Progress of the latest cache load. */
+static pthread_mutex_t warmup_lk = PTHREAD_MUTEX_INITIALIZER;
+static DB_MPOOL_WARMUP_STAT warmup;
+
+/*
+ * __memp_warmup_stat --
+ *	Return the progress of the latest cache load.
+ *
+ * PUBLIC: void __memp_warmup_stat __P((DB_ENV *, DB_MPOOL_WARMUP_STAT *));
+ */
+void
+__memp_warmup_stat(dbenv, statp)
+	DB_ENV *dbenv;
+	DB_MPOOL_WARMUP_STAT *statp;
+{
+	Pthread_mutex_lock(&warmup_lk);
+	*statp = warmup;
+	Pthread_mutex_unlock(&warmup_lk);
+}
 
+/*
+ * Read one file's pages in page order, a batch at a time so the reads of
+ * a batch are in flight together.  Give up if someone wants the bdb lock:
+ * a warm cache isn't worth holding up an election.
+ */
 static void
 load_fileids(struct thdpool *thdpool, void *work, void *thddata, int thd_op)
 {
@@ -1941,6 +1988,8 @@ load_fileids(struct thdpool *thdpool, void *work, void *thddata, int thd_op)
 	DB_ENV *dbenv;
 	DB_MPOOL *dbmp;
 	DB_MPOOLFILE *dbmfp;
+	u_int64_t i, n, batch;
+	int nread, stopped;
 
 	dbenv = fileid_env->dbenv;
 	dbmp = dbenv->mp_handle;
@@ -1954,11 +2003,33 @@ load_fileids(struct thdpool *thdpool, void *work, void *thddata, int thd_op)
 	}
 	MUTEX_THREAD_UNLOCK(dbenv, dbmp->mutexp);
 
+	stopped = 0;
 	if (dbmfp) {
-		for(int pages = 0 ; pages < pagelist->cnt; pages++) {
-			touch_page(dbmfp, pagelist->pages[pages]);
+		qsort(pagelist->pages, pagelist->cnt, sizeof(db_pgno_t), pgcmp);
+		batch = gbl_load_cache_batch > 0 ? gbl_load_cache_batch : 1;
+		for (i = 0; i < pagelist->cnt; i += n) {
+			if (bdb_the_lock_desired()) {
+				stopped = 1;
+				break;
+			}
+			n = pagelist->cnt - i < batch ? pagelist->cnt - i : batch;
+			nread = 0;
+			(void)__memp_prefetch(dbmfp,
+			    &pagelist->pages[i], (int)n, &nread);
+
+			Pthread_mutex_lock(&warmup_lk);
+			warmup.st_pages_done += n;
+			warmup.st_pages_read += nread;
+			Pthread_mutex_unlock(&warmup_lk);
 		}
-	} 
+	}
+
+	Pthread_mutex_lock(&warmup_lk);
+	if (stopped)
+		warmup.st_stopped = 1;
+	else if (dbmfp == NULL)
+		warmup.st_pages_done += pagelist->cnt;
+	Pthread_mutex_unlock(&warmup_lk);
 
 	Pthread_mutex_lock(fileid_env->lk);
 	(*fileid_env->active_threads)--;
@@ -2081,6 +2152,11 @@ static void
 load_fileids_thdpool(fileid_page_env_t *fileid_env)
 {
 	int ret;
+
+	Pthread_mutex_lock(&warmup_lk);
+	warmup.st_pages += fileid_env->pagelist->cnt;
+	Pthread_mutex_unlock(&warmup_lk);
+
 	Pthread_mutex_lock(fileid_env->lk);
 	(*fileid_env->active_threads)++;
 	if ((ret = thdpool_enqueue(gbl_loadcache_thdpool, load_fileids,
@@ -2138,6 +2214,13 @@ __memp_load(dbenv, s, pagecount, lines)
 	}
 
 	start = time(NULL);
+
+	Pthread_mutex_lock(&warmup_lk);
+	memset(&warmup, 0, sizeof(warmup));
+	warmup.st_running = 1;
+	warmup.st_start = start;
+	Pthread_mutex_unlock(&warmup_lk);
+
 	char cfileid[DB_FILE_ID_LEN*2+1];
 	cfileid[DB_FILE_ID_LEN*2] = 0;
 	while ((!max_pages || (*pagecount) < max_pages) && (ret =
@@ -2230,6 +2313,11 @@ done:
 	Pthread_mutex_unlock(&lk);
 	end = time(NULL);
 
+	Pthread_mutex_lock(&warmup_lk);
+	warmup.st_running = 0;
+	warmup.st_end = end;
+	Pthread_mutex_unlock(&warmup_lk);
+
 	logmsg(LOGMSG_DEBUG, "Loaded %"PRIu64" bufferpool pages in %u seconds\n",
 			*pagecount, (end - start));
 	(*lines) = lineno;
@@ -2423,6 +2511,18 @@ __memp_dump_default(dbenv, force)
 	char rnpath[PATH_MAX], rnpathbuf[PATH_MAX], *rrnpath;
 #endif
 	SBUF2 *s;
+	int partial;
+
+	/*
+	 * While a cache load is running, or after one gave up early, the
+	 * cache holds only part of what the page list says it should; don't
+	 * overwrite the list with it.
+	 */
+	Pthread_mutex_lock(&warmup_lk);
+	partial = warmup.st_running || warmup.st_stopped;
+	Pthread_mutex_unlock(&warmup_lk);
+	if (!force && partial)
+		return 0;
 
 	if (!force && thresh > 0) {
 		u_int64_t target = ((memp_pagecount * thresh) / 100);
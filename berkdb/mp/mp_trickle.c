@@ -21,10 +21,37 @@ static const char revid[] = "$Id: mp_trickle.c,v 11.30 2003/09/13 19:20:41 bosti
 #include "dbinc/db_shash.h"
 #include "dbinc/log.h"
 #include "dbinc/mp.h"
+#include "dbinc/txn.h"
 
 #include <time.h>
+#include <epochlib.h>
 
 static int __memp_trickle __P((DB_ENV *, int, int *, int));
+static int __memp_pace __P((DB_ENV *, int, int *));
+
+/* Pace the trickle thread to the checkpoint interval. */
+int gbl_mpool_pace_writeback = 0;
+/* Interval between pacing decisions, in milliseconds. */
+int gbl_mpool_pace_msecs = 100;
+/* Most of each interval the pacer may spend writing, as a percentage. */
+int gbl_mpool_pace_max_io_pct = 50;
+/* Dirty percentage of the cache above which the I/O limit is ignored. */
+int gbl_mpool_pace_dirty_max_pct = 50;
+/* Fewest pages worth a pass over the cache, unless it is mostly dirty. */
+int gbl_mpool_pace_min_pages = 64;
+
+/* The pacer's latest decision and inputs, exported as metrics. */
+int64_t gbl_memp_pace_rate;		/* Target pages per second. */
+int64_t gbl_memp_pace_dirty_rate;	/* Pages dirtied per second. */
+int64_t gbl_memp_pace_log_rate;		/* Log bytes per second. */
+int64_t gbl_memp_pace_ckp_secs;		/* Seconds to next checkpoint. */
+int64_t gbl_memp_pace_write_usecs;	/* Average page write time. */
+int64_t gbl_memp_pace_dirty_pct;	/* Dirty percentage of the cache. */
+int64_t gbl_memp_pace_pages;		/* Pages written by the pacer. */
+int64_t gbl_memp_pace_throttled;	/* Intervals cut by the I/O limit. */
+
+extern u_int64_t gbl_memp_flush_pages;
+extern u_int64_t gbl_memp_flush_usecs;
 
 /*
  * __memp_trickle_pp --
@@ -124,3 +151,201 @@ done:	memcpy(&mp->trickle_lsn, &last_lsn, sizeof(DB_LSN));
 
 	return (ret);
 }
+
+/*
+ * __memp_trickle_paced --
+ *	Write out the share of the dirty buffers due in the next pacing
+ *	interval.  ckp_secs is the checkpoint interval in seconds.
+ *
+ * PUBLIC: int __memp_trickle_paced __P((DB_ENV *, int, int *));
+ */
+int
+__memp_trickle_paced(dbenv, ckp_secs, nwrotep)
+	DB_ENV *dbenv;
+	int ckp_secs, *nwrotep;
+{
+	int rep_check, ret;
+
+	PANIC_CHECK(dbenv);
+	ENV_REQUIRES_CONFIG(dbenv,
+	    dbenv->mp_handle, "memp_trickle", DB_INIT_MPOOL);
+
+	rep_check = IS_ENV_REPLICATED(dbenv) ? 1 : 0;
+	if (rep_check)
+		__env_rep_enter(dbenv);
+	ret = __memp_pace(dbenv, ckp_secs, nwrotep);
+	if (rep_check)
+		__env_rep_exit(dbenv);
+	return (ret);
+}
+
+/* Weight given to the newest sample in the pacer's moving averages. */
+#define	PACE_EWMA(avg, sample)	((avg) = ((avg) * 3 + (sample)) / 4)
+
+/* There is a single trickle thread, so the pacer's state is static. */
+static struct {
+	int64_t ms;
+	DB_LSN lsn;
+	u_int32_t dirty;
+	int wrote;
+	int owed;
+	u_int64_t flush_pages;
+	u_int64_t flush_usecs;
+	double dirty_rate;
+	double log_rate;
+	double page_usecs;
+} pace;
+
+/*
+ * __memp_pace --
+ *	Spread the writeback a checkpoint would otherwise do in one burst
+ *	over the time until that checkpoint.  The checkpoint comes at the
+ *	end of its interval or when the log switches files, whichever is
+ *	first.  Each interval we write enough pages to keep up with the
+ *	rate pages are being dirtied, scaled up while the log is running
+ *	ahead of its average, plus an even share of the pages already
+ *	dirty.  How long page writes are taking limits how much of the
+ *	interval goes to writing, unless the cache is close to full of
+ *	dirty pages.
+ */
+static int
+__memp_pace(dbenv, ckp_secs, nwrotep)
+	DB_ENV *dbenv;
+	int ckp_secs, *nwrotep;
+{
+	DB_LOG *dblp;
+	DB_LSN lsn;
+	DB_MPOOL *dbmp;
+	DB_TXNMGR *mgr;
+	DB_TXNREGION *region;
+	LOG *lp;
+	MPOOL *c_mp, *mp;
+	double burst, dt, log_now, need, remain, sample;
+	int64_t now;
+	u_int64_t fpages, fusecs, logbytes;
+	u_int32_t dirty, dtmp, i, log_size, total;
+	int budget, cap, interval, ret;
+
+	dbmp = dbenv->mp_handle;
+	mp = dbmp->reginfo[0].primary;
+	*nwrotep = 0;
+	ret = 0;
+
+	interval = gbl_mpool_pace_msecs > 0 ? gbl_mpool_pace_msecs : 1;
+	now = comdb2_time_epochms();
+	__log_get_last_lsn(dbenv, &lsn);
+
+	for (i = dirty = total = 0; i < mp->nreg; ++i) {
+		c_mp = dbmp->reginfo[i].primary;
+		total += c_mp->stat.st_pages;
+		__memp_stat_hash(&dbmp->reginfo[i], c_mp, &dtmp);
+		dirty += dtmp;
+	}
+	fpages = gbl_memp_flush_pages;
+	fusecs = gbl_memp_flush_usecs;
+
+	if (pace.ms == 0 || now <= pace.ms)
+		goto done;
+	dt = (now - pace.ms) / 1000.0;
+
+	dblp = dbenv->lg_handle;
+	lp = dblp->reginfo.primary;
+	log_size = lp->log_size;
+	if (lsn.file == pace.lsn.file)
+		logbytes = lsn.offset >= pace.lsn.offset ?
+		    lsn.offset - pace.lsn.offset : 0;
+	else
+		logbytes = (u_int64_t)(lsn.file - pace.lsn.file) * log_size +
+		    lsn.offset - pace.lsn.offset;
+
+	/* Pages dirtied since last time, net of what we cleaned. */
+	sample = (double)dirty - pace.dirty + pace.wrote;
+	if (sample < 0)
+		sample = 0;
+	PACE_EWMA(pace.dirty_rate, sample / dt);
+	log_now = logbytes / dt;
+	PACE_EWMA(pace.log_rate, log_now);
+	if (fpages > pace.flush_pages)
+		PACE_EWMA(pace.page_usecs, (double)(fusecs - pace.flush_usecs) /
+		    (fpages - pace.flush_pages));
+
+	/* Seconds until the next checkpoint. */
+	remain = ckp_secs;
+	mgr = dbenv->tx_handle;
+	if (mgr != NULL) {
+		region = mgr->reginfo.primary;
+		remain -= time(NULL) - region->time_ckp;
+	}
+	if (pace.log_rate > 0 && lsn.offset < log_size &&
+	    (log_size - lsn.offset) / pace.log_rate < remain)
+		remain = (log_size - lsn.offset) / pace.log_rate;
+	if (remain < interval / 1000.0)
+		remain = interval / 1000.0;
+
+	burst = 1;
+	if (pace.log_rate > 0 && log_now > pace.log_rate)
+		burst = log_now / pace.log_rate > 4 ? 4 : log_now / pace.log_rate;
+	need = pace.dirty_rate * burst + dirty / remain;
+
+	budget = (int)(need * interval / 1000 + 0.5);
+	if (budget > (int)dirty)
+		budget = dirty;
+	if (pace.page_usecs > 0 && total > 0 &&
+	    dirty * 100 / total < gbl_mpool_pace_dirty_max_pct) {
+		cap = (int)(interval * 10.0 * gbl_mpool_pace_max_io_pct /
+		    pace.page_usecs);
+		if (cap < 1)
+			cap = 1;
+		if (budget > cap) {
+			budget = cap;
+			++gbl_memp_pace_throttled;
+		}
+	}
+
+	/*
+	 * Every sync pass walks all of the hash buckets, so don't make one
+	 * for a handful of pages: let the budget build up across intervals
+	 * until it's worth the walk.  Whatever a pass couldn't write is still
+	 * owed next time, though never more than one batch beyond this
+	 * interval's budget.
+	 */
+	pace.owed += budget;
+	if (pace.owed > budget + gbl_mpool_pace_min_pages)
+		pace.owed = budget + gbl_mpool_pace_min_pages;
+	if (pace.owed > (int)dirty)
+		pace.owed = dirty;
+	if (pace.owed >= gbl_mpool_pace_min_pages || (total > 0 &&
+	    dirty * 100 / total >= gbl_mpool_pace_dirty_max_pct))
+		budget = pace.owed;
+	else
+		budget = 0;
+
+	gbl_memp_pace_rate = (int64_t)need;
+	gbl_memp_pace_dirty_rate = (int64_t)pace.dirty_rate;
+	gbl_memp_pace_log_rate = (int64_t)pace.log_rate;
+	gbl_memp_pace_ckp_secs = (int64_t)remain;
+	gbl_memp_pace_write_usecs = (int64_t)pace.page_usecs;
+	gbl_memp_pace_dirty_pct = total > 0 ? (int64_t)dirty * 100 / total : 0;
+
+	if (budget > 0) {
+		if (dbenv->iomap && dbenv->attr.iomap_enabled)
+			dbenv->iomap->memptrickle_active = time(NULL);
+		ret = __memp_sync_int(dbenv,
+		    NULL, budget, DB_SYNC_TRICKLE, nwrotep, 1, NULL, 0);
+		if (dbenv->iomap && dbenv->attr.iomap_enabled)
+			dbenv->iomap->memptrickle_active = 0;
+
+		mp->stat.st_page_trickle += *nwrotep;
+		gbl_memp_pace_pages += *nwrotep;
+		if ((pace.owed -= *nwrotep) < 0)
+			pace.owed = 0;
+	}
+
+done:	pace.ms = now;
+	pace.lsn = lsn;
+	pace.dirty = dirty;
+	pace.wrote = *nwrotep;
+	pace.flush_pages = fpages;
+	pace.flush_usecs = fusecs;
+	return (ret);
+}
@@ -19,6 +19,9 @@ static const char revid[] = "$Id: os_region.c,v 11.17 2003/07/13 17:45:23 bostic
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/types.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 #endif
 
 #include "db_int.h"
@@ -28,6 +31,32 @@ static const char revid[] = "$Id: os_region.c,v 11.17 2003/07/13 17:45:23 bostic
 extern char gbl_dbname[MAX_DBNAME_LENGTH];
 extern int gbl_largepages;
 
+/*
+ * Page size for the mpool and lock regions: 0 is the system allocator, 1
+ * asks for transparent huge pages and 2 for reserved hugetlb pages, falling
+ * back to transparent huge pages if none are available.
+ */
+int gbl_region_hugepages = 0;
+
+/*
+ * NUMA placement for the mpool and lock regions: 0 leaves it to first touch,
+ * 1 interleaves every region across the nodes and 2 places cache region i on
+ * node (i % nodes), interleaving the lock region.
+ */
+int gbl_mpool_numa = 0;
+
+#define	REGION_NUMA_INTERLEAVE	1
+#define	REGION_NUMA_SPREAD	2
+
+/* Linux memory policies, so we needn't depend on libnuma. */
+#ifndef MPOL_PREFERRED
+#define	MPOL_PREFERRED		1
+#endif
+#ifndef MPOL_INTERLEAVE
+#define	MPOL_INTERLEAVE		3
+#endif
+#define	REGION_NUMA_MAXNODE	(8 * sizeof(unsigned long))
+
 
 struct region {
 	int maxsize;
@@ -90,6 +119,133 @@ __dbenv_regiontype(int type)
   will return the memory.
 */
 
+/*
+ * __os_r_numa_nodes --
+ *	Return the number of NUMA nodes, or 0 if there's only one or we
+ *	can't tell.
+ */
+static int
+__os_r_numa_nodes()
+{
+	static int nnodes = -1;
+	char buf[256], *p;
+	FILE *f;
+	int n;
+
+	if (nnodes >= 0)
+		return (nnodes);
+	nnodes = 0;
+
+	/* The online map looks like "0-3" or "0,2-3"; take the last node. */
+	if ((f = fopen("/sys/devices/system/node/online", "r")) == NULL)
+		return (nnodes);
+	if (fgets(buf, sizeof(buf), f) != NULL) {
+		for (p = buf + strlen(buf);
+		    p > buf && (p[-1] < '0' || p[-1] > '9'); --p)
+			;
+		for (; p > buf && p[-1] >= '0' && p[-1] <= '9'; --p)
+			;
+		n = atoi(p) + 1;
+		if (n > 1)
+			nnodes = n < (int)REGION_NUMA_MAXNODE ?
+			    n : (int)REGION_NUMA_MAXNODE - 1;
+	}
+	fclose(f);
+	return (nnodes);
+}
+
+/*
+ * __os_r_numa --
+ *	Apply the NUMA policy to a freshly mapped region.  This must happen
+ *	before the region is first touched.
+ */
+static void
+__os_r_numa(dbenv, infop, size)
+	DB_ENV *dbenv;
+	REGINFO *infop;
+	size_t size;
+{
+#ifdef __linux__
+	static int next_node;
+	unsigned long mask;
+	int i, mode, nnodes;
+
+	if (!gbl_mpool_numa || (nnodes = __os_r_numa_nodes()) == 0)
+		return;
+
+	if (gbl_mpool_numa == REGION_NUMA_SPREAD &&
+	    infop->type == REGION_TYPE_MPOOL) {
+		infop->numa_node = next_node++ % nnodes;
+		mask = 1UL << infop->numa_node;
+		mode = MPOL_PREFERRED;
+	} else {
+		for (mask = 0, i = 0; i < nnodes; ++i)
+			mask |= 1UL << i;
+		mode = MPOL_INTERLEAVE;
+	}
+
+	if (syscall(SYS_mbind, infop->addr, size, mode,
+	    &mask, REGION_NUMA_MAXNODE, 0) != 0) {
+		logmsgperror("os_r_attach: mbind");
+		infop->numa_node = -1;
+	}
+#endif
+}
+
+/*
+ * __os_r_mmap --
+ *	Allocate a region as an anonymous mapping so that it can be backed
+ *	by huge pages and placed on particular NUMA nodes.
+ */
+static int
+__os_r_mmap(dbenv, infop, rp)
+	DB_ENV *dbenv;
+	REGINFO *infop;
+	REGION *rp;
+{
+	static int warned;
+	size_t MB_2 = 2 * 1024 * 1024UL, less;
+	void *addr;
+	int flags, huge;
+
+	flags = MAP_PRIVATE | MAP_ANONYMOUS;
+	huge = gbl_region_hugepages && rp->size >= MB_2;
+
+	addr = MAP_FAILED;
+#ifdef MAP_HUGETLB
+	if (huge && gbl_region_hugepages == 2) {
+		if ((less = rp->size % MB_2) != 0)
+			rp->size += (MB_2 - less);
+		addr = mmap(NULL, rp->size,
+		    PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+		if (addr == MAP_FAILED && !warned) {
+			warned = 1;
+			logmsg(LOGMSG_WARN, "os_r_attach: no hugetlb pages "
+			    "available, using transparent huge pages\n");
+		}
+	}
+#endif
+	if (addr == MAP_FAILED) {
+		addr = mmap(NULL, rp->size,
+		    PROT_READ | PROT_WRITE, flags, -1, 0);
+		if (addr == MAP_FAILED)
+			return (__os_get_errno());
+#ifdef MADV_HUGEPAGE
+		if (huge)
+			(void)madvise(addr, rp->size, MADV_HUGEPAGE);
+#endif
+	}
+	infop->addr = addr;
+	F_SET(infop, REGION_MMAP);
+
+	__os_r_numa(dbenv, infop, rp->size);
+
+	logmsg(LOGMSG_INFO, "os_r_attach: %s region size %zu at %p, node %d\n",
+	    __dbenv_regiontype((int)infop->type), (size_t)rp->size,
+	    infop->addr, infop->numa_node);
+	return (0);
+}
+
 /*
  * __os_r_attach --
  *	Attach to a shared memory region.
@@ -109,6 +265,14 @@ __os_r_attach(dbenv, infop, rp)
 	OS_VMROUNDOFF(rp->size);
 
 	infop->fd = -1;
+	infop->numa_node = -1;
+	F_CLR(infop, REGION_MMAP);
+
+	if ((gbl_region_hugepages || gbl_mpool_numa) && !gbl_largepages &&
+	    rp->size != 0 && !dbenv->is_tmp_tbl &&
+	    (infop->type == REGION_TYPE_MPOOL ||
+	    infop->type == REGION_TYPE_LOCK))
+		return (__os_r_mmap(dbenv, infop, rp));
 
 	/* memory regions are separately tracked. To avoid
 	   double-counting on "berkdb" allocator, system malloc is
@@ -174,6 +338,12 @@ __os_r_detach(dbenv, infop, destroy)
 
 	rp = infop->rp;
 
+	if (F_ISSET(infop, REGION_MMAP)) {
+		(void)munmap(infop->addr, rp->size);
+		F_CLR(infop, REGION_MMAP);
+		return (0);
+	}
+
 	dbenv->set_use_sys_malloc(dbenv, 1);
 
 	if (infop->fd < 0 && infop->addr) {
@@ -39,11 +39,13 @@ static const char revid[] = "$Id: os_rw.c,v 11.30 2003/05/23 21:19:05 bostic Exp
 #include <pthread.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <time.h>
 #endif
 
@@ -57,6 +59,10 @@ static const char revid[] = "$Id: os_rw.c,v 11.30 2003/05/23 21:19:05 bostic Exp
 #include "logmsg.h"
 #include "locks_wrap.h"
 
+#ifdef WITH_IOURING
+#include <liburing.h>
+#endif
+
 uint64_t bb_berkdb_fasttime(void);
 
 #ifdef HAVE_FILESYSTEM_NOTZERO
@@ -563,6 +569,258 @@ err:	MUTEX_THREAD_UNLOCK(dbenv, fhp->mutexp);
 
 }
 
+/*
+ * Maximum number of reads a thread keeps in flight in a batch read.  This
+ * sizes the per-thread submission ring when io_uring support is built in.
+ */
+int gbl_iouring_queue_depth = 64;
+
+#ifdef WITH_IOURING
+struct iouring {
+	struct io_uring ring;
+	unsigned entries;
+	int broken;
+};
+
+static pthread_key_t iouringkey;
+static pthread_once_t iouring_once = PTHREAD_ONCE_INIT;
+
+static void
+free_iouring(void *p)
+{
+	struct iouring *r = p;
+
+	if (!r->broken)
+		io_uring_queue_exit(&r->ring);
+	free(r);
+}
+
+static void
+init_iouring(void)
+{
+	Pthread_key_create(&iouringkey, free_iouring);
+}
+
+/*
+ * Rings are per thread, so submissions and completions need no locking.
+ * Returns NULL if this thread can't have one; callers fall back to pread.
+ */
+static struct iouring *
+get_iouring(void)
+{
+	struct iouring *r;
+	unsigned entries;
+	int ret;
+
+	pthread_once(&iouring_once, init_iouring);
+	r = pthread_getspecific(iouringkey);
+	if (r != NULL)
+		return (r->broken ? NULL : r);
+
+	if ((r = calloc(1, sizeof(struct iouring))) == NULL)
+		return (NULL);
+	entries = gbl_iouring_queue_depth < 1 ? 1 :
+	    gbl_iouring_queue_depth > 4096 ? 4096 : gbl_iouring_queue_depth;
+	if ((ret = io_uring_queue_init(entries, &r->ring, 0)) < 0) {
+		logmsg(LOGMSG_WARN,
+		    "%s: io_uring_queue_init(%u) failed %d %s, using pread\n",
+		    __func__, entries, -ret, strerror(-ret));
+		r->broken = 1;
+	} else
+		r->entries = entries;
+	Pthread_setspecific(iouringkey, r);
+	return (r->broken ? NULL : r);
+}
+
+/*
+ * __os_io_batch_uring --
+ *	Submit as many of the reads as the ring holds, reap them, repeat.
+ *	Reads which didn't complete in full are left with niop[i] set to
+ *	(size_t)-1 for the caller to redo synchronously.
+ */
+static void
+__os_io_batch_uring(r, fhp, pgnos, bufs, n, pagesize, niop)
+	struct iouring *r;
+	DB_FH *fhp;
+	db_pgno_t *pgnos;
+	u_int8_t **bufs;
+	int n;
+	size_t pagesize, *niop;
+{
+	struct io_uring_sqe *sqe;
+	struct io_uring_cqe *cqe;
+	int i, idx, nsub, ok, queued, ret, submitted;
+
+	for (i = 0; i < n;) {
+		for (queued = 0; i < n && queued < (int)r->entries; ++i) {
+			/* O_DIRECT needs an aligned buffer, leave it to pread. */
+			if (F_ISSET(fhp, DB_FH_DIRECT) &&
+			    ((uintptr_t)bufs[i] & 511) != 0)
+				continue;
+			if ((sqe = io_uring_get_sqe(&r->ring)) == NULL)
+				break;
+			io_uring_prep_read(sqe, fhp->fd, bufs[i],
+			    pagesize, (off_t)pgnos[i] * pagesize);
+			io_uring_sqe_set_data(sqe, (void *)(uintptr_t)i);
+			++queued;
+		}
+		if (queued == 0)
+			break;
+
+		ok = 1;
+		for (submitted = 0; submitted < queued; submitted += nsub)
+			if ((nsub = io_uring_submit(&r->ring)) <= 0) {
+				ok = 0;
+				break;
+			}
+
+		for (; submitted > 0; --submitted) {
+			while ((ret = io_uring_wait_cqe(&r->ring, &cqe)) == -EINTR)
+				;
+			if (ret < 0) {
+				ok = 0;
+				break;
+			}
+			idx = (int)(uintptr_t)io_uring_cqe_get_data(cqe);
+			if (cqe->res == (int)pagesize)
+				niop[idx] = pagesize;
+			io_uring_cqe_seen(&r->ring, cqe);
+		}
+
+		/*
+		 * If the ring failed we can't know what it still references:
+		 * tear it down and let this thread use pread from now on.
+		 */
+		if (!ok) {
+			logmsg(LOGMSG_ERROR,
+			    "%s: io_uring failure, falling back to pread\n",
+			    __func__);
+			io_uring_queue_exit(&r->ring);
+			r->broken = 1;
+			break;
+		}
+	}
+}
+#endif
+
+/*
+ * __os_io_batch_advise --
+ *	Without an async engine, have the kernel start the reads before we
+ *	block on them one at a time.  Direct I/O bypasses the page cache, so
+ *	there's nothing to gain there.
+ */
+static void
+__os_io_batch_advise(fhp, pgnos, n, pagesize)
+	DB_FH *fhp;
+	db_pgno_t *pgnos;
+	int n;
+	size_t pagesize;
+{
+#ifdef POSIX_FADV_WILLNEED
+	int i;
+
+	if (F_ISSET(fhp, DB_FH_DIRECT))
+		return;
+	for (i = 0; i < n; ++i)
+		(void)posix_fadvise(fhp->fd, (off_t)pgnos[i] * pagesize,
+		    pagesize, POSIX_FADV_WILLNEED);
+#endif
+}
+
+/*
+ * __os_io_batch --
+ *	Read a batch of pages from a file.  With io_uring support the reads
+ *	are all in flight at once; otherwise the kernel is asked to start
+ *	reading ahead before the pages are read in order.  niop[i] is set to
+ *	the number of bytes read for pgnos[i].  Errors for individual pages
+ *	are reported through niop; the first one is returned.
+ *
+ * PUBLIC: int __os_io_batch __P((DB_ENV *, DB_FH *,
+ * PUBLIC:     db_pgno_t *, u_int8_t **, int, size_t, size_t *));
+ */
+int
+__os_io_batch(dbenv, fhp, pgnos, bufs, n, pagesize, niop)
+	DB_ENV *dbenv;
+	DB_FH *fhp;
+	db_pgno_t *pgnos;
+	u_int8_t **bufs;
+	int n;
+	size_t pagesize, *niop;
+{
+#ifdef WITH_IOURING
+	struct iouring *r;
+#endif
+	uint64_t x1, x2;
+	int i, inflight, ret, t_ret;
+
+	DB_ASSERT(F_ISSET(fhp, DB_FH_OPENED) && fhp->fd != -1);
+
+	for (i = 0; i < n; ++i)
+		niop[i] = (size_t)-1;
+
+	/* Test hooks and replacement read functions get the slow path. */
+	inflight = DB_GLOBAL(j_read) == NULL && __slow_read_ns == 0;
+
+	if (inflight) {
+		x1 = bb_berkdb_fasttime();
+#ifdef WITH_IOURING
+		if ((r = get_iouring()) != NULL)
+			__os_io_batch_uring(r,
+			    fhp, pgnos, bufs, n, pagesize, niop);
+		else
+#endif
+			__os_io_batch_advise(fhp, pgnos, n, pagesize);
+		x2 = bb_berkdb_fasttime();
+
+		for (i = 0; i < n; ++i) {
+			if (niop[i] != pagesize)
+				continue;
+			if (__berkdb_num_read_ios)
+				(*__berkdb_num_read_ios)++;
+			if (read_callback)
+				read_callback(pagesize);
+			if (gbl_bb_berkdb_enable_thread_stats) {
+				struct berkdb_thread_stats *p, *t;
+
+				t = bb_berkdb_get_thread_stats();
+				p = bb_berkdb_get_process_stats();
+				p->n_preads++;
+				p->pread_bytes += pagesize;
+				t->n_preads++;
+				t->pread_bytes += pagesize;
+			}
+		}
+		if (gbl_bb_berkdb_enable_thread_stats) {
+			bb_berkdb_get_thread_stats()->pread_time_us += (x2 - x1);
+			bb_berkdb_get_process_stats()->pread_time_us += (x2 - x1);
+		}
+		if (__berkdb_read_alarm_ms &&
+		    (x2 - x1) > M2U(__berkdb_read_alarm_ms) &&
+		    __berkdb_trace_func) {
+			char s[80];
+
+			snprintf(s, sizeof(s),
+			    "LONG BATCH PREAD (%d x %d) %d ms fd %d\n",
+			    n, (int)pagesize, U2M(x2 - x1), fhp->fd);
+			__berkdb_trace_func(s);
+		}
+	}
+
+	/* Anything not read above, or read short, goes through __os_io. */
+	for (ret = 0, i = 0; i < n; ++i) {
+		if (niop[i] == pagesize)
+			continue;
+		niop[i] = 0;
+		if ((t_ret = __os_io(dbenv, DB_IO_READ,
+		    fhp, pgnos[i], pagesize, bufs[i], &niop[i])) != 0) {
+			niop[i] = 0;
+			if (ret == 0)
+				ret = t_ret;
+		}
+	}
+	return (ret);
+}
+
 static int __berkdb_read(DB_ENV *dbenv, int fd, void *buf, size_t bufsz, int direct) {
 	void *abuf;
 	int rc;
@@ -811,6 +1069,71 @@ __berkdb_direct_pwritev(DB_ENV *dbenv,
 	} while (rc == -1 && ++nretries < dbenv->attr.num_write_retries);
 	return rc;
 }
+
+/*
+ * Write contiguous pages straight from their buffers.  O_DIRECT needs
+ * every buffer aligned; if one isn't, copy through the aligned buffer.
+ */
+static int
+__berkdb_pwritev(DB_ENV *dbenv, int fd, size_t pagesize, u_int8_t **bufs,
+    size_t nobufs, off_t offset, int direct)
+{
+	struct iovec iov[IOV_MAX];
+	size_t done, total;
+	ssize_t rc;
+	int i, iovcnt, nretries = 0;
+
+	DB_ASSERT(nobufs <= IOV_MAX);
+
+	if (direct) {
+		for (i = 0; i < nobufs; i++)
+			if (((uintptr_t)bufs[i] & 511) != 0)
+				return __berkdb_direct_pwritev(dbenv,
+				    fd, pagesize, bufs, nobufs, offset);
+	}
+
+	for (i = 0; i < nobufs; i++) {
+		iov[i].iov_base = bufs[i];
+		iov[i].iov_len = pagesize;
+	}
+
+	total = nobufs * pagesize;
+	for (done = 0, i = 0, iovcnt = nobufs; done < total;) {
+		rc = pwritev(fd, &iov[i], iovcnt, offset + done);
+		if (dbenv->attr.debug_enospc_chance &&
+		    rand() % 100 < dbenv->attr.debug_enospc_chance) {
+			rc = -1;
+			errno = ENOSPC;
+		}
+		if (rc == -1) {
+			int err = errno;
+			logmsg(LOGMSG_WARN, "pwritev fd %d sz %zu off %"PRId64
+			    " retry %d error %d %s\n", fd, total - done,
+			    (int64_t)(offset + done), nretries, err,
+			    strerror(err));
+			if (++nretries >= dbenv->attr.num_write_retries)
+				return (done == 0 ? -1 : (int)done);
+			if (err != EINTR && err != EBUSY)
+				poll(NULL, 0, 10);
+			continue;
+		}
+		if (rc == 0)
+			break;
+
+		/* Short write: skip what made it out and go again. */
+		done += rc;
+		while (iovcnt > 0 && (size_t)rc >= iov[i].iov_len) {
+			rc -= iov[i].iov_len;
+			++i;
+			--iovcnt;
+		}
+		if (iovcnt > 0) {
+			iov[i].iov_base = (u_int8_t *)iov[i].iov_base + rc;
+			iov[i].iov_len -= rc;
+		}
+	}
+	return (int)done;
+}
 #endif
 
 /*
@@ -830,11 +1153,13 @@ __os_iov(dbenv, op, fhp, pgno, pagesize, bufs, nobufs, niop)
 	u_int8_t **bufs;
 {
 	int ret = 0, i;
-	db_pgno_t c_pgno;
-	size_t single_niop, max_bufs;
+	size_t single_niop, max_bufs, first, n;
 	struct timespec s, rem;
 	int rc;
 
+	/* Pages before this one are known to have been transferred. */
+	first = 0;
+
 
 #if defined(HAVE_PREAD) && defined(HAVE_PWRITE)
 	if (op == DB_IO_READ && __slow_read_ns) {
@@ -855,11 +1180,22 @@ __os_iov(dbenv, op, fhp, pgno, pagesize, bufs, nobufs, niop)
 		}
 	}
 
-	if (!F_ISSET(fhp, DB_FH_DIRECT))
-		goto slow;
 	if (nobufs == 1)
 		goto slow;
 
+	/*
+	 * Reads are only vectored for direct I/O; writes always are, so a
+	 * run of adjacent dirty pages goes out in one system call.
+	 */
+	if (op == DB_IO_READ && !F_ISSET(fhp, DB_FH_DIRECT))
+		goto slow;
+	if (op == DB_IO_WRITE && DB_GLOBAL(j_write) != NULL)
+		goto slow;
+#ifdef HAVE_FILESYSTEM_NOTZERO
+	if (op == DB_IO_WRITE && __os_fs_notzero())
+		goto slow;
+#endif
+
 	if (op == DB_IO_WRITE && dbenv->attr.check_zero_lsn_writes
 	    && (dbenv->open_flags & DB_INIT_TXN)) {
 		static const char zerobuf[32];
@@ -898,28 +1234,32 @@ __os_iov(dbenv, op, fhp, pgno, pagesize, bufs, nobufs, niop)
 	*niop = 0;
 	if (max_bufs > dbenv->attr.sgio_max / pagesize)
 		max_bufs = dbenv->attr.sgio_max / pagesize;
+	if (max_bufs > IOV_MAX)
+		max_bufs = IOV_MAX;
+	if (max_bufs < 1)
+		max_bufs = 1;
 
 	switch (op) {
 	case DB_IO_READ:
 		if (__berkdb_read_alarm_ms)
 			x1 = bb_berkdb_fasttime();
 
-		c_pgno = pgno;
-		do {
-			single_niop = __berkdb_direct_preadv(fhp->fd,
-			    pagesize,
-			    bufs, max_bufs, (off_t)(c_pgno * pagesize));
-			*niop += single_niop;
-			c_pgno += max_bufs;
-			bufs += max_bufs;
-
-			if (nobufs < (*niop / pagesize) + max_bufs)
-				max_bufs = nobufs % max_bufs;
+		for (first = 0; first < nobufs; first += n) {
+			n = nobufs - first < max_bufs ? nobufs - first : max_bufs;
+			rc = __berkdb_direct_preadv(fhp->fd, pagesize,
+			    &bufs[first], n, (off_t)(pgno + first) * pagesize);
 
 			if (__berkdb_num_read_ios)
 				(*__berkdb_num_read_ios)++;
 
-		} while (single_niop > 0 && *niop < nobufs * pagesize);
+			if (rc <= 0)
+				break;
+			*niop += rc;
+			if ((size_t)rc < n * pagesize) {
+				first += rc / pagesize;
+				break;
+			}
+		}
 
 		if (__berkdb_read_alarm_ms) {
 			x2 = bb_berkdb_fasttime();
@@ -958,24 +1298,23 @@ __os_iov(dbenv, op, fhp, pgno, pagesize, bufs, nobufs, niop)
 		if (__berkdb_write_alarm_ms)
 			x1 = bb_berkdb_fasttime();
 
-		c_pgno = pgno;
-		do {
-			single_niop = __berkdb_direct_pwritev(dbenv,
-			    fhp->fd,
-			    pagesize,
-			    bufs, max_bufs, (off_t)(c_pgno * pagesize));
-			*niop += single_niop;
-			c_pgno += max_bufs;
-			bufs += max_bufs;
-
-			if (nobufs < (*niop / pagesize) + max_bufs)
-				max_bufs = nobufs % max_bufs;
+		for (first = 0; first < nobufs; first += n) {
+			n = nobufs - first < max_bufs ? nobufs - first : max_bufs;
+			rc = __berkdb_pwritev(dbenv, fhp->fd, pagesize,
+			    &bufs[first], n, (off_t)(pgno + first) * pagesize,
+			    F_ISSET(fhp, DB_FH_DIRECT));
 
 			if (__berkdb_num_write_ios)
 				(*__berkdb_num_write_ios)++;
 
-
-		} while (single_niop != 0 && *niop < nobufs * pagesize);
+			if (rc <= 0)
+				break;
+			*niop += rc;
+			if ((size_t)rc < n * pagesize) {
+				first += rc / pagesize;
+				break;
+			}
+		}
 
 
 		if (__berkdb_write_alarm_ms) {
@@ -1014,14 +1353,13 @@ __os_iov(dbenv, op, fhp, pgno, pagesize, bufs, nobufs, niop)
 	if (*niop == (size_t)(pagesize * nobufs))
 		return (0);
 	logmsg(LOGMSG_DEBUG, "%s: failed %s io: expected %zd got %zd\n", __func__, op == DB_IO_READ ? "read" : "write", pagesize * nobufs, *niop);
-    // iov - we failed to write the pages as a unit, fall through and try them individually
+    // iov - we failed to write the pages as a unit, fall through and try the rest individually
 slow:
 #endif
-	/* TODO: __os_pwritev/__os_readv */
-	*niop = 0;
+	*niop = first * pagesize;
 	single_niop = 0;
 
-	for (i = 0; i < nobufs; i++) {
+	for (i = first; i < nobufs; i++) {
 		ret = __os_io(dbenv, op, fhp, pgno + i,
 		    pagesize, bufs[i], &single_niop);
 		*niop += single_niop;
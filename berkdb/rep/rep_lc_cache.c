@@ -16,6 +16,7 @@
 #include "dbinc_auto/dbreg_auto.h"
 #include "dbinc_auto/fileops_auto.h"
 #include "dbinc_auto/qam_auto.h"
+#include "dbinc/log.h"
 #include "dbinc/txn.h"
 #include "dbinc_auto/txn_ext.h"
 #include "dbinc_auto/txn_auto.h"
@@ -28,10 +29,30 @@
 
 /* TODO:
    [X] 1.  Nested transactions
-   [ ] 2.  Overall memory limit/per transaction limit above which we stop?
+   [X] 2.  Overall memory limit/per transaction limit above which we stop?
    [ ] 3.  Use mspace (also gets us #2 for free)?
 */
 
+/*
+ * Memory is bounded two ways.  A transaction that outgrows
+ * cache_lc_memlimit_tran is spilled: its record bodies are freed and only
+ * their LSNs are kept, so apply reads each record once by LSN instead of
+ * walking the prevlsn chain and then reading it again.  When the whole
+ * cache would outgrow cache_lc_memlimit, the least recently fed
+ * transactions are spilled, and then evicted, to make room.  A transaction
+ * is only given up on if its LSNs alone don't fit.
+ */
+
+/* What a record's slot in a collection costs, on top of its body. */
+#define LC_REC_SIZE	((int)sizeof(struct logrecord))
+#define LC_REC_COST(e, size)	(LC_REC_SIZE + ((e)->spilled ? 0 : (int)(size)))
+#define LC_OVER_LIMIT(dbenv, need)					\
+	((dbenv)->attr.cache_lc_memlimit &&				\
+	 (dbenv)->lc_cache.memused + (need) > (dbenv)->attr.cache_lc_memlimit)
+#define LC_OVER_TRAN_LIMIT(dbenv, e, need)				\
+	((dbenv)->attr.cache_lc_memlimit_tran &&			\
+	 (e)->lc.memused + (need) > (dbenv)->attr.cache_lc_memlimit_tran)
+
 // PUBLIC: int __lc_cache_init __P((DB_ENV *, int));
 int
 __lc_cache_init(DB_ENV *dbenv, int reinit)
@@ -40,6 +61,8 @@ __lc_cache_init(DB_ENV *dbenv, int reinit)
 
 	if (!reinit) {
 		Pthread_mutex_init(&dbenv->lc_cache.lk, NULL);
+		dbenv->lc_cache.spilled_hits = dbenv->lc_cache.spills = 0;
+		dbenv->lc_cache.evictions = dbenv->lc_cache.drops = 0;
 	} 
 
 	Pthread_mutex_lock(&dbenv->lc_cache.lk);
@@ -114,6 +137,7 @@ free_ent(DB_ENV *dbenv, LC_CACHE_ENTRY * e)
 		hash_del(dbenv->lc_cache.txnid_hash, e);
 		free_lsn_collection(dbenv, &e->lc);
 		e->txnid = 0;
+		e->spilled = 0;
 		e->lc.had_serializable_records = 0;
 		listc_abl(&dbenv->lc_cache.avail, e);
 		dbenv->lc_cache.memused -= e->lc.memused;
@@ -154,9 +178,10 @@ err:
 	return ret;
 }
 
-/* add a log record to an existing collection */
+/* add a log record to an existing collection; if !keep, only its lsn */
 static int
-lsn_collection_add(DB_ENV *dbenv, LSN_COLLECTION * lc, DB_LSN lsn, DBT *dbt)
+lsn_collection_add(DB_ENV *dbenv, LSN_COLLECTION * lc, DB_LSN lsn, DBT *dbt,
+    int keep)
 {
 	int ret;
 	int nalloc;
@@ -173,19 +198,122 @@ lsn_collection_add(DB_ENV *dbenv, LSN_COLLECTION * lc, DB_LSN lsn, DBT *dbt)
 	}
 	lc->array[lc->nlsns].lsn = lsn;
 	lc->array[lc->nlsns].rec.size = dbt->size;
-	if ((ret = __os_malloc(dbenv, dbt->size, &lc->array[lc->nlsns].rec.data)) != 0)
-		goto err;
-	memcpy(lc->array[lc->nlsns].rec.data, dbt->data,
-	    lc->array[lc->nlsns].rec.size);
+	lc->array[lc->nlsns].rec.data = NULL;
+	if (keep) {
+		if ((ret = __os_malloc(dbenv, dbt->size,
+		    &lc->array[lc->nlsns].rec.data)) != 0)
+			goto err;
+		memcpy(lc->array[lc->nlsns].rec.data, dbt->data,
+		    lc->array[lc->nlsns].rec.size);
+	}
 	lc->nlsns++;
-	lc->memused += dbt->size;
-	dbenv->lc_cache.memused += dbt->size;
+	lc->memused += LC_REC_SIZE + (keep ? dbt->size : 0);
+	dbenv->lc_cache.memused += LC_REC_SIZE + (keep ? dbt->size : 0);
 	return 0;
 
 err:
 	return ret;
 }
 
+/* Free a cached transaction's record bodies, keeping their lsns. */
+static void
+lc_spill_ent(DB_ENV *dbenv, LC_CACHE_ENTRY * e)
+{
+	int freed = 0;
+
+	for (int i = 0; i < e->lc.nlsns; i++) {
+		if (e->lc.array[i].rec.data) {
+			__os_free(dbenv, e->lc.array[i].rec.data);
+			e->lc.array[i].rec.data = NULL;
+			freed += e->lc.array[i].rec.size;
+		}
+	}
+	e->lc.memused -= freed;
+	dbenv->lc_cache.memused -= freed;
+
+	if (!e->spilled) {
+		e->spilled = 1;
+		dbenv->lc_cache.spills++;
+		if (dbenv->attr.cache_lc_debug ||
+		    dbenv->attr.cache_lc_trace_evictions)
+			logmsg(LOGMSG_USER, ">> spilled txnid %x, freed %d\n",
+			    e->txnid, freed);
+	}
+}
+
+/* Get a cached transaction out of the cache altogether. */
+static void
+lc_drop_ent(DB_ENV *dbenv, LC_CACHE_ENTRY * e)
+{
+	listc_rfl(&dbenv->lc_cache.lru, e);
+	free_ent(dbenv, e);
+}
+
+/*
+ * Make room for need more bytes under the overall limit: spill the least
+ * recently fed transactions first, and evict them only if that's not
+ * enough.  keep is the transaction being fed, and is left alone.
+ */
+static void
+lc_make_room(DB_ENV *dbenv, LC_CACHE_ENTRY * keep, int need)
+{
+	LC_CACHE_ENTRY *e, *tmp;
+
+	LISTC_FOR_EACH_SAFE(&dbenv->lc_cache.lru, e, tmp, lnk) {
+		if (!LC_OVER_LIMIT(dbenv, need))
+			return;
+		if (e != keep && !e->spilled)
+			lc_spill_ent(dbenv, e);
+	}
+	LISTC_FOR_EACH_SAFE(&dbenv->lc_cache.lru, e, tmp, lnk) {
+		if (!LC_OVER_LIMIT(dbenv, need))
+			return;
+		if (e == keep)
+			continue;
+		if (dbenv->attr.cache_lc_debug ||
+		    dbenv->attr.cache_lc_trace_evictions)
+			logmsg(LOGMSG_USER, ">> evicting txnid %x mem %d\n",
+			    e->txnid, e->lc.memused);
+		lc_drop_ent(dbenv, e);
+		dbenv->lc_cache.evictions++;
+	}
+}
+
+/*
+ * Add a record to a cached transaction, spilling and evicting as needed to
+ * stay within the limits.  Returns non-zero if the transaction had to be
+ * dropped instead.
+ */
+static int
+lc_add_rec(DB_ENV *dbenv, LC_CACHE_ENTRY * e, DB_LSN lsn, DBT *dbt)
+{
+	if (!e->spilled && LC_OVER_TRAN_LIMIT(dbenv, e, LC_REC_COST(e, dbt->size)))
+		lc_spill_ent(dbenv, e);
+	if (LC_OVER_LIMIT(dbenv, LC_REC_COST(e, dbt->size))) {
+		lc_make_room(dbenv, e, LC_REC_COST(e, dbt->size));
+		if (!e->spilled &&
+		    LC_OVER_LIMIT(dbenv, LC_REC_COST(e, dbt->size)))
+			lc_spill_ent(dbenv, e);
+	}
+
+	if (LC_OVER_TRAN_LIMIT(dbenv, e, LC_REC_COST(e, dbt->size)) ||
+	    LC_OVER_LIMIT(dbenv, LC_REC_COST(e, dbt->size)) ||
+	    lsn_collection_add(dbenv, &e->lc, lsn, dbt, !e->spilled) != 0) {
+		if (dbenv->attr.cache_lc_debug ||
+		    dbenv->attr.cache_lc_trace_evictions) {
+			logmsg(LOGMSG_USER, 
+                "dropping txnid %x: total lc cache %d (limit %d) tran %d  (limit %d) next %d\n",
+			    e->txnid, dbenv->lc_cache.memused,
+			    dbenv->attr.cache_lc_memlimit, e->lc.memused,
+			    dbenv->attr.cache_lc_memlimit_tran, dbt->size);
+		}
+		lc_drop_ent(dbenv, e);
+		dbenv->lc_cache.drops++;
+		return 1;
+	}
+	return 0;
+}
+
 static int
 lc_dump_cache(DB_ENV *dbenv, int needlock)
 {
@@ -200,7 +328,8 @@ lc_dump_cache(DB_ENV *dbenv, int needlock)
 		e = &dbenv->lc_cache.ent[ent];
 		if (e->txnid) {
 			logmsg(LOGMSG_USER, "%x ", e->txnid);
-			logmsg(LOGMSG_USER, "mem %d ", e->lc.memused);
+			logmsg(LOGMSG_USER, "mem %d%s ", e->lc.memused,
+			    e->spilled ? " spilled" : "");
 			for (int i = 0; i < e->lc.nlsns; i++) {
 				logmsg(LOGMSG_USER, PR_LSN " (%d) ",
 				    PARM_LSN(e->lc.array[i].lsn),
@@ -228,6 +357,21 @@ __lc_cache_feed(DB_ENV *dbenv, DB_LSN lsn, DBT dbt)
 	DB_LSN prevlsn;
 	uint8_t *logrec;
 
+	/* Cache records the way the apply code reads them. */
+	if (__log_is_compressed(&dbt)) {
+		void *buf = NULL;
+		u_int32_t buflen = 0;
+
+		if (__log_uncompress(dbenv, &dbt, &buf, &buflen, &dbt.size) == 0) {
+			dbt.data = buf;
+			ret = __lc_cache_feed(dbenv, lsn, dbt);
+		} else
+			ret = 0;
+		if (buf != NULL)
+			__os_free(dbenv, buf);
+		return ret;
+	}
+
 	Pthread_mutex_lock(&dbenv->lc_cache.lk);
 
 	logrec = dbt.data;
@@ -319,8 +463,8 @@ __lc_cache_feed(DB_ENV *dbenv, DB_LSN lsn, DBT dbt)
 			    log_compare(&e->lc.array[e->lc.nlsns - 1].lsn,
 				&e->last_seen_lsn));
 
-			listc_rfl(&dbenv->lc_cache.lru, e);
-			free_ent(dbenv, e);
+			lc_drop_ent(dbenv, e);
+			dbenv->lc_cache.drops++;
 			ret = 0;
 			goto err;
 		} else {
@@ -328,40 +472,15 @@ __lc_cache_feed(DB_ENV *dbenv, DB_LSN lsn, DBT dbt)
 			 * transaction's log, which happens below. */
 			if (type != DB___txn_child) {
 				/* all is well, append to lsn collection */
-				if ((dbenv->attr.cache_lc_memlimit &&
-					dbenv->lc_cache.memused + dbt.size >
-					dbenv->attr.cache_lc_memlimit) ||
-				    (dbenv->attr.cache_lc_memlimit_tran &&
-					e->lc.memused + dbt.size >
-					dbenv->attr.cache_lc_memlimit_tran)) {
-					listc_rfl(&dbenv->lc_cache.lru, e);
-					free_ent(dbenv, e);
-					if (dbenv->attr.cache_lc_debug ||
-					    dbenv->attr.
-					    cache_lc_trace_evictions) {
-						logmsg(LOGMSG_USER, 
-                            "total lc cache %d (limit %d) tran %d  (limit %d) next %d\n",
-						    dbenv->lc_cache.memused,
-						    dbenv->attr.
-						    cache_lc_memlimit,
-						    e->lc.memused,
-						    dbenv->attr.
-						    cache_lc_memlimit_tran,
-						    dbt.size);
-					}
+				if (lc_add_rec(dbenv, e, lsn, &dbt) != 0) {
 					ret = 0;
 					goto err;
 				}
-
-				ret =
-				    lsn_collection_add(dbenv, &e->lc, lsn,
-				    &dbt);
 				if (dbenv->attr.cache_lc_debug)
 					logmsg(LOGMSG_USER, ">> txnid %x got lsn " PR_LSN
-					    ", appending to cache ret %d\n",
-					    txnid, PARM_LSN(lsn), ret);
-				if (ret)
-					goto err;
+					    ", appending to cache%s\n", txnid,
+					    PARM_LSN(lsn),
+					    e->spilled ? " (spilled)" : "");
 			}
 			e->last_seen_lsn = lsn;
 		}
@@ -371,23 +490,6 @@ __lc_cache_feed(DB_ENV *dbenv, DB_LSN lsn, DBT dbt)
 		__rep_classify_type(type, &e->lc.had_serializable_records);
 	}
 	if (e == NULL) {
-		if ((dbenv->attr.cache_lc_memlimit &&
-			dbenv->lc_cache.memused + dbt.size >
-			dbenv->attr.cache_lc_memlimit) ||
-		    (dbenv->attr.cache_lc_memlimit_tran &&
-			dbt.size > dbenv->attr.cache_lc_memlimit_tran)) {
-			if (dbenv->attr.cache_lc_debug) {
-				logmsg(LOGMSG_USER, 
-                    "total lc cache %d (limit %d) tran 0 (limit %d) next %d\n",
-				    dbenv->lc_cache.memused,
-				    dbenv->attr.cache_lc_memlimit,
-				    dbenv->attr.cache_lc_memlimit_tran,
-				    dbt.size);
-			}
-			ret = 0;
-			goto err;
-		}
-
 		if (dbenv->attr.cache_lc_debug)
 			logmsg(LOGMSG_USER, ">> didn't find txnid %x\n", txnid);
 		/* We didn't find it.  If it's a first record for a transaction, add to cache */
@@ -406,6 +508,7 @@ __lc_cache_feed(DB_ENV *dbenv, DB_LSN lsn, DBT dbt)
 					    txnid);
 				e = listc_rtl(&dbenv->lc_cache.lru);
 				free_ent(dbenv, e);
+				dbenv->lc_cache.evictions++;
 				e = listc_rtl(&dbenv->lc_cache.avail);
 			}
 			if (e == NULL) {
@@ -416,20 +519,11 @@ __lc_cache_feed(DB_ENV *dbenv, DB_LSN lsn, DBT dbt)
 			}
 			e->txnid = txnid;
 			e->last_seen_lsn = lsn;
+			listc_abl(&dbenv->lc_cache.lru, e);
+			hash_add(dbenv->lc_cache.txnid_hash, e);
 
 			if (type != DB___txn_child) {
-				ret =
-				    lsn_collection_add(dbenv, &e->lc, lsn,
-				    &dbt);
-
-				if (ret) {
-					if (dbenv->attr.cache_lc_debug)
-						logmsg(LOGMSG_USER, ">> txnid %x new transaction added to cache ret %d\n",
-						    txnid, ret);
-
-					/* don't leak if we can't add to collection - not likely to happen */
-					free_ent(dbenv, e);
-					listc_abl(&dbenv->lc_cache.avail, e);
+				if (lc_add_rec(dbenv, e, lsn, &dbt) != 0) {
 					ret = 0;
 					goto err;
 				}
@@ -437,11 +531,9 @@ __lc_cache_feed(DB_ENV *dbenv, DB_LSN lsn, DBT dbt)
 				    &e->lc.had_serializable_records);
 
 				if (dbenv->attr.cache_lc_debug)
-					logmsg(LOGMSG_USER, ">> txnid %x new transaction added to cache ret %d\n",
-					    txnid, ret);
+					logmsg(LOGMSG_USER, ">> txnid %x new transaction added to cache\n",
+					    txnid);
 			}
-			listc_abl(&dbenv->lc_cache.lru, e);
-			hash_add(dbenv->lc_cache.txnid_hash, e);
 		} else {
 			if (dbenv->attr.cache_lc_debug ||
 			    dbenv->attr.cache_lc_trace_misses)
@@ -486,17 +578,6 @@ __lc_cache_feed(DB_ENV *dbenv, DB_LSN lsn, DBT dbt)
 					logmsg(LOGMSG_USER, "found child txn %x\n",
 					    ce->txnid);
 
-				if (dbenv->attr.cache_lc_memlimit &&
-				    e->lc.memused + ce->lc.memused >
-				    dbenv->attr.cache_lc_memlimit) {
-					listc_rfl(&dbenv->lc_cache.lru, e);
-					free_ent(dbenv, e);
-					listc_rfl(&dbenv->lc_cache.lru, ce);
-					free_ent(dbenv, ce);
-					ret = 0;
-					goto err;
-				}
-
 				/* We don't want to reallocate any of those log records - just move over
 				 * the LSN_COLLECTION pointers. */
 				if ((ret =
@@ -507,10 +588,9 @@ __lc_cache_feed(DB_ENV *dbenv, DB_LSN lsn, DBT dbt)
 						    ce->txnid, txnid);
 
 					/* get rid of child and parent in this unlikely case */
-					listc_rfl(&dbenv->lc_cache.lru, e);
-					free_ent(dbenv, e);
-					listc_rfl(&dbenv->lc_cache.lru, ce);
-					free_ent(dbenv, ce);
+					lc_drop_ent(dbenv, e);
+					lc_drop_ent(dbenv, ce);
+					dbenv->lc_cache.drops += 2;
 					ret = 0;
 					goto err;
 				}
@@ -518,8 +598,17 @@ __lc_cache_feed(DB_ENV *dbenv, DB_LSN lsn, DBT dbt)
 				/* We're done with the child. Zap the child's nlsns so free_ent doesn't free it
 				 * since we now have pointers to it inside the parent. */
 				ce->lc.nlsns = 0;
-				listc_rfl(&dbenv->lc_cache.lru, ce);
-				free_ent(dbenv, ce);
+				lc_drop_ent(dbenv, ce);
+
+				/* The child's records may take the parent over its limit. */
+				if (e->spilled || LC_OVER_TRAN_LIMIT(dbenv, e, 0))
+					lc_spill_ent(dbenv, e);
+				if (LC_OVER_TRAN_LIMIT(dbenv, e, 0)) {
+					lc_drop_ent(dbenv, e);
+					dbenv->lc_cache.drops++;
+					ret = 0;
+					goto err;
+				}
 				break;
 			}
 		}
@@ -529,8 +618,8 @@ __lc_cache_feed(DB_ENV *dbenv, DB_LSN lsn, DBT dbt)
 				logmsg(LOGMSG_USER, "didn't find child, removed parent\n");
 
 			/* If we didn't find the child, we can't continue caching the parent, get rid of it. */
-			listc_rfl(&dbenv->lc_cache.lru, e);
-			free_ent(dbenv, e);
+			lc_drop_ent(dbenv, e);
+			dbenv->lc_cache.drops++;
 			ret = 0;
 			goto err;
 		}
@@ -582,6 +671,9 @@ __lc_cache_get(DB_ENV *dbenv, DB_LSN *lsnp, LSN_COLLECTION * lcout,
 				logmsg(LOGMSG_USER, "matched " PR_LSN " txn %x\n",
 				    PARM_LSNP(lsnp), e->txnid);
 
+			if (e->spilled)
+				dbenv->lc_cache.spilled_hits++;
+
 			*lcout = e->lc;
 			/* lcout now has a copy of lc which must be freed by the caller. */
 			e->lc.nlsns = 0;
@@ -590,6 +682,7 @@ __lc_cache_get(DB_ENV *dbenv, DB_LSN *lsnp, LSN_COLLECTION * lcout,
 
 			e->lc.had_serializable_records = 0;
 			e->txnid = 0;
+			e->spilled = 0;
 			// printf("%d %d\n", dbenv->lc_cache.memused, e->lc.memused);
 			dbenv->lc_cache.memused -= e->lc.memused;
 			e->lc.memused = 0;
@@ -625,3 +718,37 @@ __lc_cache_stat(DB_ENV *dbenv)
 {
 	lc_dump_cache(dbenv, 1);
 }
+
+// PUBLIC: void __lc_cache_get_stat __P((DB_ENV *, DB_LC_CACHE_STAT *));
+void
+__lc_cache_get_stat(DB_ENV *dbenv, DB_LC_CACHE_STAT *st)
+{
+	LC_CACHE *lcc;
+	LC_CACHE_ENTRY *e;
+	REP *rep;
+
+	lcc = &dbenv->lc_cache;
+	memset(st, 0, sizeof(*st));
+
+	/* Hits and misses are counted by the collector in rep_record.c. */
+	if (REP_ON(dbenv)) {
+		rep = ((DB_REP *)dbenv->rep_handle)->region;
+		st->st_hits = rep->stat.lc_cache_hits;
+		st->st_misses = rep->stat.lc_cache_misses;
+	}
+
+	Pthread_mutex_lock(&lcc->lk);
+	LISTC_FOR_EACH(&lcc->lru, e, lnk) {
+		st->st_txns++;
+		if (e->spilled)
+			st->st_spilled_txns++;
+		if (e->lc.memused > st->st_largest_txn)
+			st->st_largest_txn = e->lc.memused;
+	}
+	st->st_memused = lcc->memused;
+	st->st_spilled_hits = lcc->spilled_hits;
+	st->st_spills = lcc->spills;
+	st->st_evictions = lcc->evictions;
+	st->st_drops = lcc->drops;
+	Pthread_mutex_unlock(&lcc->lk);
+}
@@ -0,0 +1,160 @@
+/*
+   Copyright 2026 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "db_config.h"
+
+#ifndef NO_SYSTEM_INCLUDES
+#include <sys/types.h>
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#endif
+
+#include "db_int.h"
+#include "dbinc/db_page.h"
+#include "dbinc/btree.h"
+#include "dbinc/db_am.h"
+#include "dbinc/log.h"
+#include "dbinc/mp.h"
+#include "dbinc/txn.h"
+
+#include <thdpool.h>
+#include <comdb2_atomic.h>
+
+/*
+ * A replicant only applies a transaction's records once its commit
+ * arrives, and then reads every cold page it touches synchronously.  As
+ * each record is written to the log we already know which pages it will
+ * touch, so we hand them to a small pool to read in the meantime.  By the
+ * time the commit is applied the pages are usually cached.
+ *
+ * If set, prefetch the pages of incoming log records on replicants.
+ */
+int gbl_rep_prefetch = 1;
+
+int64_t gbl_rep_prefetch_recs = 0;
+int64_t gbl_rep_prefetch_pages = 0;
+int64_t gbl_rep_prefetch_dropped = 0;
+
+struct __rep_pf_job {
+	DB_ENV *dbenv;
+	int32_t fid;
+	int n;
+	db_pgno_t pgnos[1];
+};
+
+static pthread_once_t rep_prefetch_once = PTHREAD_ONCE_INIT;
+static struct thdpool *rep_prefetch_thdpool;
+
+static void
+__rep_prefetch_pool_init(void)
+{
+	rep_prefetch_thdpool = thdpool_create("repprefetch", 0);
+	thdpool_set_linger(rep_prefetch_thdpool, 10);
+	thdpool_set_minthds(rep_prefetch_thdpool, 0);
+	thdpool_set_maxthds(rep_prefetch_thdpool, 8);
+	thdpool_set_maxqueue(rep_prefetch_thdpool, 1024);
+	thdpool_set_wait(rep_prefetch_thdpool, 0);
+}
+
+/*
+ * __rep_prefetch_pages --
+ *	Thread pool work function: read a record's pages of one file.
+ */
+static void
+__rep_prefetch_pages(pool, work, thddata, op)
+	struct thdpool *pool;
+	void *work, *thddata;
+	int op;
+{
+	struct __rep_pf_job *job;
+	DB *dbp;
+	int nread;
+
+	job = work;
+	if (op == THD_RUN && __dbreg_id_to_db_prefault(job->dbenv,
+	    NULL, &dbp, job->fid, 1) == 0) {
+		if (__memp_prefetch(dbp->mpf, job->pgnos, job->n, &nread) == 0)
+			ATOMIC_ADD64(gbl_rep_prefetch_pages, nread);
+		__dbreg_prefault_complete(job->dbenv, job->fid);
+	}
+	__os_free(job->dbenv, job);
+}
+
+/*
+ * __rep_prefetch_feed --
+ *	Queue reads for the pages an incoming log record will touch when its
+ *	transaction is applied.  Never waits: if the pool is behind, the
+ *	pages are left for apply to read.
+ *
+ * PUBLIC: void __rep_prefetch_feed __P((DB_ENV *, u_int32_t, DB_LSN *, DBT *));
+ */
+void
+__rep_prefetch_feed(dbenv, rectype, lsnp, rec)
+	DB_ENV *dbenv;
+	u_int32_t rectype;
+	DB_LSN *lsnp;
+	DBT *rec;
+{
+	struct __rep_pf_job *job;
+	LSN_PAGE *pg;
+	TXN_RECS t;
+	int32_t fid;
+	int i, j, n;
+
+	if (!__db_roll_pageop(rectype))
+		return;
+
+	memset(&t, 0, sizeof(t));
+	if (__db_dispatch(dbenv, dbenv->pgnos_dtab, dbenv->pgnos_dtab_size,
+	    rec, lsnp, DB_TXN_GETALLPGNOS, &t) != 0 || t.npages == 0)
+		goto done;
+
+	(void)pthread_once(&rep_prefetch_once, __rep_prefetch_pool_init);
+	++gbl_rep_prefetch_recs;
+
+	/* One job per file; nearly every record names only one. */
+	for (i = 0; i < t.npages; ++i) {
+		if ((fid = t.array[i].fid) == DB_LOGFILEID_INVALID)
+			continue;
+		if (__os_malloc(dbenv, sizeof(struct __rep_pf_job) +
+		    t.npages * sizeof(db_pgno_t), &job) != 0)
+			break;
+		job->dbenv = dbenv;
+		job->fid = fid;
+		for (n = 0, j = i; j < t.npages; ++j) {
+			pg = &t.array[j];
+			if (pg->fid != fid)
+				continue;
+			pg->fid = DB_LOGFILEID_INVALID;
+			/* A split names page 0 for pages it doesn't have. */
+			if (rectype == DB___bam_split && pg->pgdesc.pgno == 0)
+				continue;
+			job->pgnos[n++] = pg->pgdesc.pgno;
+		}
+		job->n = n;
+		if (n == 0 || thdpool_enqueue(rep_prefetch_thdpool,
+		    __rep_prefetch_pages, job, 0, NULL, 0) != 0) {
+			if (n != 0)
+				++gbl_rep_prefetch_dropped;
+			__os_free(dbenv, job);
+		}
+	}
+
+done:	if (t.array != NULL)
+		__os_free(dbenv, t.array);
+}
@@ -74,6 +74,8 @@ extern int gbl_reallyearly;
 extern int gbl_rep_process_txn_time;
 extern int gbl_is_physical_replicant;
 extern int gbl_dumptxn_at_commit;
+extern int gbl_rep_prefetch;
+extern int gbl_log_stream_bufsize;
 int gbl_rep_badgen_trace;
 int gbl_decoupled_logputs = 1;
 int gbl_inmem_repdb = 0;
@@ -124,6 +126,7 @@ static int __rep_dorecovery __P((DB_ENV *, DB_LSN *, DB_LSN *, int, int *));
 static int __rep_lsn_cmp __P((const void *, const void *));
 static int __rep_newfile __P((DB_ENV *, REP_CONTROL *, DB_LSN *));
 static int __rep_verify_match __P((DB_ENV *, REP_CONTROL *, time_t, int));
+static int __rep_fill_streams __P((DB_LSN *, DB_LSN *));
 void send_master_req(DB_ENV *dbenv, const char *func, int line);
 static inline void send_dupmaster(DB_ENV *dbenv, const char *func, int line);
 
@@ -964,6 +967,25 @@ done:
 
 
 
+/*
+ * __rep_fill_streams --
+ *	Whether to stream the log to send a replicant the records from start
+ *	up to end.  A streaming cursor allocates two blocks and reads a whole
+ *	one before its first record, so it only pays for itself when there's
+ *	at least a block of log to send.
+ */
+static int
+__rep_fill_streams(start, end)
+	DB_LSN *start, *end;
+{
+	if (gbl_log_stream_bufsize <= 0)
+		return (0);
+	if (end->file != start->file)
+		return (end->file > start->file);
+	return (end->offset >= start->offset &&
+	    end->offset - start->offset >= (u_int32_t)gbl_log_stream_bufsize);
+}
+
 /*
  * __rep_process_message --
  *
@@ -1372,8 +1394,14 @@ skip:				/*
 			goto errlock;
 		/* A confused replicant can send a request
 		 * for an invalid log record, and cause the master
-		 * to panic.  Don't let that happen. */
-		F_SET(logc, DB_LOG_NO_PANIC);
+		 * to panic.  Don't let that happen.  Send records as they're
+		 * stored so the replicant's log matches ours. */
+		F_SET(logc, DB_LOG_NO_PANIC | DB_LOG_RAW);
+		R_LOCK(dbenv, &dblp->reginfo);
+		endlsn = lp->lsn;
+		R_UNLOCK(dbenv, &dblp->reginfo);
+		if (__rep_fill_streams(&rp->lsn, &endlsn))
+			F_SET(logc, DB_LOG_STREAM);
 		memset(&data_dbt, 0, sizeof(data_dbt));
 		oldfilelsn = lsn = rp->lsn;
 
@@ -1623,7 +1651,10 @@ more:
 		fromline = __LINE__;
 		if ((ret = __log_cursor(dbenv, &logc)) != 0)
 			goto errlock;
-		F_SET(logc, DB_LOG_NO_PANIC);
+		F_SET(logc, DB_LOG_NO_PANIC | DB_LOG_RAW);
+		if (rec != NULL && rec->size != 0 &&
+		    __rep_fill_streams(&rp->lsn, (DB_LSN *)rec->data))
+			F_SET(logc, DB_LOG_STREAM);
 		memset(&data_dbt, 0, sizeof(data_dbt));
 		ret = __log_c_get(logc, &rp->lsn, &data_dbt, DB_SET);
 		int resp_rc;
@@ -3083,6 +3114,9 @@ __rep_apply_int(dbenv, rp, rec, ret_lsnp, commit_gen, decoupled)
 
 			if (dbenv->attr.cache_lc)
 				__lc_cache_feed(dbenv, rp->lsn, *rec);
+
+			if (ret == 0 && gbl_rep_prefetch)
+				__rep_prefetch_feed(dbenv, rectype, &rp->lsn, rec);
 		}
 
 		/*
@@ -3162,6 +3196,10 @@ gap_check:		max_lsn_dbtp = NULL;
 				if (dbenv->attr.cache_lc)
 					__lc_cache_feed(dbenv, rp->lsn, *rec);
 
+				if (ret == 0 && gbl_rep_prefetch)
+					__rep_prefetch_feed(dbenv, rectype,
+					    &rp->lsn, rec);
+
 			} else {
 				/* this will flush in-memory buffer, but we don't have the region lock for it;
 				 * get it here */
@@ -3836,17 +3874,103 @@ size_t __dbenv_get_log_header_size(DB_ENV* dbenv)
 // TODO(NC): rename it to lockerid
 u_int32_t gbl_rep_lockid;
 
+/*
+ * __rep_worker_apply --
+ *	Apply one record of a transaction, reading it from the log if it
+ *	wasn't kept.  The caller owns the log cursor and its buffer.
+ */
+static void
+__rep_worker_apply(rp, rr, logcp, tmpdbt)
+	struct __recovery_processor *rp;
+	struct __recovery_record *rr;
+	DB_LOGC **logcp;
+	DBT *tmpdbt;
+{
+	DB_ENV *dbenv;
+	u_int32_t rectype;
+	int rc;
+
+	dbenv = rp->dbenv;
+
+	if (rr->logdbt.data == NULL) {
+		if (*logcp == NULL) {
+			if (__log_cursor(dbenv, logcp)) {
+				__db_err(dbenv,
+					"worker can't get log cursor while processing %u:%u\n",
+					rr->lsn.file, rr->lsn.offset);
+				abort();
+			}
+			bzero(tmpdbt, sizeof(DBT));
+			tmpdbt->flags = DB_DBT_REALLOC;
+		}
+		if ((rc = __log_c_get(*logcp, &rr->lsn, tmpdbt, DB_SET))) {
+			__db_err(dbenv, "worker can't get lsn %u:%u\n",
+				rr->lsn.file, rr->lsn.offset);
+			abort();
+		}
+		LOGCOPY_32(&rectype, tmpdbt->data);
+		tmpdbt->app_data = &rp->context;
+
+		/* Map the txnid to the context */
+		if (dispatch_rectype(rectype)) {
+			rc = __db_dispatch(dbenv, dbenv->recover_dtab,
+				dbenv->recover_dtab_size, tmpdbt, &rr->lsn,
+				DB_TXN_APPLY, rp->txninfo);
+		} else
+			rc = 0;
+	} else {
+
+		LOGCOPY_32(&rectype, rr->logdbt.data);
+
+		rr->logdbt.app_data = &rp->context;
+		if (dispatch_rectype(rectype)) {
+			rc = __db_dispatch(dbenv, dbenv->recover_dtab,
+				dbenv->recover_dtab_size, &rr->logdbt,
+				&rr->lsn, DB_TXN_APPLY, rp->txninfo);
+		} else
+			rc = 0;
+	}
+
+	/* TODO: what do I do on an error? */
+	if (rc) {
+		__db_err(dbenv, "transaction failed at %lu:%lu rc=%d",
+			(u_long)rr->lsn.file, (u_long)rr->lsn.offset, rc);
+		/* and now? */
+		abort();
+	}
+}
+
+/*
+ * __rep_worker_close --
+ *	Release a worker's log cursor.
+ */
+static void
+__rep_worker_close(dbenv, logc, tmpdbt)
+	DB_ENV *dbenv;
+	DB_LOGC *logc;
+	DBT *tmpdbt;
+{
+	int rc;
+
+	if (logc) {
+		if (tmpdbt->data)
+			free(tmpdbt->data);
+		if ((rc = __log_c_close(logc))) {
+			__db_err(dbenv, "__log_c_close rc %d\n", rc);
+			abort();
+		}
+	}
+}
+
 static void
 worker_thd(struct thdpool *pool, void *work, void *thddata, int op)
 {
 	struct __recovery_processor *rp;
 	struct __recovery_queue *rq;
 	struct __recovery_record *rr;
-	int rc;
 	DB_ENV *dbenv;
 	DB_LOGC *logc = NULL;
 	DBT tmpdbt;
-	u_int32_t rectype;
 	int recnum = 0;
 	LISTC_T(struct recovery_record) q;
 
@@ -3863,53 +3987,7 @@ worker_thd(struct thdpool *pool, void *work, void *thddata, int op)
 
 	while (rr) {
 		recnum++;
-		if (rr->logdbt.data == NULL) {
-			if (logc == NULL) {
-				if (__log_cursor(dbenv, &logc)) {
-					__db_err(dbenv,
-						"worker can't get log cursor while processing %u:%u\n",
-						rr->lsn.file, rr->lsn.offset);
-					abort();
-				}
-				bzero(&tmpdbt, sizeof(DBT));
-				tmpdbt.flags = DB_DBT_REALLOC;
-			}
-			if ((rc = __log_c_get(logc, &rr->lsn, &tmpdbt, DB_SET))) {
-				__db_err(dbenv, "worker can't get lsn %u:%u\n",
-					rr->lsn.file, rr->lsn.offset);
-				abort();
-			}
-			LOGCOPY_32(&rectype, tmpdbt.data);
-			tmpdbt.app_data = &rp->context;
-
-			/* Map the txnid to the context */
-			if (dispatch_rectype(rectype)) {
-				rc = __db_dispatch(dbenv, dbenv->recover_dtab,
-					dbenv->recover_dtab_size, &tmpdbt, &rr->lsn,
-					DB_TXN_APPLY, rq->processor->txninfo);
-			} else
-				rc = 0;
-		} else {
-
-			LOGCOPY_32(&rectype, rr->logdbt.data);
-
-			rr->logdbt.app_data = &rp->context;
-			if (dispatch_rectype(rectype)) {
-				rc = __db_dispatch(dbenv, dbenv->recover_dtab,
-					dbenv->recover_dtab_size, &rr->logdbt,
-					&rr->lsn, DB_TXN_APPLY,
-					rq->processor->txninfo);
-			} else
-				rc = 0;
-		}
-
-		/* TODO: what do I do on an error? */
-		if (rc) {
-			__db_err(dbenv, "transaction failed at %lu:%lu rc=%d",
-				(u_long)rr->lsn.file, (u_long)rr->lsn.offset, rc);
-			/* and now? */
-			abort();
-		}
+		__rep_worker_apply(rp, rr, &logc, &tmpdbt);
 
 		/* mempool? */
 		listc_abl(&q, rr);
@@ -3917,14 +3995,7 @@ worker_thd(struct thdpool *pool, void *work, void *thddata, int op)
 		rr = listc_rtl(&rq->records);
 	}
 
-	if (logc) {
-		if (tmpdbt.data)
-			free(tmpdbt.data);
-		if ((rc = __log_c_close(logc))) {
-			__db_err(dbenv, "__log_c_close rc %d\n", rc);
-			abort();
-		}
-	}
+	__rep_worker_close(dbenv, logc, &tmpdbt);
 
 	Pthread_mutex_lock(&rq->processor->lk);
 	rr = listc_rtl(&q);
@@ -3996,6 +4067,465 @@ logical_record_file_affinity(int rectype)
 	}
 }
 
+/*
+ * Page scheduling.  Each file queue below applies its records one after
+ * the other on a single worker, so a big transaction on one hot table
+ * applies serially.  Transactions of at least this many records are
+ * scheduled by page instead:
+ *
+ * - A record that only redoes the pages it names waits only for the
+ *   previous record on each of those pages.
+ * - Any other record is a barrier for its file queue.  It waits for
+ *   every earlier record in the queue, and every later record waits
+ *   for it, just as the queue would have ordered them.
+ *
+ * Records on different pages of the same file then apply at the same
+ * time.  0 turns page scheduling off.
+ */
+int gbl_rep_apply_page_dag = 16;
+
+int64_t gbl_rep_trans_page_dag = 0;
+
+struct __rep_dag_node {
+	struct __recovery_record *rr;
+	u_int32_t ndeps;		/* Predecessors not yet applied. */
+	u_int32_t succ;			/* First successor in dag->succ. */
+	u_int32_t nsucc;
+	u_int32_t flink;		/* Next in file since its barrier. */
+	u_int32_t edge;			/* First of our edges while building. */
+};
+
+struct __rep_dag_page {
+	int32_t fid;
+	db_pgno_t pgno;
+	u_int32_t last;			/* Last record on the page. */
+};
+
+struct __rep_dag_edge {
+	u_int32_t from, to;
+};
+
+#define	DAG_NONE	UINT32_MAX
+
+struct __rep_dag {
+	struct __recovery_processor *rp;
+	struct __rep_dag_node *nodes;
+	u_int32_t nnodes;
+	u_int32_t *succ;		/* Successor lists, by node. */
+	u_int32_t *ready;		/* Nodes ready to apply, in order. */
+	u_int32_t rhead, rtail;
+	int maxworkers;
+
+	/* Only while building. */
+	TXN_RECS t;
+	struct __rep_dag_edge *edges;
+	u_int32_t nedges, nedges_alloc;
+	struct __rep_dag_page *pages;	/* Open addressed by fid and pgno. */
+	u_int32_t npages, npages_alloc;
+	u_int32_t *fbarrier;		/* Last barrier, by file queue. */
+	u_int32_t *fsince;		/* Records after it, by file queue. */
+	int nfiles;
+};
+
+static int
+__rep_dag_create(dbenv, rp, dagp)
+	DB_ENV *dbenv;
+	struct __recovery_processor *rp;
+	struct __rep_dag **dagp;
+{
+	struct __rep_dag *dag;
+	u_int32_t n;
+	int ret;
+
+	n = rp->lc.nlsns;
+	if ((ret = __os_calloc(dbenv, 1, sizeof(*dag), &dag)) != 0)
+		return (ret);
+	dag->rp = rp;
+	dag->maxworkers = dbenv->num_recovery_worker_threads + 1;
+	for (dag->npages_alloc = 64;
+	    dag->npages_alloc < 4 * n; dag->npages_alloc <<= 1)
+		;
+	if ((ret = __os_malloc(dbenv,
+	    n * sizeof(struct __rep_dag_node), &dag->nodes)) != 0 ||
+	    (ret = __os_malloc(dbenv,
+	    n * sizeof(u_int32_t), &dag->ready)) != 0 ||
+	    (ret = __os_malloc(dbenv, dag->npages_alloc *
+	    sizeof(struct __rep_dag_page), &dag->pages)) != 0)
+		goto err;
+	memset(dag->pages, 0xff,
+	    dag->npages_alloc * sizeof(struct __rep_dag_page));
+	*dagp = dag;
+	return (0);
+
+err:	if (dag->nodes != NULL)
+		__os_free(dbenv, dag->nodes);
+	if (dag->ready != NULL)
+		__os_free(dbenv, dag->ready);
+	__os_free(dbenv, dag);
+	return (ret);
+}
+
+static void
+__rep_dag_destroy(dbenv, dag)
+	DB_ENV *dbenv;
+	struct __rep_dag *dag;
+{
+	if (dag->t.array != NULL)
+		__os_free(dbenv, dag->t.array);
+	if (dag->edges != NULL)
+		__os_free(dbenv, dag->edges);
+	if (dag->fbarrier != NULL)
+		__os_free(dbenv, dag->fbarrier);
+	if (dag->fsince != NULL)
+		__os_free(dbenv, dag->fsince);
+	if (dag->succ != NULL)
+		__os_free(dbenv, dag->succ);
+	__os_free(dbenv, dag->pages);
+	__os_free(dbenv, dag->ready);
+	__os_free(dbenv, dag->nodes);
+	__os_free(dbenv, dag);
+}
+
+/*
+ * __rep_dag_dep --
+ *	Make a record wait for an earlier one.
+ */
+static int
+__rep_dag_dep(dbenv, dag, from, to)
+	DB_ENV *dbenv;
+	struct __rep_dag *dag;
+	u_int32_t from, to;
+{
+	u_int32_t i;
+	int ret;
+
+	if (from == DAG_NONE)
+		return (0);
+	for (i = dag->nodes[to].edge; i < dag->nedges; ++i)
+		if (dag->edges[i].from == from)
+			return (0);
+	if (dag->nedges == dag->nedges_alloc) {
+		dag->nedges_alloc = dag->nedges_alloc ?
+		    dag->nedges_alloc * 2 : 2 * dag->rp->lc.nlsns;
+		if ((ret = __os_realloc(dbenv, dag->nedges_alloc *
+		    sizeof(struct __rep_dag_edge), &dag->edges)) != 0)
+			return (ret);
+	}
+	dag->edges[dag->nedges].from = from;
+	dag->edges[dag->nedges].to = to;
+	++dag->nedges;
+	++dag->nodes[to].ndeps;
+	return (0);
+}
+
+static inline u_int32_t
+__rep_dag_hash(fid, pgno)
+	int32_t fid;
+	db_pgno_t pgno;
+{
+	return (((u_int32_t)fid * 0x9e3779b1U) ^ (pgno * 2654435761U));
+}
+
+/*
+ * __rep_dag_page --
+ *	Return the slot for a page, adding it if it's new.
+ */
+static int
+__rep_dag_page(dbenv, dag, fid, pgno, pp)
+	DB_ENV *dbenv;
+	struct __rep_dag *dag;
+	int32_t fid;
+	db_pgno_t pgno;
+	struct __rep_dag_page **pp;
+{
+	struct __rep_dag_page *old, *p;
+	u_int32_t i, mask, nold;
+	int ret;
+
+	if (2 * (dag->npages + 1) > dag->npages_alloc) {
+		old = dag->pages;
+		nold = dag->npages_alloc;
+		if ((ret = __os_malloc(dbenv, 2 * nold *
+		    sizeof(struct __rep_dag_page), &dag->pages)) != 0) {
+			dag->pages = old;
+			return (ret);
+		}
+		dag->npages_alloc = 2 * nold;
+		memset(dag->pages, 0xff,
+		    dag->npages_alloc * sizeof(struct __rep_dag_page));
+		dag->npages = 0;
+		for (i = 0; i < nold; ++i)
+			if (old[i].last != DAG_NONE) {
+				(void)__rep_dag_page(dbenv,
+				    dag, old[i].fid, old[i].pgno, &p);
+				p->last = old[i].last;
+			}
+		__os_free(dbenv, old);
+	}
+
+	mask = dag->npages_alloc - 1;
+	for (i = __rep_dag_hash(fid, pgno) & mask;; i = (i + 1) & mask) {
+		p = &dag->pages[i];
+		if (p->last == DAG_NONE) {
+			p->fid = fid;
+			p->pgno = pgno;
+			++dag->npages;
+			break;
+		}
+		if (p->fid == fid && p->pgno == pgno)
+			break;
+	}
+	*pp = p;
+	return (0);
+}
+
+/*
+ * __rep_dag_add --
+ *	Add the next record of the transaction, which belongs to file queue
+ *	fileid.
+ */
+static int
+__rep_dag_add(dbenv, dag, rr, rectype, rec)
+	DB_ENV *dbenv;
+	struct __rep_dag *dag;
+	struct __recovery_record *rr;
+	u_int32_t rectype;
+	DBT *rec;
+{
+	struct __rep_dag_node *node;
+	struct __rep_dag_page *p;
+	LSN_PAGE *pg;
+	u_int32_t n, s;
+	int f, i, ret;
+
+	n = dag->nnodes++;
+	node = &dag->nodes[n];
+	node->rr = rr;
+	node->ndeps = 0;
+	node->nsucc = 0;
+	node->flink = DAG_NONE;
+	node->edge = dag->nedges;
+
+	f = rr->fileid;
+	if (f >= dag->nfiles) {
+		if ((ret = __os_realloc(dbenv,
+		    (f + 1) * sizeof(u_int32_t), &dag->fbarrier)) != 0 ||
+		    (ret = __os_realloc(dbenv,
+		    (f + 1) * sizeof(u_int32_t), &dag->fsince)) != 0)
+			return (ret);
+		for (i = dag->nfiles; i <= f; ++i)
+			dag->fbarrier[i] = dag->fsince[i] = DAG_NONE;
+		dag->nfiles = f + 1;
+	}
+
+	/* Find the pages if the record only touches the pages it names. */
+	dag->t.npages = 0;
+	if (__db_roll_pageop(rectype) &&
+	    __db_dispatch(dbenv, dbenv->pgnos_dtab, dbenv->pgnos_dtab_size,
+	    rec, &rr->lsn, DB_TXN_GETALLPGNOS, &dag->t) != 0)
+		dag->t.npages = 0;
+
+	if ((ret = __rep_dag_dep(dbenv, dag, dag->fbarrier[f], n)) != 0)
+		return (ret);
+
+	if (dag->t.npages == 0) {
+		/* A barrier for its file queue. */
+		for (s = dag->fsince[f]; s != DAG_NONE; s = dag->nodes[s].flink)
+			if ((ret = __rep_dag_dep(dbenv, dag, s, n)) != 0)
+				return (ret);
+		dag->fbarrier[f] = n;
+		dag->fsince[f] = DAG_NONE;
+		return (0);
+	}
+
+	for (i = 0; i < dag->t.npages; ++i) {
+		pg = &dag->t.array[i];
+		/*
+		 * A split that isn't of the root, or is of the last page,
+		 * logs page 0 for those; it doesn't touch the meta page.
+		 */
+		if (rectype == DB___bam_split && pg->pgdesc.pgno == 0)
+			continue;
+		if ((ret = __rep_dag_page(dbenv,
+		    dag, pg->fid, pg->pgdesc.pgno, &p)) != 0)
+			return (ret);
+		if ((ret = __rep_dag_dep(dbenv, dag, p->last, n)) != 0)
+			return (ret);
+		p->last = n;
+	}
+	node->flink = dag->fsince[f];
+	dag->fsince[f] = n;
+	return (0);
+}
+
+/*
+ * __rep_dag_finish --
+ *	Turn the edges into successor lists and queue the records that
+ *	don't wait for anything.
+ */
+static int
+__rep_dag_finish(dbenv, dag)
+	DB_ENV *dbenv;
+	struct __rep_dag *dag;
+{
+	struct __rep_dag_edge *e;
+	u_int32_t i, sum;
+	int ret;
+
+	if ((ret = __os_malloc(dbenv,
+	    (dag->nedges + 1) * sizeof(u_int32_t), &dag->succ)) != 0)
+		return (ret);
+
+	for (i = 0; i < dag->nedges; ++i)
+		++dag->nodes[dag->edges[i].from].nsucc;
+	for (sum = 0, i = 0; i < dag->nnodes; ++i) {
+		dag->nodes[i].succ = sum;
+		sum += dag->nodes[i].nsucc;
+		dag->nodes[i].nsucc = 0;
+	}
+	for (i = 0; i < dag->nedges; ++i) {
+		e = &dag->edges[i];
+		dag->succ[dag->nodes[e->from].succ +
+		    dag->nodes[e->from].nsucc++] = e->to;
+	}
+
+	for (i = 0; i < dag->nnodes; ++i)
+		if (dag->nodes[i].ndeps == 0)
+			dag->ready[dag->rtail++] = i;
+	return (0);
+}
+
+/*
+ * __rep_queue_record --
+ *	Add a record to the queue for its file, and the queue to queues if
+ *	this is its first record.
+ */
+static void
+__rep_queue_record(rp, queues, rr)
+	struct __recovery_processor *rp;
+	void *queues;
+	struct __recovery_record *rr;
+{
+	int fileid, j;
+
+	fileid = rr->fileid;
+	if (fileid >= rp->num_fileids) {
+		rp->recovery_queues =
+			realloc(rp->recovery_queues,
+			(fileid + 1) * sizeof(struct __recovery_queue *));
+		for (j = rp->num_fileids; j <= fileid; j++) {
+			rp->recovery_queues[j] = NULL;
+		}
+		rp->num_fileids = fileid + 1;
+	}
+	if (rp->recovery_queues[fileid] == NULL) {
+		rp->recovery_queues[fileid] =
+			malloc(sizeof(struct __recovery_queue));
+		rp->recovery_queues[fileid]->fileid = fileid;
+		rp->recovery_queues[fileid]->processor = rp;
+		rp->recovery_queues[fileid]->used = 0;
+		listc_init(&rp->recovery_queues[fileid]->records,
+			offsetof(struct __recovery_record, lnk));
+	}
+	if (!rp->recovery_queues[fileid]->used) {
+		rp->recovery_queues[fileid]->used = 1;
+		rp->num_busy_workers++;
+		listc_abl(queues, rp->recovery_queues[fileid]);
+	}
+
+	listc_abl(&rp->recovery_queues[fileid]->records, rr);
+}
+
+/*
+ * __rep_dag_unschedule --
+ *	Give up scheduling a transaction by page, after failing to build
+ *	its dag with error ret: put every record added so far on its file's
+ *	queue, in log order, and free the dag.
+ */
+static void
+__rep_dag_unschedule(dbenv, dag, queues, ret)
+	DB_ENV *dbenv;
+	struct __rep_dag *dag;
+	void *queues;
+	int ret;
+{
+	u_int32_t i;
+
+	logmsg(LOGMSG_WARN, "%s: can't schedule txn by page, rc %d; "
+	    "applying it by file\n", __func__, ret);
+	for (i = 0; i < dag->nnodes; ++i)
+		__rep_queue_record(dag->rp, queues, dag->nodes[i].rr);
+	__rep_dag_destroy(dbenv, dag);
+}
+
+static void dag_worker_thd(struct thdpool *, void *, void *, int);
+
+/*
+ * __rep_dag_run --
+ *	Apply records as they become ready until there are none, asking
+ *	for more workers while there's more ready than we can take.  The
+ *	caller has counted us in num_busy_workers.
+ */
+static void
+__rep_dag_run(dag, pool)
+	struct __rep_dag *dag;
+	struct thdpool *pool;
+{
+	struct __recovery_processor *rp;
+	struct __rep_dag_node *node;
+	DB_ENV *dbenv;
+	DB_LOGC *logc = NULL;
+	DBT tmpdbt;
+	u_int32_t i;
+	int nspawn;
+
+	rp = dag->rp;
+	dbenv = rp->dbenv;
+
+	Pthread_mutex_lock(&rp->lk);
+	while (dag->rhead != dag->rtail) {
+		node = &dag->nodes[dag->ready[dag->rhead++]];
+
+		nspawn = dag->rtail - dag->rhead;
+		if (nspawn > dag->maxworkers - rp->num_busy_workers)
+			nspawn = dag->maxworkers - rp->num_busy_workers;
+		if (nspawn > 0)
+			rp->num_busy_workers += nspawn;
+		Pthread_mutex_unlock(&rp->lk);
+
+		for (; nspawn > 0; --nspawn)
+			if (thdpool_enqueue(dbenv->recovery_workers,
+			    dag_worker_thd, dag, 0, NULL, 0) != 0) {
+				Pthread_mutex_lock(&rp->lk);
+				rp->num_busy_workers--;
+				Pthread_mutex_unlock(&rp->lk);
+			}
+
+		__rep_worker_apply(rp, node->rr, &logc, &tmpdbt);
+
+		Pthread_mutex_lock(&rp->lk);
+		pool_relablk(rp->recpool, node->rr);
+		for (i = 0; i < node->nsucc; ++i)
+			if (--dag->nodes[dag->succ[node->succ + i]].ndeps == 0)
+				dag->ready[dag->rtail++] =
+				    dag->succ[node->succ + i];
+	}
+	rp->num_busy_workers--;
+
+	/* Signal if not running inline */
+	if (pool)
+		Pthread_cond_signal(&rp->wait);
+	Pthread_mutex_unlock(&rp->lk);
+
+	__rep_worker_close(dbenv, logc, &tmpdbt);
+}
+
+static void
+dag_worker_thd(struct thdpool *pool, void *work, void *thddata, int op)
+{
+	__rep_dag_run((struct __rep_dag *)work, pool);
+}
+
 #include <stdlib.h>
 
 int gbl_processor_thd_poll;
@@ -4015,8 +4545,8 @@ processor_thd(struct thdpool *pool, void *work, void *thddata, int op)
 	DB_ENV *dbenv;
 	int ret, t_ret = 0, last_fileid = -1;
 	DB_LSN *lsnp;
-	int j;
 	LISTC_T(struct __recovery_queue) queues;
+	struct __rep_dag *dag = NULL;
 
 	DB_REP *db_rep;
 	REP *rep;
@@ -4100,6 +4630,13 @@ processor_thd(struct thdpool *pool, void *work, void *thddata, int op)
 	if ((ret = __log_cursor(dbenv, &logc)) != 0)
 		goto err;
 
+	/* Big enough transactions are scheduled by page. */
+	if (gbl_rep_apply_page_dag > 0 &&
+		rp->lc.nlsns >= gbl_rep_apply_page_dag &&
+		dbenv->num_recovery_worker_threads > 0 &&
+		__rep_dag_create(dbenv, rp, &dag) != 0)
+		dag = NULL;
+
 	/* First, bucket records per queue. */
 	data_dbt.flags = DB_DBT_REALLOC;
 
@@ -4109,8 +4646,8 @@ processor_thd(struct thdpool *pool, void *work, void *thddata, int op)
 
 		lsnp = &rp->lc.array[i].lsn;
 
+		/* Large transactions may come from the cache as lsns only. */
 		if (rp->lc.array[i].rec.data == NULL) {
-			assert(!rp->lc.filled_from_cache);
 			if ((ret =
 				__log_c_get(logc, lsnp, &data_dbt,
 					DB_SET)) != 0) {
@@ -4143,30 +4680,6 @@ processor_thd(struct thdpool *pool, void *work, void *thddata, int op)
 			fileid = 0;
 		}
 
-		if (fileid >= rp->num_fileids) {
-			rp->recovery_queues =
-				realloc(rp->recovery_queues,
-				(fileid + 1) * sizeof(struct __recovery_queue *));
-			for (j = rp->num_fileids; j <= fileid; j++) {
-				rp->recovery_queues[j] = NULL;
-			}
-			rp->num_fileids = fileid + 1;
-		}
-		if (rp->recovery_queues[fileid] == NULL) {
-			rp->recovery_queues[fileid] =
-				malloc(sizeof(struct __recovery_queue));
-			rp->recovery_queues[fileid]->fileid = fileid;
-			rp->recovery_queues[fileid]->processor = rp;
-			rp->recovery_queues[fileid]->used = 0;
-			listc_init(&rp->recovery_queues[fileid]->records,
-				offsetof(struct __recovery_record, lnk));
-		}
-		if (!rp->recovery_queues[fileid]->used) {
-			rp->recovery_queues[fileid]->used = 1;
-			rp->num_busy_workers++;
-			listc_abl(&queues, rp->recovery_queues[fileid]);
-		}
-
 		rr = pool_getablk(rp->recpool);
 		if (rp->lc.array[i].rec.data)
 			rr->logdbt = rp->lc.array[i].rec;
@@ -4175,15 +4688,42 @@ processor_thd(struct thdpool *pool, void *work, void *thddata, int op)
 		rr->lsn = *lsnp;
 		rr->fileid = fileid;
 
-		listc_abl(&rp->recovery_queues[fileid]->records, rr);
+		if (dag != NULL) {
+			if ((ret = __rep_dag_add(dbenv, dag, rr, rectype,
+				rp->lc.array[i].rec.data ?
+				&rp->lc.array[i].rec : &data_dbt)) == 0)
+				continue;
+			/* This record went in with the rest. */
+			__rep_dag_unschedule(dbenv, dag, &queues, ret);
+			dag = NULL;
+			ret = 0;
+			continue;
+		}
+
+		__rep_queue_record(rp, &queues, rr);
+	}
+
+	if (dag != NULL && (ret = __rep_dag_finish(dbenv, dag)) != 0) {
+		__rep_dag_unschedule(dbenv, dag, &queues, ret);
+		dag = NULL;
+		ret = 0;
 	}
 
 	if ((dbenv->flags & DB_ENV_ROWLOCKS) && listc_size(&queues) > 1) {
 		gbl_rep_rowlocks_multifile++;
 	}
 
+	/* Start on the page schedule here; it brings in workers as needed. */
+	if (dag != NULL) {
+		gbl_rep_trans_page_dag++;
+		inline_worker = 0;
+		Pthread_mutex_lock(&rp->lk);
+		rp->num_busy_workers++;
+		Pthread_mutex_unlock(&rp->lk);
+		__rep_dag_run(dag, NULL);
+	}
 	/* Handle inline. */
-	if (listc_size(&queues) <= 1) {
+	else if (listc_size(&queues) <= 1) {
 		inline_worker = 1;
 		rq = listc_rtl(&queues);
 
@@ -4246,6 +4786,11 @@ processor_thd(struct thdpool *pool, void *work, void *thddata, int op)
 		Pthread_mutex_unlock(&rp->lk);
 	}
 
+	if (dag != NULL) {
+		__rep_dag_destroy(dbenv, dag);
+		dag = NULL;
+	}
+
 
 #if 0
 	{
@@ -4336,6 +4881,9 @@ err:
 	if (data_dbt.data)
 		free(data_dbt.data);
 
+	if (dag != NULL)
+		__rep_dag_destroy(dbenv, dag);
+
 	if (logc != NULL && (t_ret = __log_c_close(logc)) != 0 && ret == 0)
 		ret = t_ret;
 
@@ -4798,7 +5346,6 @@ __rep_process_txn_int(dbenv, rctl, rec, ltrans, maxlsn, commit_gen, lockid, rp,
 		lsnp = &lsn;
 
 		if (!lc.array[i].rec.data) {
-			assert(!lc.filled_from_cache);
 			if ((ret =
 				__log_c_get(logc, lsnp, &data_dbt,
 					DB_SET)) != 0) {
@@ -6031,7 +6578,9 @@ __rep_collect_txn_txnid(dbenv, lsnp, lc, had_serializable_records, rp, txnid)
 						bad_compare = 1;
 						break;
 					}
-					if (memcmp(checklc.array[i].rec.data,
+					/* Spilled records are read from the log anyway. */
+					if (lc->array[i].rec.data != NULL &&
+						memcmp(checklc.array[i].rec.data,
 						lc->array[i].rec.data,
 						lc->array[i].rec.size) != 0) {
 						__db_err(dbenv,
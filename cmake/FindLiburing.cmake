@@ -0,0 +1,4 @@
+find_path(LIBURING_INCLUDE_DIR NAMES liburing.h)
+find_library(LIBURING_LIBRARY NAMES uring)
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(Liburing DEFAULT_MSG LIBURING_INCLUDE_DIR LIBURING_LIBRARY)
@@ -2714,7 +2714,10 @@ enum {
                               1 << 9,
     RECFLAGS_IN_CASCADE = 1 << 10,
     RECFLAGS_DONT_LOCK_TBL = 1 << 11,
-    RECFLAGS_MAX = 1 << 11
+    /* spool the keys in the defered index table rather than adding them;
+     * used by schema changes that bulk load the new indexes at the end */
+    RECFLAGS_SPOOL_KEYS = 1 << 12,
+    RECFLAGS_MAX = 1 << 12
 };
 
 /* flag codes */
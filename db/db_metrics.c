@@ -63,6 +63,14 @@ struct comdb2_metrics_store {
     int64_t last_checkpoint_ms;
     int64_t total_checkpoint_ms;
     int64_t checkpoint_count;
+    int64_t pace_rate;
+    int64_t pace_dirty_rate;
+    int64_t pace_log_rate;
+    int64_t pace_ckp_secs;
+    int64_t pace_write_usecs;
+    int64_t pace_dirty_pct;
+    int64_t pace_pages;
+    int64_t pace_throttled;
     int64_t rcache_hits;
     int64_t rcache_misses;
     int64_t last_election_ms;
@@ -171,6 +179,30 @@ comdb2_metric gbl_metrics[] = {
      &stats.total_checkpoint_ms},
     {"checkpoint_count", "Total number of checkpoints taken", STATISTIC_INTEGER,
      STATISTIC_COLLECTION_TYPE_CUMULATIVE, &stats.checkpoint_count},
+    {"checkpoint_pace_rate", "Pages per second the writeback pacer is aiming for",
+     STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_LATEST, &stats.pace_rate,
+     NULL},
+    {"checkpoint_pace_dirty_rate", "Pages dirtied per second",
+     STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_LATEST,
+     &stats.pace_dirty_rate, NULL},
+    {"checkpoint_pace_log_rate", "Log bytes written per second",
+     STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_LATEST,
+     &stats.pace_log_rate, NULL},
+    {"checkpoint_pace_secs", "Seconds until the next checkpoint is expected",
+     STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_LATEST,
+     &stats.pace_ckp_secs, NULL},
+    {"checkpoint_pace_write_us", "Average time to write a page",
+     STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_LATEST,
+     &stats.pace_write_usecs, NULL},
+    {"checkpoint_pace_dirty_pct", "Percentage of the buffer pool that is dirty",
+     STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_LATEST,
+     &stats.pace_dirty_pct, NULL},
+    {"checkpoint_pace_pages", "Pages written by the writeback pacer",
+     STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_CUMULATIVE,
+     &stats.pace_pages, NULL},
+    {"checkpoint_pace_throttled",
+     "Pacing intervals cut short by the write time limit", STATISTIC_INTEGER,
+     STATISTIC_COLLECTION_TYPE_CUMULATIVE, &stats.pace_throttled, NULL},
     {"rcache_hits", "Count of root-page cache hits", STATISTIC_INTEGER,
      STATISTIC_COLLECTION_TYPE_CUMULATIVE, &stats.rcache_hits},
     {"rcache_misses", "Count of root-page cache misses", STATISTIC_INTEGER,
@@ -424,6 +456,14 @@ int refresh_metrics(void)
     stats.last_checkpoint_ms = gbl_last_checkpoint_ms;
     stats.total_checkpoint_ms = gbl_total_checkpoint_ms;
     stats.checkpoint_count = gbl_checkpoint_count;
+    stats.pace_rate = gbl_memp_pace_rate;
+    stats.pace_dirty_rate = gbl_memp_pace_dirty_rate;
+    stats.pace_log_rate = gbl_memp_pace_log_rate;
+    stats.pace_ckp_secs = gbl_memp_pace_ckp_secs;
+    stats.pace_write_usecs = gbl_memp_pace_write_usecs;
+    stats.pace_dirty_pct = gbl_memp_pace_dirty_pct;
+    stats.pace_pages = gbl_memp_pace_pages;
+    stats.pace_throttled = gbl_memp_pace_throttled;
     stats.rcache_hits = rcache_hits;
     stats.rcache_misses = rcache_miss;
     stats.last_election_ms = gbl_last_election_time_ms;
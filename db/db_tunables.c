@@ -91,6 +91,8 @@ extern int gbl_notimeouts;
 extern int gbl_watchdog_disable_at_start;
 extern int gbl_osql_verify_retries_max;
 extern int gbl_page_latches;
+extern int gbl_page_latches_optimistic;
+extern int gbl_deadlock_detect_incremental;
 extern int gbl_prefault_udp;
 extern int gbl_print_syntax_err;
 extern int gbl_lclpooled_buffers;
@@ -143,6 +145,18 @@ extern uint32_t gbl_max_wr_rows_per_txn;
 extern uint32_t gbl_max_cascaded_rows_per_txn;
 extern int gbl_force_serial_on_writelock;
 extern int gbl_processor_thd_poll;
+extern int gbl_bt_append_split_pct;
+extern int gbl_pgcompact_sched;
+extern int gbl_pgcompact_sched_range_pct;
+extern int gbl_pgcompact_sched_pages_per_sec;
+extern int gbl_pgcompact_sched_logbytes_per_sec;
+extern int gbl_pgcompact_sched_rescan_secs;
+extern int gbl_temptable_skiplist;
+extern int gbl_temptable_grace_hash;
+extern int gbl_rep_apply_page_dag;
+extern int gbl_rep_batch_bytes;
+extern int gbl_rep_batch_compress_bytes;
+extern int gbl_rep_prefetch;
 extern int gbl_time_rep_apply;
 extern int gbl_incoherent_logput_window;
 extern int gbl_dump_full_net_queue;
@@ -229,6 +243,8 @@ extern int gbl_snapshot_serial_verify_retry;
 extern int gbl_cache_flush_interval;
 extern int gbl_load_cache_threads;
 extern int gbl_load_cache_max_pages;
+extern int gbl_load_cache_background;
+extern int gbl_load_cache_batch;
 extern int gbl_dump_cache_max_pages;
 extern int gbl_max_pages_per_cache_thread;
 extern int gbl_memp_dump_cache_threshold;
@@ -245,7 +261,30 @@ extern int gbl_client_abort_on_slow;
 extern int gbl_max_trigger_threads;
 extern int gbl_alternate_normalize;
 extern int gbl_sc_logbytes_per_second;
+extern int gbl_sc_bulk_index_build;
+extern int gbl_sc_bulk_index_keys_per_txn;
 extern int gbl_fingerprint_max_queries;
+extern int gbl_mpool_scan_resistant;
+extern int gbl_mpool_cold_priority_pct;
+extern int gbl_mpool_promote_window;
+extern int gbl_mpool_sweep_partitions;
+extern int gbl_iouring_queue_depth;
+extern int gbl_mpool_prefetch_batch;
+extern int gbl_pageorder_readahead;
+extern int gbl_mpool_coalesce_writes;
+extern int gbl_mpool_flush_range_pages;
+extern int gbl_mpool_pace_writeback;
+extern int gbl_mpool_pace_msecs;
+extern int gbl_mpool_pace_max_io_pct;
+extern int gbl_mpool_pace_dirty_max_pct;
+extern int gbl_mpool_pace_min_pages;
+extern int gbl_region_hugepages;
+extern int gbl_mpool_numa;
+extern int gbl_mpool_ccache_mb;
+extern int gbl_group_commit_max_usecs;
+extern int gbl_group_commit_max_batch;
+extern int gbl_log_compress_threshold;
+extern int gbl_log_stream_bufsize;
 extern long long sampling_threshold;
 
 extern size_t gbl_lk_hash;
@@ -310,6 +349,7 @@ extern int set_pbkdf2_iterations(int val);
 
 #include <stdbool.h>
 extern bool gbl_rcache;
+extern int gbl_rcache_levels;
 
 static char *gbl_name = NULL;
 static int ctrace_gzip;
@@ -419,6 +459,17 @@ int percent_verify(void *unused, void *percent)
     return 0;
 }
 
+/* Splits that leave less than half the page on the left defeat the point. */
+static int bt_append_split_pct_verify(void *unused, void *percent)
+{
+    if (*(int *)percent < 50 || *(int *)percent > 100) {
+        logmsg(LOGMSG_ERROR,
+               "Invalid value for tunable; should be in range [50, 100].\n");
+        return 1;
+    }
+    return 0;
+}
+
 struct enable_sql_stmt_caching_st {
     const char *name;
     int code;
@@ -153,6 +153,11 @@ REGISTER_TUNABLE(
     "ddl_cascade_drop",
     "On DROP, also drop the dependent keys/constraints. (Default: 1)",
     TUNABLE_BOOLEAN, &gbl_ddl_cascade_drop, READONLY, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("deadlock_detect_incremental",
+                 "Skip deadlock detector passes when no waits-for edge was "
+                 "added since the last pass found nothing. (Default: on)",
+                 TUNABLE_BOOLEAN, &gbl_deadlock_detect_incremental, NOARG, NULL,
+                 NULL, NULL, NULL);
 REGISTER_TUNABLE("deadlock_policy_override", NULL, TUNABLE_INTEGER,
                  &gbl_deadlock_policy_override, READONLY, NULL, NULL,
                  deadlock_policy_override_update, NULL);
@@ -487,6 +492,16 @@ REGISTER_TUNABLE("goslow", NULL, TUNABLE_BOOLEAN, &gbl_goslow, NOARG, NULL,
                  NULL, NULL, NULL);
 REGISTER_TUNABLE("gofast", NULL, TUNABLE_BOOLEAN, &gbl_goslow,
                  INVERSE_VALUE | NOARG, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("group_commit_max_usecs",
+                 "Longest a log flush waits for more commits to join it; 0 "
+                 "disables waiting.  (Default: 1000)",
+                 TUNABLE_INTEGER, &gbl_group_commit_max_usecs, 0, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("group_commit_max_batch",
+                 "A waiting log flush starts once this many commits have "
+                 "joined it.  (Default: 64)",
+                 TUNABLE_INTEGER, &gbl_group_commit_max_batch, NOZERO, NULL,
+                 NULL, NULL, NULL);
 REGISTER_TUNABLE(
     "group_concat_memory_limit",
     "Restrict GROUP_CONCAT from using more than this amount of memory; 0 "
@@ -580,6 +595,22 @@ REGISTER_TUNABLE("keycompr",
 REGISTER_TUNABLE("largepages", "Enables large pages. (Default: off)",
                  TUNABLE_BOOLEAN, &gbl_largepages, READONLY | NOARG, NULL, NULL,
                  NULL, NULL);
+REGISTER_TUNABLE("region_hugepages",
+                 "Back the cache and lock regions with huge pages: 0 off, "
+                 "1 transparent huge pages, 2 hugetlb pages.  (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_region_hugepages, READONLY, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("mpool_numa",
+                 "NUMA placement of the cache and lock regions: 0 off, "
+                 "1 interleave, 2 spread cache regions over nodes.  "
+                 "(Default: 0)",
+                 TUNABLE_INTEGER, &gbl_mpool_numa, READONLY, NULL, NULL, NULL,
+                 NULL);
+REGISTER_TUNABLE("mpool_ccache_mb",
+                 "Size in MB of the compressed cache of pages evicted from "
+                 "the buffer pool; 0 disables it.  (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_mpool_ccache_mb, READONLY, NULL, NULL,
+                 NULL, NULL);
 REGISTER_TUNABLE("lclpooledbufs", NULL, TUNABLE_INTEGER, &gbl_lclpooled_buffers,
                  READONLY, NULL, NULL, NULL, NULL);
 REGISTER_TUNABLE("lk_hash", NULL, TUNABLE_INTEGER, &gbl_lk_hash,
@@ -599,6 +630,11 @@ REGISTER_TUNABLE("lock_dba_user",
                  "permissions cannot be modified. (Default: off)",
                  TUNABLE_BOOLEAN, &gbl_lock_dba_user, READONLY | NOARG, NULL,
                  NULL, NULL, NULL);
+REGISTER_TUNABLE("log_compress_threshold",
+                 "Write log records at least this many bytes long LZ4-"
+                 "compressed; 0 disables compression.  (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_log_compress_threshold, 0, NULL, NULL,
+                 NULL, NULL);
 REGISTER_TUNABLE("log_delete_age", "Log deletion policy", TUNABLE_INTEGER,
                  &db->log_delete_age, READONLY, NULL, NULL, NULL, NULL);
 /* The following 3 tunables have been marked internal as we do not want them
@@ -619,6 +655,12 @@ REGISTER_TUNABLE("log_delete_now",
                  TUNABLE_INTEGER, &db->log_delete_age,
                  READONLY | NOARG | INTERNAL, NULL, NULL, log_delete_now_update,
                  NULL);
+REGISTER_TUNABLE("log_stream_bufsize",
+                 "Block size in bytes for log cursors that stream the log "
+                 "forward with readahead; 0 disables streaming.  "
+                 "(Default: 1048576)",
+                 TUNABLE_INTEGER, &gbl_log_stream_bufsize, 0, NULL, NULL, NULL,
+                 NULL);
 REGISTER_TUNABLE("loghist", NULL, TUNABLE_INTEGER, &gbl_loghist,
                  READONLY | NOARG, NULL, NULL, loghist_update, NULL);
 REGISTER_TUNABLE("loghist_verbose", NULL, TUNABLE_BOOLEAN, &gbl_loghist_verbose,
@@ -925,11 +967,43 @@ REGISTER_TUNABLE("page_compact_target_ff", NULL, TUNABLE_DOUBLE,
 REGISTER_TUNABLE("page_compact_thresh_ff", NULL, TUNABLE_DOUBLE,
                  &gbl_pg_compact_thresh, READONLY | NOARG, NULL, NULL,
                  page_compact_thresh_ff_update, NULL);
+REGISTER_TUNABLE("pgcompact_sched",
+                 "The master compacts sparse ranges of btrees in the "
+                 "background.  (Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_pgcompact_sched, 0, NULL, NULL, NULL,
+                 NULL);
+REGISTER_TUNABLE("pgcompact_sched_range_pct",
+                 "Background page compaction compacts ranges of leaf pages "
+                 "that are on average less than this percent full.  "
+                 "(Default: 50)",
+                 TUNABLE_INTEGER, &gbl_pgcompact_sched_range_pct, 0, NULL,
+                 percent_verify, NULL, NULL);
+REGISTER_TUNABLE("pgcompact_sched_pages_per_sec",
+                 "Background page compaction reads at most this many pages "
+                 "a second.  0 is unlimited.  (Default: 1000)",
+                 TUNABLE_INTEGER, &gbl_pgcompact_sched_pages_per_sec, 0, NULL,
+                 NULL, NULL, NULL);
+REGISTER_TUNABLE("pgcompact_sched_logbytes_per_sec",
+                 "Background page compaction logs at most this many bytes a "
+                 "second.  0 is unlimited.  (Default: 1048576)",
+                 TUNABLE_INTEGER, &gbl_pgcompact_sched_logbytes_per_sec, 0,
+                 NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("pgcompact_sched_rescan_secs",
+                 "Background page compaction sweeps a btree again this many "
+                 "seconds after its last sweep.  (Default: 3600)",
+                 TUNABLE_INTEGER, &gbl_pgcompact_sched_rescan_secs, 0, NULL,
+                 NULL, NULL, NULL);
 REGISTER_TUNABLE("page_latches",
                  "If set, in rowlocks mode, will acquire fast latches on pages "
                  "instead of full locks. (Default: off)",
                  TUNABLE_BOOLEAN, &gbl_page_latches, READONLY | NOARG, NULL,
                  NULL, NULL, NULL);
+REGISTER_TUNABLE("page_latches_optimistic",
+                 "With page latches, read internal btree pages during a "
+                 "search without latching them, and search again with "
+                 "latches if a page changed. (Default: on)",
+                 TUNABLE_BOOLEAN, &gbl_page_latches_optimistic, NOARG, NULL,
+                 NULL, NULL, NULL);
 REGISTER_TUNABLE(
     "pageordertablescan",
     "Perform table scans in page order and not row order. (Default: off)",
@@ -940,9 +1014,12 @@ REGISTER_TUNABLE("pagesize", NULL, TUNABLE_INTEGER,
                  &placeholder, DEPRECATED_TUNABLE|READONLY, NULL, NULL, NULL,
                  NULL);
 */
-REGISTER_TUNABLE("parallel_recovery", NULL, TUNABLE_INTEGER,
-                 &gbl_parallel_recovery_threads, READONLY, NULL, NULL, NULL,
-                 NULL);
+REGISTER_TUNABLE("parallel_recovery",
+                 "Redo the forward pass of recovery on this many threads, "
+                 "partitioned by file and page; 0 or 1 runs it serially.  "
+                 "(Default: 0)",
+                 TUNABLE_INTEGER, &gbl_parallel_recovery_threads, READONLY,
+                 NULL, NULL, NULL, NULL);
 REGISTER_TUNABLE("penaltyincpercent", NULL, TUNABLE_INTEGER,
                  &gbl_penaltyincpercent, READONLY, NULL, NULL, NULL, NULL);
 REGISTER_TUNABLE("perfect_ckp", NULL, TUNABLE_INTEGER, &gbl_use_perfect_ckp,
@@ -983,6 +1060,11 @@ REGISTER_TUNABLE("rangextlim", NULL, TUNABLE_INTEGER, &gbl_rangextunit,
 REGISTER_TUNABLE(
     "rcache", "Keep a lookaside cache of root pages for B-trees. (Default: on)",
     TUNABLE_BOOLEAN, &gbl_rcache, READONLY | NOARG, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("rcache_levels",
+                 "Number of B-tree levels, from the root down, that rcache "
+                 "keeps.  (Default: 2)",
+                 TUNABLE_INTEGER, &gbl_rcache_levels, NOZERO, NULL, NULL, NULL,
+                 NULL);
 REGISTER_TUNABLE("reallearly",
                  "Acknowledge as soon as a commit record is seen by the "
                  "replicant (before it's applied). This effectively makes "
@@ -1137,6 +1219,16 @@ REGISTER_TUNABLE("temptable_limit",
                  "create. (Default: 8192)",
                  TUNABLE_INTEGER, &gbl_temptable_pool_capacity, READONLY, NULL,
                  NULL, NULL, NULL);
+REGISTER_TUNABLE("temptable_grace_hash",
+                 "Spill hash temp tables one partition at a time when they "
+                 "outgrow the temp table cache size.  (Default: on)",
+                 TUNABLE_BOOLEAN, &gbl_temptable_grace_hash, 0, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("temptable_skiplist",
+                 "Keep new btree temp tables in memory as skiplists until they "
+                 "outgrow the temp table cache size.  (Default: on)",
+                 TUNABLE_BOOLEAN, &gbl_temptable_skiplist, 0, NULL, NULL, NULL,
+                 NULL);
 REGISTER_TUNABLE("test_blob_race", NULL, TUNABLE_INTEGER, &gbl_test_blob_race,
                  READONLY, NULL, NULL, NULL, NULL);
 REGISTER_TUNABLE("test_scindex_deadlock",
@@ -1401,6 +1493,29 @@ REGISTER_TUNABLE("processor_thd_poll", "Poll before dispatching worker thds. "
                                        "(Default: 0ms)",
                  TUNABLE_INTEGER, &gbl_processor_thd_poll,
                  EXPERIMENTAL | INTERNAL, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("rep_apply_page_dag",
+                 "Schedule the records of replicated transactions at least "
+                 "this large by the pages they touch rather than by file.  0 "
+                 "disables.  (Default: 16)",
+                 TUNABLE_INTEGER, &gbl_rep_apply_page_dag, 0, NULL, NULL, NULL,
+                 NULL);
+REGISTER_TUNABLE("rep_batch_bytes",
+                 "Pack consecutive log records sent to replicants into "
+                 "batches of up to this many bytes.  Every node must "
+                 "understand batches before this is enabled.  0 sends each "
+                 "record on its own.  (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_rep_batch_bytes, 0, NULL, NULL, NULL,
+                 NULL);
+REGISTER_TUNABLE("rep_batch_compress_bytes",
+                 "Compress replication batches of at least this many bytes "
+                 "with LZ4.  0 never compresses.  (Default: 4096)",
+                 TUNABLE_INTEGER, &gbl_rep_batch_compress_bytes, 0, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("rep_prefetch",
+                 "Read the pages of incoming log records on replicants before "
+                 "their transactions are applied.  (Default: on)",
+                 TUNABLE_BOOLEAN, &gbl_rep_prefetch, NOARG, NULL, NULL, NULL,
+                 NULL);
 REGISTER_TUNABLE("time_rep_apply", "Display rep-apply times periodically. "
                                    "(Default: off)",
                  TUNABLE_BOOLEAN, &gbl_time_rep_apply, EXPERIMENTAL | INTERNAL,
@@ -1900,6 +2015,18 @@ REGISTER_TUNABLE("load_cache_max_pages",
                  TUNABLE_INTEGER, &gbl_load_cache_max_pages, 0, NULL, NULL,
                  NULL, NULL);
 
+REGISTER_TUNABLE("load_cache_background",
+                 "Load the saved pagelist into the cache at startup without "
+                 "holding up checkpoints.  (Default: on)",
+                 TUNABLE_BOOLEAN, &gbl_load_cache_background, 0, NULL, NULL,
+                 NULL, NULL);
+
+REGISTER_TUNABLE("load_cache_batch",
+                 "Pages each cache loading thread reads as a single batch.  "
+                 "(Default: 256)",
+                 TUNABLE_INTEGER, &gbl_load_cache_batch, 0, NULL, NULL, NULL,
+                 NULL);
+
 REGISTER_TUNABLE("dump_cache_max_pages",
                  "Maximum number of pages that will dump into a pagelist.  "
                  "Setting to 0 means that there is no limit.  (Default: 0)",
@@ -2107,4 +2234,111 @@ REGISTER_TUNABLE("sc_logbytes_per_second",
                  "Throttle schema-changes to this many logbytes per second.  (Default: 10000000)",
                  TUNABLE_INTEGER, &gbl_sc_logbytes_per_second, EXPERIMENTAL | INTERNAL, NULL, NULL, NULL, NULL);
 
+REGISTER_TUNABLE("sc_bulk_index_build",
+                 "Non-live schema changes spool the keys of the new indexes "
+                 "and add them in key order once all records are converted.  "
+                 "(Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_sc_bulk_index_build, 0, NULL, NULL,
+                 NULL, NULL);
+
+REGISTER_TUNABLE("sc_bulk_index_keys_per_txn",
+                 "Add this many spooled index keys per transaction at the end "
+                 "of a schema change.  (Default: 1000)",
+                 TUNABLE_INTEGER, &gbl_sc_bulk_index_keys_per_txn, 0, NULL,
+                 NULL, NULL, NULL);
+
+REGISTER_TUNABLE("bt_append_split_pct",
+                 "Leave the left page this full when splitting the last page "
+                 "of a btree that keys are being appended to, unless it has "
+                 "its own fill factor.  (Default: 90)",
+                 TUNABLE_INTEGER, &gbl_bt_append_split_pct, 0, NULL,
+                 bt_append_split_pct_verify, NULL, NULL);
+
+REGISTER_TUNABLE("mpool_scan_resistant",
+                 "Admit pages to the buffer pool on probation and protect "
+                 "them only once they are re-referenced.  (Default: on)",
+                 TUNABLE_BOOLEAN, &gbl_mpool_scan_resistant, 0, NULL, NULL,
+                 NULL, NULL);
+
+REGISTER_TUNABLE("mpool_cold_priority_pct",
+                 "Place probationary pages this percentage of the buffer "
+                 "pool behind the most recently used page.  (Default: 50)",
+                 TUNABLE_INTEGER, &gbl_mpool_cold_priority_pct, 0, NULL, NULL,
+                 NULL, NULL);
+
+REGISTER_TUNABLE("mpool_promote_window",
+                 "References to a page within this many buffer puts of its "
+                 "admission do not promote it.  (Default: 256)",
+                 TUNABLE_INTEGER, &gbl_mpool_promote_window, 0, NULL, NULL,
+                 NULL, NULL);
+
+REGISTER_TUNABLE("mpool_sweep_partitions",
+                 "Number of independent eviction sweep partitions per cache "
+                 "region.  (Default: 16)",
+                 TUNABLE_INTEGER, &gbl_mpool_sweep_partitions, 0, NULL, NULL,
+                 NULL, NULL);
+
+REGISTER_TUNABLE("iouring_queue_depth",
+                 "Reads each thread keeps in flight during a batched page "
+                 "read when built with io_uring.  Takes effect for threads "
+                 "started after it is changed.  (Default: 64)",
+                 TUNABLE_INTEGER, &gbl_iouring_queue_depth, 0, NULL, NULL,
+                 NULL, NULL);
+
+REGISTER_TUNABLE("mpool_prefetch_batch",
+                 "Pages the btree prefetcher hands to the buffer pool at a "
+                 "time.  0 queues a separate prefetch job per page.  "
+                 "(Default: 64)",
+                 TUNABLE_INTEGER, &gbl_mpool_prefetch_batch, 0, NULL, NULL,
+                 NULL, NULL);
+
+REGISTER_TUNABLE("pageorder_readahead",
+                 "Pages a page-order table scan reads ahead of the cursor.  "
+                 "0 disables readahead.  (Default: 64)",
+                 TUNABLE_INTEGER, &gbl_pageorder_readahead, 0, NULL, NULL,
+                 NULL, NULL);
+
+REGISTER_TUNABLE("mpool_coalesce_writes",
+                 "Write runs of adjacent dirty pages with a single vectored "
+                 "write when flushing the cache.  (Default: on)",
+                 TUNABLE_BOOLEAN, &gbl_mpool_coalesce_writes, 0, NULL, NULL,
+                 NULL, NULL);
+
+REGISTER_TUNABLE("mpool_flush_range_pages",
+                 "Dirty pages of one file handed to a single flush thread.  "
+                 "Larger files are split across threads.  0 flushes each "
+                 "file with one thread.  (Default: 8192)",
+                 TUNABLE_INTEGER, &gbl_mpool_flush_range_pages, 0, NULL, NULL,
+                 NULL, NULL);
+
+REGISTER_TUNABLE("mpool_pace_writeback",
+                 "Pace the trickle thread to spread checkpoint writes over "
+                 "the checkpoint interval.  (Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_mpool_pace_writeback, 0, NULL, NULL,
+                 NULL, NULL);
+
+REGISTER_TUNABLE("mpool_pace_msecs",
+                 "Interval between writeback pacing decisions.  "
+                 "(Default: 100ms)",
+                 TUNABLE_INTEGER, &gbl_mpool_pace_msecs, 0, NULL, NULL, NULL,
+                 NULL);
+
+REGISTER_TUNABLE("mpool_pace_max_io_pct",
+                 "Most of each pacing interval to spend writing pages.  "
+                 "(Default: 50)",
+                 TUNABLE_INTEGER, &gbl_mpool_pace_max_io_pct, 0, NULL, NULL,
+                 NULL, NULL);
+
+REGISTER_TUNABLE("mpool_pace_dirty_max_pct",
+                 "Dirty percentage of the cache above which writeback pacing "
+                 "ignores its write time limit.  (Default: 50)",
+                 TUNABLE_INTEGER, &gbl_mpool_pace_dirty_max_pct, 0, NULL, NULL,
+                 NULL, NULL);
+
+REGISTER_TUNABLE("mpool_pace_min_pages",
+                 "Fewest pages writeback pacing writes in one pass over the "
+                 "cache, unless the cache is mostly dirty.  (Default: 64)",
+                 TUNABLE_INTEGER, &gbl_mpool_pace_min_pages, 0, NULL, NULL,
+                 NULL, NULL);
+
 #endif /* _DB_TUNABLES_H */
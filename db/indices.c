@@ -1393,3 +1393,174 @@ done:
     // We can also delete if we are done with the tmptbl
     return rc;
 }
+
+/* Hand this thread's defered index table to the caller, who must delete
+ * it with delete_constraint_table().  Returns NULL if nothing was added. */
+void *detach_defered_index_tbl(void)
+{
+    void *tbl;
+
+    close_defered_index_tbl_cursor();
+    tbl = defered_index_tbl;
+    defered_index_tbl = NULL;
+    return tbl;
+}
+
+/* Merges the defered index tables filled by several threads in key order,
+ * handing out the keys in batches which can be replayed if the transaction
+ * that adds them has to be retried.  A key spooled again because its record
+ * was retried is handed out once. */
+struct defered_index_merge {
+    int ntbls;
+    void **curs; /* NULL once that table is exhausted */
+    int havelast;
+    dtikey_t last;
+    int nkeys;   /* keys in the current batch */
+    int maxkeys;
+    dtikey_t *keys;
+    void **tails;
+    int *taillens;
+};
+
+struct defered_index_merge *defered_index_merge_create(void **tbls, int ntbls,
+                                                       int maxkeys)
+{
+    struct defered_index_merge *m;
+    int err, rc;
+
+    if (maxkeys < 1)
+        maxkeys = 1;
+    m = calloc(1, sizeof(struct defered_index_merge));
+    if (m == NULL)
+        return NULL;
+    m->ntbls = ntbls;
+    m->maxkeys = maxkeys;
+    m->curs = calloc(ntbls, sizeof(void *));
+    m->keys = malloc(maxkeys * sizeof(dtikey_t));
+    m->tails = calloc(maxkeys, sizeof(void *));
+    m->taillens = calloc(maxkeys, sizeof(int));
+    if (!m->curs || !m->keys || !m->tails || !m->taillens)
+        goto err;
+
+    for (int i = 0; i < ntbls; i++) {
+        if (tbls[i] == NULL)
+            continue;
+        if ((m->curs[i] = get_constraint_table_cursor(tbls[i])) == NULL)
+            goto err;
+        rc = bdb_temp_table_first(thedb->bdb_env, m->curs[i], &err);
+        if (rc == IX_EMPTY) {
+            close_constraint_table_cursor(m->curs[i]);
+            m->curs[i] = NULL;
+        } else if (rc != IX_OK) {
+            logmsg(LOGMSG_ERROR, "%s: bdb_temp_table_first rc = %d err %d\n",
+                   __func__, rc, err);
+            goto err;
+        }
+    }
+    return m;
+
+err:
+    defered_index_merge_destroy(m);
+    return NULL;
+}
+
+void defered_index_merge_destroy(struct defered_index_merge *m)
+{
+    if (m == NULL)
+        return;
+    for (int i = 0; m->curs && i < m->ntbls; i++) {
+        if (m->curs[i])
+            close_constraint_table_cursor(m->curs[i]);
+    }
+    for (int i = 0; m->tails && i < m->nkeys; i++)
+        free(m->tails[i]);
+    free(m->curs);
+    free(m->keys);
+    free(m->tails);
+    free(m->taillens);
+    free(m);
+}
+
+/* Replace the current batch with the next keys in order.  Returns how many
+ * keys the batch holds, 0 once all tables are exhausted, or -1 on error. */
+int defered_index_merge_next(struct defered_index_merge *m)
+{
+    int err, rc;
+
+    for (int i = 0; i < m->nkeys; i++) {
+        free(m->tails[i]);
+        m->tails[i] = NULL;
+    }
+    m->nkeys = 0;
+
+    while (m->nkeys < m->maxkeys) {
+        dtikey_t *ditk, *min = NULL;
+        int mini = -1;
+
+        for (int i = 0; i < m->ntbls; i++) {
+            if (m->curs[i] == NULL)
+                continue;
+            ditk = bdb_temp_table_key(m->curs[i]);
+            if (min == NULL || defered_index_key_cmp(NULL, sizeof(dtikey_t),
+                                                     ditk, sizeof(dtikey_t),
+                                                     min) < 0) {
+                min = ditk;
+                mini = i;
+            }
+        }
+        if (min == NULL)
+            break;
+
+        if (m->havelast && defered_index_key_cmp(NULL, sizeof(dtikey_t), min,
+                                                 sizeof(dtikey_t),
+                                                 &m->last) == 0)
+            goto next;
+        memcpy(&m->last, min, sizeof(dtikey_t));
+        m->havelast = 1;
+
+        memcpy(&m->keys[m->nkeys], min, sizeof(dtikey_t));
+        m->taillens[m->nkeys] = bdb_temp_table_datasize(m->curs[mini]);
+        if (m->taillens[m->nkeys] > 0) {
+            m->tails[m->nkeys] = malloc(m->taillens[m->nkeys]);
+            if (m->tails[m->nkeys] == NULL)
+                return -1;
+            memcpy(m->tails[m->nkeys], bdb_temp_table_data(m->curs[mini]),
+                   m->taillens[m->nkeys]);
+        }
+        m->nkeys++;
+
+    next:
+        rc = bdb_temp_table_next(thedb->bdb_env, m->curs[mini], &err);
+        if (rc == IX_PASTEOF) {
+            close_constraint_table_cursor(m->curs[mini]);
+            m->curs[mini] = NULL;
+        } else if (rc != IX_OK) {
+            logmsg(LOGMSG_ERROR, "%s: bdb_temp_table_next rc = %d err %d\n",
+                   __func__, rc, err);
+            return -1;
+        }
+    }
+    return m->nkeys;
+}
+
+/* Add the keys of the current batch through trans. */
+int defered_index_merge_apply(struct ireq *iq, void *trans,
+                              struct defered_index_merge *m, int *ixfailnum)
+{
+    int rc = 0;
+
+    for (int i = 0; i < m->nkeys; i++) {
+        dtikey_t *ditk = &m->keys[i];
+
+        assert(ditk->type == DIT_ADD);
+        iq->usedb = ditk->usedb;
+        rc = ix_addk(iq, trans, ditk->ixkey, ditk->ixnum, ditk->genid, 2,
+                     m->tails[i], m->taillens[i],
+                     ix_isnullk(iq->usedb, ditk->ixkey, ditk->ixnum));
+        if (rc != 0) {
+            *ixfailnum = ditk->ixnum;
+            break;
+        }
+    }
+    return rc;
+}
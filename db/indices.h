@@ -54,4 +54,14 @@ int del_new_record_indices(struct ireq *iq, void *trans,
                            unsigned long long del_keys,
                            blob_buffer_t *del_idx_blobs, int verify_retry);
 
+void *detach_defered_index_tbl(void);
+
+struct defered_index_merge;
+struct defered_index_merge *defered_index_merge_create(void **tbls, int ntbls,
+                                                       int maxkeys);
+void defered_index_merge_destroy(struct defered_index_merge *m);
+int defered_index_merge_next(struct defered_index_merge *m);
+int defered_index_merge_apply(struct ireq *iq, void *trans,
+                              struct defered_index_merge *m, int *ixfailnum);
+
 #endif
@@ -74,6 +74,15 @@ extern int64_t gbl_last_checkpoint_ms;
 extern int64_t gbl_total_checkpoint_ms;
 extern int gbl_checkpoint_count;
 
+extern int64_t gbl_memp_pace_rate;
+extern int64_t gbl_memp_pace_dirty_rate;
+extern int64_t gbl_memp_pace_log_rate;
+extern int64_t gbl_memp_pace_ckp_secs;
+extern int64_t gbl_memp_pace_write_usecs;
+extern int64_t gbl_memp_pace_dirty_pct;
+extern int64_t gbl_memp_pace_pages;
+extern int64_t gbl_memp_pace_throttled;
+
 extern uint32_t rcache_hits;
 extern uint32_t rcache_miss;
 
@@ -1140,6 +1140,53 @@ clipper_usage:
         }
 
        logmsg(LOGMSG_USER, "successfully deleted files\n");
+    } else if (tokcmp(tok, ltok, "fillfactor") == 0) {
+        char table[MAXTABLELEN];
+        struct dbtable *db;
+        int ixnum, pct, rc;
+
+        tok = segtok(line, lline, &st, &ltok);
+        if (ltok == 0 || ltok >= MAXTABLELEN) {
+            logmsg(LOGMSG_ERROR,
+                   "Usage: fillfactor <table> <dta|ixnum> <percent>\n");
+            return -1;
+        }
+        tokcpy(tok, ltok, table);
+        db = get_dbtable_by_name(table);
+        if (!db) {
+            logmsg(LOGMSG_ERROR, "fillfactor: could not find table: %s\n",
+                   table);
+            return -1;
+        }
+
+        tok = segtok(line, lline, &st, &ltok);
+        if (ltok == 0) {
+            logmsg(LOGMSG_ERROR,
+                   "Usage: fillfactor <table> <dta|ixnum> <percent>\n");
+            return -1;
+        }
+        ixnum = tokcmp(tok, ltok, "dta") == 0 ? -1 : toknum(tok, ltok);
+
+        tok = segtok(line, lline, &st, &ltok);
+        if (ltok == 0) {
+            logmsg(LOGMSG_ERROR,
+                   "Usage: fillfactor <table> <dta|ixnum> <percent>\n");
+            return -1;
+        }
+        pct = toknum(tok, ltok);
+
+        /* The master saves it for the table's next open; elsewhere it only
+         * lasts until then. */
+        if (thedb->master == gbl_myhostname)
+            rc = bdb_set_fillpct(db->handle, ixnum, pct);
+        else
+            rc = bdb_handle_dbp_set_fillpct(db->handle, ixnum, pct);
+        if (rc != 0) {
+            logmsg(LOGMSG_ERROR, "fillfactor: failed rc %d\n", rc);
+            return -1;
+        }
+        logmsg(LOGMSG_USER, "%s %s fill factor set to %d%%\n", table,
+               ixnum < 0 ? "data" : "index", pct);
     }
 
     /* Temporary message-trap to delete the stale backup stats from llmeta. */
@@ -1911,7 +1958,9 @@ clipper_usage:
         else if (tokcmp(tok, ltok, "rcache") == 0) {
             extern uint32_t rcache_hits, rcache_miss, rcache_savd,
                 rcache_invalid, rcache_collide;
+            extern int gbl_rcache_levels;
             logmsg(LOGMSG_ERROR, "rcache enabled:%s\n", YESNO(gbl_rcache));
+            logmsg(LOGMSG_ERROR, "cache levels: %d\n", gbl_rcache_levels);
             logmsg(LOGMSG_ERROR, "cache hits: %u\n", rcache_hits);
             logmsg(LOGMSG_ERROR, "cache miss: %u\n", rcache_miss);
             logmsg(LOGMSG_ERROR, "cache save: %u\n", rcache_savd);
@@ -515,11 +515,12 @@ int add_record(struct ireq *iq, void *trans, const uint8_t *p_buf_tag_name,
 
     if (iq->usedb->nix > 0 || (iq->usedb->sc_to && iq->usedb->sc_to->nix > 0)) {
         bool reorder =
-            osql_is_index_reorder_on(iq->osql_flags) && !is_event_from_sc(flags) &&
-            rec_flags == 0 && iq->usedb->sc_from != iq->usedb &&
-            strcasecmp(iq->usedb->tablename, "comdb2_oplog") != 0 &&
-            strcasecmp(iq->usedb->tablename, "comdb2_commit_log") != 0 &&
-            strncasecmp(iq->usedb->tablename, "sqlite_stat", 11) != 0;
+            (flags & RECFLAGS_SPOOL_KEYS) ||
+            (osql_is_index_reorder_on(iq->osql_flags) && !is_event_from_sc(flags) &&
+             rec_flags == 0 && iq->usedb->sc_from != iq->usedb &&
+             strcasecmp(iq->usedb->tablename, "comdb2_oplog") != 0 &&
+             strcasecmp(iq->usedb->tablename, "comdb2_commit_log") != 0 &&
+             strncasecmp(iq->usedb->tablename, "sqlite_stat", 11) != 0);
 
         if (reorder)
             rec_flags |= OSQL_ITEM_REORDERED;
@@ -7299,6 +7299,12 @@ sqlite3BtreeCursor_temptable(Btree *pBt,      /* The btree */
         return SQLITE_INTERNAL;
     }
 
+    /* The key and data handed to sqlite are only needed until the cursor
+     * moves, so don't copy them out of in-memory tables.  A table shared
+     * between threads is read without its lock held, so keep copying. */
+    if (cur->tmptable->lk == NULL)
+        bdb_temp_table_set_zerocopy(cur->tmptable->cursor, 1);
+
     /* if comments above are to be believed
      * this will be set the same on each cursor
      * that is opened for a table */
@@ -99,6 +99,7 @@ enum {
     USER_TYPE_TRANSFERMASTER_NAME,
     USER_TYPE_REQ_START_LSN,
     USER_TYPE_TRUNCATE_LOG,
+    USER_TYPE_BERKDB_REP_BATCH,
 
     NET_QUIESCE_THREADS = 100,
     NET_RESUME_THREADS = 101,
@@ -35,9 +35,16 @@
 #include "reqlog.h"
 #include "logmsg.h"
 #include "debug_switches.h"
+#include "block_internal.h"
+#include "indices.h"
 
 int gbl_logical_live_sc = 0;
 
+/* If set, non-live schema changes spool the keys of the new indexes and
+ * load them in key order once all records are converted. */
+int gbl_sc_bulk_index_build = 0;
+int gbl_sc_bulk_index_keys_per_txn = 1000;
+
 extern __thread snap_uid_t *osql_snap_info; /* contains cnonce */
 extern int gbl_partial_indexes;
 // Increase max threads to do SC -- called when no contention is detected
@@ -750,7 +757,8 @@ static int convert_record(struct convert_record_data *data)
                 usellmeta = 1; /* dta is not being built */
             }
             rc = 0;
-            if (usellmeta && !is_dta_being_rebuilt(data->to->plan)) {
+            if (usellmeta && !is_dta_being_rebuilt(data->to->plan) &&
+                !data->spool_keys) {
                 int bdberr;
                 rc = bdb_set_high_genid_stripe(NULL, data->to->tablename,
                                                data->stripe, -1ULL, &bdberr);
@@ -956,6 +964,7 @@ static int convert_record(struct convert_record_data *data)
                    RECFLAGS_NEW_SCHEMA | RECFLAGS_KEEP_GENID;
 
     if (data->to->plan && gbl_use_plan) addflags |= RECFLAGS_NO_BLOBS;
+    if (data->spool_keys) addflags |= RECFLAGS_SPOOL_KEYS;
 
     char *tagname = ".NEW..ONDISK";
     uint8_t *p_tagname_buf = (uint8_t *)tagname;
@@ -986,8 +995,10 @@ static int convert_record(struct convert_record_data *data)
     }
 
     /* if we have been rebuilding the data files we're gonna
-       call bdb_get_high_genid to resume, not look at llmeta */
+       call bdb_get_high_genid to resume, not look at llmeta.
+       Spooled keys are lost on a restart, so we can't resume then. */
     if (usellmeta && !is_dta_being_rebuilt(data->to->plan) &&
+        !data->spool_keys &&
         (data->nrecs %
          BDB_ATTR_GET(thedb->bdb_attr, INDEXREBUILD_SAVE_EVERY_N)) == 0) {
         int bdberr;
@@ -1294,6 +1305,13 @@ cleanup:
     }
 
 cleanup_no_msg:
+    if (data->spool_keys) {
+        /* hand our spooled keys to convert_all_records to load */
+        if (data->outrc == 0)
+            data->spooled_keys = detach_defered_index_tbl();
+        else
+            delete_defered_index_tbl();
+    }
     convert_record_data_cleanup(data);
     if (data->isThread) backend_thread_event(thedb, COMDB2_THR_EVENT_DONE_RDWR);
 
@@ -1318,6 +1336,97 @@ static void stop_sc_redo_wait(bdb_state_type *bdb_state,
 int gbl_sc_pause_at_end = 0;
 int gbl_sc_is_at_end = 0;
 
+/* Add the keys spooled by the convert threads to the new indexes.  Merging
+ * the threads' sorted spools adds each index's keys in order, so pages fill
+ * up from left to right instead of splitting all over the tree. */
+static int bulk_load_keys(struct convert_record_data *data, void **tbls,
+                          int ntbls)
+{
+    struct defered_index_merge *m;
+    long long nkeys = 0;
+    int n, rc = 0, ixfailnum = -1;
+
+    m = defered_index_merge_create(tbls, ntbls, gbl_sc_bulk_index_keys_per_txn);
+    if (m == NULL) {
+        sc_errf(data->s, "bulk_load_keys: failed to merge spooled keys\n");
+        return -1;
+    }
+    sc_printf(data->s, "[%s] loading spooled index keys\n",
+              data->from->tablename);
+
+    while ((n = defered_index_merge_next(m)) > 0) {
+        do {
+            if (gbl_sc_abort || data->from->sc_abort ||
+                (data->s->iq && data->s->iq->sc_should_abort)) {
+                sc_errf(data->s, "bulk load aborted after %lld keys\n", nkeys);
+                rc = -1;
+                goto done;
+            }
+            rc = trans_start_sc_lowpri(&data->iq, &data->trans);
+            if (rc) {
+                sc_errf(data->s, "bulk_load_keys: trans_start failed with "
+                                 "rcode %d\n",
+                        rc);
+                rc = -1;
+                goto done;
+            }
+            rc = defered_index_merge_apply(&data->iq, data->trans, m,
+                                           &ixfailnum);
+            if (rc) {
+                increment_sc_logbytes(bdb_tran_logbytes(data->trans));
+                trans_abort(&data->iq, data->trans);
+                data->trans = NULL;
+                if (rc == RC_INTERNAL_RETRY) {
+                    data->totnretries++;
+                    poll(0, 0, (rand() % 500 + 10));
+                }
+                continue;
+            }
+            rc = trans_commit(&data->iq, data->trans, gbl_myhostname);
+            increment_sc_logbytes(data->iq.txnsize);
+            data->trans = NULL;
+            if (rc) {
+                sc_errf(data->s, "bulk_load_keys: trans_commit failed with "
+                                 "rcode %d\n",
+                        rc);
+                rc = -1;
+                goto done;
+            }
+        } while (rc == RC_INTERNAL_RETRY);
+
+        if (rc == IX_DUP) {
+            if (data->s->iq)
+                reqerrstr(data->s->iq, ERR_SC,
+                          "Could not add duplicate entry in index %d",
+                          ixfailnum);
+            sc_errf(data->s, "Could not add duplicate entry in index %d\n",
+                    ixfailnum);
+            rc = -1;
+            goto done;
+        } else if (rc) {
+            if (data->s->iq)
+                reqerrstr(data->s->iq, ERR_SC,
+                          "Error adding key rc %d index %d", rc, ixfailnum);
+            sc_errf(data->s, "Error adding key rcode %d index %d\n", rc,
+                    ixfailnum);
+            rc = -1;
+            goto done;
+        }
+        nkeys += n;
+    }
+    if (n < 0) {
+        sc_errf(data->s, "bulk_load_keys: failed to read spooled keys\n");
+        rc = -1;
+    }
+
+done:
+    defered_index_merge_destroy(m);
+    if (rc == 0)
+        sc_printf(data->s, "[%s] loaded %lld index keys\n",
+                  data->from->tablename, nkeys);
+    return rc;
+}
+
 int convert_all_records(struct dbtable *from, struct dbtable *to,
                         unsigned long long *sc_genids,
                         struct schema_change_type *s)
@@ -1343,6 +1452,31 @@ int convert_all_records(struct dbtable *from, struct dbtable *to,
         return -1;
     }
 
+    /* Spooled keys don't outlive the process, so a schema change that
+     * spooled them can't be resumed.  One that didn't carries on without. */
+    if (s->resume) {
+        int bdberr;
+        int spooled = bdb_get_sc_spooled_keys(NULL, s->tablename, &bdberr);
+        if (spooled) {
+            sc_errf(data.s, "cannot resume a schema change that spooled its "
+                            "index keys, it must be restarted\n");
+            return -1;
+        }
+    }
+
+    /* Concurrent writers add their keys straight to the new indexes during
+     * a live schema change, so only spool ours when there are none. */
+    if (gbl_sc_bulk_index_build && !data.live && !gbl_logical_live_sc &&
+        !s->resume && s->schema_change != SC_CONSTRAINT_CHANGE) {
+        int bdberr;
+        if (bdb_set_sc_spooled_keys(NULL, s->tablename, &bdberr)) {
+            sc_errf(data.s, "failed to mark the schema change as spooling "
+                            "its index keys, bdberr %d\n", bdberr);
+            return -1;
+        }
+        data.spool_keys = 1;
+    }
+
     /* Calculate blob data file numbers to feed direct into bdb.  This used
      * to be a hard coded array.  And it was wrong.  By employing for loop
      * technology, we can't possibly get this wrong again! */
@@ -1512,12 +1646,21 @@ int convert_all_records(struct dbtable *from, struct dbtable *to,
     if (data.scanmode != SCAN_PARALLEL && data.scanmode != SCAN_PAGEORDER) {
         convert_records_thd(&data);
         outrc = data.outrc;
+        if (data.spooled_keys) {
+            if (outrc == 0)
+                outrc = bulk_load_keys(&data, &data.spooled_keys, 1);
+            delete_constraint_table(data.spooled_keys);
+            data.spooled_keys = NULL;
+        }
     } else {
         struct convert_record_data threadData[gbl_dtastripe];
         int threadSkipped[gbl_dtastripe];
         pthread_attr_t attr;
         int rc = 0;
 
+        memset(threadData, 0, sizeof(threadData));
+        memset(threadSkipped, 0, sizeof(threadSkipped));
+
         data.isThread = 1;
 
         Pthread_attr_init(&attr);
@@ -1593,6 +1736,17 @@ int convert_all_records(struct dbtable *from, struct dbtable *to,
 
         /* destroy attr */
         Pthread_attr_destroy(&attr);
+
+        if (data.spool_keys) {
+            void *spooled[gbl_dtastripe];
+            for (ii = 0; ii < gbl_dtastripe; ++ii)
+                spooled[ii] =
+                    threadSkipped[ii] ? NULL : threadData[ii].spooled_keys;
+            if (outrc == 0)
+                outrc = bulk_load_keys(&data, spooled, gbl_dtastripe);
+            for (ii = 0; ii < gbl_dtastripe; ++ii)
+                delete_constraint_table(spooled[ii]);
+        }
     }
 
     print_final_sc_stat(&data);
@@ -77,6 +77,8 @@ struct convert_record_data {
                            converting the records */
     unsigned long long cv_genid; /* the genid of the record that we get
                                     constraint violation on */
+    int spool_keys;     /* spool the new keys and bulk load them at the end */
+    void *spooled_keys; /* this thread's spooled keys once it is done */
 };
 
 int convert_all_records(struct dbtable *from, struct dbtable *to,
@@ -0,0 +1,107 @@
+/*
+   Copyright 2026 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+
+#include "comdb2.h"
+#include "comdb2systblInt.h"
+#include "sql.h"
+#include "ezsystables.h"
+#include "types.h"
+
+#include "bdb_api.h"
+
+struct cache_warmup {
+    char *status;
+    cdb2_client_datetime_t start_time;
+    int start_isnull;
+    int64_t elapsed_secs;
+    int64_t pages;
+    int64_t pages_done;
+    int64_t pages_read;
+    double pct_done;
+};
+
+static int get_rows(void **data, int *num_points)
+{
+    struct cache_warmup *row;
+    uint64_t pages, pages_done, pages_read;
+    int running, stopped, start, end;
+
+    row = calloc(1, sizeof(struct cache_warmup));
+    if (row == NULL)
+        return ENOMEM;
+
+    bdb_get_cache_warmup(thedb->bdb_env, &running, &stopped, &start, &end,
+                         &pages, &pages_done, &pages_read);
+
+    if (start == 0)
+        row->status = "idle";
+    else if (running)
+        row->status = "loading";
+    else if (stopped)
+        row->status = "stopped";
+    else
+        row->status = "done";
+
+    row->start_isnull = (start == 0);
+    if (start != 0) {
+        dttz_t d = {.dttz_sec = start, .dttz_frac = 0,
+                    .dttz_prec = DTTZ_PREC_MSEC};
+        dttz_to_client_datetime(&d, "UTC", &row->start_time);
+        row->elapsed_secs = (running ? time(NULL) : end) - start;
+    }
+    row->pages = pages;
+    row->pages_done = pages_done;
+    row->pages_read = pages_read;
+    row->pct_done = pages ? 100.0 * pages_done / pages : 0;
+
+    *data = row;
+    *num_points = 1;
+    return 0;
+}
+
+static void free_rows(void *data, int num_points)
+{
+    free(data);
+}
+
+sqlite3_module systblCacheWarmupModule = {
+    .access_flag = CDB2_ALLOW_USER,
+};
+
+int systblCacheWarmupInit(sqlite3 *db)
+{
+    return create_system_table(
+        db, "comdb2_cache_warmup", &systblCacheWarmupModule, get_rows,
+        free_rows, sizeof(struct cache_warmup),
+        CDB2_CSTRING, "status", -1, offsetof(struct cache_warmup, status),
+        CDB2_DATETIME, "start_time",
+        offsetof(struct cache_warmup, start_isnull),
+        offsetof(struct cache_warmup, start_time),
+        CDB2_INTEGER, "elapsed_secs", -1,
+        offsetof(struct cache_warmup, elapsed_secs),
+        CDB2_INTEGER, "pages", -1, offsetof(struct cache_warmup, pages),
+        CDB2_INTEGER, "pages_done", -1,
+        offsetof(struct cache_warmup, pages_done),
+        CDB2_INTEGER, "pages_read", -1,
+        offsetof(struct cache_warmup, pages_read),
+        CDB2_REAL, "pct_done", -1, offsetof(struct cache_warmup, pct_done),
+        SYSTABLE_END_OF_FIELDS);
+}
@@ -74,6 +74,10 @@ int systblViewsInit(sqlite3 *);
 int systblSQLClientStats(sqlite3 *);
 int systblSQLIndexStatsInit(sqlite3 *);
 int systblTemporaryFileSizesModuleInit(sqlite3 *);
+int systblCacheWarmupInit(sqlite3 *);
+int systblLogFlushHistInit(sqlite3 *);
+int systblLCCacheInit(sqlite3 *);
+int systblPageCompactInit(sqlite3 *);
 
 int comdb2_next_allowed_table(sqlite3_int64 *tabId);
 
@@ -0,0 +1,103 @@
+/*
+   Copyright 2026 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "comdb2.h"
+#include "comdb2systblInt.h"
+#include "sql.h"
+#include "ezsystables.h"
+#include "types.h"
+
+#include "bdb_api.h"
+
+struct lc_cache {
+    int64_t txns;
+    int64_t spilled_txns;
+    int64_t bytes;
+    int64_t largest_txn_bytes;
+    int64_t hits;
+    int64_t spilled_hits;
+    int64_t misses;
+    double hit_rate;
+    int64_t spills;
+    int64_t evictions;
+    int64_t drops;
+};
+
+static int get_rows(void **data, int *num_points)
+{
+    struct lc_cache *row;
+    uint64_t hits, spilled_hits, misses, spills, evictions, drops;
+    int txns, spilled_txns, memused, largest_txn;
+
+    row = calloc(1, sizeof(struct lc_cache));
+    if (row == NULL)
+        return ENOMEM;
+
+    bdb_get_lc_cache(thedb->bdb_env, &txns, &spilled_txns, &memused,
+                     &largest_txn, &hits, &spilled_hits, &misses, &spills,
+                     &evictions, &drops);
+
+    row->txns = txns;
+    row->spilled_txns = spilled_txns;
+    row->bytes = memused;
+    row->largest_txn_bytes = largest_txn;
+    row->hits = hits;
+    row->spilled_hits = spilled_hits;
+    row->misses = misses;
+    row->hit_rate = (hits + misses) ? 100.0 * hits / (hits + misses) : 0;
+    row->spills = spills;
+    row->evictions = evictions;
+    row->drops = drops;
+
+    *data = row;
+    *num_points = 1;
+    return 0;
+}
+
+static void free_rows(void *data, int num_points)
+{
+    free(data);
+}
+
+sqlite3_module systblLCCacheModule = {
+    .access_flag = CDB2_ALLOW_USER,
+};
+
+int systblLCCacheInit(sqlite3 *db)
+{
+    return create_system_table(
+        db, "comdb2_lc_cache", &systblLCCacheModule, get_rows, free_rows,
+        sizeof(struct lc_cache),
+        CDB2_INTEGER, "txns", -1, offsetof(struct lc_cache, txns),
+        CDB2_INTEGER, "spilled_txns", -1,
+        offsetof(struct lc_cache, spilled_txns),
+        CDB2_INTEGER, "bytes", -1, offsetof(struct lc_cache, bytes),
+        CDB2_INTEGER, "largest_txn_bytes", -1,
+        offsetof(struct lc_cache, largest_txn_bytes),
+        CDB2_INTEGER, "hits", -1, offsetof(struct lc_cache, hits),
+        CDB2_INTEGER, "spilled_hits", -1,
+        offsetof(struct lc_cache, spilled_hits),
+        CDB2_INTEGER, "misses", -1, offsetof(struct lc_cache, misses),
+        CDB2_REAL, "hit_rate", -1, offsetof(struct lc_cache, hit_rate),
+        CDB2_INTEGER, "spills", -1, offsetof(struct lc_cache, spills),
+        CDB2_INTEGER, "evictions", -1, offsetof(struct lc_cache, evictions),
+        CDB2_INTEGER, "drops", -1, offsetof(struct lc_cache, drops),
+        SYSTABLE_END_OF_FIELDS);
+}
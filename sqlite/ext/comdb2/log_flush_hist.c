@@ -0,0 +1,97 @@
+/*
+   Copyright 2026 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "comdb2.h"
+#include "comdb2systblInt.h"
+#include "sql.h"
+#include "ezsystables.h"
+#include "types.h"
+
+#include "bdb_api.h"
+
+#define LOG_FLUSH_HIST_MAX 64
+
+struct log_flush_hist {
+    char *histogram;
+    int64_t bucket_max;
+    int bucket_max_isnull;
+    int64_t count;
+};
+
+static void add_rows(struct log_flush_hist *rows, int *nrows, char *name,
+                     const uint32_t *hist, int nbuckets, int64_t base)
+{
+    int i;
+
+    for (i = 0; i < nbuckets; i++) {
+        struct log_flush_hist *row = &rows[(*nrows)++];
+        row->histogram = name;
+        /* The last bucket has no upper bound */
+        row->bucket_max_isnull = (i == nbuckets - 1);
+        row->bucket_max = base << i;
+        row->count = hist[i];
+    }
+}
+
+static int get_rows(void **data, int *num_points)
+{
+    uint32_t commits[LOG_FLUSH_HIST_MAX], fsyncs[LOG_FLUSH_HIST_MAX];
+    struct log_flush_hist *rows;
+    int nbuckets, nrows = 0;
+
+    nbuckets = bdb_get_log_flush_hist(thedb->bdb_env, commits, fsyncs,
+                                      LOG_FLUSH_HIST_MAX);
+    if (nbuckets < 0)
+        return SQLITE_INTERNAL;
+
+    rows = calloc(2 * nbuckets, sizeof(struct log_flush_hist));
+    if (rows == NULL)
+        return ENOMEM;
+
+    add_rows(rows, &nrows, "commits_per_flush", commits, nbuckets, 1);
+    add_rows(rows, &nrows, "fsync_usecs", fsyncs, nbuckets, 16);
+
+    *data = rows;
+    *num_points = nrows;
+    return 0;
+}
+
+static void free_rows(void *data, int num_points)
+{
+    free(data);
+}
+
+sqlite3_module systblLogFlushHistModule = {
+    .access_flag = CDB2_ALLOW_USER,
+};
+
+int systblLogFlushHistInit(sqlite3 *db)
+{
+    return create_system_table(
+        db, "comdb2_log_flush_histogram", &systblLogFlushHistModule,
+        get_rows, free_rows, sizeof(struct log_flush_hist),
+        CDB2_CSTRING, "histogram", -1,
+        offsetof(struct log_flush_hist, histogram),
+        CDB2_INTEGER, "bucket_max",
+        offsetof(struct log_flush_hist, bucket_max_isnull),
+        offsetof(struct log_flush_hist, bucket_max),
+        CDB2_INTEGER, "count", -1, offsetof(struct log_flush_hist, count),
+        SYSTABLE_END_OF_FIELDS);
+}
@@ -0,0 +1,117 @@
+/*
+   Copyright 2026 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "comdb2.h"
+#include "comdb2systblInt.h"
+#include "sql.h"
+#include "ezsystables.h"
+#include "types.h"
+
+#include "bdb_api.h"
+
+struct page_compact {
+    char *tablename;
+    char *file;
+    int64_t filenum;
+    int64_t stripe;
+    int64_t leaf_pages;
+    double fill_pct;
+    int64_t ranges_compacted;
+    int64_t pages_merged;
+    int64_t bytes_reclaimed;
+    int64_t log_bytes;
+};
+
+static int get_rows(void **data, int *num_points)
+{
+    struct bdb_pgcompact_stat *stats, *s;
+    struct page_compact *rows, *row;
+    int i, n, rc;
+
+    if ((rc = bdb_get_pgcompact_stats(&stats, &n)) != 0)
+        return rc;
+
+    rows = calloc(n ? n : 1, sizeof(struct page_compact));
+    if (rows == NULL) {
+        free(stats);
+        return ENOMEM;
+    }
+
+    for (i = 0; i < n; i++) {
+        s = &stats[i];
+        row = &rows[i];
+        row->tablename = strdup(s->table);
+        if (s->ixnum >= 0) {
+            row->file = "index";
+            row->filenum = s->ixnum;
+        } else {
+            row->file = s->dtanum == 0 ? "data" : "blob";
+            row->filenum = s->dtanum == 0 ? 0 : s->dtanum - 1;
+        }
+        row->stripe = s->stripe;
+        row->leaf_pages = s->leaf_pages;
+        row->fill_pct = s->fill_pct;
+        row->ranges_compacted = s->ranges_compacted;
+        row->pages_merged = s->pages_merged;
+        row->bytes_reclaimed = s->bytes_reclaimed;
+        row->log_bytes = s->logbytes;
+    }
+    free(stats);
+
+    *data = rows;
+    *num_points = n;
+    return 0;
+}
+
+static void free_rows(void *data, int num_points)
+{
+    struct page_compact *rows = data;
+    for (int i = 0; i < num_points; i++)
+        free(rows[i].tablename);
+    free(data);
+}
+
+sqlite3_module systblPageCompactModule = {
+    .access_flag = CDB2_ALLOW_USER,
+};
+
+int systblPageCompactInit(sqlite3 *db)
+{
+    return create_system_table(
+        db, "comdb2_page_compact", &systblPageCompactModule, get_rows,
+        free_rows, sizeof(struct page_compact),
+        CDB2_CSTRING, "tablename", -1,
+        offsetof(struct page_compact, tablename),
+        CDB2_CSTRING, "file", -1, offsetof(struct page_compact, file),
+        CDB2_INTEGER, "filenum", -1, offsetof(struct page_compact, filenum),
+        CDB2_INTEGER, "stripe", -1, offsetof(struct page_compact, stripe),
+        CDB2_INTEGER, "leaf_pages", -1,
+        offsetof(struct page_compact, leaf_pages),
+        CDB2_REAL, "fill_pct", -1, offsetof(struct page_compact, fill_pct),
+        CDB2_INTEGER, "ranges_compacted", -1,
+        offsetof(struct page_compact, ranges_compacted),
+        CDB2_INTEGER, "pages_merged", -1,
+        offsetof(struct page_compact, pages_merged),
+        CDB2_INTEGER, "bytes_reclaimed", -1,
+        offsetof(struct page_compact, bytes_reclaimed),
+        CDB2_INTEGER, "log_bytes", -1,
+        offsetof(struct page_compact, log_bytes),
+        SYSTABLE_END_OF_FIELDS);
+}
@@ -309,6 +309,14 @@ int comdb2SystblInit(
     rc = systblSQLIndexStatsInit(db);
   if (rc == SQLITE_OK)
     rc = systblTemporaryFileSizesModuleInit(db);
+  if (rc == SQLITE_OK)
+    rc = systblCacheWarmupInit(db);
+  if (rc == SQLITE_OK)
+    rc = systblLogFlushHistInit(db);
+  if (rc == SQLITE_OK)
+    rc = systblLCCacheInit(db);
+  if (rc == SQLITE_OK)
+    rc = systblPageCompactInit(db);
   if (rc == SQLITE_OK)
     rc = systblFunctionsInit(db);
   if (rc == SQLITE_OK)
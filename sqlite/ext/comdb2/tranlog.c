@@ -138,7 +138,14 @@ static int tranlogNext(sqlite3_vtab_cursor *cur){
                   __func__, __LINE__, rc);
           return SQLITE_INTERNAL;
       }
-      pCur->logc->setflags(pCur->logc, DB_LOG_SILENT_ERR);
+      /* Payloads are returned as stored: physical replicants write them
+       * into their own logs, which must match ours byte for byte.  Forward
+       * scans read the log in large blocks. */
+      pCur->logc->setflags(pCur->logc,
+                           DB_LOG_SILENT_ERR | DB_LOG_RAW |
+                               ((pCur->flags & TRANLOG_FLAGS_DESCENDING)
+                                    ? 0
+                                    : DB_LOG_STREAM));
       pCur->openCursor = 1;
       pCur->data.flags = DB_DBT_REALLOC;
 
@@ -392,7 +399,7 @@ static int tranlogColumn(
     case TRANLOG_COLUMN_RECTYPE:
         if (pCur->data.data)
             LOGCOPY_32(&rectype, pCur->data.data); 
-        sqlite3_result_int64(ctx, rectype);
+        sqlite3_result_int64(ctx, rectype & ~DB_lz4_FLAG);
         break;
     case TRANLOG_COLUMN_GENERATION:
         if (pCur->data.data)
@@ -0,0 +1,88 @@
+/* Check bt_keycmp_skip against memcmp ordering on random keys, with
+ * random amounts of the shared prefix skipped.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+
+typedef struct {
+    void *data;
+    u_int32_t size;
+} DBT;
+
+#include <bt_keycmp.h>
+
+#define ITERS 2000000
+#define MAXKEY 300
+
+static int sign(long x)
+{
+    return x < 0 ? -1 : x > 0;
+}
+
+/* What __bam_defcmp returns, up to sign, and the prefix the keys share. */
+static int refcmp(const u_int8_t *a, u_int32_t alen, const u_int8_t *b,
+                  u_int32_t blen, u_int32_t *lcpp)
+{
+    u_int32_t i, len = alen < blen ? alen : blen;
+    int rc;
+
+    for (i = 0; i < len && a[i] == b[i]; i++)
+        ;
+    *lcpp = i;
+    if ((rc = memcmp(a, b, len)) != 0)
+        return sign(rc);
+    return sign((long)alen - (long)blen);
+}
+
+int main(int argc, char *argv[])
+{
+    u_int8_t a[MAXKEY], b[MAXKEY];
+    u_int32_t alen, blen, skip, lcp, reflcp, i, j;
+    unsigned seed;
+    DBT key;
+    int rc, refrc;
+
+    seed = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 10) : (unsigned)time(NULL);
+    printf("seed %u\n", seed);
+    srandom(seed);
+
+    for (i = 0; i < ITERS; i++) {
+        /* Mostly long shared prefixes, so every word size gets a turn. */
+        alen = random() % MAXKEY;
+        blen = random() % 4 ? alen : random() % MAXKEY;
+        for (j = 0; j < alen; j++)
+            a[j] = random() % 4 ? 0x41 : random();
+        memcpy(b, a, blen < alen ? blen : alen);
+        for (j = alen; j < blen; j++)
+            b[j] = random();
+        if (blen > 0 && random() % 4) {
+            j = random() % blen;
+            b[j] = random() % 2 ? b[j] + 1 : b[j] - 1;
+            if (random() % 2)
+                b[j] ^= 0x80;
+        }
+
+        refrc = refcmp(a, alen, b, blen, &reflcp);
+
+        /* Callers only skip what they know is shared. */
+        skip = reflcp == 0 ? 0 : random() % (reflcp + 1);
+        key.data = a;
+        key.size = alen;
+        rc = bt_keycmp_skip(&key, b, blen, skip, &lcp);
+
+        if (sign(rc) != refrc || lcp != reflcp) {
+            fprintf(stderr,
+                    "iteration %u: alen %u blen %u skip %u: got %d lcp %u, "
+                    "want %d lcp %u\n",
+                    i, alen, blen, skip, sign(rc), lcp, refrc, reflcp);
+            return 1;
+        }
+    }
+
+    printf("passed\n");
+    return 0;
+}
@@ -318,7 +318,8 @@ int tool_cdb2_printlog_main(argc, argv)
 	} else if ((ret = dbenv->log_cursor(dbenv, &logc, 0)) != 0) {
 		dbenv->err(dbenv, ret, "DB_ENV->log_cursor");
 		goto shutdown;
-	}
+	} else if (!rflag)
+		(void)logc->setflags(logc, DB_LOG_STREAM);
 
 	memset(&data, 0, sizeof(data));
 	memset(&keydbt, 0, sizeof(keydbt));
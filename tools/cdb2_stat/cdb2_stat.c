@@ -720,6 +720,19 @@ lock_stats(dbenv, internal, flags)
 	dl("Transaction timeout value.\n", (u_long)sp->st_txntimeout);
 	dl("Number of transactions that have timed out.\n",
 	    (u_long)sp->st_ntxntimeouts);
+	dl("Number of pages searched without taking their latch.\n",
+	    (u_long)sp->st_nlatch_optimistic);
+	dl("Number of those found changed and searched again.\n",
+	    (u_long)sp->st_nlatch_optimistic_fail);
+	dl("Number of deadlock detector passes.\n", (u_long)sp->st_ndetects);
+	dl("Number of detector passes skipped with no new waits.\n",
+	    (u_long)sp->st_ndetects_skipped);
+	dl("Number of deadlock cycles found.\n",
+	    (u_long)sp->st_ndeadlock_cycles);
+	dl("Total microseconds spent in the deadlock detector.\n",
+	    (u_long)sp->st_detect_usecs);
+	dl("Longest deadlock detector pass in microseconds.\n",
+	    (u_long)sp->st_detect_max_usecs);
 
 	dl_bytes("The size of the lock region.",
 	    (u_long)0, (u_long)0, (u_long)sp->st_regsize);
@@ -743,7 +756,7 @@ log_stats(dbenv, flags)
 	u_int32_t flags;
 {
 	DB_LOG_STAT *sp;
-	int ret;
+	int i, ret;
 
 	if ((ret = dbenv->log_stat(dbenv, &sp, flags)) != 0) {
 		dbenv->err(dbenv, ret, NULL);
@@ -780,6 +793,30 @@ log_stats(dbenv, flags)
 
 	dl("Max commits in a log flush.\n", (u_long)sp->st_maxcommitperflush);
 	dl("Min commits in a log flush.\n", (u_long)sp->st_mincommitperflush);
+	dl("Log flushes held to gather commits.\n", (u_long)sp->st_gc_waits);
+	dl("Microseconds flushes were held.\n", (u_long)sp->st_gc_wait_usecs);
+	dl("Microseconds spent syncing the log.\n", (u_long)sp->st_fsync_usecs);
+	dl("Log records compressed.\n", (u_long)sp->st_lz4_records);
+	dl_bytes("Log bytes before compression",
+	    (u_long)0, (u_long)0, (u_long)sp->st_lz4_bytes_in);
+	dl_bytes("Log bytes after compression",
+	    (u_long)0, (u_long)0, (u_long)sp->st_lz4_bytes_out);
+	dl("Streaming log cursor block reads.\n",
+	    (u_long)sp->st_stream_reads);
+	dl("Streaming log cursor blocks read ahead.\n",
+	    (u_long)sp->st_stream_ahead);
+	for (i = 0; i < DB_LOG_HIST_BUCKETS; ++i)
+		if (sp->st_commit_hist[i] != 0)
+			printf("%lu\tLog flushes of %s%lu commits.\n",
+			    (u_long)sp->st_commit_hist[i],
+			    i == DB_LOG_HIST_BUCKETS - 1 ? "more than " : "up to ",
+			    (u_long)1 << (i == DB_LOG_HIST_BUCKETS - 1 ? i - 1 : i));
+	for (i = 0; i < DB_LOG_HIST_BUCKETS; ++i)
+		if (sp->st_fsync_hist[i] != 0)
+			printf("%lu\tLog syncs taking %s%lu microseconds.\n",
+			    (u_long)sp->st_fsync_hist[i],
+			    i == DB_LOG_HIST_BUCKETS - 1 ? "more than " : "up to ",
+			    (u_long)16 << (i == DB_LOG_HIST_BUCKETS - 1 ? i - 1 : i));
 
 	dl_bytes("Log region size",
 	    (u_long)0, (u_long)0, (u_long)sp->st_regsize);
@@ -889,6 +926,26 @@ mpool_stats(dbenv, internal, flags)
 	    (u_long)gsp->st_ckp_pages_sync);
 	dl("The number of pages skipped using perfect checkpoint\n",
 	    (u_long)gsp->st_ckp_pages_skip);
+	dl("Requested probationary pages found in the cache.\n",
+	    (u_long)gsp->st_cold_hit);
+	dl("Requested protected pages found in the cache.\n",
+	    (u_long)gsp->st_hot_hit);
+	dl("Pages promoted from probationary to protected.\n",
+	    (u_long)gsp->st_promote);
+	dl("Probationary pages forced from the cache.\n",
+	    (u_long)gsp->st_cold_evict);
+	dl("Protected pages forced from the cache.\n",
+	    (u_long)gsp->st_hot_evict);
+	dl("Pages held in the compressed cache.\n",
+	    (u_long)gsp->st_ccache_pages);
+	dl("Bytes used by the compressed cache.\n",
+	    (u_long)gsp->st_ccache_bytes);
+	dl("Pages found in the compressed cache.\n",
+	    (u_long)gsp->st_ccache_hit);
+	dl("Pages not found in the compressed cache.\n",
+	    (u_long)gsp->st_ccache_miss);
+	dl("Pages forced from the compressed cache.\n",
+	    (u_long)gsp->st_ccache_evict);
 
 	for (; fsp != NULL && *fsp != NULL; ++fsp) {
 		printf("%s\n", DB_LINE);
@@ -911,6 +968,28 @@ mpool_stats(dbenv, internal, flags)
 		    (u_long)(*fsp)->st_page_in);
 		dl("Pages written from the cache to the backing file.\n",
 		    (u_long)(*fsp)->st_page_out);
+		dl("Writes issued to flush pages",
+		    (u_long)(*fsp)->st_flush_writes);
+		if ((*fsp)->st_flush_writes != 0)
+			printf(" (%lu usecs average, %lu usecs max)",
+			    (u_long)((*fsp)->st_flush_usecs /
+			    (*fsp)->st_flush_writes),
+			    (u_long)(*fsp)->st_flush_max_usecs);
+		printf(".\n");
+		dl("Pages found in the compressed cache",
+		    (u_long)(*fsp)->st_ccache_hit);
+		if ((*fsp)->st_ccache_hit + (*fsp)->st_ccache_miss != 0)
+			printf(" (%.0f%%)", ((double)(*fsp)->st_ccache_hit /
+			    ((*fsp)->st_ccache_hit + (*fsp)->st_ccache_miss)) *
+			    100);
+		printf(".\n");
+		dl("Pages put in the compressed cache",
+		    (u_long)(*fsp)->st_ccache_put);
+		if ((*fsp)->st_ccache_bytes_out != 0)
+			printf(" (%.2f compression ratio)",
+			    (double)(*fsp)->st_ccache_bytes_in /
+			    (*fsp)->st_ccache_bytes_out);
+		printf(".\n");
 	}
 
 	free(gsp);